@@ -53,6 +53,18 @@
 /* USER CODE BEGIN 0 */
   extern void configureTimerForRunTimeStats(void);
   extern unsigned long getRunTimeCounterValue(void);
+  /* trace hooks (traceTASK_SWITCHED_IN, traceQUEUE_RECEIVE, ...) */
+  #include "trace.h"
+  /* stack and queue sizing monitor */
+  #include "sizing.h"
+  /* CPU load meter, idle, tick and switch out hooks */
+  #include "cpu_load.h"
+  /* hooks used by both */
+  #define traceTASK_CREATE(pxNewTCB)                do { TRACE_TASK_CREATE(pxNewTCB); SIZING_TASK_CREATE(pxNewTCB); } while (0)
+  #define traceQUEUE_SEND(pxQueue)                  do { TRACE_QUEUE_SEND(pxQueue); SIZING_QUEUE_SEND(pxQueue); } while (0)
+  #define traceQUEUE_SEND_FROM_ISR(pxQueue)         do { TRACE_QUEUE_SEND_FROM_ISR(pxQueue); SIZING_QUEUE_SEND(pxQueue); } while (0)
+  #define traceQUEUE_SEND_FAILED(pxQueue)           do { TRACE_QUEUE_SEND_FAILED(pxQueue); SIZING_QUEUE_SEND_FAILED(pxQueue); } while (0)
+  #define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue)  do { TRACE_QUEUE_SEND_FAILED(pxQueue); SIZING_QUEUE_SEND_FAILED(pxQueue); } while (0)
 /* USER CODE END 0 */
 #endif
 #define configUSE_PREEMPTION                     1
@@ -154,6 +166,22 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* tickless idle, vPortSuppressTicksAndSleep() is tickless.c (TIM1 HAL timebase) */
+#define configUSE_TICKLESS_IDLE                  2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    2
+/* stack high water marks for the sizing report (sizing.c) */
+#define INCLUDE_uxTaskGetStackHighWaterMark      1
+/* timer command queue, 1 kHz status timer restarts (can2can_slave.c) */
+#undef configTIMER_QUEUE_LENGTH
+#define configTIMER_QUEUE_LENGTH                 8
+/* CAN service task on the highest priority, above the timer task (can.c) */
+#undef configMAX_PRIORITIES
+#define configMAX_PRIORITIES                     ( 8 )
+#undef configTIMER_TASK_PRIORITY
+#define configTIMER_TASK_PRIORITY                (configMAX_PRIORITIES - 2)
+/* tick hook of the CPU load meter, ends the load windows (cpu_load.c) */
+#undef configUSE_TICK_HOOK
+#define configUSE_TICK_HOOK                      CPU_LOAD_USE_METER
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
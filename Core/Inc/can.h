@@ -40,10 +40,34 @@ extern CAN_HandleTypeDef hcan;
 #define BXCAN_MAX_TX_FIFO     (3u)
 #define BXCAN_MAX_RX_FIFO     (3u)
 
+#define BXCAN_BIT_RATE        (1000000u)  /* bits/s, MX_CAN_Init() */
+
+/* standard data frame with the interframe space, without stuff bits */
+#define BXCAN_FRAME_BITS(len) (47u + (8u * (len)))
+
 #define BXCAN_TX_MB0          (0u)
 #define BXCAN_TX_MB1          (1u)
 #define BXCAN_TX_MB2          (2u)
 
+/* 1: the CAN interrupts only move received frames, TX completions and errors
+ * into lock free structures and wake the CAN service task, which runs the
+ * RX handlers (bxCAN_SetRxHandler()), the TX complete and the error
+ * callbacks. 0: they run in the interrupts. The handlers and callbacks pick
+ * the task or the FromISR kernel API with this flag */
+#define BXCAN_USE_SERVICE_TASK      (1u)
+#define BXCAN_SERVICE_TASK_PRIORITY (7u)    /* configMAX_PRIORITIES - 1, above the timer task */
+#define BXCAN_SERVICE_STACK_DEPTH   (160u)
+#define BXCAN_SERVICE_RX_SLOTS      (8u)    /* frames per RX FIFO, power of 2 */
+#define BXCAN_SERVICE_TX_SLOTS      (8u)    /* TX completions, power of 2 */
+#define BXCAN_SERVICE_RX_BUDGET     (4u)    /* frames per RX FIFO and pass */
+
+/* 1: the cyclic frames of the nodes are loaded into the scheduled mailbox
+ * from the TX scheduler interrupt at their release time (tx_scheduler.h),
+ * bxCAN_Transmit() uses the other mailboxes. 0: they're sent by the node
+ * tasks on FreeRTOS software timers */
+#define BXCAN_USE_TX_SCHEDULER      (1u)
+#define BXCAN_SCHEDULED_MAILBOX     (BXCAN_TX_MB2)
+
 typedef union bxCAN_Filter_t {
     struct {
         uint32_t __const: 1;
@@ -66,7 +90,40 @@ typedef enum {
 
 typedef bxCAN_Filter_t bxCAN_Mask_t;
 
-typedef void (* bxCAN_TxCompleteCallback_t)(void);
+/* called from the TX complete ISR with the mailbox that completed */
+typedef void (* bxCAN_TxCompleteCallback_t)(uint8_t mailbox);
+
+typedef enum {
+    BXCAN_DIRECTION_RX,
+    BXCAN_DIRECTION_TX,
+} bxCAN_Direction_t;
+
+/* called for every frame passing through the driver, from task or ISR context */
+typedef void (* bxCAN_MonitorCallback_t)(uint16_t std_id, const uint8_t *const data, uint8_t len, bxCAN_Direction_t direction);
+
+/* called from the CAN error ISR with the HAL_CAN_ERROR_x flags */
+typedef void (* bxCAN_ErrorCallback_t)(uint32_t error);
+
+/* called by the CAN service task for each received frame, reads it with bxCAN_Receive() */
+typedef void (* bxCAN_RxHandler_t)(CAN_HandleTypeDef *hcan);
+
+/* CAN service task work, in priority order */
+typedef enum {
+    BXCAN_SOURCE_ERROR,
+    BXCAN_SOURCE_TX,
+    BXCAN_SOURCE_RX0,
+    BXCAN_SOURCE_RX1,
+    BXCAN_SOURCE_NUMBER,
+} bxCAN_Source_t;
+
+/* CAN service task statistics, per source */
+typedef struct {
+    uint32_t handled;               /* frames, TX completions or error reports processed */
+    uint32_t dropped;               /* frames or TX completions dropped, ring full */
+    uint32_t deferred;              /* passes that left work for the next pass, budget used up */
+    uint32_t max_latency_cycles;    /* interrupt to handler start, longest */
+    uint32_t max_handler_cycles;    /* handler run, longest */
+} bxCAN_ServiceStatistics_t;
 
 /* USER CODE END Private defines */
 
@@ -75,9 +132,23 @@ void MX_CAN_Init(void);
 /* USER CODE BEGIN Prototypes */
 HAL_StatusTypeDef bxCAN_Initialize(void);
 HAL_StatusTypeDef bxCAN_SetFilterPolicy(uint8_t policy_number, uint8_t filter_fifo, bxCAN_Filter_t filter_id, bxCAN_Mask_t filter_mask);
+HAL_StatusTypeDef bxCAN_ClearFilterPolicy(uint8_t policy_number);
+HAL_StatusTypeDef bxCAN_SetFilterId(uint8_t policy_number, bxCAN_Filter_t filter_id, bxCAN_Mask_t filter_mask);
+void bxCAN_DeactivateFilterPolicy(uint8_t policy_number);
 HAL_StatusTypeDef bxCAN_Transmit(const uint8_t *const data, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback);
-HAL_StatusTypeDef bxCAN_Receive(bxCAN_RxFifo_t rx_fifo, uint8_t *data, uint8_t *len, uint16_t *std_id);
+HAL_StatusTypeDef bxCAN_TryTransmit(const uint8_t *const data, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback);
+HAL_StatusTypeDef bxCAN_TransmitScheduled(const uint8_t *const data, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback);
+HAL_StatusTypeDef bxCAN_Receive(bxCAN_RxFifo_t rx_fifo, uint8_t *data, uint8_t *len, uint16_t *std_id, uint8_t *e2e_status);
+uint16_t bxCAN_GetRxStdId(bxCAN_RxFifo_t rx_fifo);
+uint16_t bxCAN_GetTxStdId(uint8_t mailbox);
+void bxCAN_SetMonitorCallback(bxCAN_MonitorCallback_t callback);
+void bxCAN_SetErrorCallback(bxCAN_ErrorCallback_t callback);
 void bxCAN_TxCompleteCallback(CAN_HandleTypeDef * hcan, uint32_t mailbox);
+void bxCAN_SetRxHandler(bxCAN_RxFifo_t rx_fifo, bxCAN_RxHandler_t handler);
+uint64_t bxCAN_GetRxTime(bxCAN_RxFifo_t rx_fifo);
+uint64_t bxCAN_GetTxTime(uint8_t mailbox);
+void bxCAN_GetServiceStatistics(bxCAN_Source_t source, bxCAN_ServiceStatistics_t *const statistics);
+uint32_t bxCAN_GetBusBits(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
@@ -1,26 +1,134 @@
 #ifndef _CAN2CAN_H_
 #define _CAN2CAN_H_
 
+/* message layouts, generated from Tools/dbc/can2can.dbc */
+#include "can2can_signals.h"
+#include "jitter.h"
+#include "histogram.h"
+#include "event.h"
+#include "event_pool.h"
+#include "schedule_table.h"
+
 #define OPERATION_COMMAND_STD_ID          (0x300u)
 #define OPERATION_COMMAND_FREQUENCY       (1u)
-#define OPERATION_COMMAND_MSG_SIZE        (1u)
-#define OPERATION_COMMAND_POS             (0u)
+#define OPERATION_COMMAND_MSG_SIZE        (6u)
 #define OPERATION_COMMAND_OFF             (0x55u)
 #define OPERATION_COMMAND_ON              (0xAAu)
 
 #define OPERATION_STATUS_STD_ID           (0x301u)
-#define OPERATION_STATUS_FREQUENCY        (10u)
-#define OPERATION_STATUS_MSG_SIZE         (2u)
-#define OPERATION_STATUS_POS              (0u)
-#define OPERATION_VALUE_POS               (1u)
-#define OPERATION_STATUS_OFF              (0u)
-#define OPERATION_STATUS_ON               (1u)
+#define OPERATION_STATUS_FREQUENCY        (10u)     /* default, can be changed with MasterNode_SetStatusRate() */
+#define OPERATION_STATUS_MAX_FREQUENCY    (1000u)
+/* 1: operation status frames carry a sequence number, the master counts
+ * lost, duplicated and reordered frames, 0: no sequence number (DLC 5) */
+#define CAN2CAN_USE_STATUS_SEQUENCE       (1u)
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+#define OPERATION_STATUS_MSG_SIZE         (6u)
+#else
+#define OPERATION_STATUS_MSG_SIZE         (5u)
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+#define OPERATION_STATUS_OFF              (OPERATION_STATUS_STATUS_OFF)
+#define OPERATION_STATUS_ON               (OPERATION_STATUS_STATUS_ON)
 #define OPERATION_STATUS_VALUE_MODIFIER   (0x01u)
 
 #define OPERATION_STATUS_COUNT            (OPERATION_STATUS_FREQUENCY/ OPERATION_COMMAND_FREQUENCY)
+#define OPERATION_COMMAND_PERIOD_MS       (1000u / OPERATION_COMMAND_FREQUENCY)
+#define OPERATION_STATUS_PERIOD_MS        (1000u / OPERATION_STATUS_FREQUENCY)
+
+/* operation status frames sent per operation command, and their period, at a given rate */
+#define OPERATION_STATUS_COUNT_AT(frequency)      ((frequency) / OPERATION_COMMAND_FREQUENCY)
+#define OPERATION_STATUS_PERIOD_US_AT(frequency)  (1000000u / (frequency))
+
+/* slaves polled by the master, slave n owns the contiguous ID range
+ * [0x300 + 2n, 0x301 + 2n]: operation command, operation status */
+#define CAN2CAN_SLAVE_NUMBER              (1u)
+#define CAN2CAN_SLAVE_MAX_NUMBER          (32u)
+#define SLAVE_ID_RANGE_SIZE               (2u)
+#define SLAVE_ID_STD_ID_MASK              ((CAN2CAN_SLAVE_MAX_NUMBER - 1u) * SLAVE_ID_RANGE_SIZE)
+#define OPERATION_COMMAND_STD_ID_OF(slave)  (OPERATION_COMMAND_STD_ID + ((slave) * SLAVE_ID_RANGE_SIZE))
+#define OPERATION_STATUS_STD_ID_OF(slave)   (OPERATION_STATUS_STD_ID + ((slave) * SLAVE_ID_RANGE_SIZE))
+#define SLAVE_ID_OF_STD_ID(std_id)          (((std_id) - OPERATION_COMMAND_STD_ID) / SLAVE_ID_RANGE_SIZE)
+
+/* slave ID of the slave node running on this device */
+#define SLAVE_NODE_ID                     (0u)
+
+/* master schedule table: slave n is commanded at this offset (us) in each
+ * command period, spreading the slaves' operation status frames evenly over
+ * the operation status period instead of sending them in bursts. In
+ * microseconds, the slaves' slots are shorter than a millisecond above
+ * 125 Hz with 8 slaves */
+#define MASTER_NODE_SCHEDULE_OFFSET_US(slave, slave_number, status_period_us) \
+  (((slave) * (status_period_us)) / (slave_number))
+
+/* 1: the nodes send their operation commands and operation status frames
+ * at the expiry points of the communication schedule table
+ * (Can2Can_Schedule, schedule_table.h), the slaves synchronize their cycle to
+ * their operation command. The status rate is fixed by the table
+ * (OPERATION_STATUS_FREQUENCY). 0: master schedule table and status deadlines
+ * from the command reception. Needs the TX scheduler */
+#define CAN2CAN_USE_SCHEDULE_TABLE        (0u)
+#define CAN2CAN_SCHEDULE_BIT_RATE         (1000000u)  /* bits/s, BXCAN_BIT_RATE */
+#define CAN2CAN_SCHEDULE_RESPONSE_US      (1000u)     /* operation command to the first operation status of its slave */
+#define CAN2CAN_SCHEDULE_PRECISION_US     (100u)      /* slave cycle deviation corrected without restarting its table */
+#define CAN2CAN_SCHEDULE_MAX_ADJUST_US    (20u)       /* slave cycle correction per operation command */
+
+/**
+ * @brief Messages of the communication schedule table
+ */
+typedef enum {
+  CAN2CAN_SCHEDULE_COMMAND,     /* operation commands, sync point of the slaves */
+  CAN2CAN_SCHEDULE_STATUS,      /* operation status frames */
+  CAN2CAN_SCHEDULE_MESSAGE_NUMBER,
+} Can2Can_ScheduleMessage_t;
+
+extern const ScheduleTable_t Can2Can_Schedule;
+
+/* master: operation status frame k of a command is due k status periods after
+ * the command, and timed out (lost) when it isn't received within this time
+ * after it's due: half a period for jitter, plus 2 ticks for scheduling */
+#define MASTER_NODE_STATUS_TIMEOUT_US(status_period_us) \
+  (((status_period_us) / 2u) + 2000u)
+
+/* master: received sequence numbers are tracked over this many frames behind
+ * the newest one, to tell duplicates from late (reordered) frames */
+#define MASTER_NODE_SEQUENCE_WINDOW       (32u)
+
+/* master: burst loss length histogram, bin n counts bursts of
+ * [2^n, 2^(n+1) - 1] consecutive lost frames, the last bin everything above */
+#define MASTER_NODE_BURST_BINS            (6u)
+
+/* E2E protection: counter jump accepted without reporting a wrong sequence,
+ * and periods without a valid frame before reporting a timeout (the
+ * operation status period follows MasterNode_GetStatusRate()) */
+#define OPERATION_COMMAND_E2E_MAX_DELTA       (1u)
+#define OPERATION_COMMAND_E2E_TIMEOUT_PERIODS (2u)
+#define OPERATION_STATUS_E2E_MAX_DELTA        (2u)
+#define OPERATION_STATUS_E2E_TIMEOUT_PERIODS  (3u)
+
+#define CLOCK_SYNC_STD_ID                 (0x0F0u)
+#define CLOCK_SYNC_FREQUENCY              (1u)
+#define CLOCK_SYNC_MSG_SIZE               (8u)
+#define CLOCK_SYNC_SYNC_MSG_SIZE          (2u)
+#define CLOCK_SYNC_TYPE_SYNC              (CLOCK_SYNC_FRAME_TYPE_SYNC)
+#define CLOCK_SYNC_TYPE_FOLLOW_UP         (CLOCK_SYNC_FRAME_TYPE_FOLLOW_UP)
+
+/* configuration service (config_service.h), reserved IDs */
+#define CONFIG_SERVICE_REQUEST_STD_ID     (0x7E0u)
+#define CONFIG_SERVICE_REQUEST_MSG_SIZE   (3u)
+#define CONFIG_SERVICE_RESPONSE_STD_ID    (0x7E1u)
+#define CONFIG_SERVICE_RESPONSE_MSG_SIZE  (8u)
+#define CONFIG_SERVICE_LOAD_STD_ID        (0x7E2u)
+#define CONFIG_SERVICE_LOAD_MSG_SIZE      (8u)
+
+/* node roles, enabled/disabled by the configuration service */
+#define CAN2CAN_ROLE_MASTER               (0x01u)
+#define CAN2CAN_ROLE_SLAVE                (0x02u)
+#define CAN2CAN_ROLE_ALL                  (CAN2CAN_ROLE_MASTER | CAN2CAN_ROLE_SLAVE)
 
 #define MASTER_NODE_POLICY_NUMBER         (0u)
 #define SLAVE_NODE_POLICY_NUMBER          (1u)
+#define CLOCK_SYNC_POLICY_NUMBER          (2u)
+#define CONFIG_SERVICE_POLICY_NUMBER      (3u)
+#define SLAVE_NODE_ALT_POLICY_NUMBER      (4u)    /* operation command filter moves between this bank and SLAVE_NODE_POLICY_NUMBER on slave ID changes */
 
 #define MASTER_TASK_TASK_PRIORITY         (3u)
 #define MASTER_TASK_STACK_DEPTH           (128u)
@@ -28,19 +136,67 @@
 #define SLAVE_TASK_TASK_PRIORITY          (2u)
 #define SLAVE_TASK_STACK_DEPTH            (128u)
 
-#define MASTER_NODE_RX_QUEUE_SIZE         (3u)
-#define SLAVE_NODE_RX_QUEUE_SIZE          (3u)
+/* 1: master and slave node state machines share the executive task and its
+ * event queue (executive.h), 0: each node has its own task and event queue */
+#define CAN2CAN_USE_EXECUTIVE             (0u)
+
+/* 1: node tasks receive their events through an event channel (task
+ * notification bit and lock free ring, event_channel.h), 0: through a FreeRTOS
+ * queue. Not used with the executive */
+#define CAN2CAN_USE_EVENT_CHANNEL         (1u)
+#define CAN2CAN_EVENT_CHANNEL_BIT         (0x01u)   /* node task notification bit */
 
 #define MASTER_NODE_MAX_EVENTS            (10u)
 #define SLAVE_NODE_MAX_EVENTS             (10u)
 
+#define MASTER_NODE_FRAME_SUBSCRIBERS     (2u)    /* consumers of received operation status frames, besides the master node */
+
 #define MASTER_NODE_RX_FIFO               (BXCAN_RX_FIFO0)
 #define MASTER_NODE_RX_FIFO_NOTIFICATION  (CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO0_FULL | CAN_IT_RX_FIFO0_OVERRUN)
-#define MASTER_NODE_RX_FIFO_CALLBACK      HAL_CAN_RxFifo0MsgPendingCallback
 
 #define SLAVE_NODE_RX_FIFO                (BXCAN_RX_FIFO1)
 #define SLAVE_NODE_RX_FIFO_NOTIFICATION   (CAN_IT_RX_FIFO1_MSG_PENDING | CAN_IT_RX_FIFO1_FULL | CAN_IT_RX_FIFO1_OVERRUN)
-#define SLAVE_NODE_RX_FIFO_CALLBACK       HAL_CAN_RxFifo1MsgPendingCallback
+
+#if (OPERATION_COMMAND_STD_ID != OPERATION_COMMAND_FRAME_ID) || (OPERATION_COMMAND_MSG_SIZE != OPERATION_COMMAND_FRAME_DLC)
+#error operation command does not match can2can.dbc
+#endif /* (OPERATION_COMMAND_STD_ID != OPERATION_COMMAND_FRAME_ID) || (OPERATION_COMMAND_MSG_SIZE != OPERATION_COMMAND_FRAME_DLC) */
+
+#if (OPERATION_STATUS_STD_ID != OPERATION_STATUS_FRAME_ID) || (OPERATION_STATUS_MSG_SIZE > OPERATION_STATUS_FRAME_DLC)
+#error operation status does not match can2can.dbc
+#endif /* (OPERATION_STATUS_STD_ID != OPERATION_STATUS_FRAME_ID) || (OPERATION_STATUS_MSG_SIZE > OPERATION_STATUS_FRAME_DLC) */
+
+#if (CLOCK_SYNC_STD_ID != CLOCK_SYNC_FRAME_FRAME_ID) || (CLOCK_SYNC_MSG_SIZE != CLOCK_SYNC_FRAME_FRAME_DLC)
+#error clock sync does not match can2can.dbc
+#endif /* (CLOCK_SYNC_STD_ID != CLOCK_SYNC_FRAME_FRAME_ID) || (CLOCK_SYNC_MSG_SIZE != CLOCK_SYNC_FRAME_FRAME_DLC) */
+
+#if (CONFIG_SERVICE_REQUEST_STD_ID != CONFIG_REQUEST_FRAME_ID) || (CONFIG_SERVICE_REQUEST_MSG_SIZE != CONFIG_REQUEST_FRAME_DLC)
+#error configuration request does not match can2can.dbc
+#endif /* (CONFIG_SERVICE_REQUEST_STD_ID != CONFIG_REQUEST_FRAME_ID) || (CONFIG_SERVICE_REQUEST_MSG_SIZE != CONFIG_REQUEST_FRAME_DLC) */
+
+#if (CONFIG_SERVICE_RESPONSE_STD_ID != CONFIG_RESPONSE_FRAME_ID) || (CONFIG_SERVICE_RESPONSE_MSG_SIZE != CONFIG_RESPONSE_FRAME_DLC)
+#error configuration response does not match can2can.dbc
+#endif /* (CONFIG_SERVICE_RESPONSE_STD_ID != CONFIG_RESPONSE_FRAME_ID) || (CONFIG_SERVICE_RESPONSE_MSG_SIZE != CONFIG_RESPONSE_FRAME_DLC) */
+
+#if (CONFIG_SERVICE_LOAD_STD_ID != LOAD_REPORT_FRAME_ID) || (CONFIG_SERVICE_LOAD_MSG_SIZE != LOAD_REPORT_FRAME_DLC)
+#error load report does not match can2can.dbc
+#endif /* (CONFIG_SERVICE_LOAD_STD_ID != LOAD_REPORT_FRAME_ID) || (CONFIG_SERVICE_LOAD_MSG_SIZE != LOAD_REPORT_FRAME_DLC) */
+
+#if !((CAN2CAN_SLAVE_NUMBER > 0) && (CAN2CAN_SLAVE_NUMBER <= CAN2CAN_SLAVE_MAX_NUMBER))
+#error CAN2CAN_SLAVE_NUMBER must be in [1, CAN2CAN_SLAVE_MAX_NUMBER]
+#endif /* !((CAN2CAN_SLAVE_NUMBER > 0) && (CAN2CAN_SLAVE_NUMBER <= CAN2CAN_SLAVE_MAX_NUMBER)) */
+
+#if !(SLAVE_NODE_ID < CAN2CAN_SLAVE_NUMBER)
+#error SLAVE_NODE_ID must be < CAN2CAN_SLAVE_NUMBER
+#endif /* !(SLAVE_NODE_ID < CAN2CAN_SLAVE_NUMBER) */
+
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u) \
+    && (CAN2CAN_SCHEDULE_RESPONSE_US >= (OPERATION_STATUS_PERIOD_US_AT(OPERATION_STATUS_FREQUENCY) / CAN2CAN_SLAVE_NUMBER))
+#error CAN2CAN_SCHEDULE_RESPONSE_US must be shorter than the slave stride, or the last slaves lose operation status frames
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) && (CAN2CAN_SCHEDULE_RESPONSE_US >= ...) */
+
+#if !(CLOCK_SYNC_FREQUENCY > 0)
+#error CLOCK_SYNC_FREQUENCY must be > 0
+#endif /* !(CLOCK_SYNC_FREQUENCY > 0) */
 
 #if !(OPERATION_COMMAND_FREQUENCY > 0)
 #error OPERATION_COMMAND_FREQUENCY must be > 0
@@ -50,6 +206,10 @@
 #error OPERATION_STATUS_FREQUENCY must be > 0
 #endif /* !(OPERATION_STATUS_FREQUENCY > 0) */
 
+#if (OPERATION_STATUS_FREQUENCY > OPERATION_STATUS_MAX_FREQUENCY)
+#error OPERATION_STATUS_FREQUENCY must be <= OPERATION_STATUS_MAX_FREQUENCY
+#endif /* (OPERATION_STATUS_FREQUENCY > OPERATION_STATUS_MAX_FREQUENCY) */
+
 #if (OPERATION_COMMAND_FREQUENCY > OPERATION_STATUS_FREQUENCY)
 #error OPERATION_STATUS_FREQUENCY must be larger than OPERATION_COMMAND_FREQUENCY
 #endif /* (OPERATION_COMMAND_FREQUENCY <= OPERATION_STATUS_FREQUENCY) */
@@ -58,16 +218,6 @@
 #error OPERATION_STATUS_FREQUENCY must be a multiple of OPERATION_COMMAND_FREQUENCY
 #endif /* ((OPERATION_STATUS_COUNT * OPERATION_COMMAND_FREQUENCY) != OPERATION_STATUS_FREQUENCY) */
 
-/**
- * @brief Node event type
- */
-typedef enum {
-  NO_EVENT,     /* no event */
-  TIME_EVENT,   /* timer expired, and it's time to send the next operation command/operation status */
-  CAN_TX_EVENT, /* operation command/operation status was transmitted successfully */
-  CAN_RX_EVENT, /* operation command/operation status status received */
-} EventType_t;
-
 /**
  * @brief Operation status
  */
@@ -82,29 +232,41 @@ typedef struct {
 typedef uint8_t OperationCommand_t;
 
 /**
- * @brief Received CAN message
+ * @brief Master node operation status reception statistics of a slave
  */
 typedef struct {
-  uint16_t data[8]; /* message data buffer (8 bytes) */
-  uint16_t StdId;   /* CAN message standard ID */
-  uint8_t DLC;      /* can message data length code */
-} CANRxMessage_t;
+  uint32_t cycles;            /* command cycles closed (next command sent to the slave) */
+  uint32_t complete_cycles;   /* cycles that received all expected operation status frames */
+  uint32_t received;          /* operation status frames received */
+  uint32_t missed;            /* operation status frames never received in their cycle */
+  uint32_t timeouts;          /* operation status frames not received within their timeout */
+  uint32_t losses;            /* loss events: first timeout after frames were received on time */
+  uint32_t injected;          /* received frames discarded by MasterNode_InjectStatusLoss() */
+  uint32_t last_recovery_us;  /* last loss: detection to next received frame */
+  uint32_t max_recovery_us;   /* longest recovery */
+} MasterNode_SlaveStatistics_t;
 
 /**
- * @brief Node event
+ * @brief Master node operation status sequence statistics of a slave
  */
 typedef struct {
-  EventType_t type;  /*  event type */
-} Event_t;
+  uint32_t in_order;          /* frames received with the next sequence number */
+  uint32_t lost;              /* sequence numbers skipped, less the frames that arrived late */
+  uint32_t duplicates;        /* frames received again */
+  uint32_t reordered;         /* frames received after a newer one */
+  uint32_t bursts;            /* gaps: runs of consecutive lost frames */
+  uint32_t max_burst;         /* longest run of consecutive lost frames */
+  uint32_t burst_histogram[MASTER_NODE_BURST_BINS];   /* gap lengths, see MASTER_NODE_BURST_BINS */
+} MasterNode_SequenceStatistics_t;
 
 /**
- * @brief Node state handler event processing result
+ * @brief Master node latency histograms of a slave
  */
 typedef enum {
-  EVENT_IGNORED,  /* event was ignored by the current state handler */
-  EVENT_REQUEUE,  /* event was not processed by the current state handler, and should be added back to the event queue */
-  EVENT_HANDLED,  /* event was processed by the current state handler */
-} StateResult_t;
+  MASTER_NODE_LATENCY_COMMAND,  /* operation command TX complete to the first operation status received */
+  MASTER_NODE_LATENCY_STATUS,   /* operation status to the next one of the same command */
+  MASTER_NODE_LATENCY_NUMBER,
+} MasterNode_Latency_t;
 
 extern const OperationCommand_t OperationCommandOFF;
 extern const OperationCommand_t OperationCommandON;
@@ -112,4 +274,32 @@ extern const OperationCommand_t OperationCommandON;
 void MasterNode_Initialize(void);
 void SlaveNode_Initialize(void);
 
+uint8_t MasterNode_SetStatusRate(uint16_t frequency);
+uint16_t MasterNode_GetStatusRate(void);
+void MasterNode_GetStatusJitter(uint8_t slave, Jitter_Statistics_t *const statistics);
+void MasterNode_GetSlaveStatistics(uint8_t slave, MasterNode_SlaveStatistics_t *const statistics);
+void MasterNode_InjectStatusLoss(uint8_t slave, uint32_t frames);
+void MasterNode_GetSequenceStatistics(uint8_t slave, MasterNode_SequenceStatistics_t *const statistics);
+void MasterNode_GetLatencyHistogram(uint8_t slave, MasterNode_Latency_t latency, Histogram_t *const histogram);
+uint32_t MasterNode_GetCANErrors(uint32_t *const last_error);
+void MasterNode_GetEventLatency(EventLatency_t *const latency);
+uint32_t MasterNode_GetDroppedTimeEvents(void);
+uint8_t MasterNode_SubscribeFrames(EventPool_Subscriber_t subscriber);
+void MasterNode_SetActive(uint8_t active);
+uint8_t MasterNode_IsActive(void);
+void SlaveNode_GetStatusJitter(Jitter_Statistics_t *const statistics);
+void SlaveNode_GetEventLatency(EventLatency_t *const latency);
+uint32_t SlaveNode_GetDroppedTimeEvents(void);
+void SlaveNode_GetScheduleStatistics(ScheduleTable_Statistics_t *const statistics);
+uint8_t SlaveNode_SetId(uint8_t slave_id);
+uint8_t SlaveNode_GetId(void);
+void SlaveNode_SetActive(uint8_t active);
+uint8_t SlaveNode_IsActive(void);
+
+/* with event_channel.h (FreeRTOS), can2can.h stays usable by the host tools */
+#ifdef _EVENT_CHANNEL_H_
+void MasterNode_GetEventChannelStatistics(EventChannel_Statistics_t *const statistics);
+void SlaveNode_GetEventChannelStatistics(EventChannel_Statistics_t *const statistics);
+#endif /* _EVENT_CHANNEL_H_ */
+
 #endif /* _CAN2CAN_H_ */
\ No newline at end of file
@@ -0,0 +1,221 @@
+/* generated by Tools/dbc/dbc2c.py from can2can.dbc, do not edit */
+#ifndef _CAN2CAN_SIGNALS_H_
+#define _CAN2CAN_SIGNALS_H_
+
+#include <stdint.h>
+
+/* ClockSyncFrame: ID 0x0F0, DLC 8, sender Master, two-step clock synchronization, SYNC (2 bytes) then FOLLOW_UP (8 bytes) with the SYNC TX time */
+#define CLOCK_SYNC_FRAME_FRAME_ID         (0x0F0u)
+#define CLOCK_SYNC_FRAME_FRAME_DLC        (8u)
+#define CLOCK_SYNC_FRAME_TYPE_SYNC        (1u)
+#define CLOCK_SYNC_FRAME_TYPE_FOLLOW_UP   (2u)
+
+typedef struct {
+  uint8_t type; /* 0|8@1+ [1|2] */
+  uint8_t sequence; /* 8|8@1+ [0|255] */
+  uint64_t tx_time; /* 16|48@1+ [0|281474976710655] us */
+} ClockSyncFrame_Msg_t;
+
+static inline void ClockSyncFrame_Pack(const ClockSyncFrame_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(msg->type & 0xFFu);
+  data[1] = (uint8_t)(msg->sequence & 0xFFu);
+  data[2] = (uint8_t)(msg->tx_time & 0xFFu);
+  data[3] = (uint8_t)((msg->tx_time >> 8u) & 0xFFu);
+  data[4] = (uint8_t)((msg->tx_time >> 16u) & 0xFFu);
+  data[5] = (uint8_t)((msg->tx_time >> 24u) & 0xFFu);
+  data[6] = (uint8_t)((msg->tx_time >> 32u) & 0xFFu);
+  data[7] = (uint8_t)((msg->tx_time >> 40u) & 0xFFu);
+}
+
+static inline void ClockSyncFrame_Unpack(const uint8_t *const data, ClockSyncFrame_Msg_t *const msg) {
+  msg->type = (uint8_t)data[0];
+  msg->sequence = (uint8_t)data[1];
+  msg->tx_time = (uint64_t)((uint64_t)data[2] | ((uint64_t)data[3] << 8u) | ((uint64_t)data[4] << 16u) | ((uint64_t)data[5] << 24u) | ((uint64_t)data[6] << 32u) | ((uint64_t)data[7] << 40u));
+}
+
+/* OperationCommand: ID 0x300, DLC 6, sender Master, operation command, 0xAA: ON, 0x55: OFF, with the operation status rate until the next command, E2E protected, slave n uses ID + 2n */
+#define OPERATION_COMMAND_FRAME_ID        (0x300u)
+#define OPERATION_COMMAND_FRAME_DLC       (6u)
+
+typedef struct {
+  uint16_t e2e_crc; /* 0|16@1+ [0|65535] */
+  uint8_t e2e_counter; /* 16|4@1+ [0|15] */
+  uint8_t command; /* 24|8@1+ [0|255] */
+  uint16_t status_rate; /* 32|16@1+ [1|1000] Hz */
+} OperationCommand_Msg_t;
+
+static inline void OperationCommand_Pack(const OperationCommand_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(msg->e2e_crc & 0xFFu);
+  data[1] = (uint8_t)((msg->e2e_crc >> 8u) & 0xFFu);
+  data[2] = (uint8_t)(msg->e2e_counter & 0x0Fu);
+  data[3] = (uint8_t)(msg->command & 0xFFu);
+  data[4] = (uint8_t)(msg->status_rate & 0xFFu);
+  data[5] = (uint8_t)((msg->status_rate >> 8u) & 0xFFu);
+}
+
+static inline void OperationCommand_Unpack(const uint8_t *const data, OperationCommand_Msg_t *const msg) {
+  msg->e2e_crc = (uint16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8u));
+  msg->e2e_counter = (uint8_t)(data[2] & 0x0Fu);
+  msg->command = (uint8_t)data[3];
+  msg->status_rate = (uint16_t)((uint16_t)data[4] | ((uint16_t)data[5] << 8u));
+}
+
+/* OperationStatus: ID 0x301, DLC 6, sender Slave, operation status, sent at the commanded rate until the next operation command, E2E protected, slave n uses ID + 2n, sequence is optional (DLC 5 without it) */
+#define OPERATION_STATUS_FRAME_ID         (0x301u)
+#define OPERATION_STATUS_FRAME_DLC        (6u)
+#define OPERATION_STATUS_STATUS_OFF       (0u)
+#define OPERATION_STATUS_STATUS_ON        (1u)
+
+typedef struct {
+  uint16_t e2e_crc; /* 0|16@1+ [0|65535] */
+  uint8_t e2e_counter; /* 16|4@1+ [0|15] */
+  uint8_t status; /* 24|8@1+ [0|1] */
+  uint8_t value; /* 32|8@1+ [0|255] */
+  uint8_t sequence; /* 40|8@1+ [0|255] */
+} OperationStatus_Msg_t;
+
+static inline void OperationStatus_Pack(const OperationStatus_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(msg->e2e_crc & 0xFFu);
+  data[1] = (uint8_t)((msg->e2e_crc >> 8u) & 0xFFu);
+  data[2] = (uint8_t)(msg->e2e_counter & 0x0Fu);
+  data[3] = (uint8_t)(msg->status & 0xFFu);
+  data[4] = (uint8_t)(msg->value & 0xFFu);
+  data[5] = (uint8_t)(msg->sequence & 0xFFu);
+}
+
+static inline void OperationStatus_Unpack(const uint8_t *const data, OperationStatus_Msg_t *const msg) {
+  msg->e2e_crc = (uint16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8u));
+  msg->e2e_counter = (uint8_t)(data[2] & 0x0Fu);
+  msg->status = (uint8_t)data[3];
+  msg->value = (uint8_t)data[4];
+  msg->sequence = (uint8_t)data[5];
+}
+
+/* ConfigRequest: ID 0x7E0, DLC 3, sender Tool, configuration service request, applied live: status rate, slave ID, node roles (bit 0: master, bit 1: slave) */
+#define CONFIG_REQUEST_FRAME_ID           (0x7E0u)
+#define CONFIG_REQUEST_FRAME_DLC          (3u)
+#define CONFIG_REQUEST_SERVICE_SET_STATUS_RATE  (1u)
+#define CONFIG_REQUEST_SERVICE_SET_SLAVE_ID  (2u)
+#define CONFIG_REQUEST_SERVICE_SET_ROLES  (3u)
+#define CONFIG_REQUEST_SERVICE_GET_CONFIG  (4u)
+#define CONFIG_REQUEST_SERVICE_GET_LOAD   (5u)
+
+typedef struct {
+  uint8_t service; /* 0|8@1+ [1|5] */
+  uint16_t value; /* 8|16@1+ [0|65535] */
+} ConfigRequest_Msg_t;
+
+static inline void ConfigRequest_Pack(const ConfigRequest_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(msg->service & 0xFFu);
+  data[1] = (uint8_t)(msg->value & 0xFFu);
+  data[2] = (uint8_t)((msg->value >> 8u) & 0xFFu);
+}
+
+static inline void ConfigRequest_Unpack(const uint8_t *const data, ConfigRequest_Msg_t *const msg) {
+  msg->service = (uint8_t)data[0];
+  msg->value = (uint16_t)((uint16_t)data[1] | ((uint16_t)data[2] << 8u));
+}
+
+/* ConfigResponse: ID 0x7E1, DLC 8, sender Slave, configuration service response, with the time from request reception to the new configuration in effect, and the current configuration */
+#define CONFIG_RESPONSE_FRAME_ID          (0x7E1u)
+#define CONFIG_RESPONSE_FRAME_DLC         (8u)
+#define CONFIG_RESPONSE_RESULT_OK         (0u)
+#define CONFIG_RESPONSE_RESULT_INVALID    (1u)
+#define CONFIG_RESPONSE_RESULT_BUSY       (2u)
+#define CONFIG_RESPONSE_RESULT_UNKNOWN    (3u)
+
+typedef struct {
+  uint8_t service; /* 0|8@1+ [1|5] */
+  uint8_t result; /* 8|8@1+ [0|3] */
+  uint16_t latency; /* 16|16@1+ [0|65535] us */
+  uint16_t status_rate; /* 32|16@1+ [1|1000] Hz */
+  uint8_t slave_id; /* 48|8@1+ [0|31] */
+  uint8_t roles; /* 56|8@1+ [0|3] */
+} ConfigResponse_Msg_t;
+
+static inline void ConfigResponse_Pack(const ConfigResponse_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(msg->service & 0xFFu);
+  data[1] = (uint8_t)(msg->result & 0xFFu);
+  data[2] = (uint8_t)(msg->latency & 0xFFu);
+  data[3] = (uint8_t)((msg->latency >> 8u) & 0xFFu);
+  data[4] = (uint8_t)(msg->status_rate & 0xFFu);
+  data[5] = (uint8_t)((msg->status_rate >> 8u) & 0xFFu);
+  data[6] = (uint8_t)(msg->slave_id & 0xFFu);
+  data[7] = (uint8_t)(msg->roles & 0xFFu);
+}
+
+static inline void ConfigResponse_Unpack(const uint8_t *const data, ConfigResponse_Msg_t *const msg) {
+  msg->service = (uint8_t)data[0];
+  msg->result = (uint8_t)data[1];
+  msg->latency = (uint16_t)((uint16_t)data[2] | ((uint16_t)data[3] << 8u));
+  msg->status_rate = (uint16_t)((uint16_t)data[4] | ((uint16_t)data[5] << 8u));
+  msg->slave_id = (uint8_t)data[6];
+  msg->roles = (uint8_t)data[7];
+}
+
+/* LoadReport: ID 0x7E2, DLC 8, sender Slave, CPU load report, sent after the response to GET_LOAD: load of the last 1 s window, of the last 10 s window, peak window load, and bus load of the last 1 s window */
+#define LOAD_REPORT_FRAME_ID              (0x7E2u)
+#define LOAD_REPORT_FRAME_DLC             (8u)
+
+typedef struct {
+  uint16_t cpu_load; /* 0|16@1+ [0|100] % */
+  uint16_t cpu_load_long; /* 16|16@1+ [0|100] % */
+  uint16_t cpu_peak; /* 32|16@1+ [0|100] % */
+  uint16_t bus_load; /* 48|16@1+ [0|100] % */
+} LoadReport_Msg_t;
+
+static inline void LoadReport_Pack(const LoadReport_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(msg->cpu_load & 0xFFu);
+  data[1] = (uint8_t)((msg->cpu_load >> 8u) & 0xFFu);
+  data[2] = (uint8_t)(msg->cpu_load_long & 0xFFu);
+  data[3] = (uint8_t)((msg->cpu_load_long >> 8u) & 0xFFu);
+  data[4] = (uint8_t)(msg->cpu_peak & 0xFFu);
+  data[5] = (uint8_t)((msg->cpu_peak >> 8u) & 0xFFu);
+  data[6] = (uint8_t)(msg->bus_load & 0xFFu);
+  data[7] = (uint8_t)((msg->bus_load >> 8u) & 0xFFu);
+}
+
+static inline void LoadReport_Unpack(const uint8_t *const data, LoadReport_Msg_t *const msg) {
+  msg->cpu_load = (uint16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8u));
+  msg->cpu_load_long = (uint16_t)((uint16_t)data[2] | ((uint16_t)data[3] << 8u));
+  msg->cpu_peak = (uint16_t)((uint16_t)data[4] | ((uint16_t)data[5] << 8u));
+  msg->bus_load = (uint16_t)((uint16_t)data[6] | ((uint16_t)data[7] << 8u));
+}
+
+static inline float LoadReport_cpu_load_ToPhys(uint16_t raw) {
+  return (float)raw * 0.01f;
+}
+
+static inline uint16_t LoadReport_cpu_load_FromPhys(float phys) {
+  float raw = phys / 0.01f;
+  return (uint16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float LoadReport_cpu_load_long_ToPhys(uint16_t raw) {
+  return (float)raw * 0.01f;
+}
+
+static inline uint16_t LoadReport_cpu_load_long_FromPhys(float phys) {
+  float raw = phys / 0.01f;
+  return (uint16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float LoadReport_cpu_peak_ToPhys(uint16_t raw) {
+  return (float)raw * 0.01f;
+}
+
+static inline uint16_t LoadReport_cpu_peak_FromPhys(float phys) {
+  float raw = phys / 0.01f;
+  return (uint16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float LoadReport_bus_load_ToPhys(uint16_t raw) {
+  return (float)raw * 0.01f;
+}
+
+static inline uint16_t LoadReport_bus_load_FromPhys(float phys) {
+  float raw = phys / 0.01f;
+  return (uint16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+#endif /* _CAN2CAN_SIGNALS_H_ */
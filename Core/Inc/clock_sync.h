@@ -0,0 +1,76 @@
+#ifndef _CLOCK_SYNC_H_
+#define _CLOCK_SYNC_H_
+
+#include <stdint.h>
+
+/* SYNC -> FOLLOW_UP two-step protocol, the master captures the precise SYNC
+ * transmission time on TX complete, and sends it in the FOLLOW_UP frame. The
+ * slave pairs it with the SYNC reception time to estimate offset and drift */
+
+#define CLOCK_SYNC_PERIOD_MS              (1000u / CLOCK_SYNC_FREQUENCY)
+
+/* time between end of frame on the bus and the TX complete / RX pending ISR
+ * time stamps, the difference between both is subtracted from each sample */
+#define CLOCK_SYNC_RX_LATENCY_US          (0)
+
+/* drift estimation low-pass filter weight (1 / 2^N) */
+#define CLOCK_SYNC_DRIFT_FILTER_SHIFT     (3u)
+
+/* samples with a larger residual are rejected (late SYNC RX time stamp) */
+#define CLOCK_SYNC_OUTLIER_US             (500u)
+
+/* consecutive rejected samples before the slave drops its estimation and resynchronizes */
+#define CLOCK_SYNC_MAX_OUTLIERS           (3u)
+
+/**
+ * @brief Clock synchronization status, as seen by the slave
+ */
+typedef struct {
+  uint64_t ref_local_us;        /* local time of the last accepted SYNC */
+  uint64_t ref_master_us;       /* master time of the last accepted SYNC */
+  int32_t drift_ppb;            /* local clock rate error against master clock (parts per billion) */
+  int32_t residual_us;          /* last residual offset, (predicted - actual) master time */
+  uint32_t max_residual_us;     /* largest absolute residual offset since synchronized */
+  uint32_t sync_count;          /* accepted SYNC/FOLLOW_UP pairs */
+  uint32_t missed_count;        /* FOLLOW_UP frames without matching SYNC */
+  uint32_t outlier_count;       /* rejected samples */
+  uint8_t synchronized;         /* 1: offset and drift estimations are valid */
+} ClockSync_Status_t;
+
+/**
+ * @brief Clock synchronization transmission, as seen by the master. The
+ * frames are sent from the timer task without waiting for a mailbox
+ */
+typedef struct {
+  uint32_t sync_count;          /* SYNC frames sent */
+  uint32_t sync_busy;           /* periods without SYNC, both mailboxes busy */
+  uint32_t follow_up_errors;    /* FOLLOW_UP frames not sent, mailboxes busy or timer queue full */
+} ClockSync_MasterStatistics_t;
+
+void ClockSync_MasterInitialize(void);
+void ClockSync_SlaveInitialize(void);
+
+/**
+ * @brief Process a received clock sync frame, from an RX handler: the CAN
+ * service task or the CAN RX interrupt (BXCAN_USE_SERVICE_TASK)
+ *
+ * @param data [in] frame data
+ * @param len [in] frame data length
+ * @param rx_time_us [in] local reception time stamp
+ */
+void ClockSync_SlaveProcessFrame(const uint8_t *const data, uint8_t len, uint64_t rx_time_us);
+
+/**
+ * @brief Convert a local time stamp to master time
+ */
+uint64_t ClockSync_LocalToMaster(uint64_t local_us);
+
+/**
+ * @brief Current time in the shared (master) timebase
+ */
+uint64_t ClockSync_GetMasterTime(void);
+
+void ClockSync_GetStatus(ClockSync_Status_t *const status);
+void ClockSync_GetMasterStatistics(ClockSync_MasterStatistics_t *const statistics);
+
+#endif /* _CLOCK_SYNC_H_ */
@@ -0,0 +1,40 @@
+#ifndef _CONFIG_SERVICE_H_
+#define _CONFIG_SERVICE_H_
+
+#include <stdint.h>
+
+/* configuration service: requests received on CONFIG_SERVICE_REQUEST_STD_ID
+ * change the status rate, the slave ID and the node roles live, and are
+ * answered on CONFIG_SERVICE_RESPONSE_STD_ID with the result, the time from
+ * the request reception to the new configuration in effect, and the current
+ * configuration. Requests are applied one at a time in the timer task,
+ * requests received while one is pending are answered BUSY. The timer task
+ * doesn't wait for a mailbox, a response is dropped when both are busy */
+
+/**
+ * @brief Configuration service statistics
+ */
+typedef struct {
+  uint32_t requests;          /* requests applied */
+  uint32_t rejected;          /* invalid values or unknown services */
+  uint32_t busy;              /* requests received while one was pending */
+  uint32_t unsent;            /* responses and load reports not sent, mailboxes busy */
+  uint32_t last_latency_us;   /* last request: reception to configuration in effect */
+  uint32_t max_latency_us;    /* longest latency */
+} ConfigService_Statistics_t;
+
+void ConfigService_Initialize(void);
+
+/**
+ * @brief Process a received configuration request, from an RX handler: the
+ * CAN service task or the CAN RX interrupt (BXCAN_USE_SERVICE_TASK)
+ *
+ * @param data [in] frame data
+ * @param len [in] frame data length
+ * @param rx_time_us [in] local reception time stamp
+ */
+void ConfigService_ProcessFrame(const uint8_t *const data, uint8_t len, uint64_t rx_time_us);
+
+void ConfigService_GetStatistics(ConfigService_Statistics_t *const statistics);
+
+#endif /* _CONFIG_SERVICE_H_ */
@@ -0,0 +1,48 @@
+#ifndef _CPU_LOAD_H_
+#define _CPU_LOAD_H_
+
+#include <stdint.h>
+
+/* CPU load meter: the idle task's time is measured with the cycle counter,
+ * from the first idle hook call (vApplicationIdleHook()) after the idle task
+ * is switched in, to its switch out (traceTASK_SWITCHED_OUT). Tickless idle
+ * sleeps are added to the cycle counter, they count as idle. The accounted
+ * interrupt handlers (runtime_stats.h) that preempt the idle task are taken
+ * out of its time, they count as load. SysTick, PendSV, USART1 and its DMA
+ * channels aren't accounted, their cycles in the idle task count as idle,
+ * so the load is a lower bound. The tick hook
+ * ends the windows: the load of a window is the share of its cycles not
+ * spent in the idle task. The hooks never block or loop, the idle task
+ * still sleeps, and a window ends at the first tick after a sleep. This
+ * header is included by FreeRTOSConfig.h */
+
+#define CPU_LOAD_USE_METER          (1u)        /* 1: idle, tick and switch out hooks are compiled in */
+#define CPU_LOAD_WINDOW_MS          (1000u)
+#define CPU_LOAD_LONG_WINDOWS       (10u)       /* windows per long window (10 s) */
+#define CPU_LOAD_FULL_SCALE         (10000u)    /* loads are in 0.01 % */
+
+/**
+ * @brief CPU load, with the interrupt and bus load of the same windows
+ */
+typedef struct {
+  uint16_t load;              /* last window, 0.01 % */
+  uint16_t long_load;         /* last long window */
+  uint16_t peak_load;         /* highest window since the start */
+  uint16_t peak_bus_load;     /* bus load of the window with the peak load */
+  uint16_t isr_load;          /* accounted interrupt handlers (runtime_stats.h), last window */
+  uint16_t bus_load;          /* frames sent and received through bxCAN, last window, 0.01 % of the bit rate.
+                               * Other nodes' frames that the filters reject, error frames and stuff bits
+                               * aren't counted, it's the node's traffic, not the bus load */
+  uint32_t windows;           /* windows completed */
+  uint32_t window_cycles;     /* length of the last window, longer than CPU_LOAD_WINDOW_MS after a sleep */
+  uint32_t idle_cycles;       /* idle task, last window */
+} CpuLoad_Statistics_t;
+
+void CpuLoad_TaskSwitchedOut(void);
+void CpuLoad_GetStatistics(CpuLoad_Statistics_t *const statistics);
+
+#if (CPU_LOAD_USE_METER == 1u)
+#define traceTASK_SWITCHED_OUT()    CpuLoad_TaskSwitchedOut()
+#endif /* (CPU_LOAD_USE_METER == 1u) */
+
+#endif /* _CPU_LOAD_H_ */
@@ -0,0 +1,69 @@
+#ifndef _E2E_H_
+#define _E2E_H_
+
+#include <stdint.h>
+
+/* End to end protection of selected standard IDs, applied by the CAN driver:
+ * protected frames start with a CRC over the data ID (standard ID), DLC and
+ * the rest of the frame, followed by an alive counter. The CRC is the low
+ * 16 bits of the CRC-32 (0x04C11DB7, MSB first, init 0xFFFFFFFF) computed by
+ * the CRC peripheral */
+
+#define E2E_CRC_POS               (0u)      /* CRC, 16 bit, little endian */
+#define E2E_COUNTER_POS           (2u)      /* alive counter, low nibble */
+#define E2E_HEADER_SIZE           (3u)
+#define E2E_COUNTER_MASK          (0x0Fu)
+
+#define E2E_USE_HW_CRC            (1u)      /* 1: CRC peripheral, 0: table driven software CRC */
+#define E2E_BENCHMARK_FRAMES      (64u)
+
+/**
+ * @brief Result of the check of a frame (E2E_Check()), or state of a
+ * protected ID (E2E_GetStatus(): last check, or timeout)
+ */
+typedef enum {
+  E2E_STATUS_NONE,            /* nothing received yet */
+  E2E_STATUS_OK,              /* valid frame, counter advanced within the allowed delta */
+  E2E_STATUS_REPEATED,        /* valid frame, counter did not advance (stuck sender) */
+  E2E_STATUS_WRONG_SEQUENCE,  /* valid frame, counter jumped more than the allowed delta */
+  E2E_STATUS_ERROR,           /* CRC mismatch or frame too short */
+  E2E_STATUS_NO_NEW_DATA,     /* no valid frame within the timeout, after one was received */
+} E2E_Status_t;
+
+/**
+ * @brief Receive statistics of a protected ID
+ */
+typedef struct {
+  uint32_t ok_count;        /* frames with E2E_STATUS_OK */
+  uint32_t crc_errors;      /* frames with E2E_STATUS_ERROR */
+  uint32_t repeated;        /* frames with E2E_STATUS_REPEATED */
+  uint32_t wrong_sequence;  /* frames with E2E_STATUS_WRONG_SEQUENCE */
+  uint32_t lost_frames;     /* frames skipped by accepted counter jumps */
+  uint32_t timeouts;        /* transitions to E2E_STATUS_NO_NEW_DATA */
+} E2E_Statistics_t;
+
+/**
+ * @brief CRC cost per protected 8 byte frame, measured at initialization
+ */
+typedef struct {
+  uint32_t hw_cycles;   /* CRC peripheral, CPU cycles per frame */
+  uint32_t sw_cycles;   /* table driven software CRC, CPU cycles per frame */
+  uint8_t match;        /* 1: both CRCs agree on all benchmark frames */
+} E2E_Benchmark_t;
+
+void E2E_Initialize(void);
+void E2E_Protect(uint16_t std_id, uint8_t *const data, uint8_t len);
+E2E_Status_t E2E_Check(uint16_t std_id, const uint8_t *const data, uint8_t len);
+E2E_Status_t E2E_GetStatus(uint16_t std_id);
+
+/**
+ * @brief Check the timeouts of all protected IDs, called periodically by
+ * the master node. New timeouts are recorded by the trace recorder
+ *
+ * @return uint32_t ms until the next timeout can expire, UINT32_MAX: none
+ */
+uint32_t E2E_Supervise(void);
+void E2E_GetStatistics(uint16_t std_id, E2E_Statistics_t *const statistics);
+void E2E_GetBenchmark(E2E_Benchmark_t *const benchmark);
+
+#endif /* _E2E_H_ */
@@ -0,0 +1,99 @@
+#ifndef _EVENT_H_
+#define _EVENT_H_
+
+#include <stdint.h>
+
+#define EVENT_FRAME_MAX_SIZE    (8u)    /* CAN data bytes */
+
+/**
+ * @brief Node event type
+ */
+typedef enum {
+  NO_EVENT,     /* no event */
+  TIME_EVENT,   /* timer expired, and it's time to send the next operation command/operation status (TX scheduler: it was sent) */
+  CAN_TX_EVENT, /* operation command/operation status was transmitted successfully */
+  CAN_RX_EVENT, /* operation command/operation status status received */
+  CAN_ERROR_EVENT,  /* CAN error reported by the peripheral */
+  EVENT_TYPE_NUMBER,  /* number of event types, size of the state machine transition tables */
+} EventType_t;
+
+/**
+ * @brief Received frame, read from the RX FIFO by the ISR
+ */
+typedef struct {
+  uint16_t std_id;                      /* standard ID */
+  uint8_t len;                          /* data length code */
+  uint8_t e2e_status;                   /* E2E_Status_t of the frame, E2E_STATUS_OK: not protected */
+  uint8_t data[EVENT_FRAME_MAX_SIZE];   /* data */
+} EventFrame_t;
+
+/**
+ * @brief Transmitted frame
+ */
+typedef struct {
+  uint16_t std_id;                      /* standard ID of the transmitted frame */
+  uint8_t mailbox;                      /* TX mailbox that completed */
+} EventTx_t;
+
+/**
+ * @brief CAN error
+ */
+typedef struct {
+  uint32_t code;                        /* HAL_CAN_ERROR_x flags */
+} EventError_t;
+
+/**
+ * @brief Node event, carries everything its handler needs, so handlers don't
+ * access the peripherals, and recorded events can be replayed
+ */
+typedef struct {
+  EventType_t type;         /*  event type */
+  uint64_t timestamp_us;    /* time the event was generated (Timebase_GetMicros()), 0: not time stamped */
+  union {
+    EventFrame_t frame;     /* CAN_RX_EVENT */
+    EventTx_t tx;           /* CAN_TX_EVENT */
+    EventError_t error;     /* CAN_ERROR_EVENT */
+  } payload;
+} Event_t;
+
+/**
+ * @brief Event latency, from the event time stamp to its dispatch to the
+ * node state machine
+ */
+typedef struct {
+  uint32_t count;           /* time stamped events dispatched */
+  uint32_t last_us;         /* latency of the last event */
+  uint32_t max_us;          /* longest latency */
+  uint64_t total_us;        /* sum of latencies, average: total_us / count */
+} EventLatency_t;
+
+/**
+ * @brief Add an event's latency to the latency statistics
+ *
+ * @param latency [in] latency statistics
+ * @param pEvent [in] dispatched event, not time stamped events are ignored
+ * @param now_us [in] dispatch time
+ */
+static inline void EventLatency_Update(EventLatency_t *const latency, const Event_t *const pEvent, uint64_t now_us) {
+  if ((pEvent->timestamp_us == 0) || (pEvent->timestamp_us > now_us)) {
+    return;
+  }
+
+  latency->last_us = (uint32_t)(now_us - pEvent->timestamp_us);
+  latency->total_us += latency->last_us;
+  latency->count++;
+  if (latency->last_us > latency->max_us) {
+    latency->max_us = latency->last_us;
+  }
+}
+
+/**
+ * @brief Node state handler event processing result
+ */
+typedef enum {
+  EVENT_IGNORED,  /* event was ignored by the current state handler */
+  EVENT_REQUEUE,  /* event was not processed by the current state handler, and should be added back to the event queue */
+  EVENT_HANDLED,  /* event was processed by the current state handler */
+} StateResult_t;
+
+#endif /* _EVENT_H_ */
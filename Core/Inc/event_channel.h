@@ -0,0 +1,59 @@
+#ifndef _EVENT_CHANNEL_H_
+#define _EVENT_CHANNEL_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event.h"
+
+/* single consumer event channel: producers (tasks and ISRs) reserve a slot
+ * of a ring of pool event pointers (event_pool.h) with LDREX/STREX, write the
+ * pointer, and set the channel's bit in the consumer task's notification
+ * value. No critical section and no copy through a queue. Events are received
+ * in slot reservation order (FIFO, as with a queue): the consumer stops at a
+ * reserved slot until its producer has written it */
+
+#define EVENT_CHANNEL_BENCHMARK_PASSES  (16u)
+
+/**
+ * @brief Channel statistics
+ */
+typedef struct {
+  uint32_t posted;              /* events posted (the head) */
+  uint32_t full;                /* events not posted, no free slot */
+  uint32_t high_water;          /* most events waiting, seen by the consumer */
+} EventChannel_Statistics_t;
+
+/**
+ * @brief Post and receive cost, channel vs FreeRTOS queue of event pointers,
+ * measured at the first channel initialization (no task switch)
+ */
+typedef struct {
+  uint32_t channel_post_cycles;     /* CPU cycles per post, notification included */
+  uint32_t channel_receive_cycles;  /* CPU cycles per receive, event waiting */
+  uint32_t queue_post_cycles;       /* CPU cycles per xQueueSend() */
+  uint32_t queue_receive_cycles;    /* CPU cycles per xQueueReceive(), event waiting */
+} EventChannel_Benchmark_t;
+
+/**
+ * @brief Event channel
+ */
+typedef struct {
+  Event_t **ring;               /* slots, NULL: free, or reserved and not written yet */
+  uint32_t size;                /* slots, power of 2 */
+  volatile uint32_t head;       /* next slot to reserve, runs freely */
+  volatile uint32_t tail;       /* next slot to receive, runs freely */
+  TaskHandle_t task;            /* consumer */
+  uint32_t bit;                 /* notification bit of the channel */
+  uint8_t number;               /* trace object number (Trace_Object_t) */
+  EventChannel_Statistics_t statistics;
+} EventChannel_t;
+
+void EventChannel_Initialize(EventChannel_t *const channel, Event_t **const storage, uint32_t size, TaskHandle_t task, uint32_t bit, uint8_t number);
+BaseType_t EventChannel_Post(EventChannel_t *const channel, Event_t *const pEvent);
+BaseType_t EventChannel_PostFromISR(EventChannel_t *const channel, Event_t *const pEvent, BaseType_t *const pxTaskWoken);
+Event_t *EventChannel_Receive(EventChannel_t *const channel, TickType_t wait);
+void EventChannel_GetStatistics(const EventChannel_t *const channel, EventChannel_Statistics_t *const statistics);
+void EventChannel_GetBenchmark(EventChannel_Benchmark_t *const benchmark);
+
+#endif /* _EVENT_CHANNEL_H_ */
@@ -0,0 +1,43 @@
+#ifndef _EVENT_POOL_H_
+#define _EVENT_POOL_H_
+
+#include <stdint.h>
+#include "event.h"
+
+/* fixed block pool of reference counted events, safe from tasks and ISRs.
+ * Queues carry event pointers instead of event copies: the producer allocates
+ * an event (1 reference) and fills it in place, each queue an event is posted
+ * to holds one reference, and each consumer releases its reference once the
+ * event is processed. The block is returned to the pool with the last
+ * reference, so an event can be published to several consumers without copies */
+
+#define EVENT_POOL_SIZE           (16u)     /* blocks, shared by all producers */
+#define EVENT_POOL_MAX_REFERENCES (255u)
+
+/**
+ * @brief Event subscriber, receives one reference to the event, which it
+ * must release once the event is processed. May be called from an ISR
+ */
+typedef void (*EventPool_Subscriber_t)(Event_t *const pEvent);
+
+/**
+ * @brief Event pool statistics
+ */
+typedef struct {
+  uint32_t allocated;       /* events allocated */
+  uint32_t failed;          /* allocations failed, pool empty */
+  uint32_t in_use;          /* blocks allocated now */
+  uint32_t high_water;      /* most blocks allocated at the same time */
+  uint32_t shared;          /* references added to allocated events (EventPool_Ref()) */
+  uint32_t max_references;  /* most references held on one shared event at the same time */
+  uint32_t last_cycles;     /* CPU cycles of the last allocation */
+  uint32_t max_cycles;      /* CPU cycles of the longest allocation */
+} EventPool_Statistics_t;
+
+void EventPool_Initialize(void);
+Event_t *EventPool_Alloc(EventType_t type);
+Event_t *EventPool_Ref(Event_t *const pEvent);
+void EventPool_Release(Event_t *const pEvent);
+void EventPool_GetStatistics(EventPool_Statistics_t *const statistics);
+
+#endif /* _EVENT_POOL_H_ */
@@ -0,0 +1,43 @@
+#ifndef _EXECUTIVE_H_
+#define _EXECUTIVE_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "event.h"
+
+/* run to completion executive: node state machines share a single task and
+ * a single event queue. Events are dispatched one at a time, highest node
+ * priority first, FIFO within a node. Event slots are shared by all nodes,
+ * and hold pool events (event_pool.h), released after their dispatch */
+
+#define EXECUTIVE_TASK_PRIORITY       (3u)
+#define EXECUTIVE_TASK_STACK_DEPTH    (160u)
+
+#define EXECUTIVE_MAX_NODES           (2u)
+#define EXECUTIVE_MAX_EVENTS          (16u)
+
+/**
+ * @brief Node hosted by the executive
+ */
+typedef struct {
+  void (*start)(void);                            /* called once by the executive task before the first event, NULL: none */
+  void (*dispatch)(const Event_t *const pEvent);  /* run one event to completion */
+  TickType_t (*poll)(void);                       /* called before waiting for events, returns ticks to the node's next deadline (portMAX_DELAY: none), NULL: none */
+} Executive_Node_t;
+
+/**
+ * @brief Executive statistics
+ */
+typedef struct {
+  uint32_t dispatched;      /* events dispatched */
+  uint32_t dropped;         /* events not posted, no free event slot */
+  uint32_t max_queued;      /* most events queued at the same time */
+} Executive_Statistics_t;
+
+void Executive_Initialize(void);
+uint8_t Executive_Register(const Executive_Node_t *const node, UBaseType_t priority);
+BaseType_t Executive_Post(uint8_t node_id, Event_t *const pEvent);
+BaseType_t Executive_PostFromISR(uint8_t node_id, Event_t *const pEvent, BaseType_t *const pxTaskWoken);
+void Executive_GetStatistics(Executive_Statistics_t *const statistics);
+
+#endif /* _EXECUTIVE_H_ */
@@ -0,0 +1,30 @@
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include <stdint.h>
+
+/* latency histogram with logarithmic bins: bin 0 collects latencies below
+ * HISTOGRAM_FIRST_BIN_US, each next bin is twice as wide as the previous one,
+ * and the last bin collects everything above. Not thread safe, callers
+ * serialize access */
+
+#define HISTOGRAM_BINS            (16u)
+#define HISTOGRAM_FIRST_BIN_US    (64u)   /* power of 2, bin n > 0: [64 << (n - 1), 64 << n) us */
+
+/**
+ * @brief Latency histogram
+ */
+typedef struct {
+  uint32_t count;                       /* latencies added */
+  uint32_t min_us;                      /* shortest latency */
+  uint32_t max_us;                      /* longest latency */
+  uint64_t total_us;                    /* sum of latencies, average: total_us / count */
+  uint32_t bins[HISTOGRAM_BINS];        /* latencies per bin */
+} Histogram_t;
+
+void Histogram_Initialize(Histogram_t *const histogram);
+void Histogram_Add(Histogram_t *const histogram, uint32_t latency_us);
+uint32_t Histogram_GetBinUpperEdge(uint32_t bin);
+uint32_t Histogram_GetPercentile(const Histogram_t *const histogram, uint32_t percent);
+
+#endif /* _HISTOGRAM_H_ */
@@ -0,0 +1,100 @@
+#ifndef _HSM_H_
+#define _HSM_H_
+
+#include <stdint.h>
+#include "event.h"
+
+/* table driven hierarchical state machine: states and their transitions are
+ * const tables (flash), each state has one transition per event type, so an
+ * event is dispatched by indexing the current state's table, then its
+ * parents' tables if the state doesn't handle it. Events can be deferred by
+ * returning EVENT_REQUEUE from a transition action, they're recalled after
+ * the next state change */
+
+#define HSM_NO_STATE              (0xFFu)   /* no parent, no initial sub-state */
+#define HSM_MAX_DEPTH             (4u)      /* state nesting levels */
+#define HSM_DEFERRED_EVENTS       (4u)
+
+typedef uint8_t Hsm_StateId_t;
+
+/**
+ * @brief Transition action, returns EVENT_HANDLED to take the transition,
+ * EVENT_IGNORED to pass the event to the parent state, or EVENT_REQUEUE to
+ * defer it
+ */
+typedef StateResult_t (*Hsm_Action_t)(const Event_t *const pEvent);
+
+/**
+ * @brief Transition guard, evaluated after the action, selects the target of
+ * a choice transition: 1: target, 0: otherwise
+ */
+typedef uint8_t (*Hsm_Guard_t)(void);
+
+/**
+ * @brief State entry/exit action
+ */
+typedef void (*Hsm_EntryExit_t)(void);
+
+/**
+ * @brief Transition kind
+ */
+typedef enum {
+  HSM_TRANSITION_NONE,      /* event not handled by the state, passed to the parent state */
+  HSM_TRANSITION_INTERNAL,  /* action only, no exit/entry */
+  HSM_TRANSITION_EXTERNAL,  /* action, then exit to target state */
+} Hsm_TransitionType_t;
+
+/**
+ * @brief Transition table entry
+ */
+typedef struct {
+  Hsm_Action_t action;        /* NULL: no action */
+  Hsm_Guard_t guard;          /* NULL: always target */
+  uint8_t type;               /* Hsm_TransitionType_t */
+  Hsm_StateId_t target;       /* target state */
+  Hsm_StateId_t otherwise;    /* target state when the guard fails */
+} Hsm_Transition_t;
+
+/**
+ * @brief State definition
+ */
+typedef struct {
+  Hsm_StateId_t parent;                   /* HSM_NO_STATE: top level state */
+  Hsm_StateId_t initial;                  /* sub-state entered with the state, HSM_NO_STATE: leaf state */
+  Hsm_EntryExit_t entry;                  /* NULL: no entry action */
+  Hsm_EntryExit_t exit;                   /* NULL: no exit action */
+  const Hsm_Transition_t *transitions;    /* EVENT_TYPE_NUMBER entries indexed by event type, NULL: none */
+} Hsm_State_t;
+
+/**
+ * @brief State machine instance
+ */
+typedef struct {
+  const Hsm_State_t *states;                  /* state table, indexed by state ID */
+  Hsm_StateId_t current;                      /* current (leaf) state */
+  Event_t deferred[HSM_DEFERRED_EVENTS];      /* deferred events, FIFO */
+  uint8_t deferred_head;
+  uint8_t deferred_count;
+  uint32_t deferred_dropped;                  /* events not deferred, deferred events FIFO full */
+} Hsm_t;
+
+/* transition table entries */
+#define HSM_INTERNAL(action_) \
+  { .type = HSM_TRANSITION_INTERNAL, .action = (action_), .guard = NULL, .target = HSM_NO_STATE, .otherwise = HSM_NO_STATE }
+
+#define HSM_EXTERNAL(action_, target_) \
+  { .type = HSM_TRANSITION_EXTERNAL, .action = (action_), .guard = NULL, .target = (target_), .otherwise = (target_) }
+
+#define HSM_CHOICE(action_, guard_, target_, otherwise_) \
+  { .type = HSM_TRANSITION_EXTERNAL, .action = (action_), .guard = (guard_), .target = (target_), .otherwise = (otherwise_) }
+
+#define HSM_DEFER \
+  HSM_INTERNAL(Hsm_DeferEvent)
+
+void Hsm_Initialize(Hsm_t *const hsm, const Hsm_State_t *const states, Hsm_StateId_t initial);
+void Hsm_Dispatch(Hsm_t *const hsm, const Event_t *const pEvent);
+Hsm_StateId_t Hsm_GetState(const Hsm_t *const hsm);
+uint8_t Hsm_IsIn(const Hsm_t *const hsm, Hsm_StateId_t state);
+StateResult_t Hsm_DeferEvent(const Event_t *const pEvent);
+
+#endif /* _HSM_H_ */
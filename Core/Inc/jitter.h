@@ -0,0 +1,42 @@
+#ifndef _JITTER_H_
+#define _JITTER_H_
+
+#include <stdint.h>
+
+/* period jitter of a cyclic event: deviation of each measured period from
+ * the nominal period. Not thread safe, callers serialize access */
+
+#define JITTER_HISTOGRAM_BINS     (32u)
+#define JITTER_BIN_WIDTH_US       (50u)   /* last bin collects everything above */
+
+/**
+ * @brief Period jitter statistics
+ */
+typedef struct {
+  int32_t min_us;     /* shortest period - nominal period */
+  int32_t max_us;     /* longest period - nominal period */
+  int32_t avg_us;     /* average period - nominal period */
+  uint32_t p99_us;    /* 99th percentile of the absolute jitter (histogram bin upper edge) */
+  uint32_t count;     /* measured periods */
+} Jitter_Statistics_t;
+
+/**
+ * @brief Period jitter accumulator
+ */
+typedef struct {
+  uint32_t nominal_us;                          /* nominal period */
+  uint64_t last_us;                             /* time stamp of the last event */
+  uint8_t running;                              /* last_us is valid */
+  int32_t min_us;                               /* shortest period - nominal period */
+  int32_t max_us;                               /* longest period - nominal period */
+  int64_t sum_us;                               /* sum of period - nominal period */
+  uint32_t count;                               /* measured periods */
+  uint32_t histogram[JITTER_HISTOGRAM_BINS];    /* absolute jitter histogram */
+} Jitter_t;
+
+void Jitter_Initialize(Jitter_t *const jitter, uint32_t nominal_us);
+void Jitter_Restart(Jitter_t *const jitter, uint32_t nominal_us);
+void Jitter_Update(Jitter_t *const jitter, uint64_t timestamp_us);
+void Jitter_GetStatistics(const Jitter_t *const jitter, Jitter_Statistics_t *const statistics);
+
+#endif /* _JITTER_H_ */
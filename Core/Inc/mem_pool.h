@@ -0,0 +1,70 @@
+#ifndef _MEM_POOL_H_
+#define _MEM_POOL_H_
+
+#include <stdint.h>
+
+/* lock free fixed block memory pool, safe from tasks and ISRs. Blocks of a
+ * few size classes for buffers passed between an interrupt and a task,
+ * instead of a separately sized static buffer for each. The SLCAN gateway is
+ * the only user: the CAN service RX rings are written in place without
+ * allocation, and the event pool keeps its own cleared, reference counted
+ * 24 byte events, which would take 32 byte blocks here. The free blocks of a
+ * class are a stack linked through the blocks themselves, allocation pops
+ * and release pushes its head with LDREX/STREX, interrupts are never masked.
+ * An allocation takes a block of the smallest class that fits, or of a
+ * larger one when that class is empty. Unlike the event pool (event_pool.h),
+ * blocks aren't cleared and aren't reference counted */
+
+#define MEM_POOL_SMALL_SIZE       (16u)     /* bytes, multiple of 8: CAN frame with its time stamp */
+#define MEM_POOL_SMALL_BLOCKS     (24u)
+#define MEM_POOL_MEDIUM_SIZE      (32u)
+#define MEM_POOL_MEDIUM_BLOCKS    (8u)
+#define MEM_POOL_LARGE_SIZE       (64u)
+#define MEM_POOL_LARGE_BLOCKS     (4u)
+
+#define MEM_POOL_BENCHMARK_PASSES (16u)
+
+/**
+ * @brief Size classes, by block size
+ */
+typedef enum {
+  MEM_POOL_SMALL,
+  MEM_POOL_MEDIUM,
+  MEM_POOL_LARGE,
+  MEM_POOL_CLASS_NUMBER,
+} MemPool_Class_t;
+
+/**
+ * @brief Statistics of a size class
+ */
+typedef struct {
+  uint32_t block_size;      /* bytes */
+  uint32_t blocks;
+  uint32_t allocated;       /* blocks allocated from the class */
+  uint32_t fallbacks;       /* requests of the class served by a larger class, the class was empty */
+  uint32_t failed;          /* requests of the class not served, the class and the larger ones were empty */
+  uint32_t in_use;          /* blocks allocated now */
+  uint32_t high_water;      /* most blocks allocated at the same time */
+} MemPool_Statistics_t;
+
+/**
+ * @brief Allocation and release cost of a small block, lock free pool vs
+ * free list in a critical section, and copy of a small block through a
+ * FreeRTOS queue, measured at initialization (no contention, no task switch)
+ */
+typedef struct {
+  uint32_t pool_alloc_cycles;       /* CPU cycles per MemPool_Alloc() */
+  uint32_t pool_free_cycles;        /* CPU cycles per MemPool_Free() */
+  uint32_t list_alloc_cycles;       /* CPU cycles per allocation, critical section free list */
+  uint32_t list_free_cycles;        /* CPU cycles per release, critical section free list */
+  uint32_t queue_send_cycles;       /* CPU cycles per xQueueSend(), block copied in */
+  uint32_t queue_receive_cycles;    /* CPU cycles per xQueueReceive(), block copied out */
+} MemPool_Benchmark_t;
+
+void MemPool_Initialize(void);
+void *MemPool_Alloc(uint32_t size);
+void MemPool_Free(void *const block);
+void MemPool_GetStatistics(MemPool_Class_t pool_class, MemPool_Statistics_t *const statistics);
+void MemPool_GetBenchmark(MemPool_Benchmark_t *const benchmark);
+
+#endif /* _MEM_POOL_H_ */
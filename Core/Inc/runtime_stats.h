@@ -0,0 +1,77 @@
+#ifndef _RUNTIME_STATS_H_
+#define _RUNTIME_STATS_H_
+
+#include <stdint.h>
+#include "timebase.h"
+#include "trace.h"
+
+/* run time statistics in CPU cycles: the FreeRTOS run time counter is the
+ * DWT cycle counter, and the CAN, TIM1 and TIM2 interrupt handlers account their
+ * own cycles. Counters are 32 bit and wrap every 2^32 cycles (536 s at
+ * 8 MHz), statistics are reported per window (since the previous snapshot)
+ * as differences, which are exact as long as the window is shorter than a
+ * wrap. Task cycles include the interrupts that preempted the task, and
+ * interrupt cycles include the higher priority interrupts nested in them */
+
+#define RUNTIME_STATS_MAX_TASKS       (8u)
+#define RUNTIME_STATS_NAME_SIZE       (7u)    /* task name characters in the snapshot, not terminated */
+#define RUNTIME_STATS_VERSION         (1u)
+
+/* snapshot layout, little endian:
+ * header:        version (1), tasks (1), interrupts (1), flags (1), window cycles (4)
+ * per interrupt: count (4), window cycles (4), longest run cycles (4)
+ * per task:      task number (1), state (1), priority (1), stack high water mark in words (2),
+ *                window cycles (4), name (RUNTIME_STATS_NAME_SIZE) */
+#define RUNTIME_STATS_HEADER_SIZE     (8u)
+#define RUNTIME_STATS_ISR_SIZE        (12u)
+#define RUNTIME_STATS_TASK_SIZE       (9u + RUNTIME_STATS_NAME_SIZE)
+#define RUNTIME_STATS_SNAPSHOT_SIZE   (RUNTIME_STATS_HEADER_SIZE + (RUNTIME_STATS_ISR_NUMBER * RUNTIME_STATS_ISR_SIZE) \
+                                      + (RUNTIME_STATS_MAX_TASKS * RUNTIME_STATS_TASK_SIZE))
+
+#define RUNTIME_STATS_FLAG_WRAPPED    (0x01u)   /* window longer than a counter wrap, window cycles are not valid */
+#define RUNTIME_STATS_FLAG_TRUNCATED  (0x02u)   /* more than RUNTIME_STATS_MAX_TASKS tasks, no task records */
+
+/**
+ * @brief Accounted interrupt handlers
+ */
+typedef enum {
+  RUNTIME_STATS_ISR_CAN_TX,
+  RUNTIME_STATS_ISR_CAN_RX0,
+  RUNTIME_STATS_ISR_CAN_RX1,
+  RUNTIME_STATS_ISR_CAN_SCE,
+  RUNTIME_STATS_ISR_TIM1,
+  RUNTIME_STATS_ISR_TIM2,
+  RUNTIME_STATS_ISR_NUMBER,
+} RuntimeStats_Isr_t;
+
+/**
+ * @brief Interrupt handler accounting
+ */
+typedef struct {
+  uint32_t count;           /* runs */
+  uint32_t cycles;          /* CPU cycles, wraps */
+  uint32_t max_cycles;      /* longest run */
+  uint32_t max_latency;     /* request to handler entry in CPU cycles, longest, 0: not measured */
+} RuntimeStats_IsrStatistics_t;
+
+/**
+ * @brief Start of an interrupt handler, recorded by the trace recorder if
+ * the handler is in TRACE_ISR_MASK
+ *
+ * @param isr [in] interrupt handler
+ * @return uint32_t start, to pass to RuntimeStats_IsrExit()
+ */
+static inline uint32_t RuntimeStats_IsrEnter(RuntimeStats_Isr_t isr) {
+  if ((TRACE_ISR_MASK & (1u << isr)) != 0) {
+    Trace_Record(TRACE_EVENT_ISR_ENTER, (uint8_t)isr, 0);
+  }
+
+  return Timebase_GetCycles();
+}
+
+void RuntimeStats_IsrExit(RuntimeStats_Isr_t isr, uint32_t start);
+void RuntimeStats_IsrLatency(RuntimeStats_Isr_t isr, uint32_t cycles);
+void RuntimeStats_GetIsrStatistics(RuntimeStats_Isr_t isr, RuntimeStats_IsrStatistics_t *const statistics);
+uint16_t RuntimeStats_Snapshot(uint8_t *const buffer, uint16_t size);
+
+#endif /* _RUNTIME_STATS_H_ */
@@ -0,0 +1,117 @@
+#ifndef _SCHEDULE_TABLE_H_
+#define _SCHEDULE_TABLE_H_
+
+#include <stdint.h>
+
+/* schedule tables (OSEK/AUTOSAR OS style): a communication cycle of fixed
+ * duration, described by a const table in flash. Each message of the table
+ * has an offset and a period within the cycle, its expiry points are
+ * offset + k * period, per slave messages are shifted by a stride for each
+ * slave. A node runs the table for its own messages: at each expiry point
+ * its frame producer builds the frame, which is released at that time (TX
+ * scheduler). Sync points are messages whose reception aligns the cycle of
+ * the receivers to the sender's: deviations within the precision are
+ * corrected a bounded step per sync point, larger ones restart the table at
+ * the sync point. The engine has no kernel or HAL dependency, the host
+ * simulator (Tools/schedule_sim) runs the same tables */
+
+#define SCHEDULE_TABLE_FLAG_PER_SLAVE   (0x01u)   /* one frame per slave, slave n at n strides and n ID ranges */
+#define SCHEDULE_TABLE_FLAG_SYNC        (0x02u)   /* sync point of the slaves, once per cycle (period 0) */
+
+/* worst case standard data frame length, with stuff bits and IFS */
+#define SCHEDULE_TABLE_FRAME_BITS(len)  (47u + (8u * (len)) + ((34u + (8u * (len)) - 1u) / 4u))
+#define SCHEDULE_TABLE_FRAME_US(len, bit_rate) \
+  (((SCHEDULE_TABLE_FRAME_BITS(len) * 1000000u) + (bit_rate) - 1u) / (bit_rate))
+
+/**
+ * @brief Schedule table states
+ */
+typedef enum {
+  SCHEDULE_TABLE_STOPPED,
+  SCHEDULE_TABLE_WAITING,                   /* started, waiting for the first sync point */
+  SCHEDULE_TABLE_RUNNING,                   /* running, restarted at the last sync point (or never synchronized) */
+  SCHEDULE_TABLE_RUNNING_AND_SYNCHRONOUS,   /* running, the last sync point was within the precision */
+} ScheduleTable_State_t;
+
+/**
+ * @brief Sending node of a message
+ */
+typedef enum {
+  SCHEDULE_TABLE_SENDER_MASTER,   /* per slave messages: the master sends one to each slave */
+  SCHEDULE_TABLE_SENDER_SLAVE,    /* per slave messages: each slave sends its own, others: slave 0 */
+} ScheduleTable_Sender_t;
+
+/**
+ * @brief Message of a schedule table
+ */
+typedef struct {
+  uint32_t offset_us;         /* first expiry point, from the start of the cycle */
+  uint32_t period_us;         /* expiry points repeat with this period within the cycle, 0: once */
+  uint32_t slave_stride_us;   /* per slave messages, offset between consecutive slaves */
+  uint16_t std_id;            /* frame, of slave 0 for per slave messages */
+  uint8_t len;                /* data length */
+  uint8_t sender;             /* ScheduleTable_Sender_t */
+  uint8_t flags;              /* SCHEDULE_TABLE_FLAG_x */
+} ScheduleTable_Message_t;
+
+/**
+ * @brief Schedule table, const
+ */
+typedef struct {
+  uint32_t duration_us;       /* cycle */
+  uint32_t bit_rate;          /* bits/s, frame lengths (sync point reception) */
+  uint32_t precision_us;      /* largest deviation corrected without restarting the table */
+  uint32_t max_adjust_us;     /* largest correction per sync point */
+  uint16_t id_stride;         /* per slave messages, ID offset between consecutive slaves */
+  uint8_t slave_number;
+  uint8_t message_number;
+  const ScheduleTable_Message_t *messages;
+} ScheduleTable_t;
+
+/**
+ * @brief Expiry point of a node
+ */
+typedef struct {
+  uint64_t release_us;        /* local time */
+  uint32_t offset_us;         /* in the cycle */
+  uint16_t std_id;
+  uint8_t len;
+  uint8_t message;            /* index in the table */
+  uint8_t slave;              /* slave the frame belongs to, per slave messages */
+} ScheduleTable_ExpiryPoint_t;
+
+/**
+ * @brief Synchronization statistics of a running table
+ */
+typedef struct {
+  uint32_t cycles;            /* cycles started */
+  uint32_t syncs;             /* sync points received */
+  uint32_t adjusted;          /* sync points within the precision, corrected */
+  uint32_t restarts;          /* sync points out of the precision (or the first), table restarted */
+  int32_t last_deviation_us;  /* sync point reception to its expected time, positive: the table was early */
+  uint32_t max_deviation_us;  /* largest absolute deviation corrected */
+} ScheduleTable_Statistics_t;
+
+/**
+ * @brief Table run by a node
+ */
+typedef struct {
+  const ScheduleTable_t *table;
+  uint8_t sender;             /* ScheduleTable_Sender_t, messages of the node */
+  uint8_t slave;              /* slave ID of a slave node */
+  uint8_t state;              /* ScheduleTable_State_t */
+  uint64_t start_us;          /* start of the current cycle, local time */
+  uint64_t position;          /* key of the last expiry point (offset, message, slave), 0: start of the cycle */
+  ScheduleTable_Statistics_t statistics;
+} ScheduleTable_Run_t;
+
+void ScheduleTable_Start(ScheduleTable_Run_t *const run, const ScheduleTable_t *const table, uint8_t sender, uint8_t slave,
+  uint64_t start_us);
+void ScheduleTable_StartSynchronized(ScheduleTable_Run_t *const run, const ScheduleTable_t *const table, uint8_t sender,
+  uint8_t slave);
+void ScheduleTable_Stop(ScheduleTable_Run_t *const run);
+uint8_t ScheduleTable_Next(ScheduleTable_Run_t *const run, ScheduleTable_ExpiryPoint_t *const point);
+uint32_t ScheduleTable_Count(const ScheduleTable_Run_t *const run);
+uint8_t ScheduleTable_Sync(ScheduleTable_Run_t *const run, uint8_t message, uint8_t slave, uint64_t sync_us);
+
+#endif /* _SCHEDULE_TABLE_H_ */
@@ -0,0 +1,87 @@
+#ifndef _SIGNAL_DB_H_
+#define _SIGNAL_DB_H_
+
+#include <stdint.h>
+#include "can2can.h"
+
+/* RAM signal database: typed values published by the nodes, observable by
+ * anyone. Each signal has a single writer (a task), values are protected by
+ * a sequence counter (seqlock): the writer makes it odd while the value is
+ * updated, readers copy the value without locking and retry if the counter
+ * changed. Subscribers are notified of changed signals from the timer task,
+ * changes are batched: a signal written several times within a tick is
+ * notified once */
+
+#define SIGNAL_DB_MAX_SIZE          (4u)    /* largest signal value, bytes */
+#define SIGNAL_DB_SUBSCRIBERS       (4u)
+#define SIGNAL_DB_READ_RETRIES      (4u)    /* a reader preempting the writer can't wait for it */
+#define SIGNAL_DB_BENCHMARK_PASSES  (64u)
+
+/**
+ * @brief Signals, SIGNAL_MASTER_STATUS_OF(slave) for each polled slave
+ */
+typedef enum {
+  SIGNAL_SLAVE_COMMAND,   /* OperationCommand_t, last operation command received by the slave node */
+  SIGNAL_SLAVE_STATUS,    /* OperationStatus_t, slave device status */
+  SIGNAL_MASTER_STATUS,   /* OperationStatus_t, last valid operation status received by the master node (slave 0) */
+  SIGNAL_NUMBER = SIGNAL_MASTER_STATUS + CAN2CAN_SLAVE_NUMBER,
+} SignalDb_Id_t;
+
+#define SIGNAL_MASTER_STATUS_OF(slave)  ((SignalDb_Id_t)(SIGNAL_MASTER_STATUS + (slave)))
+
+/**
+ * @brief Signal value type
+ */
+typedef enum {
+  SIGNAL_TYPE_U8,
+  SIGNAL_TYPE_U16,
+  SIGNAL_TYPE_U32,
+  SIGNAL_TYPE_OPERATION_STATUS,   /* OperationStatus_t */
+} SignalDb_Type_t;
+
+/**
+ * @brief Signal description
+ */
+typedef struct {
+  const char *name;
+  SignalDb_Type_t type;
+  uint8_t size;                   /* value size, bytes */
+} SignalDb_Info_t;
+
+/**
+ * @brief Change notification, called from the timer task once per tick for
+ * each changed signal of the subscribed range, must not block
+ */
+typedef void (*SignalDb_Subscriber_t)(SignalDb_Id_t id);
+
+/**
+ * @brief Signal access cost, seqlock vs mutex protected values, measured at
+ * initialization (no contention)
+ */
+typedef struct {
+  uint32_t seqlock_read_cycles;   /* CPU cycles per read */
+  uint32_t seqlock_write_cycles;  /* CPU cycles per write */
+  uint32_t mutex_read_cycles;     /* CPU cycles per read, FreeRTOS mutex */
+  uint32_t mutex_write_cycles;    /* CPU cycles per write, FreeRTOS mutex */
+} SignalDb_Benchmark_t;
+
+/**
+ * @brief Signal database statistics
+ */
+typedef struct {
+  uint32_t writes;                /* values written */
+  uint32_t changes;               /* values written that differ from the previous value */
+  uint32_t batches;               /* notification batches (ticks with changes) */
+  uint32_t notifications;         /* subscriber calls */
+  uint32_t failed_reads;          /* reads that found the writer busy after all retries */
+} SignalDb_Statistics_t;
+
+void SignalDb_Initialize(void);
+void SignalDb_Write(SignalDb_Id_t id, const void *const value);
+uint8_t SignalDb_Read(SignalDb_Id_t id, void *const value, uint64_t *const timestamp_us);
+uint8_t SignalDb_Subscribe(SignalDb_Subscriber_t subscriber, SignalDb_Id_t first, uint32_t count);
+const SignalDb_Info_t *SignalDb_GetInfo(SignalDb_Id_t id);
+void SignalDb_GetBenchmark(SignalDb_Benchmark_t *const benchmark);
+void SignalDb_GetStatistics(SignalDb_Statistics_t *const statistics);
+
+#endif /* _SIGNAL_DB_H_ */
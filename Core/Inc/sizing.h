@@ -0,0 +1,99 @@
+#ifndef _SIZING_H_
+#define _SIZING_H_
+
+#include <stdint.h>
+#include "mem_pool.h"
+
+/* stack and queue sizing monitor: the stack depth of each task is kept at
+ * creation (traceTASK_CREATE, pxEndOfStack is recorded with
+ * configRECORD_STACK_HIGH_ADDRESS), the peak occupancy and the failed sends
+ * of each queue are tracked in the queue send hooks. The report suggests the
+ * smallest safe stack depths and queue lengths from the stack high water
+ * marks and the queue peaks, measured under a stress workload
+ * (Sizing_StartStress()). This header is included by FreeRTOSConfig.h */
+
+#define SIZING_USE_MONITOR          (1u)    /* 1: FreeRTOS sizing hooks are compiled in */
+#define SIZING_MAX_TASKS            (8u)
+#define SIZING_MAX_QUEUES           (6u)    /* kernel queues tracked, semaphores and mutexes aren't */
+#define SIZING_NAME_SIZE            (7u)    /* task name characters in the report, not terminated */
+#define SIZING_STACK_MARGIN_SHIFT   (2u)    /* stack margin: a quarter of the peak use */
+#define SIZING_STACK_MIN_MARGIN     (16u)   /* words, at least two exception frames */
+#define SIZING_STACK_GRANULE        (8u)    /* words, suggested depths are rounded up to */
+#define SIZING_QUEUE_MARGIN         (1u)    /* items above the peak */
+#define SIZING_VERSION              (1u)
+
+/* report layout, little endian:
+ * header:    version (1), tasks (1), queues (1), flags (1),
+ *            stack bytes reclaimable (2), queue bytes reclaimable (2)
+ * per task:  task number (1), depth (2), peak use (2), suggested depth (2) in words,
+ *            name (SIZING_NAME_SIZE)
+ * per queue: kind (1), number (1), item size (1), length (2), peak (2),
+ *            failed sends (2), suggested length (2) */
+#define SIZING_HEADER_SIZE          (8u)
+#define SIZING_TASK_SIZE            (7u + SIZING_NAME_SIZE)
+#define SIZING_QUEUE_SIZE           (11u)
+#define SIZING_MAX_RECORDS          (SIZING_MAX_QUEUES + 3u + MEM_POOL_CLASS_NUMBER)    /* kernel queues, node event channels, event pool, memory pool classes */
+#define SIZING_REPORT_SIZE          (SIZING_HEADER_SIZE + (SIZING_MAX_TASKS * SIZING_TASK_SIZE) \
+                                    + (SIZING_MAX_RECORDS * SIZING_QUEUE_SIZE))
+
+#define SIZING_FLAG_STRESS          (0x01u)   /* stress workload running */
+#define SIZING_FLAG_TRUNCATED       (0x02u)   /* more tasks or queues than tracked */
+#define SIZING_FLAG_SATURATED       (0x04u)   /* a queue was full, its length must grow */
+
+/**
+ * @brief Queue kinds in the report
+ */
+typedef enum {
+  SIZING_QUEUE_KERNEL,          /* FreeRTOS queue, number: Trace_Object_t */
+  SIZING_QUEUE_TIMER,           /* timer command queue, configTIMER_QUEUE_LENGTH */
+  SIZING_QUEUE_CHANNEL,         /* node event channel (event_channel.h), number: Trace_Object_t */
+  SIZING_QUEUE_POOL,            /* event pool (event_pool.h), EVENT_POOL_SIZE */
+  SIZING_QUEUE_MEM_POOL,        /* memory pool size class (mem_pool.h), number: MemPool_Class_t */
+} Sizing_QueueKind_t;
+
+/**
+ * @brief Stack use of a task
+ */
+typedef struct {
+  uint8_t number;               /* task number */
+  uint16_t depth;               /* words */
+  uint16_t used;                /* words used at the deepest point since the start */
+  uint16_t suggested;           /* smallest safe depth */
+  const char *name;
+} Sizing_TaskReport_t;
+
+/**
+ * @brief Occupancy of a queue
+ */
+typedef struct {
+  uint8_t kind;                 /* Sizing_QueueKind_t */
+  uint8_t number;
+  uint8_t item_size;            /* bytes */
+  uint16_t length;              /* items */
+  uint16_t peak;                /* most items at the same time since the stress start */
+  uint16_t failed;              /* sends failed, queue full */
+  uint16_t suggested;           /* smallest safe length */
+} Sizing_QueueReport_t;
+
+void Sizing_TaskCreated(void *const task, uint32_t depth);
+void Sizing_QueueSend(void *const queue, uint32_t waiting, uint32_t length, uint32_t item_size);
+void Sizing_QueueFailed(void *const queue, uint32_t length, uint32_t item_size);
+void Sizing_StartStress(void);
+void Sizing_StopStress(void);
+uint8_t Sizing_GetTaskReport(uint8_t index, Sizing_TaskReport_t *const report);
+uint8_t Sizing_GetQueueReport(uint8_t index, Sizing_QueueReport_t *const report);
+uint16_t Sizing_Report(uint8_t *const buffer, uint16_t size);
+
+/* hooks shared with the trace recorder (trace.h), combined into the kernel
+ * hooks by FreeRTOSConfig.h. Semaphores and mutexes (no item) are skipped */
+#if (SIZING_USE_MONITOR == 1u)
+#define SIZING_TASK_CREATE(pxNewTCB)  Sizing_TaskCreated((pxNewTCB), (uint32_t)(((pxNewTCB)->pxEndOfStack - (pxNewTCB)->pxStack) + 1))
+#define SIZING_QUEUE_SEND(pxQueue)    Sizing_QueueSend((pxQueue), (pxQueue)->uxMessagesWaiting, (pxQueue)->uxLength, (pxQueue)->uxItemSize)
+#define SIZING_QUEUE_SEND_FAILED(pxQueue) Sizing_QueueFailed((pxQueue), (pxQueue)->uxLength, (pxQueue)->uxItemSize)
+#else
+#define SIZING_TASK_CREATE(pxNewTCB)
+#define SIZING_QUEUE_SEND(pxQueue)
+#define SIZING_QUEUE_SEND_FAILED(pxQueue)
+#endif /* (SIZING_USE_MONITOR == 1u) */
+
+#endif /* _SIZING_H_ */
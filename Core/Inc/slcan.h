@@ -0,0 +1,47 @@
+#ifndef _SLCAN_H_
+#define _SLCAN_H_
+
+#include <stdint.h>
+
+/* SLCAN (Lawicel) gateway over USART1, frames passing through the CAN driver
+ * are queued in binary form, then encoded to ASCII in batches by the gateway
+ * task and sent using DMA. Frames are held in memory pool blocks
+ * (SLCAN_USE_MEM_POOL) or copied through the frame queue. Commands are received with circular DMA. While
+ * the channel is closed, the link can carry the trace recorder's binary
+ * blocks instead (trace.h). Operation status frames received by the master
+ * node are not copied: the gateway subscribes to the master's events
+ * (MasterNode_SubscribeFrames()) and encodes the frame from the event */
+
+#define SLCAN_TASK_PRIORITY         (1u)
+#define SLCAN_TASK_STACK_DEPTH      (160u)
+
+#define SLCAN_USE_MEM_POOL          (1u)      /* 1: frames are pool blocks (mem_pool.h), the queue carries pointers */
+#define SLCAN_FRAME_QUEUE_SIZE      (16u)
+#define SLCAN_EVENT_QUEUE_SIZE      (4u)      /* master node events held, taken from the event pool */
+#define SLCAN_RX_BUFFER_SIZE        (64u)
+#define SLCAN_TX_BUFFER_SIZE        (512u)
+#define SLCAN_COMMAND_MAX_SIZE      (32u)
+
+#define SLCAN_RATE_WINDOW_MS        (1000u)
+#define SLCAN_TRACE_FLUSH_MS        (5u)      /* trace ring drain period while recording */
+
+#define SLCAN_VERSION               "V1013"
+#define SLCAN_SERIAL_NUMBER         "NC2C0"
+
+/**
+ * @brief SLCAN gateway statistics
+ */
+typedef struct {
+  uint32_t forwarded_frames;    /* frames encoded and queued for transmission to the host */
+  uint32_t dropped_frames;      /* frames dropped, frame queue or TX buffer full */
+  uint32_t injected_frames;     /* frames received from the host and sent on the bus */
+  uint32_t rejected_commands;   /* unknown or invalid host commands */
+  uint32_t frame_rate;          /* frames forwarded per second, last window */
+  uint32_t max_frame_rate;      /* highest forwarded frame rate */
+  uint32_t max_batch;           /* most frames encoded in a single pass */
+} Slcan_Statistics_t;
+
+void Slcan_Initialize(void);
+void Slcan_GetStatistics(Slcan_Statistics_t *const statistics);
+
+#endif /* _SLCAN_H_ */
@@ -0,0 +1,35 @@
+#ifndef _TICKLESS_H_
+#define _TICKLESS_H_
+
+#include <stdint.h>
+
+/* tickless idle (configUSE_TICKLESS_IDLE 2): the idle task stops the kernel
+ * tick (SysTick) and the HAL tick (TIM1 update interrupt) until the next
+ * kernel timeout, and sleeps. TIM1 keeps counting at 1 MHz while its
+ * interrupt is off, the milliseconds it wrapped through are added back to the
+ * HAL tick before interrupts are enabled again, so Timebase_GetMicros() is
+ * correct for the interrupt that woke the core. The time the SysTick is
+ * stopped is measured with the cycle counter and given back to the kernel */
+
+#define TICKLESS_MIN_LOAD_CYCLES  (32u)   /* SysTick reload left after a sleep, shorter: next tick */
+
+/**
+ * @brief Tickless idle statistics
+ */
+typedef struct {
+  uint32_t sleeps;              /* low power entries */
+  uint32_t aborted;             /* entries abandoned, a task became ready or a tick was pending */
+  uint32_t interrupted;         /* sleeps ended before the expected idle time by an interrupt */
+  uint32_t slept_ticks;         /* kernel ticks suppressed */
+  uint32_t max_sleep_ticks;     /* longest sleep */
+  uint32_t last_wakeup_cycles;  /* last sleep ended by the tick: expected wake-up to interrupts enabled */
+  uint32_t max_wakeup_cycles;   /* longest of those */
+  uint32_t max_exit_cycles;     /* any sleep: core awake to interrupts enabled, delay of the waking interrupt */
+  int32_t last_error_us;        /* last sleep: kernel time minus TIM1 timebase over the sleep */
+  int32_t long_sleep_error_us;  /* error over the longest sleep */
+  uint32_t max_error_us;        /* largest error, absolute */
+} Tickless_Statistics_t;
+
+void Tickless_GetStatistics(Tickless_Statistics_t *const statistics);
+
+#endif /* _TICKLESS_H_ */
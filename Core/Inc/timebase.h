@@ -0,0 +1,38 @@
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Initialize the local timebase (enables the DWT cycle counter)
+ */
+void Timebase_Initialize(void);
+
+/**
+ * @brief Clear the TIM1 update flag and increment the HAL tick with
+ * interrupts disabled, from the TIM1 update ISR before HAL_TIM_IRQHandler():
+ * Timebase_GetMicros() sees either the flag or the new tick
+ */
+void Timebase_TickHandler(void);
+
+/**
+ * @brief Get local time in microseconds since boot
+ *
+ * Built from the HAL millisecond tick and the TIM1 counter (1 MHz), safe to
+ * call from tasks and ISRs of any priority.
+ */
+uint64_t Timebase_GetMicros(void);
+
+/**
+ * @brief Get CPU cycles since boot: the DWT cycle counter, plus the cycles it
+ * missed while the core was sleeping (wraps every 2^32 cycles)
+ */
+uint32_t Timebase_GetCycles(void);
+
+/**
+ * @brief Add the cycles of a sleep the DWT cycle counter didn't count, with
+ * interrupts disabled (tickless idle)
+ */
+void Timebase_AddSleepCycles(uint32_t cycles);
+
+#endif /* _TIMEBASE_H_ */
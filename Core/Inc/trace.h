@@ -0,0 +1,110 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+
+/* kernel and CAN driver trace recorder: FreeRTOS trace hooks (task switches,
+ * queue operations, timer callbacks), interrupt handler entry/exit and CAN
+ * driver events are written as 8 byte time stamped records to a RAM ring
+ * buffer, from any task or interrupt up to configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ * The ring is drained in blocks by the SLCAN gateway task and sent over the
+ * USART1 DMA (Y1/Y0 commands). Records that don't fit are dropped and
+ * reported with an overflow record. Decoded on the host by
+ * Tools/trace_decoder. This header is included by FreeRTOSConfig.h */
+
+#define TRACE_USE_RECORDER        (1u)    /* 1: FreeRTOS trace hooks are compiled in */
+#define TRACE_BUFFER_RECORDS      (128u)  /* power of 2 */
+#define TRACE_BLOCK_RECORDS       (16u)   /* records per block sent to the host */
+#define TRACE_TASK_NAMES          (8u)    /* tasks whose name is sent at start */
+#define TRACE_ISR_MASK            (0x2Fu) /* RuntimeStats_Isr_t recorded: CAN and TIM2, TIM1 (1 kHz) would fill the link */
+
+/* block sent to the host, little endian: magic (2), records (1), flags (1),
+ * average and longest record cost in CPU cycles (2 + 2), then the records */
+#define TRACE_BLOCK_MAGIC         (0x5254u)   /* "TR" */
+#define TRACE_BLOCK_HEADER_SIZE   (8u)
+#define TRACE_BLOCK_SIZE          (TRACE_BLOCK_HEADER_SIZE + (TRACE_BLOCK_RECORDS * 8u))
+#define TRACE_BLOCK_FLAG_DROPPED  (0x01u)     /* records were dropped since the start */
+
+/**
+ * @brief Record types
+ */
+typedef enum {
+  TRACE_EVENT_START = 1,        /* recording started, arg16: CPU clock (kHz) */
+  TRACE_EVENT_TASK_NAME,        /* arg8: task number, arg16: name part, timestamp: 4 name characters */
+  TRACE_EVENT_TASK_SWITCH,      /* arg8: task number switched in */
+  TRACE_EVENT_QUEUE_SEND,       /* arg8: queue number (Trace_Object_t), arg16: messages waiting before */
+  TRACE_EVENT_QUEUE_SEND_ISR,   /* arg8: queue number, arg16: messages waiting before */
+  TRACE_EVENT_QUEUE_RECEIVE,    /* arg8: queue number, arg16: messages waiting before */
+  TRACE_EVENT_QUEUE_BLOCK,      /* arg8: queue number, task blocks on an empty queue */
+  TRACE_EVENT_QUEUE_FULL,       /* arg8: queue number, send failed */
+  TRACE_EVENT_TIMER,            /* arg8: timer number (Trace_Object_t), callback about to run */
+  TRACE_EVENT_ISR_ENTER,        /* arg8: RuntimeStats_Isr_t */
+  TRACE_EVENT_ISR_EXIT,         /* arg8: RuntimeStats_Isr_t */
+  TRACE_EVENT_CAN_TX,           /* arg16: standard ID added to a TX mailbox */
+  TRACE_EVENT_CAN_TX_COMPLETE,  /* arg8: mailbox, arg16: standard ID */
+  TRACE_EVENT_CAN_RX,           /* arg8: RX FIFO, arg16: standard ID */
+  TRACE_EVENT_CAN_ERROR,        /* arg16: HAL_CAN_ERROR_x flags (low 16 bits) */
+  TRACE_EVENT_OVERFLOW,         /* arg16: records dropped before this one */
+  TRACE_EVENT_E2E_TIMEOUT,      /* arg16: protected standard ID without a valid frame within its timeout */
+} Trace_Event_t;
+
+/**
+ * @brief Queue and timer numbers (vQueueSetQueueNumber(), vTimerSetTimerNumber())
+ */
+typedef enum {
+  TRACE_OBJECT_OTHER,           /* kernel objects (timer command queue, mutexes) */
+  TRACE_OBJECT_MASTER_NODE,
+  TRACE_OBJECT_SLAVE_NODE,
+  TRACE_OBJECT_SLCAN,
+  TRACE_OBJECT_SIGNAL_DB,
+  TRACE_OBJECT_CLOCK_SYNC,
+} Trace_Object_t;
+
+/**
+ * @brief Trace record
+ */
+typedef struct {
+  uint32_t timestamp;           /* DWT cycle counter */
+  uint8_t type;                 /* Trace_Event_t */
+  uint8_t arg8;
+  uint16_t arg16;
+} Trace_Record_t;
+
+/**
+ * @brief Recorder statistics
+ */
+typedef struct {
+  uint32_t records;             /* records written or dropped since the start */
+  uint32_t dropped;             /* records dropped, ring full */
+  uint32_t avg_cycles;          /* CPU cycles per record, average */
+  uint32_t max_cycles;          /* CPU cycles per record, longest */
+} Trace_Statistics_t;
+
+void Trace_Start(void);
+void Trace_Stop(void);
+uint8_t Trace_IsRunning(void);
+void Trace_Record(uint8_t type, uint8_t arg8, uint16_t arg16);
+void Trace_TaskCreated(uint8_t number, const char *const name);
+uint16_t Trace_ReadBlock(uint8_t *const block);
+void Trace_GetStatistics(Trace_Statistics_t *const statistics);
+
+/* hooks shared with the sizing monitor (sizing.h) are the TRACE_ macros,
+ * combined into the kernel hooks by FreeRTOSConfig.h */
+#if (TRACE_USE_RECORDER == 1u)
+#define TRACE_TASK_CREATE(pxNewTCB)             Trace_TaskCreated((uint8_t)(pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName)
+#define TRACE_QUEUE_SEND(pxQueue)               Trace_Record(TRACE_EVENT_QUEUE_SEND, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define TRACE_QUEUE_SEND_FROM_ISR(pxQueue)      Trace_Record(TRACE_EVENT_QUEUE_SEND_ISR, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define TRACE_QUEUE_SEND_FAILED(pxQueue)        Trace_Record(TRACE_EVENT_QUEUE_FULL, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define traceTASK_SWITCHED_IN()                 Trace_Record(TRACE_EVENT_TASK_SWITCH, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#define traceQUEUE_RECEIVE(pxQueue)             Trace_Record(TRACE_EVENT_QUEUE_RECEIVE, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)    Trace_Record(TRACE_EVENT_QUEUE_RECEIVE, (uint8_t)(pxQueue)->uxQueueNumber, (uint16_t)(pxQueue)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) Trace_Record(TRACE_EVENT_QUEUE_BLOCK, (uint8_t)(pxQueue)->uxQueueNumber, 0)
+#define traceTIMER_EXPIRED(pxTimer)             Trace_Record(TRACE_EVENT_TIMER, (uint8_t)(pxTimer)->uxTimerNumber, 0)
+#else
+#define TRACE_TASK_CREATE(pxNewTCB)
+#define TRACE_QUEUE_SEND(pxQueue)
+#define TRACE_QUEUE_SEND_FROM_ISR(pxQueue)
+#define TRACE_QUEUE_SEND_FAILED(pxQueue)
+#endif /* (TRACE_USE_RECORDER == 1u) */
+
+#endif /* _TRACE_H_ */
@@ -0,0 +1,62 @@
+#ifndef _TX_SCHEDULER_H_
+#define _TX_SCHEDULER_H_
+
+#include <stdint.h>
+#include "can.h"
+
+/* TX scheduler (BXCAN_USE_TX_SCHEDULER): the nodes build their next cyclic
+ * frame in advance and arm a slot with its release time, the TIM2 compare
+ * interrupt loads it into the scheduled mailbox at that time, so the frames
+ * don't inherit the tick granularity and the timer task latency of the
+ * software timers. TIM2 counts microseconds from the same clock as the TIM1
+ * timebase, each slot has its own compare channel. Releases more than a
+ * counter wrap away are reached in hops, compare values the counter already
+ * passed generate their event at once */
+
+#define TX_SCHEDULER_IRQ_PRIORITY   (5u)        /* configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, FromISR calls */
+#define TX_SCHEDULER_MAX_HOP_US     (0x8000u)   /* longest compare step, half the counter range */
+#define TX_SCHEDULER_RETRY_US       (50u)       /* scheduled mailbox still pending, retry delay */
+
+/**
+ * @brief Schedule table slots, one TIM2 compare channel each (4 at most)
+ */
+typedef enum {
+  TX_SCHEDULER_SLOT_MASTER,     /* operation commands */
+  TX_SCHEDULER_SLOT_SLAVE,      /* operation status */
+  TX_SCHEDULER_SLOT_NUMBER,
+} TxScheduler_Slot_t;
+
+/* called from the TIM2 interrupt once the frame of a slot was released, with its release time */
+typedef void (* TxScheduler_Callback_t)(uint64_t release_us);
+
+/**
+ * @brief Frame built in advance, E2E protection is added at the release
+ */
+typedef struct {
+  uint16_t std_id;
+  uint8_t len;
+  uint8_t data[BXCAN_MAX_DATA_SIZE];
+} TxScheduler_Frame_t;
+
+/**
+ * @brief Slot statistics
+ */
+typedef struct {
+  uint32_t released;            /* releases, with or without a frame */
+  uint32_t late;                /* armed after their release time, released at once */
+  uint32_t busy;                /* scheduled mailbox still pending at the release, retried */
+  uint32_t cancelled;           /* cancelled before their release */
+  uint32_t retried;             /* callbacks called again (TxScheduler_RetryFromISR()), counted in released */
+  uint32_t last_delay_us;       /* release time to frame loaded, last release */
+  uint32_t max_delay_us;        /* longest of those (interrupt latency, retries) */
+} TxScheduler_Statistics_t;
+
+void TxScheduler_Initialize(void);
+void TxScheduler_Arm(TxScheduler_Slot_t slot, uint64_t release_us, const TxScheduler_Frame_t *const frame,
+  bxCAN_TxCompleteCallback_t tx_callback, TxScheduler_Callback_t callback);
+void TxScheduler_RetryFromISR(TxScheduler_Slot_t slot);
+uint8_t TxScheduler_Cancel(TxScheduler_Slot_t slot);
+void TxScheduler_IRQHandler(void);
+void TxScheduler_GetStatistics(TxScheduler_Slot_t slot, TxScheduler_Statistics_t *const statistics);
+
+#endif /* _TX_SCHEDULER_H_ */
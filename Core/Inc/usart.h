@@ -35,6 +35,8 @@ extern "C" {
 extern UART_HandleTypeDef huart1;
 
 /* USER CODE BEGIN Private defines */
+/* highest standard rate with a 8 MHz PCLK2 and 16x oversampling (BRR = 1.0) */
+#define USART1_BAUDRATE   (500000u)
 
 /* USER CODE END Private defines */
 
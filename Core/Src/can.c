@@ -21,19 +21,109 @@
 #include "can.h"
 
 /* USER CODE BEGIN 0 */
+#include <string.h>
 #include "FreeRTOS.h"
 #include "semphr.h"
 #include "event_groups.h"
 #include "queue.h"
+#include "task.h"
+#include "e2e.h"
+#include "timebase.h"
+#include "trace.h"
 
 #define BXCAN_TX_MB0_FLAG     (1u << BXCAN_TX_MB0)
 #define BXCAN_TX_MB1_FLAG     (1u << BXCAN_TX_MB1)
 #define BXCAN_TX_MB2_FLAG     (1u << BXCAN_TX_MB2)
 #define BXCAN_TX_ALL_FLAGS    (BXCAN_TX_MB0_FLAG | BXCAN_TX_MB1_FLAG | BXCAN_TX_MB2_FLAG)
 
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+#if (BXCAN_SCHEDULED_MAILBOX != BXCAN_TX_MB2)
+#error BXCAN_SCHEDULED_MAILBOX must be the last mailbox, bxCAN_Transmit() takes the lowest free one
+#endif /* (BXCAN_SCHEDULED_MAILBOX != BXCAN_TX_MB2) */
+
+/* mailboxes of bxCAN_Transmit(), the scheduled mailbox is loaded by the TX scheduler only */
+#define BXCAN_TX_TASK_FLAGS   (BXCAN_TX_MB0_FLAG | BXCAN_TX_MB1_FLAG)
+#else
+#define BXCAN_TX_TASK_FLAGS   (BXCAN_TX_ALL_FLAGS)
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
 static EventGroupHandle_t bxCAN_TxEventGroupHandle = NULL;
 static StaticEventGroup_t bxCAN_TxEventGroup = {0};
 static bxCAN_TxCompleteCallback_t bxCAN_TxCompleteCallbacks [BXCAN_MAX_TX_FIFO] = {0};
+static bxCAN_MonitorCallback_t bxCAN_MonitorCallback = NULL;
+static bxCAN_ErrorCallback_t bxCAN_ErrorCallback = NULL;
+
+/* bits of the frames on the bus, sent or received by the node, wraps */
+static volatile uint32_t bxCAN_BusBits = 0;
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+#if (BXCAN_SERVICE_TASK_PRIORITY != (configMAX_PRIORITIES - 1)) || (BXCAN_SERVICE_TASK_PRIORITY <= configTIMER_TASK_PRIORITY)
+#error BXCAN_SERVICE_TASK_PRIORITY must be the highest priority, above the timer task
+#endif /* (BXCAN_SERVICE_TASK_PRIORITY != (configMAX_PRIORITIES - 1)) || (BXCAN_SERVICE_TASK_PRIORITY <= configTIMER_TASK_PRIORITY) */
+
+#define BXCAN_SERVICE_RX_FIFOS      (2u)
+#define BXCAN_SERVICE_RX_MASK       (BXCAN_SERVICE_RX_SLOTS - 1u)
+#define BXCAN_SERVICE_TX_MASK       (BXCAN_SERVICE_TX_SLOTS - 1u)
+
+/**
+ * @brief Received frame, waiting for the service task
+ */
+typedef struct {
+  uint64_t time_us;                 /* reception, Timebase_GetMicros() in the RX interrupt */
+  uint32_t cycles;                  /* reception, Timebase_GetCycles() */
+  uint16_t std_id;
+  uint8_t len;
+  uint8_t data[BXCAN_MAX_DATA_SIZE];
+} bxCAN_RxSlot_t;
+
+/**
+ * @brief RX FIFO ring, filled by its RX interrupt (head), drained by the
+ * service task (tail). Indexes run free and wrap at 256
+ */
+typedef struct {
+  bxCAN_RxSlot_t slots[BXCAN_SERVICE_RX_SLOTS];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  bxCAN_RxHandler_t handler;
+} bxCAN_RxRing_t;
+
+/**
+ * @brief Completed transmission, waiting for the service task. The mailbox
+ * and the callback are kept with it, the mailbox can be reused and complete
+ * again before the task runs
+ */
+typedef struct {
+  uint64_t time_us;
+  uint32_t cycles;
+  uint16_t std_id;
+  uint8_t mailbox;
+  bxCAN_TxCompleteCallback_t callback;
+} bxCAN_TxRecord_t;
+
+/**
+ * @brief TX completion ring, filled by the TX interrupt (head), drained by
+ * the service task (tail). Indexes run free and wrap at 256
+ */
+typedef struct {
+  bxCAN_TxRecord_t records[BXCAN_SERVICE_TX_SLOTS];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+} bxCAN_TxRing_t;
+
+static bxCAN_RxRing_t bxCAN_RxRings[BXCAN_SERVICE_RX_FIFOS] = {0};
+static bxCAN_TxRing_t bxCAN_TxRing = {0};
+static volatile uint32_t bxCAN_ErrorPending = 0;  /* HAL_CAN_ERROR_x, set by the error interrupt */
+static uint32_t bxCAN_ErrorCycles = 0;            /* first pending error */
+
+/* written by the service task, dropped frames by the RX interrupts */
+static bxCAN_ServiceStatistics_t bxCAN_ServiceStatistics[BXCAN_SOURCE_NUMBER] = {0};
+
+static TaskHandle_t bxCAN_ServiceTaskHandle = NULL;
+static StaticTask_t bxCAN_ServiceTaskBuffer = {0};
+static StackType_t bxCAN_ServiceTaskStack[BXCAN_SERVICE_STACK_DEPTH] = {0};
+
+static void bxCAN_ServiceTaskFunction(void *const pvParam);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
 
 /* USER CODE END 0 */
 
@@ -69,6 +159,18 @@ void MX_CAN_Init(void) {
   bxCAN_TxEventGroupHandle = xEventGroupCreateStatic(&bxCAN_TxEventGroup);
   xEventGroupSetBits(bxCAN_TxEventGroupHandle, BXCAN_TX_MB0_FLAG | BXCAN_TX_MB1_FLAG | BXCAN_TX_MB2_FLAG);
 
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  bxCAN_ServiceTaskHandle = xTaskCreateStatic(
+    &bxCAN_ServiceTaskFunction,
+    "CanServiceTask",
+    BXCAN_SERVICE_STACK_DEPTH,
+    NULL,
+    BXCAN_SERVICE_TASK_PRIORITY,
+    bxCAN_ServiceTaskStack,   /* stack buffer (StackType_t *)  */
+    &bxCAN_ServiceTaskBuffer  /* task buffer (StaticTask_t *) */
+  );
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
   /* USER CODE END CAN_Init 2 */
 }
 
@@ -102,6 +204,8 @@ void HAL_CAN_MspInit(CAN_HandleTypeDef *canHandle) {
     HAL_NVIC_EnableIRQ(USB_HP_CAN1_TX_IRQn);
     HAL_NVIC_SetPriority(USB_LP_CAN1_RX0_IRQn, 5, 0);
     HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+    HAL_NVIC_SetPriority(CAN1_RX1_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(CAN1_RX1_IRQn);
     HAL_NVIC_SetPriority(CAN1_SCE_IRQn, 5, 0);
     HAL_NVIC_EnableIRQ(CAN1_SCE_IRQn);
     /* USER CODE BEGIN CAN1_MspInit 1 */
@@ -128,6 +232,7 @@ void HAL_CAN_MspDeInit(CAN_HandleTypeDef *canHandle) {
     /* CAN1 interrupt Deinit */
     HAL_NVIC_DisableIRQ(USB_HP_CAN1_TX_IRQn);
     HAL_NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
+    HAL_NVIC_DisableIRQ(CAN1_RX1_IRQn);
     HAL_NVIC_DisableIRQ(CAN1_SCE_IRQn);
     /* USER CODE BEGIN CAN1_MspDeInit 1 */
 
@@ -195,55 +300,280 @@ HAL_StatusTypeDef bxCAN_SetFilterPolicy(uint8_t policy_number, uint8_t filter_fi
   return HAL_OK;
 }
 
+/**
+ * @brief Deactivate a filter bank, frames it accepted are no longer received
+ * 
+ * @param policy_number [in] filter bank
+ */
+HAL_StatusTypeDef bxCAN_ClearFilterPolicy(uint8_t policy_number) {
+  CAN_FilterTypeDef filter = {0};
+
+  assert_param(policy_number < BXCAN_FILTER_BANK_MAX);
+
+  filter.FilterActivation = DISABLE;
+  filter.FilterBank = policy_number;
+  filter.FilterMode = CAN_FILTERMODE_IDMASK;
+  filter.FilterScale = CAN_FILTERSCALE_32BIT;
+
+  if (HAL_CAN_ConfigFilter(&hcan, &filter) != HAL_OK) {
+    Error_Handler();
+    return HAL_ERROR;
+  }
+
+  return HAL_OK;
+}
+
+/**
+ * @brief Set the ID and mask of a deactivated filter bank and activate it,
+ * without the filter initialization mode. RM0008 allows the filter registers
+ * of a deactivated bank to be written with FINIT cleared, so the reception
+ * through the other banks goes on. The mode, scale and FIFO assignment need
+ * FINIT, they are kept from bxCAN_SetFilterPolicy()
+ * 
+ * @param policy_number [in] filter bank, set once with bxCAN_SetFilterPolicy(), then deactivated
+ * @param filter_id [in] ID
+ * @param filter_mask [in] mask
+ * @return HAL_StatusTypeDef HAL_ERROR: the bank is active
+ */
+HAL_StatusTypeDef bxCAN_SetFilterId(uint8_t policy_number, bxCAN_Filter_t filter_id, bxCAN_Mask_t filter_mask) {
+  CAN_TypeDef *const can = hcan.Instance;
+  const uint32_t bank = (1uL << policy_number);
+  HAL_StatusTypeDef status = HAL_ERROR;
+
+  assert_param(policy_number < BXCAN_FILTER_BANK_MAX);
+
+  taskENTER_CRITICAL();
+  if ((can->FA1R & bank) == 0) {
+    can->sFilterRegister[policy_number].FR1 = ((uint32_t)filter_id.as_u16.high << 16) | filter_id.as_u16.low;
+    can->sFilterRegister[policy_number].FR2 = ((uint32_t)filter_mask.as_u16.high << 16) | filter_mask.as_u16.low;
+    can->FA1R |= bank;
+    status = HAL_OK;
+  }
+  taskEXIT_CRITICAL();
+
+  return status;
+}
+
+/**
+ * @brief Deactivate a filter bank without the filter initialization mode,
+ * the reception through the other banks goes on. The mode, scale and FIFO
+ * assignment are kept for bxCAN_SetFilterId()
+ * 
+ * @param policy_number [in] filter bank
+ */
+void bxCAN_DeactivateFilterPolicy(uint8_t policy_number) {
+  assert_param(policy_number < BXCAN_FILTER_BANK_MAX);
+
+  taskENTER_CRITICAL();
+  hcan.Instance->FA1R &= ~(1uL << policy_number);
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Add a frame to the bus bits. In loopback mode the bus only carries
+ * the node's own frames, received frames are its transmitted ones
+ *
+ * @param len [in] data length
+ * @param direction [in] transmitted or received
+ */
+static void bxCAN_AccountFrame(uint8_t len, bxCAN_Direction_t direction) {
+  UBaseType_t saved_mask = 0;
+
+  if ((direction == BXCAN_DIRECTION_RX) && (hcan.Init.Mode == CAN_MODE_LOOPBACK)) {
+    return;
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  bxCAN_BusBits += BXCAN_FRAME_BITS(len);
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Load a frame into a mailbox and request its transmission. The
+ * mailbox registers are written directly, the HAL would take the lowest
+ * free mailbox instead of the claimed one
+ *
+ * @param mailbox [in] claimed empty mailbox
+ * @param frame [in] E2E protected frame data, BXCAN_MAX_DATA_SIZE bytes
+ * @param len [in] data length
+ * @param std_id [in] standard ID
+ * @param callback [in] TX complete callback, NULL: none
+ */
+static void bxCAN_LoadMailbox(uint8_t mailbox, const uint8_t *const frame, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback) {
+  CAN_TxMailBox_TypeDef *const tx_mailbox = &hcan.Instance->sTxMailBox[mailbox];
+
+  configASSERT((hcan.Instance->TSR & (CAN_TSR_TME0 << mailbox)) != 0);
+
+  bxCAN_TxCompleteCallbacks[mailbox] = callback;
+
+  tx_mailbox->TIR = ((uint32_t)std_id << CAN_TI0R_STID_Pos) | CAN_RTR_DATA | CAN_ID_STD;
+  tx_mailbox->TDTR = len;
+  tx_mailbox->TDLR = ((uint32_t)frame[3] << 24) | ((uint32_t)frame[2] << 16) | ((uint32_t)frame[1] << 8) | frame[0];
+  tx_mailbox->TDHR = ((uint32_t)frame[7] << 24) | ((uint32_t)frame[6] << 16) | ((uint32_t)frame[5] << 8) | frame[4];
+  SET_BIT(tx_mailbox->TIR, CAN_TI0R_TXRQ);
+  Trace_Record(TRACE_EVENT_CAN_TX, 0, std_id);
+  bxCAN_AccountFrame(len, BXCAN_DIRECTION_TX);
+
+  if(bxCAN_MonitorCallback != NULL) {
+    bxCAN_MonitorCallback(std_id, frame, len, BXCAN_DIRECTION_TX);
+  }
+}
+
+/**
+ * @brief Claim the lowest free mailbox of bxCAN_Transmit(). The free bits
+ * are read and the claimed one cleared in one critical section, two tasks
+ * woken by the same completion can't take the same mailbox
+ *
+ * @param wait [in] ticks to wait for a free mailbox
+ * @return uint8_t claimed mailbox, BXCAN_MAX_TX_FIFO: none free in time
+ */
+static uint8_t bxCAN_ClaimMailbox(TickType_t wait) {
+  uint8_t mailbox = BXCAN_MAX_TX_FIFO;
+
+  for (;;) {
+    taskENTER_CRITICAL();
+    const EventBits_t available_mailbox = xEventGroupGetBits(bxCAN_TxEventGroupHandle) & BXCAN_TX_TASK_FLAGS;
+
+    if ((available_mailbox & BXCAN_TX_MB0_FLAG) != 0) {
+      mailbox = BXCAN_TX_MB0;
+    } else if ((available_mailbox & BXCAN_TX_MB1_FLAG) != 0) {
+      mailbox = BXCAN_TX_MB1;
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
+    } else if ((available_mailbox & BXCAN_TX_MB2_FLAG) != 0) {
+      mailbox = BXCAN_TX_MB2;
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
+    }
+
+    if (mailbox != BXCAN_MAX_TX_FIFO) {
+      xEventGroupClearBits(bxCAN_TxEventGroupHandle, (EventBits_t)1u << mailbox);
+    }
+    taskEXIT_CRITICAL();
+
+    if ((mailbox != BXCAN_MAX_TX_FIFO) || (wait == 0)) {
+      return mailbox;
+    }
+
+    /* the bits aren't cleared on exit, the next pass claims one of them */
+    if ((xEventGroupWaitBits(bxCAN_TxEventGroupHandle, BXCAN_TX_TASK_FLAGS, pdFALSE, pdFALSE, wait) & BXCAN_TX_TASK_FLAGS) == 0) {
+      return BXCAN_MAX_TX_FIFO;
+    }
+  }
+}
+
 /* Blocking Transmit ------------------------------------------------------- */
 
 HAL_StatusTypeDef bxCAN_Transmit(const uint8_t *const data, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback) {
-  CAN_TxHeaderTypeDef tx_header = {0};
-  uint32_t mailbox = 0;
-
-  tx_header.DLC = len;
-  tx_header.StdId = std_id;
-  tx_header.IDE = CAN_ID_STD;
-  tx_header.RTR = CAN_RTR_DATA;
-  tx_header.TransmitGlobalTime = DISABLE;
-
-  // // wait until 1 tx mailbox is free
-  // while(HAL_CAN_GetTxMailboxesFreeLevel(&hcan) == 0) {
-  // }
-
-  EventBits_t available_mailbox = xEventGroupWaitBits(
-    bxCAN_TxEventGroupHandle, 
-    BXCAN_TX_MB0_FLAG | BXCAN_TX_MB1_FLAG | BXCAN_TX_MB2_FLAG,
-    0,
-    pdFALSE,
-    portMAX_DELAY
-  );
+  uint8_t frame[BXCAN_MAX_DATA_SIZE] = {0};
+  uint8_t mailbox = BXCAN_MAX_TX_FIFO;
+
+  assert_param(len <= BXCAN_MAX_DATA_SIZE);
+
+  /* add CRC & alive counter to E2E protected IDs */
+  memcpy(frame, data, len);
+  E2E_Protect(std_id, frame, len);
+
+  /* wait until a mailbox of the task is free */
+  mailbox = bxCAN_ClaimMailbox(portMAX_DELAY);
+  configASSERT(mailbox != BXCAN_MAX_TX_FIFO);
+
+  bxCAN_LoadMailbox(mailbox, frame, len, std_id, callback);
+
+  return HAL_OK;
+}
 
-  if((available_mailbox & BXCAN_TX_MB0_FLAG) == BXCAN_TX_MB0_FLAG) {
-    bxCAN_TxCompleteCallbacks[BXCAN_TX_MB0] = callback;
-    xEventGroupClearBits(bxCAN_TxEventGroupHandle, BXCAN_TX_MB0_FLAG);
+/**
+ * @brief Transmit a frame if a mailbox of the task is free, without
+ * waiting. For the timer task: the mailbox bits are set from the TX
+ * complete interrupt through the timer task, it can't wait for them
+ *
+ * @param data [in] frame data
+ * @param len [in] data length
+ * @param std_id [in] standard ID
+ * @param callback [in] TX complete callback, NULL: none
+ * @return HAL_StatusTypeDef HAL_BUSY: no free mailbox, the frame isn't sent
+ */
+HAL_StatusTypeDef bxCAN_TryTransmit(const uint8_t *const data, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback) {
+  uint8_t frame[BXCAN_MAX_DATA_SIZE] = {0};
+  uint8_t mailbox = BXCAN_MAX_TX_FIFO;
 
-  } else if((available_mailbox & BXCAN_TX_MB1_FLAG) == BXCAN_TX_MB1_FLAG) {
-    bxCAN_TxCompleteCallbacks[BXCAN_TX_MB1] = callback;
-    xEventGroupClearBits(bxCAN_TxEventGroupHandle, BXCAN_TX_MB1_FLAG);
+  assert_param(len <= BXCAN_MAX_DATA_SIZE);
 
-  } else {
-    bxCAN_TxCompleteCallbacks[BXCAN_TX_MB2] = callback;
-    xEventGroupClearBits(bxCAN_TxEventGroupHandle, BXCAN_TX_MB2_FLAG);
+  mailbox = bxCAN_ClaimMailbox(0);
+  if (mailbox == BXCAN_MAX_TX_FIFO) {
+    return HAL_BUSY;
   }
 
-  // add message to mailbox
-  if (HAL_CAN_AddTxMessage(&hcan, &tx_header, data, &mailbox) != HAL_OK) {
-    Error_Handler();
-    return HAL_ERROR;
+  /* protected once a mailbox is claimed, a busy frame doesn't skip an alive counter value */
+  memcpy(frame, data, len);
+  E2E_Protect(std_id, frame, len);
+
+  bxCAN_LoadMailbox(mailbox, frame, len, std_id, callback);
+
+  return HAL_OK;
+}
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+ * @brief Load a frame into the scheduled mailbox, from the TX scheduler
+ * interrupt. The mailbox registers are written directly, the HAL would
+ * take the lowest free mailbox
+ *
+ * @param data [in] frame data
+ * @param len [in] data length
+ * @param std_id [in] standard ID
+ * @param callback [in] TX complete callback, NULL: none
+ * @return HAL_StatusTypeDef HAL_BUSY: the previous scheduled frame is still pending
+ */
+HAL_StatusTypeDef bxCAN_TransmitScheduled(const uint8_t *const data, uint8_t len, uint16_t std_id, bxCAN_TxCompleteCallback_t callback) {
+  uint8_t frame[BXCAN_MAX_DATA_SIZE] = {0};
+
+  assert_param(len <= BXCAN_MAX_DATA_SIZE);
+
+  if ((hcan.Instance->TSR & CAN_TSR_TME2) == 0) {
+    return HAL_BUSY;
   }
 
+  /* add CRC & alive counter to E2E protected IDs */
+  memcpy(frame, data, len);
+  E2E_Protect(std_id, frame, len);
+
+  bxCAN_LoadMailbox(BXCAN_SCHEDULED_MAILBOX, frame, len, std_id, callback);
+
   return HAL_OK;
 }
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
 
 /* Blocking Receive ------------------------------------------------------- */
 
-HAL_StatusTypeDef bxCAN_Receive(bxCAN_RxFifo_t rx_fifo, uint8_t *data, uint8_t *len, uint16_t *std_id) {
+/**
+ * @brief Read a received frame and check it if its ID is E2E protected
+ *
+ * @param rx_fifo [in] RX FIFO
+ * @param data [out] BXCAN_MAX_DATA_SIZE bytes
+ * @param len [out] DLC
+ * @param std_id [out] standard ID
+ * @param e2e_status [out] E2E_Status_t of this frame, E2E_STATUS_OK if the ID isn't protected
+ * @return HAL_StatusTypeDef HAL_ERROR: no frame (service task ring empty)
+ */
+HAL_StatusTypeDef bxCAN_Receive(bxCAN_RxFifo_t rx_fifo, uint8_t *data, uint8_t *len, uint16_t *std_id, uint8_t *e2e_status) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  /* the RX interrupt moved the frame to the ring, read by the RX handler */
+  bxCAN_RxRing_t *const ring = &bxCAN_RxRings[rx_fifo];
+  const uint8_t tail = ring->tail;
+  const bxCAN_RxSlot_t *const slot = &ring->slots[tail & BXCAN_SERVICE_RX_MASK];
+
+  if (tail == ring->head) {
+    return HAL_ERROR;
+  }
+
+  memcpy(data, slot->data, BXCAN_MAX_DATA_SIZE);
+  (*len) = slot->len;
+  (*std_id) = slot->std_id;
+
+  /* the slot is free once copied */
+  __DMB();
+  ring->tail = (uint8_t)(tail + 1u);
+#else
   CAN_RxHeaderTypeDef rx_header = {0};
 
   // wait a message on RX FIFO 0
@@ -257,19 +587,199 @@ HAL_StatusTypeDef bxCAN_Receive(bxCAN_RxFifo_t rx_fifo, uint8_t *data, uint8_t *
 
   (*len) = rx_header.DLC;
   (*std_id) = rx_header.StdId;
+  Trace_Record(TRACE_EVENT_CAN_RX, (uint8_t)rx_fifo, (*std_id));
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  /* check E2E protected IDs, the result belongs to this frame, a later
+   * frame of the same ID doesn't overwrite it */
+  (*e2e_status) = (uint8_t)E2E_Check((*std_id), data, (*len));
+  bxCAN_AccountFrame((*len), BXCAN_DIRECTION_RX);
+
+  if(bxCAN_MonitorCallback != NULL) {
+    bxCAN_MonitorCallback((*std_id), data, (*len), BXCAN_DIRECTION_RX);
+  }
 
   return HAL_OK;
 }
 
+/**
+ * @brief Set a callback to monitor every frame transmitted or received 
+ * through the driver, NULL to disable
+ * 
+ * @param callback [in] monitor callback
+ */
+void bxCAN_SetMonitorCallback(bxCAN_MonitorCallback_t callback) {
+  bxCAN_MonitorCallback = callback;
+}
+
+/**
+ * @brief Set a callback to receive CAN errors (bus off, error passive,
+ * protocol errors), NULL to disable
+ * 
+ * @param callback [in] error callback
+ */
+void bxCAN_SetErrorCallback(bxCAN_ErrorCallback_t callback) {
+  bxCAN_ErrorCallback = callback;
+}
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+/**
+ * @brief TX completion whose callback the service task is running
+ *
+ * @param mailbox [in] TX mailbox of the callback
+ */
+static inline const bxCAN_TxRecord_t *bxCAN_CurrentTxRecord(uint8_t mailbox) {
+  const bxCAN_TxRecord_t *const record = &bxCAN_TxRing.records[bxCAN_TxRing.tail & BXCAN_SERVICE_TX_MASK];
+
+  assert_param((bxCAN_TxRing.tail != bxCAN_TxRing.head) && (record->mailbox == mailbox));
+  (void)mailbox;
+
+  return record;
+}
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+/**
+ * @brief Get standard ID of the oldest message pending in an RX FIFO, 
+ * without releasing it. RX FIFO must not be empty
+ * 
+ * @param rx_fifo [in] RX FIFO
+ */
+uint16_t bxCAN_GetRxStdId(bxCAN_RxFifo_t rx_fifo) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  const bxCAN_RxRing_t *const ring = &bxCAN_RxRings[rx_fifo];
+
+  assert_param(ring->tail != ring->head);
+
+  return ring->slots[ring->tail & BXCAN_SERVICE_RX_MASK].std_id;
+#else
+  assert_param(HAL_CAN_GetRxFifoFillLevel(&hcan, rx_fifo) != 0);
+
+  return (uint16_t)((hcan.Instance->sFIFOMailBox[rx_fifo].RIR & CAN_RI0R_STID) >> CAN_RI0R_STID_Pos);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+/**
+ * @brief Get standard ID of the last message added to a TX mailbox, the
+ * identifier register keeps it after the transmission completes (can be
+ * called from the TX complete callback)
+ * 
+ * @param mailbox [in] TX mailbox
+ */
+uint16_t bxCAN_GetTxStdId(uint8_t mailbox) {
+  assert_param(mailbox < BXCAN_MAX_TX_FIFO);
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  /* the mailbox may have been reused since, the TX interrupt kept the ID */
+  return bxCAN_CurrentTxRecord(mailbox)->std_id;
+#else
+  return (uint16_t)((hcan.Instance->sTxMailBox[mailbox].TIR & CAN_TI0R_STID) >> CAN_TI0R_STID_Pos);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+/**
+ * @brief Get the reception time of the oldest received frame of an RX FIFO,
+ * call before bxCAN_Receive(). With the service task it's the time the RX
+ * interrupt took the frame, otherwise the current time
+ *
+ * @param rx_fifo [in] RX FIFO
+ * @return uint64_t reception time, Timebase_GetMicros()
+ */
+uint64_t bxCAN_GetRxTime(bxCAN_RxFifo_t rx_fifo) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  const bxCAN_RxRing_t *const ring = &bxCAN_RxRings[rx_fifo];
+
+  if (ring->tail != ring->head) {
+    return ring->slots[ring->tail & BXCAN_SERVICE_RX_MASK].time_us;
+  }
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  return Timebase_GetMicros();
+}
+
+/**
+ * @brief Get the completion time of a transmission, from its TX complete
+ * callback. With the service task it's the time of the TX interrupt,
+ * otherwise the current time
+ *
+ * @param mailbox [in] TX mailbox
+ * @return uint64_t completion time, Timebase_GetMicros()
+ */
+uint64_t bxCAN_GetTxTime(uint8_t mailbox) {
+  assert_param(mailbox < BXCAN_MAX_TX_FIFO);
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  return bxCAN_CurrentTxRecord(mailbox)->time_us;
+#else
+  (void)mailbox;
+  return Timebase_GetMicros();
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+/**
+ * @brief Get the bits of the frames sent and received through the driver
+ * since boot, without stuff bits (BXCAN_FRAME_BITS()). Frames dropped by the
+ * filters or the service task aren't counted. The bus load over a window is
+ * the difference divided by BXCAN_BIT_RATE and the window length
+ *
+ * @return uint32_t bits, wraps
+ */
+uint32_t bxCAN_GetBusBits(void) {
+  return bxCAN_BusBits;
+}
+
 /* CAN Callbacks ---------------------------------------------------------- */
 
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+/**
+ * @brief Queue a completed transmission for the service task, TX interrupt.
+ * Each completion gets its record, a mailbox that completes again before the
+ * task runs doesn't overwrite the previous one
+ *
+ * @param mailbox [in] TX mailbox
+ * @param std_id [in] ID of the frame sent
+ * @param pxTaskWoken [out] pdTRUE: the service task was woken
+ */
+static void bxCAN_RecordTx(uint8_t mailbox, uint16_t std_id, BaseType_t *const pxTaskWoken) {
+  const uint8_t head = bxCAN_TxRing.head;
+  bxCAN_TxRecord_t *const record = &bxCAN_TxRing.records[head & BXCAN_SERVICE_TX_MASK];
+
+  if ((uint8_t)(head - bxCAN_TxRing.tail) >= BXCAN_SERVICE_TX_SLOTS) {
+    bxCAN_ServiceStatistics[BXCAN_SOURCE_TX].dropped++;
+    return;
+  }
+
+  record->time_us = Timebase_GetMicros();
+  record->cycles = Timebase_GetCycles();
+  record->std_id = std_id;
+  record->mailbox = mailbox;
+  record->callback = bxCAN_TxCompleteCallbacks[mailbox];
+
+  /* the record is written before it's published */
+  __DMB();
+  bxCAN_TxRing.head = (uint8_t)(head + 1u);
+
+  vTaskNotifyGiveFromISR(bxCAN_ServiceTaskHandle, pxTaskWoken);
+}
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
 static inline BaseType_t __bxCAN_TxCompleteCallback(uint32_t mailbox_id) {
   BaseType_t xTaskWoken = pdFALSE;
+  const uint16_t std_id = (uint16_t)((hcan.Instance->sTxMailBox[mailbox_id].TIR & CAN_TI0R_STID) >> CAN_TI0R_STID_Pos);
+
+  Trace_Record(TRACE_EVENT_CAN_TX_COMPLETE, (uint8_t)mailbox_id, std_id);
 
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  /* the callback runs in the service task */
+  if (bxCAN_TxCompleteCallbacks[mailbox_id] != NULL) {
+    bxCAN_RecordTx((uint8_t)mailbox_id, std_id, &xTaskWoken);
+  }
+  xEventGroupSetBitsFromISR(bxCAN_TxEventGroupHandle, (1u << mailbox_id), &xTaskWoken);
+#else
   xEventGroupSetBitsFromISR(bxCAN_TxEventGroupHandle, (1u << mailbox_id), &xTaskWoken);
   if(bxCAN_TxCompleteCallbacks[mailbox_id] != NULL) {
-    bxCAN_TxCompleteCallbacks[mailbox_id]();
+    bxCAN_TxCompleteCallbacks[mailbox_id]((uint8_t)mailbox_id);
   }
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
 
   return xTaskWoken;
 }
@@ -297,6 +807,267 @@ void HAL_CAN_SleepCallback(CAN_HandleTypeDef *hcan) {}
 
 void HAL_CAN_WakeUpFromRxMsgCallback(CAN_HandleTypeDef *hcan) {}
 
-void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan) {}
+void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan) {
+  uint32_t error = hcan->ErrorCode;
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  BaseType_t xTaskWoken = pdFALSE;
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  /* HAL accumulates error flags until they're reset */
+  (void)HAL_CAN_ResetError(hcan);
+  Trace_Record(TRACE_EVENT_CAN_ERROR, 0, (uint16_t)error);
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  /* errors are merged until the service task reports them */
+  if (bxCAN_ErrorPending == 0) {
+    bxCAN_ErrorCycles = Timebase_GetCycles();
+  }
+  bxCAN_ErrorPending |= error;
+
+  vTaskNotifyGiveFromISR(bxCAN_ServiceTaskHandle, &xTaskWoken);
+  portYIELD_FROM_ISR(xTaskWoken);
+#else
+  if(bxCAN_ErrorCallback != NULL) {
+    bxCAN_ErrorCallback(error);
+  }
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+/* CAN Service Task ------------------------------------------------------- */
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+/**
+ * @brief Move a received frame from an RX FIFO to its ring and wake the
+ * service task, RX interrupt. The frame is read even if the ring is full,
+ * to release the FIFO
+ *
+ * @param rx_fifo [in] RX FIFO
+ */
+static void bxCAN_CaptureFrame(bxCAN_RxFifo_t rx_fifo) {
+  bxCAN_RxRing_t *const ring = &bxCAN_RxRings[rx_fifo];
+  const uint8_t head = ring->head;
+  bxCAN_RxSlot_t *const slot = &ring->slots[head & BXCAN_SERVICE_RX_MASK];
+  uint8_t discarded[BXCAN_MAX_DATA_SIZE] = {0};
+  CAN_RxHeaderTypeDef rx_header = {0};
+  BaseType_t xTaskWoken = pdFALSE;
+
+  if ((uint8_t)(head - ring->tail) >= BXCAN_SERVICE_RX_SLOTS) {
+    (void)HAL_CAN_GetRxMessage(&hcan, rx_fifo, &rx_header, discarded);
+    bxCAN_ServiceStatistics[BXCAN_SOURCE_RX0 + rx_fifo].dropped++;
+    return;
+  }
+
+  slot->time_us = Timebase_GetMicros();
+  slot->cycles = Timebase_GetCycles();
+  if (HAL_CAN_GetRxMessage(&hcan, rx_fifo, &rx_header, slot->data) != HAL_OK) {
+    Error_Handler();
+    return;
+  }
+  slot->std_id = (uint16_t)rx_header.StdId;
+  slot->len = (uint8_t)rx_header.DLC;
+  Trace_Record(TRACE_EVENT_CAN_RX, (uint8_t)rx_fifo, slot->std_id);
+
+  /* the slot is written before it's published */
+  __DMB();
+  ring->head = (uint8_t)(head + 1u);
+
+  vTaskNotifyGiveFromISR(bxCAN_ServiceTaskHandle, &xTaskWoken);
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan) {
+  bxCAN_CaptureFrame(BXCAN_RX_FIFO0);
+}
+
+void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan) {
+  bxCAN_CaptureFrame(BXCAN_RX_FIFO1);
+}
+
+/**
+ * @brief Account one handler run
+ *
+ * @param source [in] work source
+ * @param latency [in] interrupt to handler start, CPU cycles
+ * @param start [in] handler start, Timebase_GetCycles()
+ */
+static void bxCAN_ServiceAccount(bxCAN_Source_t source, uint32_t latency, uint32_t start) {
+  bxCAN_ServiceStatistics_t *const statistics = &bxCAN_ServiceStatistics[source];
+  const uint32_t cycles = Timebase_GetCycles() - start;
+
+  statistics->handled++;
+  if (latency > statistics->max_latency_cycles) {
+    statistics->max_latency_cycles = latency;
+  }
+  if (cycles > statistics->max_handler_cycles) {
+    statistics->max_handler_cycles = cycles;
+  }
+}
+
+/**
+ * @brief Report the pending CAN errors, merged since the interrupt
+ *
+ * @return uint8_t 1: work left for the next pass, 0: done
+ */
+static uint8_t bxCAN_ServiceErrors(void) {
+  uint32_t cycles = 0;
+  uint32_t error = 0;
+  uint32_t start = 0;
+
+  /* the interrupt stamps the first error of an empty word, the flags and
+   * their time stamp are taken together */
+  taskENTER_CRITICAL();
+  error = bxCAN_ErrorPending;
+  cycles = bxCAN_ErrorCycles;
+  bxCAN_ErrorPending = 0;
+  taskEXIT_CRITICAL();
+
+  start = Timebase_GetCycles();
+
+  if (error == 0) {
+    return 0;
+  }
+
+  if (bxCAN_ErrorCallback != NULL) {
+    bxCAN_ErrorCallback(error);
+  }
+  bxCAN_ServiceAccount(BXCAN_SOURCE_ERROR, start - cycles, start);
+
+  return 0;
+}
+
+/**
+ * @brief Run the TX complete callbacks of the completed transmissions, in
+ * completion order, for up to BXCAN_SERVICE_TX_SLOTS completions
+ *
+ * @return uint8_t 1: work left for the next pass, 0: done
+ */
+static uint8_t bxCAN_ServiceTx(void) {
+  const bxCAN_TxRecord_t *record = NULL;
+  uint8_t tail = 0;
+  uint32_t start = 0;
+
+  for (uint8_t budget = BXCAN_SERVICE_TX_SLOTS; budget > 0; budget--) {
+    tail = bxCAN_TxRing.tail;
+    if (tail == bxCAN_TxRing.head) {
+      return 0;
+    }
+
+    /* the record is released after its callback, bxCAN_GetTxTime() reads it */
+    record = &bxCAN_TxRing.records[tail & BXCAN_SERVICE_TX_MASK];
+    start = Timebase_GetCycles();
+    record->callback(record->mailbox);
+    bxCAN_ServiceAccount(BXCAN_SOURCE_TX, start - record->cycles, start);
+    bxCAN_TxRing.tail = (uint8_t)(tail + 1u);
+  }
+
+  if (bxCAN_TxRing.tail == bxCAN_TxRing.head) {
+    return 0;
+  }
+
+  bxCAN_ServiceStatistics[BXCAN_SOURCE_TX].deferred++;
+  return 1;
+}
+
+/**
+ * @brief Run the RX handler of an RX FIFO for up to BXCAN_SERVICE_RX_BUDGET
+ * frames
+ *
+ * @param rx_fifo [in] RX FIFO
+ * @return uint8_t 1: work left for the next pass, 0: done
+ */
+static uint8_t bxCAN_ServiceRx(bxCAN_RxFifo_t rx_fifo) {
+  bxCAN_RxRing_t *const ring = &bxCAN_RxRings[rx_fifo];
+  const bxCAN_Source_t source = (bxCAN_Source_t)(BXCAN_SOURCE_RX0 + rx_fifo);
+  uint8_t tail = 0;
+  uint32_t start = 0;
+  uint32_t latency = 0;
+
+  for (uint8_t budget = BXCAN_SERVICE_RX_BUDGET; budget > 0; budget--) {
+    tail = ring->tail;
+    if (tail == ring->head) {
+      return 0;
+    }
+
+    /* the slot is reused once the handler read the frame */
+    start = Timebase_GetCycles();
+    latency = start - ring->slots[tail & BXCAN_SERVICE_RX_MASK].cycles;
+    if (ring->handler != NULL) {
+      ring->handler(&hcan);
+    }
+
+    /* frames the handler didn't read are dropped */
+    if (ring->tail == tail) {
+      ring->tail = (uint8_t)(tail + 1u);
+    }
+    bxCAN_ServiceAccount(source, latency, start);
+  }
+
+  if (ring->tail == ring->head) {
+    return 0;
+  }
+
+  bxCAN_ServiceStatistics[source].deferred++;
+  return 1;
+}
+
+/**
+ * @brief CAN service task, highest priority: runs the work moved out of the
+ * CAN interrupts in priority order (bxCAN_Source_t), in passes with a budget
+ * per source, so a busy RX FIFO doesn't hold back the other sources
+ *
+ * @param pvParam
+ */
+static void bxCAN_ServiceTaskFunction(void *const pvParam) {
+  uint8_t pending = 0;
+
+  while (1) {
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    do {
+      pending = bxCAN_ServiceErrors();
+      pending |= bxCAN_ServiceTx();
+      pending |= bxCAN_ServiceRx(BXCAN_RX_FIFO0);
+      pending |= bxCAN_ServiceRx(BXCAN_RX_FIFO1);
+    } while (pending != 0);
+  }
+
+  (void)pvParam;
+}
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+/**
+ * @brief Set the handler of the frames received in an RX FIFO, run by the
+ * CAN service task. Without the service task, the handler is the
+ * HAL_CAN_RxFifoxMsgPendingCallback() of the FIFO and this has no effect
+ *
+ * @param rx_fifo [in] RX FIFO
+ * @param handler [in] RX handler, reads the frame with bxCAN_Receive()
+ */
+void bxCAN_SetRxHandler(bxCAN_RxFifo_t rx_fifo, bxCAN_RxHandler_t handler) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  bxCAN_RxRings[rx_fifo].handler = handler;
+#else
+  (void)rx_fifo;
+  (void)handler;
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+/**
+ * @brief Get the CAN service task statistics of a source, all 0 without
+ * the service task
+ *
+ * @param source [in] work source
+ * @param statistics [out] statistics
+ */
+void bxCAN_GetServiceStatistics(bxCAN_Source_t source, bxCAN_ServiceStatistics_t *const statistics) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &bxCAN_ServiceStatistics[source], sizeof(bxCAN_ServiceStatistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+#else
+  (void)source;
+  memset(statistics, 0x00, sizeof(bxCAN_ServiceStatistics_t));
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
 
 /* USER CODE END 1 */
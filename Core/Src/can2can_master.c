@@ -3,56 +3,164 @@
 #include "gpio.h"
 #include "can.h"
 #include "cmsis_os.h"
+#include "event_channel.h"
 #include "can2can.h"
+#include "timebase.h"
+#include "clock_sync.h"
+#include "e2e.h"
+#include "hsm.h"
+#include "executive.h"
+#include "event_pool.h"
+#include "signal_db.h"
+#include "tx_scheduler.h"
+
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u) && (BXCAN_USE_TX_SCHEDULER != 1u)
+#error CAN2CAN_USE_SCHEDULE_TABLE needs BXCAN_USE_TX_SCHEDULER
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) && (BXCAN_USE_TX_SCHEDULER != 1u) */
+
+#if (CAN2CAN_SCHEDULE_BIT_RATE != BXCAN_BIT_RATE)
+#error CAN2CAN_SCHEDULE_BIT_RATE must be the bit rate of MX_CAN_Init()
+#endif /* (CAN2CAN_SCHEDULE_BIT_RATE != BXCAN_BIT_RATE) */
+
+/* RX handler, selected with the CAN driver configuration (can.h) */
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+#define MASTER_NODE_RX_FIFO_CALLBACK      MasterNode_RxFifoHandler  /* run by the CAN service task */
+#else
+#define MASTER_NODE_RX_FIFO_CALLBACK      HAL_CAN_RxFifo0MsgPendingCallback
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
 
 /**
  * @brief Master node state
  */
 typedef enum {
+  MASTER_NODE_STATE_OPERATING,  /* top level state, operation status frames are received in any sub-state */
   MASTER_NODE_STATE_IDLE,  /* master node is idle, waiting for time event to send next operation command */
   MASTER_NODE_STATE_TX,  /* master node waits for operation command transmission */
-  MASTER_NODE_STATE_RX,  /* master node receives operation status from slave node */
+  MASTER_NODE_STATE_NUMBER,
 } MasterNode_State_t;
 
+/**
+ * @brief Master schedule table entry
+ */
+typedef struct {
+  uint32_t offset_us;  /* operation command time, from the start of the command period */
+  uint8_t slave;       /* slave ID */
+} MasterNode_ScheduleEntry_t;
+
+/**
+ * @brief Master node view of a slave node
+ */
+typedef struct {
+  uint64_t cycle_start_us;    /* last command time, start of the current cycle */
+  uint32_t period_us;         /* operation status period of the current cycle */
+  uint32_t expected;          /* operation status frames expected for the last command */
+  uint32_t received;          /* operation status frames received since the last command */
+  uint32_t due;               /* operation status frames past their timeout in the current cycle */
+  uint32_t timed_out;         /* operation status frames declared lost in the current cycle */
+  uint64_t loss_us;           /* detection time of the current loss */
+  uint8_t lost;               /* 1: loss detected, waiting for the next operation status */
+  uint32_t inject;            /* received operation status frames to discard (loss injection) */
+  MasterNode_SlaveStatistics_t statistics;
+  Jitter_t jitter;            /* operation status reception period jitter */
+  uint64_t command_tx_us;     /* TX complete time of the last command, 0: not transmitted yet */
+  uint64_t last_status_us;    /* reception time of the last operation status since the last command, 0: none */
+  Histogram_t latency[MASTER_NODE_LATENCY_NUMBER];
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  uint8_t sequence_valid;     /* 1: a sequence number was received, next_sequence is valid */
+  uint8_t next_sequence;      /* sequence number expected next */
+  uint32_t sequence_window;   /* bit n: sequence number next_sequence - 1 - n was received */
+  MasterNode_SequenceStatistics_t sequence;
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+} MasterNode_Slave_t;
+
 
 /* operation commands */
 const OperationCommand_t OperationCommandOFF = OPERATION_COMMAND_OFF;
 const OperationCommand_t OperationCommandON  = OPERATION_COMMAND_ON;
 
-/* master node current state */
-static MasterNode_State_t MasterNode_CurrentState = MASTER_NODE_STATE_IDLE;
+/* master node state machine */
+static Hsm_t MasterNode_Hsm = {0};
+
+/* slave nodes */
+static MasterNode_Slave_t MasterNode_Slaves[CAN2CAN_SLAVE_NUMBER] = {0};
+
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+/* communication schedule table, the operation commands are the master's
+ * expiry points, and the current one */
+static ScheduleTable_Run_t MasterNode_ScheduleRun = {0};
+static ScheduleTable_ExpiryPoint_t MasterNode_ExpiryPoint = {0};
+#else
+/* schedule table, and start of the current command period (us) */
+static MasterNode_ScheduleEntry_t MasterNode_Schedule[CAN2CAN_SLAVE_NUMBER] = {0};
+static uint32_t MasterNode_ScheduleIndex = 0;
+static uint64_t MasterNode_PeriodStart = 0;
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
 
-/* master node current operation status */
-static OperationStatus_t MasterNode_CurrentOperationStatus = {0};
+/* master role enabled, operation commands are sent */
+static volatile uint8_t MasterNode_Active = 1;
 
-static uint32_t MasterNode_ReceivedMessages = 0;
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/* the current schedule table entry was armed with a command (master role enabled then) */
+static uint8_t MasterNode_CommandScheduled = 0;
 
+static void MasterNode_BxCANTxCompleteCallback(uint8_t mailbox);
+static void MasterNode_ReleaseCallback(uint64_t release_us);
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+/* CAN errors reported by the peripheral */
+static uint32_t MasterNode_CANErrorCount = 0;
+static uint32_t MasterNode_LastCANError = 0;
+
+/* earliest operation status timeout of all slaves, UINT64_MAX: none */
+static uint64_t MasterNode_NextDeadline = UINT64_MAX;
+
+/* operation status rate commanded to the slaves, and rate to use from the next command period */
+static uint16_t MasterNode_StatusRate = OPERATION_STATUS_FREQUENCY;
+static volatile uint16_t MasterNode_RequestedStatusRate = OPERATION_STATUS_FREQUENCY;
+
+/* event time stamp to dispatch latency */
+static EventLatency_t MasterNode_EventLatency = {0};
+
+/* TIME_EVENT not allocated (event pool empty), retried */
+static volatile uint32_t MasterNode_DroppedTimeEvents = 0;
+
+/* other consumers of the received operation status frames */
+static EventPool_Subscriber_t MasterNode_FrameSubscribers[MASTER_NODE_FRAME_SUBSCRIBERS] = {0};
+static uint8_t MasterNode_FrameSubscriberCount = 0;
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+/* master node ID in the executive */
+static uint8_t MasterNode_ExecutiveId = 0;
+#else
 /* master node task */
 static TaskHandle_t MasterNode_TaskHandle = NULL;
 static StaticTask_t MasterNode_TaskBuffer = {0};
 static StackType_t MasterNode_TaskStack[MASTER_TASK_STACK_DEPTH] = {0};
 
-/* master node CAN RX message queue */
-static QueueHandle_t MasterNode_RxQueueHandle = NULL;
-static uint8_t MasterNode_RxQueueStorage[MASTER_NODE_RX_QUEUE_SIZE * OPERATION_STATUS_MSG_SIZE] = {0};
-static StaticQueue_t MasterNode_RxQueue = {0};
-
+#if (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+/* master node event channel, one slot per pool event, never full */
+static EventChannel_t MasterNode_EventChannel = {0};
+static Event_t *MasterNode_EventChannelStorage[EVENT_POOL_SIZE] = {0};
+#else
 /* master node event queue */
 static QueueHandle_t MasterNode_EventQueueHandle = NULL;
 static StaticQueue_t MasterNode_EventQueue = {0};
-static Event_t MasterNode_EventQueueStorage[MASTER_NODE_MAX_EVENTS] = {0};
+static Event_t *MasterNode_EventQueueStorage[MASTER_NODE_MAX_EVENTS] = {0};
+#endif /* (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
 
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
 /* master node timer */
 static TimerHandle_t MasterNode_TimerHandle = NULL;
 static StaticTimer_t MasterNode_Timer = {0};
 static uint32_t MasterNode_TimerID = 0xF0;
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
 
 static const bxCAN_Filter_t MasterNode_CANRxFilter = {
   .as_struct = {
     .RTR = 0, /* data */
     .IDE = 0, /* standard ID */
     .StdId = OPERATION_STATUS_STD_ID
-    // .StdId = OPERATION_COMMAND_STD_ID
   }
 };
 
@@ -60,232 +168,854 @@ static const bxCAN_Filter_t MasterNode_CANRxMask = {
   .as_struct = {
     .RTR = 0, /* don't care */
     .IDE = 0, /* don't care */
-    .StdId = ~0 /* exact match */
+    .StdId = ~SLAVE_ID_STD_ID_MASK & 0x7FFu /* operation status of any slave */
   }
 };
 
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+/**
+ * @brief Slave of the current expiry point
+ */
+static inline uint8_t MasterNode_ScheduledSlave(void) {
+  return MasterNode_ExpiryPoint.slave;
+}
+
+/**
+ * @brief Command time of the current expiry point
+ */
+static inline uint64_t MasterNode_ScheduledTime(void) {
+  return MasterNode_ExpiryPoint.release_us;
+}
+#else
+/**
+ * @brief Fill the schedule table, slaves are commanded in ID order, spread
+ * over the operation status period
+ */
+static void MasterNode_BuildSchedule(void) {
+  const uint32_t status_period_us = OPERATION_STATUS_PERIOD_US_AT(MasterNode_StatusRate);
+
+  for (uint32_t slave = 0; slave < CAN2CAN_SLAVE_NUMBER; slave++) {
+    MasterNode_Schedule[slave].offset_us = MASTER_NODE_SCHEDULE_OFFSET_US(slave, CAN2CAN_SLAVE_NUMBER, status_period_us);
+    MasterNode_Schedule[slave].slave = (uint8_t)slave;
+  }
+}
+
+/**
+ * @brief Slave of the current schedule table entry
+ */
+static inline uint8_t MasterNode_ScheduledSlave(void) {
+  return MasterNode_Schedule[MasterNode_ScheduleIndex].slave;
+}
+
+/**
+ * @brief Command time of the current schedule table entry, relative to the
+ * start of the command period
+ */
+static inline uint64_t MasterNode_ScheduledTime(void) {
+  return MasterNode_PeriodStart + MasterNode_Schedule[MasterNode_ScheduleIndex].offset_us;
+}
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+
+/**
+ * @brief Pack the operation command of a slave, selected from its current
+ * operation status
+ *
+ * @param slave_id [in] slave ID
+ * @param tx_message [out] frame data
+ */
+static void MasterNode_PackCommand(uint8_t slave_id, uint8_t *const tx_message) {
+  OperationCommand_Msg_t command = {0};
+  OperationStatus_t status = {0};
+
+  (void)SignalDb_Read(SIGNAL_MASTER_STATUS_OF(slave_id), &status, NULL);
+  if(status.status == 0x00) {
+    command.command = OperationCommandON;
+  } else {
+    command.command = OperationCommandOFF;
+  }
+  command.status_rate = MasterNode_StatusRate;
+
+  OperationCommand_Pack(&command, tx_message);
+}
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+ * @brief Arm the TX scheduler at the current schedule table entry (expiry
+ * point). The command is built now, from the operation status known one slot
+ * before it's sent
+ */
+static void MasterNode_StartScheduleTimer(void) {
+  const uint8_t slave_id = MasterNode_ScheduledSlave();
+  TxScheduler_Frame_t frame = {0};
+
+  /* master role disabled, the slot is released without a frame */
+  MasterNode_CommandScheduled = MasterNode_Active;
+  if (MasterNode_CommandScheduled != 0) {
+    MasterNode_PackCommand(slave_id, frame.data);
+    frame.std_id = OPERATION_COMMAND_STD_ID_OF(slave_id);
+    frame.len = OPERATION_COMMAND_MSG_SIZE;
+  }
+
+  TxScheduler_Arm(TX_SCHEDULER_SLOT_MASTER,
+    MasterNode_ScheduledTime(),
+    (MasterNode_CommandScheduled != 0) ? &frame : NULL,
+    MasterNode_BxCANTxCompleteCallback,
+    MasterNode_ReleaseCallback
+  );
+}
+#else
+/**
+ * @brief Start master node timer to expire at the current schedule table
+ * entry, relative to the start of the command period so that delays in
+ * handling TIME_EVENT don't accumulate
+ */
+static void MasterNode_StartScheduleTimer(void) {
+  uint64_t expiry_us = MasterNode_ScheduledTime();
+  uint64_t now_us = Timebase_GetMicros();
+  TickType_t delay = 1;
+
+  /* late (or first entry at offset 0), expire as soon as possible */
+  if (expiry_us > now_us) {
+    delay = pdMS_TO_TICKS((uint32_t)((expiry_us - now_us + 999u) / 1000u));
+    if (delay == 0) {
+      delay = 1;
+    }
+  }
+
+  configASSERT(xTimerChangePeriod(MasterNode_TimerHandle, delay, portMAX_DELAY) == pdPASS);
+}
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+/**
+ * @brief Move to the next expiry point, the status rate is fixed by the table
+ */
+static void MasterNode_AdvanceSchedule(void) {
+  configASSERT(ScheduleTable_Next(&MasterNode_ScheduleRun, &MasterNode_ExpiryPoint) != 0);
+
+  MasterNode_StartScheduleTimer();
+}
+#else
+/**
+ * @brief Move to the next schedule table entry
+ */
+static void MasterNode_AdvanceSchedule(void) {
+  MasterNode_ScheduleIndex++;
+  if (MasterNode_ScheduleIndex == CAN2CAN_SLAVE_NUMBER) {
+    MasterNode_ScheduleIndex = 0;
+    MasterNode_PeriodStart += (uint64_t)OPERATION_COMMAND_PERIOD_MS * 1000u;
+
+    /* status rate changes take effect at the start of a command period */
+    if (MasterNode_RequestedStatusRate != MasterNode_StatusRate) {
+      MasterNode_StatusRate = MasterNode_RequestedStatusRate;
+      MasterNode_BuildSchedule();
+    }
+  }
+
+  MasterNode_StartScheduleTimer();
+}
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+
+/**
+ * @brief Timeout of the next operation status frame of a slave
+ *
+ * @param slave [in] slave
+ * @return uint64_t time (us) after which the frame is declared lost
+ */
+static inline uint64_t MasterNode_StatusDeadline(const MasterNode_Slave_t *const slave) {
+  return slave->cycle_start_us + ((uint64_t)slave->due * slave->period_us)
+    + MASTER_NODE_STATUS_TIMEOUT_US(slave->period_us);
+}
+
+/**
+ * @brief Close the current cycle of a slave and start a new one, called when
+ * a command is sent to the slave
+ *
+ * @param slave [in] slave
+ * @param now_us [in] command time
+ */
+static void MasterNode_StartCycle(MasterNode_Slave_t *const slave, uint64_t now_us) {
+  /* operation status frames of the previous command that never arrived */
+  if (slave->expected > 0) {
+    slave->statistics.cycles++;
+    if (slave->received >= slave->expected) {
+      slave->statistics.complete_cycles++;
+    } else {
+      slave->statistics.missed += slave->expected - slave->received;
+    }
+  }
+
+  slave->cycle_start_us = now_us;
+  slave->period_us = OPERATION_STATUS_PERIOD_US_AT(MasterNode_StatusRate);
+  slave->expected = OPERATION_STATUS_COUNT_AT(MasterNode_StatusRate);
+  slave->received = 0;
+  slave->due = 0;
+  slave->timed_out = 0;
+  slave->command_tx_us = 0;
+  slave->last_status_us = 0;
+
+  if (MasterNode_StatusDeadline(slave) < MasterNode_NextDeadline) {
+    MasterNode_NextDeadline = MasterNode_StatusDeadline(slave);
+  }
+}
+
+/**
+ * @brief Declare operation status frames past their timeout lost, and find
+ * the next timeout
+ *
+ * @param now_us [in] current time
+ */
+static void MasterNode_CheckTimeouts(uint64_t now_us) {
+  MasterNode_NextDeadline = UINT64_MAX;
+
+  for (uint32_t slave_id = 0; slave_id < CAN2CAN_SLAVE_NUMBER; slave_id++) {
+    MasterNode_Slave_t *const slave = &MasterNode_Slaves[slave_id];
+
+    while ((slave->due < slave->expected) && (MasterNode_StatusDeadline(slave) <= now_us)) {
+      slave->due++;
+    }
+
+    /* late frames received after their timeout don't undo it */
+    if (slave->due > (slave->received + slave->timed_out)) {
+      uint32_t overdue = slave->due - (slave->received + slave->timed_out);
+      slave->timed_out += overdue;
+      slave->statistics.timeouts += overdue;
+      if (slave->lost == 0) {
+        slave->lost = 1;
+        slave->loss_us = now_us;
+        slave->statistics.losses++;
+      }
+    }
+
+    if ((slave->due < slave->expected) && (MasterNode_StatusDeadline(slave) < MasterNode_NextDeadline)) {
+      MasterNode_NextDeadline = MasterNode_StatusDeadline(slave);
+    }
+  }
+}
+
+/**
+ * @brief Post an event to the master node, from a task
+ *
+ * @param pEvent [in] pool event, the caller's reference is passed to the master node
+ */
+static inline void MasterNode_PostEvent(Event_t *const pEvent) {
+  configASSERT(pEvent != NULL);
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  configASSERT(Executive_Post(MasterNode_ExecutiveId, pEvent) == pdPASS);
+#elif (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  configASSERT(EventChannel_Post(&MasterNode_EventChannel, pEvent) == pdPASS);
+#else
+  configASSERT(xQueueSend(MasterNode_EventQueueHandle, (const void *const)&pEvent, 0) == pdTRUE);
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+}
+
+/**
+ * @brief Post an event to the master node, from an ISR. The event is
+ * released if the queue is full
+ *
+ * @param pEvent [in] pool event, the caller's reference is passed to the master node
+ */
+static inline void MasterNode_PostEventFromISR(Event_t *const pEvent) {
+  BaseType_t xTaskWoken = pdFALSE;
+  BaseType_t queued = pdFALSE;
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  queued = Executive_PostFromISR(MasterNode_ExecutiveId, pEvent, &xTaskWoken);
+#elif (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  queued = EventChannel_PostFromISR(&MasterNode_EventChannel, pEvent, &xTaskWoken);
+#else
+  queued = xQueueSendFromISR(MasterNode_EventQueueHandle, (const void *const)&pEvent, &xTaskWoken);
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+
+  if (queued != pdTRUE) {
+    EventPool_Release(pEvent);
+  }
+
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+/**
+ * @brief Post an event of a CAN handler or callback to the master node, from
+ * the CAN service task (BXCAN_USE_SERVICE_TASK) or the CAN interrupt. The
+ * event is released if the queue is full
+ *
+ * @param pEvent [in] pool event, the caller's reference is passed to the master node
+ */
+static inline void MasterNode_PostCANEvent(Event_t *const pEvent) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  BaseType_t queued = pdFALSE;
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  queued = Executive_Post(MasterNode_ExecutiveId, pEvent);
+#elif (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  queued = EventChannel_Post(&MasterNode_EventChannel, pEvent);
+#else
+  queued = xQueueSend(MasterNode_EventQueueHandle, (const void *const)&pEvent, 0);
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+
+  if (queued != pdTRUE) {
+    EventPool_Release(pEvent);
+  }
+#else
+  MasterNode_PostEventFromISR(pEvent);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+/**
+ * @brief Account the sequence number of a received operation status frame:
+ * frames ahead of the expected number open a gap (burst of lost frames),
+ * frames behind it are duplicates if already received, or reordered (late)
+ * frames that were counted lost
+ *
+ * @param slave [in] slave
+ * @param sequence [in] received sequence number
+ */
+static void MasterNode_TrackSequence(MasterNode_Slave_t *const slave, uint8_t sequence) {
+  MasterNode_SequenceStatistics_t *const statistics = &slave->sequence;
+  uint8_t ahead = (uint8_t)(sequence - slave->next_sequence);
+  uint8_t behind = 0;
+  uint32_t bin = 0;
+
+  /* first frame, nothing to compare to */
+  if (slave->sequence_valid == 0) {
+    slave->sequence_valid = 1;
+    slave->next_sequence = (uint8_t)(sequence + 1u);
+    slave->sequence_window = 1;
+    statistics->in_order++;
+    return;
+  }
+
+  /* half the sequence number range ahead is a gap, the other half is the past */
+  if (ahead < 128u) {
+    if (ahead == 0) {
+      statistics->in_order++;
+    } else {
+      statistics->lost += ahead;
+      statistics->bursts++;
+      if (ahead > statistics->max_burst) {
+        statistics->max_burst = ahead;
+      }
+      for (uint8_t length = ahead; (length > 1u) && (bin < (MASTER_NODE_BURST_BINS - 1u)); length >>= 1) {
+        bin++;
+      }
+      statistics->burst_histogram[bin]++;
+    }
+
+    slave->sequence_window = ((ahead + 1u) < MASTER_NODE_SEQUENCE_WINDOW) ? (slave->sequence_window << (ahead + 1u)) : 0;
+    slave->sequence_window |= 1u;
+    slave->next_sequence = (uint8_t)(sequence + 1u);
+    return;
+  }
+
+  behind = (uint8_t)(slave->next_sequence - 1u - sequence);
+  if ((behind < MASTER_NODE_SEQUENCE_WINDOW) && ((slave->sequence_window & (1uL << behind)) != 0)) {
+    statistics->duplicates++;
+    return;
+  }
+
+  /* late frame, it was counted lost when the newer frame arrived. Frames
+   * older than the window can't be told from duplicates, they're counted
+   * as reordered */
+  statistics->reordered++;
+  if (behind < MASTER_NODE_SEQUENCE_WINDOW) {
+    slave->sequence_window |= (1uL << behind);
+    if (statistics->lost > 0) {
+      statistics->lost--;
+    }
+  }
+}
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+ * @brief TX scheduler release callback, from the TIM2 interrupt: the
+ * operation command of the slot was loaded into the mailbox (or the slot
+ * had none), sends TIME_EVENT to the master node
+ *
+ * @param release_us [in] release time of the slot
+ */
+static void MasterNode_ReleaseCallback(uint64_t release_us) {
+  Event_t *const time_event = EventPool_Alloc(TIME_EVENT);
+
+  /* pool empty, the command was sent, the node gets its TIME_EVENT on a
+   * retry of the slot so the schedule goes on */
+  if (time_event == NULL) {
+    MasterNode_DroppedTimeEvents++;
+    TxScheduler_RetryFromISR(TX_SCHEDULER_SLOT_MASTER);
+    return;
+  }
+
+  time_event->timestamp_us = release_us;
+
+  MasterNode_PostEventFromISR(time_event);
+}
+#else
 /**
  * @brief Master node timer callback function, sends TIME_EVENT
- * to MasterTask_EventQueue
+ * to the master node
  * 
  * @param timer_handle 
  */
 static void MasterNode_TimerCallback(TimerHandle_t timer_handle) {
-  Event_t time_event = {
-      .type = TIME_EVENT,
-  };
+  Event_t *const time_event = EventPool_Alloc(TIME_EVENT);
+
+  /* pool empty, the entry is retried one tick later so the schedule goes on */
+  if (time_event == NULL) {
+    MasterNode_DroppedTimeEvents++;
+    (void)xTimerChangePeriod(timer_handle, 1, 0);
+    return;
+  }
+
+  time_event->timestamp_us = Timebase_GetMicros();
 
-  /* send timer event to MasterTask_EventQueue */
-  configASSERT(xQueueSend(MasterNode_EventQueueHandle, (const void *const)&time_event, 0) == pdTRUE);
+  MasterNode_PostEvent(time_event);
 }
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
 
 /**
- * @brief CAN FIFO 0 message pending callback
+ * @brief CAN FIFO 0 message pending callback, or RX handler run by the CAN
+ * service task (BXCAN_USE_SERVICE_TASK)
  * 
  * @param hcan [in] pointer to CAN handle that triggered the callback
  */
 void MASTER_NODE_RX_FIFO_CALLBACK(CAN_HandleTypeDef *hcan) {
-  BaseType_t xTaskWoken = pdFALSE;
-  Event_t rx_event = {
-    .type = CAN_RX_EVENT,
-  };
+  const uint64_t timestamp_us = bxCAN_GetRxTime(MASTER_NODE_RX_FIFO);
+  Event_t *const rx_event = EventPool_Alloc(CAN_RX_EVENT);
+  EventFrame_t discarded = {0};
+  EventFrame_t *const frame = (rx_event != NULL) ? &rx_event->payload.frame : &discarded;
 
-  configASSERT(HAL_CAN_DeactivateNotification(hcan, MASTER_NODE_RX_FIFO_NOTIFICATION) == HAL_OK);
+  /* the frame is delivered with the event, the task doesn't access the RX
+   * FIFO. It's read even if the pool is empty, to release the FIFO */
+  configASSERT(bxCAN_Receive(MASTER_NODE_RX_FIFO, frame->data, &frame->len, &frame->std_id, &frame->e2e_status) == HAL_OK);
+  if (rx_event == NULL) {
+    return;
+  }
 
-  xQueueSendFromISR(MasterNode_EventQueueHandle, &rx_event, &xTaskWoken);
-  portYIELD_FROM_ISR(xTaskWoken);
+  rx_event->timestamp_us = timestamp_us;
+
+  /* the same event is published to every consumer, one reference each */
+  for (uint8_t subscriber = 0; subscriber < MasterNode_FrameSubscriberCount; subscriber++) {
+    MasterNode_FrameSubscribers[subscriber](EventPool_Ref(rx_event));
+  }
+
+  MasterNode_PostCANEvent(rx_event);
 }
 
 /**
  * @brief CAN TX complete callback
  * 
- * @param hcan [in] pointer to CAN handle that triggered the callback
  * @param mailbox [in] mailbox used to transmit the message
  */
-static void MasterNode_BxCANTxCompleteCallback(void) {
-  BaseType_t xTaskWoken = pdFALSE;
-  Event_t rx_event = {
-    .type = CAN_TX_EVENT,
-  };
+static void MasterNode_BxCANTxCompleteCallback(uint8_t mailbox) {
+  const uint64_t timestamp_us = bxCAN_GetTxTime(mailbox);
+  Event_t *const tx_event = EventPool_Alloc(CAN_TX_EVENT);
 
-  xQueueSendFromISR(MasterNode_EventQueueHandle, &rx_event, &xTaskWoken);
-  portYIELD_FROM_ISR(xTaskWoken);
+  if (tx_event == NULL) {
+    return;
+  }
+
+  tx_event->timestamp_us = timestamp_us;
+  tx_event->payload.tx.std_id = bxCAN_GetTxStdId(mailbox);
+  tx_event->payload.tx.mailbox = mailbox;
+
+  MasterNode_PostCANEvent(tx_event);
 }
 
 /**
- * @brief Master node idle state handler
+ * @brief CAN error callback
  * 
- * @param pEvent [in] pointer to the current event
+ * @param error [in] HAL_CAN_ERROR_x flags
  */
-static StateResult_t MasterNode_Idle_StateHandler(const Event_t * const pEvent) {
-  const uint8_t * command = NULL;
+static void MasterNode_BxCANErrorCallback(uint32_t error) {
+  const uint64_t timestamp_us = Timebase_GetMicros();
+  Event_t *const error_event = EventPool_Alloc(CAN_ERROR_EVENT);
 
-  if(pEvent->type != TIME_EVENT) {
-    /* pass event */
-    return EVENT_IGNORED;
+  if (error_event == NULL) {
+    return;
   }
 
-  /* select command based on current operation status */
-  if(MasterNode_CurrentOperationStatus.status == 0x00) {
-    command = (uint8_t *)&OperationCommandON;
-  } else {
-    command = (uint8_t *)&OperationCommandOFF;
+  error_event->timestamp_us = timestamp_us;
+  error_event->payload.error.code = error;
+
+  MasterNode_PostCANEvent(error_event);
+}
+
+/**
+ * @brief Send the operation command of the current schedule table entry
+ * 
+ * @param pEvent [in] pointer to the current event (TIME_EVENT)
+ */
+static StateResult_t MasterNode_SendCommand(const Event_t * const pEvent) {
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
+  uint8_t tx_message [BXCAN_MAX_DATA_SIZE] = {0};
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
+  uint8_t slave_id = 0;
+  MasterNode_Slave_t *slave = NULL;
+
+  /* master role disabled (when the slot was armed, with the TX scheduler),
+   * the schedule keeps running so that command slots stay aligned when it's
+   * enabled again */
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+  if (MasterNode_CommandScheduled == 0) {
+#else
+  if (MasterNode_Active == 0) {
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+    MasterNode_AdvanceSchedule();
+    return EVENT_IGNORED;
   }
 
-  /* send command */
+  slave_id = MasterNode_ScheduledSlave();
+  slave = &MasterNode_Slaves[slave_id];
+
+  /* late operation status frames of the previous command are accepted until
+   * now, or until the release of the command sent by the TX scheduler */
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+  MasterNode_StartCycle(slave, pEvent->timestamp_us);
+#else
+  MasterNode_StartCycle(slave, Timebase_GetMicros());
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+  /* new operation status sequence, the gap from the previous one isn't a period */
+  taskENTER_CRITICAL();
+  Jitter_Restart(&slave->jitter, OPERATION_STATUS_PERIOD_US_AT(MasterNode_StatusRate));
+  taskEXIT_CRITICAL();
+
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
+  /* send command, selected from the current operation status */
+  MasterNode_PackCommand(slave_id, tx_message);
   configASSERT(
     bxCAN_Transmit(
-      command, 
+      tx_message, 
       OPERATION_COMMAND_MSG_SIZE, 
-      OPERATION_COMMAND_STD_ID, 
+      OPERATION_COMMAND_STD_ID_OF(slave_id), 
       MasterNode_BxCANTxCompleteCallback) 
     == HAL_OK
   );
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
+
+  /* wait for next slave's slot */
+  MasterNode_AdvanceSchedule();
 
   /* event was processed */
   return EVENT_HANDLED;
 }
 
 /**
- * @brief Master node transmit state handler
+ * @brief Record the transmission time of an operation command, the start of
+ * the command to status latency
  * 
- * @param pEvent [in] pointer to the current event
+ * @param pEvent [in] pointer to the current event (CAN_TX_EVENT)
  */
-static StateResult_t MasterNode_Transmit_StateHandler(const Event_t * const pEvent) {
-  if(pEvent->type != CAN_TX_EVENT) {
-    return EVENT_IGNORED;
+static StateResult_t MasterNode_CommandSent(const Event_t * const pEvent) {
+  const uint16_t std_id = pEvent->payload.tx.std_id;
+
+  if ((SLAVE_ID_OF_STD_ID(std_id) >= CAN2CAN_SLAVE_NUMBER)
+      || (std_id != OPERATION_COMMAND_STD_ID_OF(SLAVE_ID_OF_STD_ID(std_id)))) {
+    return EVENT_HANDLED;
   }
 
-  /* reset received message count */
-  MasterNode_ReceivedMessages = 0;
+  MasterNode_Slaves[SLAVE_ID_OF_STD_ID(std_id)].command_tx_us = pEvent->timestamp_us;
 
-  /* event was processed */
+  /* event processed */
   return EVENT_HANDLED;
 }
 
 /**
- * @brief Master node receive status state handler
+ * @brief Add an operation status reception to the latency histograms: the
+ * first frame after a command to the command latency, the next ones to the
+ * status interval
+ *
+ * @param slave [in] slave
+ * @param rx_time_us [in] reception time
+ */
+static void MasterNode_UpdateLatency(MasterNode_Slave_t *const slave, uint64_t rx_time_us) {
+  if (slave->last_status_us != 0) {
+    Histogram_Add(&slave->latency[MASTER_NODE_LATENCY_STATUS], (uint32_t)(rx_time_us - slave->last_status_us));
+  } else if ((slave->command_tx_us != 0) && (rx_time_us >= slave->command_tx_us)) {
+    Histogram_Add(&slave->latency[MASTER_NODE_LATENCY_COMMAND], (uint32_t)(rx_time_us - slave->command_tx_us));
+  }
+
+  slave->last_status_us = rx_time_us;
+}
+
+/**
+ * @brief Receive an operation status frame
  * 
- * @param pEvent [in] pointer to the current event
+ * @param pEvent [in] pointer to the current event (CAN_RX_EVENT)
  */
-static StateResult_t MasterNode_ReceiveStatus_StateHandler(const Event_t * const pEvent) {
-  uint8_t rx_message [BXCAN_MAX_DATA_SIZE] = {0};
-  uint16_t StdId = 0;
-  uint8_t len = 0;
+static StateResult_t MasterNode_ReceiveStatus(const Event_t * const pEvent) {
+  const EventFrame_t *const frame = &pEvent->payload.frame;
+  const uint64_t rx_time_us = pEvent->timestamp_us;
+  OperationStatus_Msg_t status = {0};
+  OperationStatus_t current = {0};
+  MasterNode_Slave_t *slave = NULL;
+  uint8_t discard = 0;
 
-  if(pEvent->type != CAN_RX_EVENT) {
-    /* pass event */
-    return EVENT_IGNORED;
+  /* filter accepts the whole ID range, ignore slaves that aren't polled */
+  if(SLAVE_ID_OF_STD_ID(frame->std_id) >= CAN2CAN_SLAVE_NUMBER) {
+    return EVENT_HANDLED;
   }
 
-  /* receive message from CAN RX message queue */
-  configASSERT(bxCAN_Receive(MASTER_NODE_RX_FIFO, rx_message, &len, &StdId) == HAL_OK);
-  configASSERT(HAL_CAN_ActivateNotification(&hcan, MASTER_NODE_RX_FIFO_NOTIFICATION) == HAL_OK);
+  slave = &MasterNode_Slaves[SLAVE_ID_OF_STD_ID(frame->std_id)];
 
-  /* process received message */
-  MasterNode_CurrentOperationStatus.status = rx_message[0];
-  MasterNode_CurrentOperationStatus.value  = rx_message[1];
-  
-  /* update received message count */
-  MasterNode_ReceivedMessages++;
-  if(MasterNode_ReceivedMessages < OPERATION_STATUS_COUNT) {
-    /* event processed */
-    return EVENT_IGNORED;
+  taskENTER_CRITICAL();
+  if (slave->inject > 0) {
+    slave->inject--;
+    slave->statistics.injected++;
+    discard = 1;
+  } else {
+    Jitter_Update(&slave->jitter, rx_time_us);
+    MasterNode_UpdateLatency(slave, rx_time_us);
+  }
+  taskEXIT_CRITICAL();
+
+  /* injected loss, handled as if the frame never arrived */
+  if (discard) {
+    return EVENT_HANDLED;
+  }
+
+  slave->received++;
+  slave->statistics.received++;
+
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  /* repeated and out of sequence frames are valid frames, only corrupted ones are skipped */
+  if ((frame->e2e_status != E2E_STATUS_ERROR) && (frame->len >= OPERATION_STATUS_MSG_SIZE)) {
+    OperationStatus_Unpack(frame->data, &status);
+    MasterNode_TrackSequence(slave, status.sequence);
+  }
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+
+  /* first frame after a loss, the slave is back */
+  if (slave->lost) {
+    slave->lost = 0;
+    slave->statistics.last_recovery_us = (rx_time_us > slave->loss_us) ? (uint32_t)(rx_time_us - slave->loss_us) : 0;
+    if (slave->statistics.last_recovery_us > slave->statistics.max_recovery_us) {
+      slave->statistics.max_recovery_us = slave->statistics.last_recovery_us;
+    }
+  }
+
+  /* process received message, corrupted, repeated or out of sequence status is discarded */
+  if (frame->e2e_status == E2E_STATUS_OK) {
+    OperationStatus_Unpack(frame->data, &status);
+    current.status = status.status;
+    current.value  = status.value;
+    SignalDb_Write(SIGNAL_MASTER_STATUS_OF(SLAVE_ID_OF_STD_ID(frame->std_id)), &current);
   }
-  
+
   /* event processed */
   return EVENT_HANDLED;
 }
 
+/**
+ * @brief Count a CAN error
+ * 
+ * @param pEvent [in] pointer to the current event (CAN_ERROR_EVENT)
+ */
+static StateResult_t MasterNode_CountCANError(const Event_t * const pEvent) {
+  MasterNode_CANErrorCount++;
+  MasterNode_LastCANError = pEvent->payload.error.code;
 
+  /* event processed */
+  return EVENT_HANDLED;
+}
+
+/* transition tables, indexed by event type */
+static const Hsm_Transition_t MasterNode_OperatingTransitions[EVENT_TYPE_NUMBER] = {
+  [CAN_RX_EVENT] = HSM_INTERNAL(MasterNode_ReceiveStatus),
+  [CAN_TX_EVENT] = HSM_INTERNAL(MasterNode_CommandSent), /* TX complete of an earlier command */
+  [CAN_ERROR_EVENT] = HSM_INTERNAL(MasterNode_CountCANError),
+};
+
+static const Hsm_Transition_t MasterNode_IdleTransitions[EVENT_TYPE_NUMBER] = {
+  [TIME_EVENT] = HSM_EXTERNAL(MasterNode_SendCommand, MASTER_NODE_STATE_TX),
+};
+
+static const Hsm_Transition_t MasterNode_TransmitTransitions[EVENT_TYPE_NUMBER] = {
+  [TIME_EVENT] = HSM_INTERNAL(MasterNode_SendCommand), /* next slot came before TX complete, the schedule can't wait */
+  [CAN_TX_EVENT] = HSM_EXTERNAL(MasterNode_CommandSent, MASTER_NODE_STATE_IDLE),
+};
+
+/* state table, indexed by state ID */
+static const Hsm_State_t MasterNode_States[MASTER_NODE_STATE_NUMBER] = {
+  [MASTER_NODE_STATE_OPERATING] = {
+    .parent = HSM_NO_STATE,
+    .initial = MASTER_NODE_STATE_IDLE,
+    .transitions = MasterNode_OperatingTransitions,
+  },
+  [MASTER_NODE_STATE_IDLE] = {
+    .parent = MASTER_NODE_STATE_OPERATING,
+    .initial = HSM_NO_STATE,
+    .transitions = MasterNode_IdleTransitions,
+  },
+  [MASTER_NODE_STATE_TX] = {
+    .parent = MASTER_NODE_STATE_OPERATING,
+    .initial = HSM_NO_STATE,
+    .transitions = MasterNode_TransmitTransitions,
+  },
+};
+
+/**
+ * @brief Start the master node, called from the task that runs it before
+ * the first event
+ */
+static void MasterNode_Start(void) {
+  /* first command period starts now */
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  ScheduleTable_Start(&MasterNode_ScheduleRun, &Can2Can_Schedule, SCHEDULE_TABLE_SENDER_MASTER, 0, Timebase_GetMicros());
+  configASSERT(ScheduleTable_Next(&MasterNode_ScheduleRun, &MasterNode_ExpiryPoint) != 0);
+#else
+  MasterNode_PeriodStart = Timebase_GetMicros();
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+  MasterNode_StartScheduleTimer();
+}
+
+/**
+ * @brief Check operation status timeouts and the E2E timeouts of the
+ * protected IDs, called before waiting for the next event
+ *
+ * @return TickType_t ticks to the next timeout, portMAX_DELAY: none
+ */
+static TickType_t MasterNode_Poll(void) {
+  uint64_t now_us = Timebase_GetMicros();
+  uint32_t e2e_ms = 0;
+  TickType_t wait = portMAX_DELAY;
+
+  /* operation status timeouts, checked on every event and when the next one expires */
+  if (MasterNode_NextDeadline <= now_us) {
+    MasterNode_CheckTimeouts(now_us);
+  }
+
+  /* E2E timeouts of the received IDs, the master and slave roles included */
+  e2e_ms = E2E_Supervise();
+
+  if (MasterNode_NextDeadline != UINT64_MAX) {
+    wait = pdMS_TO_TICKS((uint32_t)((MasterNode_NextDeadline - now_us + 999u) / 1000u));
+  }
+
+  if ((e2e_ms != UINT32_MAX) && (pdMS_TO_TICKS(e2e_ms) < wait)) {
+    wait = pdMS_TO_TICKS(e2e_ms);
+  }
+
+  return wait;
+}
+
+/**
+ * @brief Run an event to completion in the master node state machine
+ *
+ * @param pEvent [in] event
+ */
+static void MasterNode_DispatchEvent(const Event_t *const pEvent) {
+  uint64_t now_us = Timebase_GetMicros();
+
+  taskENTER_CRITICAL();
+  EventLatency_Update(&MasterNode_EventLatency, pEvent, now_us);
+  taskEXIT_CRITICAL();
+
+  Hsm_Dispatch(&MasterNode_Hsm, pEvent);
+}
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+static const Executive_Node_t MasterNode_ExecutiveNode = {
+  .start = MasterNode_Start,
+  .dispatch = MasterNode_DispatchEvent,
+  .poll = MasterNode_Poll,
+};
+#else
 /**
  * @brief Master node task, handles events generated by MasterNode_Timer and HAL_CAN_RxFifo0MsgPendingCallback
  * 
  * @param pvParam 
  */
 static void MasterNode_TaskFunction(void *const pvParam) {
-  Event_t current_event = {0};
+  Event_t *current_event = NULL;
+  TickType_t wait = portMAX_DELAY;
 
-  xTimerStart(MasterNode_TimerHandle, portMAX_DELAY);
+  MasterNode_Start();
 
   while (1) {
-    /* reset current event */
-    memset(&current_event, 0x00, sizeof(Event_t));
-
-    /* get event */
-    xQueueReceive(MasterNode_EventQueueHandle, (void * const)&current_event, portMAX_DELAY);
-
-    switch(MasterNode_CurrentState) {
-      case MASTER_NODE_STATE_IDLE: {
-        if(MasterNode_Idle_StateHandler(&current_event) == EVENT_HANDLED) {
-          MasterNode_CurrentState = MASTER_NODE_STATE_TX;
-        }
-      } break;
-
-      case MASTER_NODE_STATE_TX: {
-        if(MasterNode_Transmit_StateHandler(&current_event) == EVENT_HANDLED) {
-          MasterNode_CurrentState = MASTER_NODE_STATE_RX;
-        }
-      } break;
-
-      case MASTER_NODE_STATE_RX: {
-        if(MasterNode_ReceiveStatus_StateHandler(&current_event) == EVENT_HANDLED) {
-          MasterNode_CurrentState = MASTER_NODE_STATE_IDLE;
-        }
-      } break;
-      
-      default:
-      break;
+    wait = MasterNode_Poll();
+
+    /* get event, or wake up at the next timeout */
+#if (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+    current_event = EventChannel_Receive(&MasterNode_EventChannel, wait);
+    if (current_event == NULL) {
+      continue;
     }
+#else
+    if (xQueueReceive(MasterNode_EventQueueHandle, (void * const)&current_event, wait) != pdTRUE) {
+      continue;
+    }
+#endif /* (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+
+    MasterNode_DispatchEvent(current_event);
+    EventPool_Release(current_event);
   }
 
   (void)pvParam;
 }
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
 
 void MasterNode_Initialize(void) {
-  MasterNode_CurrentState = MASTER_NODE_STATE_IDLE;
-  MasterNode_CurrentOperationStatus.status = 0;
-  MasterNode_CurrentOperationStatus.value = 0;
-  MasterNode_ReceivedMessages = 0;
+  Hsm_Initialize(&MasterNode_Hsm, MasterNode_States, MASTER_NODE_STATE_OPERATING);
+  memset(MasterNode_Slaves, 0x00, sizeof(MasterNode_Slaves));
+  for (uint32_t slave = 0; slave < CAN2CAN_SLAVE_NUMBER; slave++) {
+    Jitter_Initialize(&MasterNode_Slaves[slave].jitter, OPERATION_STATUS_PERIOD_US_AT(OPERATION_STATUS_FREQUENCY));
+    for (uint32_t latency = 0; latency < MASTER_NODE_LATENCY_NUMBER; latency++) {
+      Histogram_Initialize(&MasterNode_Slaves[slave].latency[latency]);
+    }
+  }
+
+  MasterNode_StatusRate = OPERATION_STATUS_FREQUENCY;
+  MasterNode_RequestedStatusRate = OPERATION_STATUS_FREQUENCY;
+  MasterNode_NextDeadline = UINT64_MAX;
+  MasterNode_Active = 1;
+  memset(&MasterNode_EventLatency, 0x00, sizeof(EventLatency_t));
+  MasterNode_DroppedTimeEvents = 0;
+  memset(MasterNode_FrameSubscribers, 0x00, sizeof(MasterNode_FrameSubscribers));
+  MasterNode_FrameSubscriberCount = 0;
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 0u)
+  MasterNode_ScheduleIndex = 0;
+  MasterNode_BuildSchedule();
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 0u) */
 
-  /* initialize CAN RX filters for operation status STD ID */
+  /* initialize CAN RX filters for operation status STD ID range */
   configASSERT(bxCAN_SetFilterPolicy(MASTER_NODE_POLICY_NUMBER, 
     MASTER_NODE_RX_FIFO,
     MasterNode_CANRxFilter, 
     MasterNode_CANRxMask) == HAL_OK
   );
+  bxCAN_SetRxHandler(MASTER_NODE_RX_FIFO, MASTER_NODE_RX_FIFO_CALLBACK);
 
   /* start CAN */
   if (hcan.State == HAL_CAN_STATE_READY) {
     configASSERT(bxCAN_Initialize() == HAL_OK);
   }
 
-  /* initialize timer */
+  /* CAN errors are reported to the master node task */
+  MasterNode_CANErrorCount = 0;
+  MasterNode_LastCANError = 0;
+  bxCAN_SetErrorCallback(MasterNode_BxCANErrorCallback);
+
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
+  /* initialize timer, one shot, restarted for each schedule table entry.
+   * Operation commands are released by the TX scheduler otherwise */
   MasterNode_TimerHandle = xTimerCreateStatic(
     "MasterNodeTimer", 
-    pdMS_TO_TICKS(1000u / OPERATION_COMMAND_FREQUENCY),
-    pdTRUE,
+    pdMS_TO_TICKS(OPERATION_COMMAND_PERIOD_MS),
+    pdFALSE,
     (const void* const)&MasterNode_TimerID,
     MasterNode_TimerCallback, 
     &MasterNode_Timer
   );
+  vTimerSetTimerNumber(MasterNode_TimerHandle, TRACE_OBJECT_MASTER_NODE);
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
 
-  /* initialize rx queue */
-  MasterNode_RxQueueHandle = xQueueCreateStatic(
-    MASTER_NODE_RX_QUEUE_SIZE,
-    OPERATION_STATUS_MSG_SIZE,
-    MasterNode_RxQueueStorage,
-    &MasterNode_RxQueue
-  );
-
-  /* initialize event queue */
-  MasterNode_EventQueueHandle = xQueueCreateStatic(
-    MASTER_NODE_MAX_EVENTS, 
-    sizeof(Event_t),
-    (uint8_t *)&MasterNode_EventQueueStorage, 
-    &MasterNode_EventQueue
-  );
-
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  /* master node runs in the executive task */
+  MasterNode_ExecutiveId = Executive_Register(&MasterNode_ExecutiveNode, MASTER_TASK_TASK_PRIORITY);
+#else
   // initialize master node task
   MasterNode_TaskHandle = xTaskCreateStatic(
     &MasterNode_TaskFunction, 
@@ -296,4 +1026,216 @@ void MasterNode_Initialize(void) {
     MasterNode_TaskStack,  /* stack buffer (StackType_t *)  */
     &MasterNode_TaskBuffer /* task buffer (StaticTask_t *) */
   );
+
+#if (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  /* initialize event channel, the task is its consumer */
+  EventChannel_Initialize(&MasterNode_EventChannel,
+    MasterNode_EventChannelStorage,
+    EVENT_POOL_SIZE,
+    MasterNode_TaskHandle,
+    CAN2CAN_EVENT_CHANNEL_BIT,
+    TRACE_OBJECT_MASTER_NODE
+  );
+#else
+  /* initialize event queue */
+  MasterNode_EventQueueHandle = xQueueCreateStatic(
+    MASTER_NODE_MAX_EVENTS, 
+    sizeof(Event_t *),
+    (uint8_t *)&MasterNode_EventQueueStorage, 
+    &MasterNode_EventQueue
+  );
+  vQueueSetQueueNumber(MasterNode_EventQueueHandle, TRACE_OBJECT_MASTER_NODE);
+#endif /* (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+
+  /* master node is the time master */
+  ClockSync_MasterInitialize();
 }
+
+/**
+ * @brief Set the operation status rate of all slaves, applied from the next
+ * command period
+ *
+ * @param frequency [in] operation status frequency (Hz), in
+ * [OPERATION_COMMAND_FREQUENCY, OPERATION_STATUS_MAX_FREQUENCY], the
+ * communication schedule table's (OPERATION_STATUS_FREQUENCY) when it's used
+ * @return uint8_t 1: rate accepted, 0: out of range
+ */
+uint8_t MasterNode_SetStatusRate(uint16_t frequency) {
+  if ((frequency < OPERATION_COMMAND_FREQUENCY) || (frequency > OPERATION_STATUS_MAX_FREQUENCY)) {
+    return 0;
+  }
+
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  if (frequency != OPERATION_STATUS_FREQUENCY) {
+    return 0;
+  }
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+
+  MasterNode_RequestedStatusRate = frequency;
+  return 1;
+}
+
+uint16_t MasterNode_GetStatusRate(void) {
+  return MasterNode_RequestedStatusRate;
+}
+
+/**
+ * @brief Get the operation status reception period jitter of a slave
+ *
+ * @param slave [in] slave ID
+ * @param statistics [out] jitter statistics
+ */
+void MasterNode_GetStatusJitter(uint8_t slave, Jitter_Statistics_t *const statistics) {
+  configASSERT(slave < CAN2CAN_SLAVE_NUMBER);
+
+  taskENTER_CRITICAL();
+  Jitter_GetStatistics(&MasterNode_Slaves[slave].jitter, statistics);
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get a latency histogram of a slave, copied in a short critical
+ * section, the nodes keep running
+ *
+ * @param slave [in] slave ID
+ * @param latency [in] histogram
+ * @param histogram [out] copy of the histogram
+ */
+void MasterNode_GetLatencyHistogram(uint8_t slave, MasterNode_Latency_t latency, Histogram_t *const histogram) {
+  configASSERT((slave < CAN2CAN_SLAVE_NUMBER) && (latency < MASTER_NODE_LATENCY_NUMBER));
+
+  taskENTER_CRITICAL();
+  memcpy(histogram, &MasterNode_Slaves[slave].latency[latency], sizeof(Histogram_t));
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get the operation status reception statistics of a slave
+ *
+ * @param slave [in] slave ID
+ * @param statistics [out] reception statistics
+ */
+void MasterNode_GetSlaveStatistics(uint8_t slave, MasterNode_SlaveStatistics_t *const statistics) {
+  configASSERT(slave < CAN2CAN_SLAVE_NUMBER);
+
+  taskENTER_CRITICAL();
+  memcpy(statistics, &MasterNode_Slaves[slave].statistics, sizeof(MasterNode_SlaveStatistics_t));
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Discard the next operation status frames received from a slave, as
+ * if they were lost on the bus, to measure timeout detection and recovery
+ *
+ * @param slave [in] slave ID
+ * @param frames [in] operation status frames to discard
+ */
+void MasterNode_InjectStatusLoss(uint8_t slave, uint32_t frames) {
+  configASSERT(slave < CAN2CAN_SLAVE_NUMBER);
+
+  taskENTER_CRITICAL();
+  MasterNode_Slaves[slave].inject += frames;
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get the operation status sequence statistics of a slave
+ *
+ * @param slave [in] slave ID
+ * @param statistics [out] sequence statistics, all 0 if CAN2CAN_USE_STATUS_SEQUENCE is 0
+ */
+void MasterNode_GetSequenceStatistics(uint8_t slave, MasterNode_SequenceStatistics_t *const statistics) {
+  configASSERT(slave < CAN2CAN_SLAVE_NUMBER);
+
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  taskENTER_CRITICAL();
+  memcpy(statistics, &MasterNode_Slaves[slave].sequence, sizeof(MasterNode_SequenceStatistics_t));
+  taskEXIT_CRITICAL();
+#else
+  memset(statistics, 0x00, sizeof(MasterNode_SequenceStatistics_t));
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+}
+
+/**
+ * @brief Get the number of CAN errors reported by the peripheral
+ *
+ * @param last_error [out] HAL_CAN_ERROR_x flags of the last error
+ * @return uint32_t CAN errors since initialization
+ */
+uint32_t MasterNode_GetCANErrors(uint32_t *const last_error) {
+  uint32_t count = 0;
+
+  taskENTER_CRITICAL();
+  count = MasterNode_CANErrorCount;
+  (*last_error) = MasterNode_LastCANError;
+  taskEXIT_CRITICAL();
+
+  return count;
+}
+
+/**
+ * @brief Subscribe to the operation status frames received by the master
+ * node, must be called before the scheduler is started. The subscriber is
+ * called from the master's RX handler (CAN service task or CAN RX interrupt,
+ * BXCAN_USE_SERVICE_TASK) with a reference to the master node's event
+ *
+ * @param subscriber [in] subscriber, must release the event
+ * @return uint8_t 1: subscribed, 0: MASTER_NODE_FRAME_SUBSCRIBERS reached
+ */
+uint8_t MasterNode_SubscribeFrames(EventPool_Subscriber_t subscriber) {
+  if (MasterNode_FrameSubscriberCount >= MASTER_NODE_FRAME_SUBSCRIBERS) {
+    return 0;
+  }
+
+  MasterNode_FrameSubscribers[MasterNode_FrameSubscriberCount++] = subscriber;
+  return 1;
+}
+
+/**
+ * @brief Enable/disable the master role, from the next command slot. Open
+ * cycles complete (or time out) normally
+ *
+ * @param active [in] 1: operation commands are sent, 0: no operation commands
+ */
+void MasterNode_SetActive(uint8_t active) {
+  MasterNode_Active = (active != 0) ? 1 : 0;
+}
+
+uint8_t MasterNode_IsActive(void) {
+  return MasterNode_Active;
+}
+
+/**
+ * @brief Get the latency of the events dispatched to the master node
+ *
+ * @param latency [out] event latency statistics
+ */
+void MasterNode_GetEventLatency(EventLatency_t *const latency) {
+  taskENTER_CRITICAL();
+  memcpy(latency, &MasterNode_EventLatency, sizeof(EventLatency_t));
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get the number of TIME_EVENT allocations that failed (event pool
+ * empty), each one delayed a schedule table entry
+ *
+ * @return uint32_t failed allocations since the initialization
+ */
+uint32_t MasterNode_GetDroppedTimeEvents(void) {
+  return MasterNode_DroppedTimeEvents;
+}
+
+/**
+ * @brief Get the master node event channel statistics
+ *
+ * @param statistics [out] channel statistics, all 0 if the node doesn't use an event channel
+ */
+void MasterNode_GetEventChannelStatistics(EventChannel_Statistics_t *const statistics) {
+#if (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  EventChannel_GetStatistics(&MasterNode_EventChannel, statistics);
+#else
+  memset(statistics, 0x00, sizeof(EventChannel_Statistics_t));
+#endif /* (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "can2can.h"
+
+/* slaves are spread evenly over the operation status period, as in the
+ * master schedule table (MASTER_NODE_SCHEDULE_OFFSET_US) */
+#define CAN2CAN_SCHEDULE_SLAVE_STRIDE_US \
+  (OPERATION_STATUS_PERIOD_US_AT(OPERATION_STATUS_FREQUENCY) / CAN2CAN_SLAVE_NUMBER)
+
+/* communication schedule table, one command cycle. Clock sync and
+ * configuration service frames aren't in the table, they are event triggered */
+static const ScheduleTable_Message_t Can2Can_ScheduleMessages[CAN2CAN_SCHEDULE_MESSAGE_NUMBER] = {
+  [CAN2CAN_SCHEDULE_COMMAND] = {
+    .offset_us = 0,
+    .period_us = 0,
+    .slave_stride_us = CAN2CAN_SCHEDULE_SLAVE_STRIDE_US,
+    .std_id = OPERATION_COMMAND_STD_ID,
+    .len = OPERATION_COMMAND_MSG_SIZE,
+    .sender = SCHEDULE_TABLE_SENDER_MASTER,
+    .flags = SCHEDULE_TABLE_FLAG_PER_SLAVE | SCHEDULE_TABLE_FLAG_SYNC,
+  },
+  [CAN2CAN_SCHEDULE_STATUS] = {
+    .offset_us = CAN2CAN_SCHEDULE_RESPONSE_US,
+    .period_us = OPERATION_STATUS_PERIOD_US_AT(OPERATION_STATUS_FREQUENCY),
+    .slave_stride_us = CAN2CAN_SCHEDULE_SLAVE_STRIDE_US,
+    .std_id = OPERATION_STATUS_STD_ID,
+    .len = OPERATION_STATUS_MSG_SIZE,
+    .sender = SCHEDULE_TABLE_SENDER_SLAVE,
+    .flags = SCHEDULE_TABLE_FLAG_PER_SLAVE,
+  },
+};
+
+const ScheduleTable_t Can2Can_Schedule = {
+  .duration_us = OPERATION_COMMAND_PERIOD_MS * 1000u,
+  .bit_rate = CAN2CAN_SCHEDULE_BIT_RATE,
+  .precision_us = CAN2CAN_SCHEDULE_PRECISION_US,
+  .max_adjust_us = CAN2CAN_SCHEDULE_MAX_ADJUST_US,
+  .id_stride = SLAVE_ID_RANGE_SIZE,
+  .slave_number = CAN2CAN_SLAVE_NUMBER,
+  .message_number = CAN2CAN_SCHEDULE_MESSAGE_NUMBER,
+  .messages = Can2Can_ScheduleMessages,
+};
@@ -3,51 +3,119 @@
 #include "gpio.h"
 #include "can.h"
 #include "cmsis_os.h"
+#include "event_channel.h"
 #include "can2can.h"
+#include "timebase.h"
+#include "clock_sync.h"
+#include "e2e.h"
+#include "hsm.h"
+#include "executive.h"
+#include "event_pool.h"
+#include "config_service.h"
+#include "signal_db.h"
+#include "tx_scheduler.h"
+
+/* RX handler, selected with the CAN driver configuration (can.h) */
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+#define SLAVE_NODE_RX_FIFO_CALLBACK       SlaveNode_RxFifoHandler   /* run by the CAN service task */
+#else
+#define SLAVE_NODE_RX_FIFO_CALLBACK       HAL_CAN_RxFifo1MsgPendingCallback
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
 
 /**
  * @brief Slave node state
  */
 typedef enum {
+  SLAVE_NODE_STATE_ACTIVE,  /* top level state, a new operation command restarts the operation status sequence in any sub-state */
   SLAVE_NODE_STATE_IDLE,  /* slave node is idle, waiting for CAN RX event */
   SLAVE_NODE_STATE_TX,  /* slave node waits for CAN tx complete event */
   SLAVE_NODE_WAIT_TIMER,  /* slave node waits for time event to send out operation status */
+  SLAVE_NODE_STATE_NUMBER,
 } SlaveNode_State_t;
 
 
-/* slave node current state */
-static SlaveNode_State_t SlaveNode_CurrentState = SLAVE_NODE_STATE_IDLE;
+/* slave node state machine */
+static Hsm_t SlaveNode_Hsm = {0};
 
-/* slave node current operation status */
-static OperationStatus_t SlaveNode_CurrentOperationStatus = {0};
-static OperationCommand_t SlaveNode_CurrentOperationCommand = {0};
+/* operation status frames sent for the current command, the current
+ * operation command and status are published in the signal database
+ * (SIGNAL_SLAVE_COMMAND, SIGNAL_SLAVE_STATUS) */
 static uint32_t SlaveNode_TransmitCount = 0;
-
+static const OperationStatus_t SlaveNode_InitialStatus = {0};
+
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+/* sequence number of the next operation status frame, continues across commands */
+static uint8_t SlaveNode_StatusSequence = 0;
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+
+/* operation status sequence: rate and frame count from the last command,
+ * frame k is due at SlaveNode_SequenceStart + k periods */
+static uint16_t SlaveNode_StatusRate = OPERATION_STATUS_FREQUENCY;
+static uint32_t SlaveNode_StatusCount = OPERATION_STATUS_COUNT;
+static uint64_t SlaveNode_SequenceStart = 0;
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/* operation status of the frame armed in the TX scheduler, published when it's released */
+static OperationStatus_t SlaveNode_ScheduledStatus = {0};
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+/* communication schedule table, synchronized to the operation commands,
+ * the operation status frames are the slave's expiry points */
+static ScheduleTable_Run_t SlaveNode_ScheduleRun = {0};
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+
+/* slave ID, and filter bank of its operation command filter. The slave is
+ * active (role enabled) when the filter bank is active */
+static uint8_t SlaveNode_Id = SLAVE_NODE_ID;
+static uint8_t SlaveNode_FilterBank = SLAVE_NODE_POLICY_NUMBER;
+static uint8_t SlaveNode_Active = 1;
+
+/* slave ID of the command the current operation status sequence answers */
+static uint8_t SlaveNode_SequenceId = SLAVE_NODE_ID;
+
+/* operation status transmission period jitter */
+static Jitter_t SlaveNode_StatusJitter = {0};
+
+/* event time stamp to dispatch latency */
+static EventLatency_t SlaveNode_EventLatency = {0};
+
+/* TIME_EVENT not allocated (event pool empty), retried */
+static volatile uint32_t SlaveNode_DroppedTimeEvents = 0;
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+/* slave node ID in the executive */
+static uint8_t SlaveNode_ExecutiveId = 0;
+#else
 /* slave node task */
 static TaskHandle_t SlaveNode_TaskHandle = NULL;
 static StaticTask_t SlaveNode_TaskBuffer = {0};
 static StackType_t SlaveNode_TaskStack[SLAVE_TASK_STACK_DEPTH] = {0};
 
-/* slave node CAN RX message queue */
-static QueueHandle_t SlaveNode_RxQueueHandle = NULL;
-static uint8_t SlaveNode_RxQueueStorage[SLAVE_NODE_RX_QUEUE_SIZE * OPERATION_COMMAND_MSG_SIZE] = {0};
-static StaticQueue_t SlaveNode_RxQueue = {0};
-
+#if (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+/* slave node event channel, one slot per pool event, never full */
+static EventChannel_t SlaveNode_EventChannel = {0};
+static Event_t *SlaveNode_EventChannelStorage[EVENT_POOL_SIZE] = {0};
+#else
 /* slave node event queue */
 static QueueHandle_t SlaveNode_EventQueueHandle = NULL;
 static StaticQueue_t SlaveNode_EventQueue = {0};
-static Event_t SlaveNode_EventQueueStorage[SLAVE_NODE_MAX_EVENTS] = {0};
+static Event_t *SlaveNode_EventQueueStorage[SLAVE_NODE_MAX_EVENTS] = {0};
+#endif /* (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
 
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
 /* slave node timer */
 static TimerHandle_t SlaveNode_TimerHandle = NULL;
 static StaticTimer_t SlaveNode_Timer = {0};
 static uint32_t SlaveNode_TimerID = 0xF0;
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
 
-static const bxCAN_Filter_t SlaveNode_CANRxFilter = {
+static const bxCAN_Filter_t SlaveNode_ClockSyncRxFilter = {
   .as_struct = {
     .RTR = 0, /* data */
     .IDE = 0, /* standard ID */
-    .StdId = OPERATION_COMMAND_STD_ID
+    .StdId = CLOCK_SYNC_STD_ID
   }
 };
 
@@ -59,211 +127,616 @@ static const bxCAN_Filter_t SlaveNode_CANRxMask = {
   }
 };
 
+/**
+ * @brief Operation command filter of a slave ID
+ *
+ * @param slave_id [in] slave ID
+ */
+static bxCAN_Filter_t SlaveNode_CommandFilter(uint8_t slave_id) {
+  const bxCAN_Filter_t filter = {
+    .as_struct = {
+      .RTR = 0, /* data */
+      .IDE = 0, /* standard ID */
+      .StdId = OPERATION_COMMAND_STD_ID_OF(slave_id)
+    }
+  };
+
+  return filter;
+}
+
+/**
+ * @brief Accept the operation commands of a slave ID in a deactivated filter
+ * bank. Only the ID is written, the filter initialization mode isn't entered
+ * and the reception goes on
+ *
+ * @param bank [in] filter bank, SLAVE_NODE_POLICY_NUMBER or SLAVE_NODE_ALT_POLICY_NUMBER
+ * @param slave_id [in] slave ID
+ */
+static void SlaveNode_SetCommandFilter(uint8_t bank, uint8_t slave_id) {
+  configASSERT(bxCAN_SetFilterId(bank, SlaveNode_CommandFilter(slave_id), SlaveNode_CANRxMask) == HAL_OK);
+}
+
+/**
+ * @brief Post an event to the slave node, from a task
+ *
+ * @param pEvent [in] pool event, the caller's reference is passed to the slave node
+ */
+static inline void SlaveNode_PostEvent(Event_t *const pEvent) {
+  configASSERT(pEvent != NULL);
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  configASSERT(Executive_Post(SlaveNode_ExecutiveId, pEvent) == pdPASS);
+#elif (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  configASSERT(EventChannel_Post(&SlaveNode_EventChannel, pEvent) == pdPASS);
+#else
+  configASSERT(xQueueSend(SlaveNode_EventQueueHandle, (const void *const)&pEvent, 0) == pdTRUE);
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+}
+
+/**
+ * @brief Post an event to the slave node, from an ISR. The event is
+ * released if the queue is full
+ *
+ * @param pEvent [in] pool event, the caller's reference is passed to the slave node
+ */
+static inline void SlaveNode_PostEventFromISR(Event_t *const pEvent) {
+  BaseType_t xTaskWoken = pdFALSE;
+  BaseType_t queued = pdFALSE;
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  queued = Executive_PostFromISR(SlaveNode_ExecutiveId, pEvent, &xTaskWoken);
+#elif (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  queued = EventChannel_PostFromISR(&SlaveNode_EventChannel, pEvent, &xTaskWoken);
+#else
+  queued = xQueueSendFromISR(SlaveNode_EventQueueHandle, (const void *const)&pEvent, &xTaskWoken);
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+
+  if (queued != pdTRUE) {
+    EventPool_Release(pEvent);
+  }
+
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+/**
+ * @brief Post an event of a CAN handler or callback to the slave node, from
+ * the CAN service task (BXCAN_USE_SERVICE_TASK) or the CAN interrupt. The
+ * event is released if the queue is full
+ *
+ * @param pEvent [in] pool event, the caller's reference is passed to the slave node
+ */
+static inline void SlaveNode_PostCANEvent(Event_t *const pEvent) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  BaseType_t queued = pdFALSE;
+
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  queued = Executive_Post(SlaveNode_ExecutiveId, pEvent);
+#elif (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  queued = EventChannel_Post(&SlaveNode_EventChannel, pEvent);
+#else
+  queued = xQueueSend(SlaveNode_EventQueueHandle, (const void *const)&pEvent, 0);
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+
+  if (queued != pdTRUE) {
+    EventPool_Release(pEvent);
+  }
+#else
+  SlaveNode_PostEventFromISR(pEvent);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+ * @brief TX scheduler release callback, from the TIM2 interrupt: the
+ * operation status frame was loaded into the mailbox, its sequence number
+ * is used. Sends TIME_EVENT to the slave node
+ *
+ * @param release_us [in] release time of the frame
+ */
+static void SlaveNode_ReleaseCallback(uint64_t release_us) {
+  Event_t *const time_event = EventPool_Alloc(TIME_EVENT);
+
+  /* pool empty, the frame was sent, the node gets its TIME_EVENT on a retry
+   * of the slot so the sequence goes on. The sequence number is used once */
+  if (time_event == NULL) {
+    SlaveNode_DroppedTimeEvents++;
+    TxScheduler_RetryFromISR(TX_SCHEDULER_SLOT_SLAVE);
+    return;
+  }
+
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  SlaveNode_StatusSequence++;
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+
+  time_event->timestamp_us = release_us;
+
+  SlaveNode_PostEventFromISR(time_event);
+}
+#else
 /**
  * @brief Slave node timer callback function, sends TIME_EVENT
- * to SlaveTask_EventQueue
+ * to the slave node
  * 
  * @param timer_handle 
  */
 static void SlaveNode_TimerCallback(TimerHandle_t timer_handle) {
-  Event_t time_event = {
-      .type = TIME_EVENT,
-  };
+  Event_t *const time_event = EventPool_Alloc(TIME_EVENT);
 
-  /* send timer event to SlaveTask_EventQueue */
-  configASSERT(xQueueSend(SlaveNode_EventQueueHandle, (const void *const)&time_event, 0) == pdTRUE);
+  /* pool empty, the frame is retried one tick later so the sequence goes on */
+  if (time_event == NULL) {
+    SlaveNode_DroppedTimeEvents++;
+    (void)xTimerChangePeriod(timer_handle, 1, 0);
+    return;
+  }
+
+  time_event->timestamp_us = Timebase_GetMicros();
+
+  SlaveNode_PostEvent(time_event);
 }
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
 
 /**
- * @brief CAN FIFO 0 message pending callback
+ * @brief CAN FIFO 1 message pending callback, or RX handler run by the CAN
+ * service task (BXCAN_USE_SERVICE_TASK)
  * 
  * @param hcan [in] pointer to CAN handle that triggered the callback
  */
 void SLAVE_NODE_RX_FIFO_CALLBACK(CAN_HandleTypeDef *hcan) {
-  BaseType_t xTaskWoken = pdFALSE;
-  Event_t rx_event = {
-    .type = CAN_RX_EVENT,
-  };
+  const uint64_t timestamp_us = bxCAN_GetRxTime(SLAVE_NODE_RX_FIFO);
+  Event_t *const rx_event = EventPool_Alloc(CAN_RX_EVENT);
+  EventFrame_t discarded = {0};
+  EventFrame_t *const frame = (rx_event != NULL) ? &rx_event->payload.frame : &discarded;
+
+  /* the frame is delivered with the event, the task doesn't access the RX
+   * FIFO. It's read even if the pool is empty, to release the FIFO */
+  configASSERT(bxCAN_Receive(SLAVE_NODE_RX_FIFO, frame->data, &frame->len, &frame->std_id, &frame->e2e_status) == HAL_OK);
+
+  /* clock sync frames are consumed here, the reception time stamp must be
+   * taken as close as possible to the frame reception */
+  if (frame->std_id == CLOCK_SYNC_STD_ID) {
+    ClockSync_SlaveProcessFrame(frame->data, frame->len, timestamp_us);
+    EventPool_Release(rx_event);
+    return;
+  }
+
+  /* configuration requests are applied by the configuration service */
+  if (frame->std_id == CONFIG_SERVICE_REQUEST_STD_ID) {
+    ConfigService_ProcessFrame(frame->data, frame->len, timestamp_us);
+    EventPool_Release(rx_event);
+    return;
+  }
 
-  configASSERT(HAL_CAN_DeactivateNotification(hcan, SLAVE_NODE_RX_FIFO_NOTIFICATION) == HAL_OK);
+  if (rx_event == NULL) {
+    return;
+  }
 
-  xQueueSendFromISR(SlaveNode_EventQueueHandle, &rx_event, &xTaskWoken);
-  portYIELD_FROM_ISR(xTaskWoken);
+  rx_event->timestamp_us = timestamp_us;
+
+  SlaveNode_PostCANEvent(rx_event);
 }
 
 /**
  * @brief CAN TX complete callback
  * 
- * @param hcan [in] pointer to CAN handle that triggered the callback
  * @param mailbox [in] mailbox used to transmit the message
  */
-static void SlaveNode_BxCANTxCompleteCallback(void) {
-  BaseType_t xTaskWoken = pdFALSE;
-  Event_t rx_event = {
-    .type = CAN_TX_EVENT,
-  };
+static void SlaveNode_BxCANTxCompleteCallback(uint8_t mailbox) {
+  const uint64_t timestamp_us = bxCAN_GetTxTime(mailbox);
+  Event_t *tx_event = NULL;
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  taskENTER_CRITICAL();
+  Jitter_Update(&SlaveNode_StatusJitter, timestamp_us);
+  taskEXIT_CRITICAL();
+#else
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  Jitter_Update(&SlaveNode_StatusJitter, timestamp_us);
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  tx_event = EventPool_Alloc(CAN_TX_EVENT);
+  if (tx_event == NULL) {
+    return;
+  }
 
-  xQueueSendFromISR(SlaveNode_EventQueueHandle, &rx_event, &xTaskWoken);
-  portYIELD_FROM_ISR(xTaskWoken);
+  tx_event->timestamp_us = timestamp_us;
+  tx_event->payload.tx.std_id = bxCAN_GetTxStdId(mailbox);
+  tx_event->payload.tx.mailbox = mailbox;
+
+  SlaveNode_PostCANEvent(tx_event);
 }
 
-static inline void SlaveNode_UpdateOperationStatus(void) {
-  if(SlaveNode_CurrentOperationCommand == OperationCommandON) {
-    SlaveNode_CurrentOperationStatus.status = OPERATION_STATUS_ON;
-    SlaveNode_CurrentOperationStatus.value += OPERATION_STATUS_VALUE_MODIFIER;
+/**
+ * @brief Next operation status, from the current command and status
+ *
+ * @param status [out] next operation status
+ */
+static inline void SlaveNode_NextOperationStatus(OperationStatus_t *const status) {
+  OperationCommand_t command = {0};
+
+  /* the slave node is the only writer, its reads can't fail */
+  (void)SignalDb_Read(SIGNAL_SLAVE_COMMAND, &command, NULL);
+  (void)SignalDb_Read(SIGNAL_SLAVE_STATUS, status, NULL);
+
+  if(command == OperationCommandON) {
+    status->status = OPERATION_STATUS_ON;
+    status->value += OPERATION_STATUS_VALUE_MODIFIER;
   } else {
-    SlaveNode_CurrentOperationStatus.status = OPERATION_STATUS_OFF;
-    SlaveNode_CurrentOperationStatus.value -= OPERATION_STATUS_VALUE_MODIFIER;
+    status->status = OPERATION_STATUS_OFF;
+    status->value -= OPERATION_STATUS_VALUE_MODIFIER;
+  }
+}
+
+static inline void SlaveNode_UpdateOperationStatus(void) {
+  OperationStatus_t status = {0};
+
+  SlaveNode_NextOperationStatus(&status);
+  SignalDb_Write(SIGNAL_SLAVE_STATUS, &status);
+}
+
+/**
+ * @brief Deadline of an operation status frame
+ *
+ * @param index [in] index of the frame in the current sequence
+ * @return uint64_t deadline (us)
+ */
+static inline uint64_t SlaveNode_StatusDeadline(uint32_t index) {
+  return SlaveNode_SequenceStart + ((uint64_t)index * OPERATION_STATUS_PERIOD_US_AT(SlaveNode_StatusRate));
+}
+
+/**
+ * @brief Pack an operation status frame, with the next sequence number
+ *
+ * @param current [in] operation status
+ * @param tx_message [out] frame data
+ */
+static inline void SlaveNode_PackOperationStatus(const OperationStatus_t *const current, uint8_t *const tx_message) {
+  OperationStatus_Msg_t status = {0};
+
+  status.status = current->status;
+  status.value = current->value;
+
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  status.sequence = SlaveNode_StatusSequence;
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+
+  OperationStatus_Pack(&status, tx_message);
+}
+
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
+/**
+ * @brief Start slave node timer to expire at the deadline of an operation
+ * status frame. Deadlines are absolute, so timer and task latencies delay a
+ * single frame (by up to 1 tick) but don't accumulate
+ * 
+ * @param index [in] index of the frame in the current sequence
+ */
+static void SlaveNode_StartStatusTimer(uint32_t index) {
+  uint64_t deadline_us = SlaveNode_StatusDeadline(index);
+  uint64_t now_us = Timebase_GetMicros();
+  TickType_t delay = 1;
+
+  if (deadline_us > now_us) {
+    delay = pdMS_TO_TICKS((uint32_t)((deadline_us - now_us + 999u) / 1000u));
+    if (delay == 0) {
+      delay = 1;
+    }
   }
+
+  configASSERT(xTimerChangePeriod(SlaveNode_TimerHandle, delay, portMAX_DELAY) == pdPASS);
 }
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
 
 static inline void SlaveNode_TransmitOperationStatus(void) {
+  uint8_t tx_message [BXCAN_MAX_DATA_SIZE] = {0};
+  OperationStatus_t current = {0};
+
+  (void)SignalDb_Read(SIGNAL_SLAVE_STATUS, &current, NULL);
+  SlaveNode_PackOperationStatus(&current, tx_message);
   configASSERT(
     bxCAN_Transmit(
-      (uint8_t *)&SlaveNode_CurrentOperationStatus, 
+      tx_message, 
       OPERATION_STATUS_MSG_SIZE, 
-      OPERATION_STATUS_STD_ID, 
+      OPERATION_STATUS_STD_ID_OF(SlaveNode_SequenceId), 
       SlaveNode_BxCANTxCompleteCallback
     ) == HAL_OK
   );
 
-  configASSERT(xTimerStart(SlaveNode_TimerHandle, portMAX_DELAY) == pdTRUE);
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  SlaveNode_StatusSequence++;
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+  SlaveNode_TransmitCount++;
+}
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+ * @brief Wait timer state entry, build the next frame and arm the TX
+ * scheduler at its deadline. Its operation status is published once it's
+ * released (SlaveNode_SendStatus())
+ */
+static void SlaveNode_WaitTimer_Entry(void) {
+  TxScheduler_Frame_t frame = {0};
+  uint64_t deadline_us = 0;
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  ScheduleTable_ExpiryPoint_t point = {0};
+
+  /* next expiry point of the slave after its sync point (operation command) */
+  configASSERT(ScheduleTable_Next(&SlaveNode_ScheduleRun, &point) != 0);
+  deadline_us = point.release_us;
+#else
+  deadline_us = SlaveNode_StatusDeadline(SlaveNode_TransmitCount);
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+
+  SlaveNode_NextOperationStatus(&SlaveNode_ScheduledStatus);
+  SlaveNode_PackOperationStatus(&SlaveNode_ScheduledStatus, frame.data);
+  frame.std_id = OPERATION_STATUS_STD_ID_OF(SlaveNode_SequenceId);
+  frame.len = OPERATION_STATUS_MSG_SIZE;
+
+  TxScheduler_Arm(TX_SCHEDULER_SLOT_SLAVE,
+    deadline_us,
+    &frame,
+    SlaveNode_BxCANTxCompleteCallback,
+    SlaveNode_ReleaseCallback
+  );
+}
+
+/**
+ * @brief Wait timer state exit, a new operation command cancels the pending
+ * frame. A frame released already is accounted by its TIME_EVENT
+ */
+static void SlaveNode_WaitTimer_Exit(void) {
+  (void)TxScheduler_Cancel(TX_SCHEDULER_SLOT_SLAVE);
+}
+#else
+/**
+ * @brief Wait timer state entry, start the timer for the next frame's deadline
+ */
+static void SlaveNode_WaitTimer_Entry(void) {
+  SlaveNode_StartStatusTimer(SlaveNode_TransmitCount);
+}
+
+/**
+ * @brief Wait timer state exit, a new operation command cancels the pending frame
+ */
+static void SlaveNode_WaitTimer_Exit(void) {
+  configASSERT(xTimerStop(SlaveNode_TimerHandle, portMAX_DELAY) == pdPASS);
 }
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
 
 /**
- * @brief Slave node idle state handler
+ * @brief Operation status frames of the current sequence left to send
+ */
+static uint8_t SlaveNode_SequencePending(void) {
+  return (SlaveNode_TransmitCount < SlaveNode_StatusCount);
+}
+
+/**
+ * @brief Receive an operation command, and start a new operation status sequence
  * 
- * @param pEvent [in] pointer to the current event
+ * @param pEvent [in] pointer to the current event (CAN_RX_EVENT)
  */
-static StateResult_t SlaveNode_Idle_StateHandler(const Event_t * const pEvent) {
-  uint8_t data_buffer [BXCAN_MAX_DATA_SIZE] = {0};
-  uint16_t std_id = 0x00;
-  uint8_t data_len = 0;
+static StateResult_t SlaveNode_ReceiveCommand(const Event_t * const pEvent) {
+  const EventFrame_t *const frame = &pEvent->payload.frame;
+  OperationCommand_Msg_t command = {0};
 
-  if(pEvent->type != CAN_RX_EVENT) {
-    /* pass event */
+  /* corrupted, repeated or out of sequence command is discarded */
+  if (frame->e2e_status != E2E_STATUS_OK) {
     return EVENT_IGNORED;
   }
 
-  /* receive operation command */
-  configASSERT(bxCAN_Receive(SLAVE_NODE_RX_FIFO, data_buffer, &data_len, &std_id) == HAL_OK);
-  configASSERT(HAL_CAN_ActivateNotification(&hcan, SLAVE_NODE_RX_FIFO_NOTIFICATION) == HAL_OK);
-
   /* save operation command */
-  SlaveNode_CurrentOperationCommand = data_buffer[OPERATION_COMMAND_POS];
+  OperationCommand_Unpack(frame->data, &command);
+  if ((command.status_rate < OPERATION_COMMAND_FREQUENCY) || (command.status_rate > OPERATION_STATUS_MAX_FREQUENCY)) {
+    return EVENT_IGNORED;
+  }
+  SignalDb_Write(SIGNAL_SLAVE_COMMAND, &command.command);
+
+  /* the sequence answers with the ID the command was sent to, commands
+   * received before a slave ID change are answered with the previous ID */
+  SlaveNode_SequenceId = (uint8_t)SLAVE_ID_OF_STD_ID(frame->std_id);
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+  /* the frame armed for the previous sequence must not be released with
+   * the first one, the state exit (cancel) runs after this action */
+  (void)TxScheduler_Cancel(TX_SCHEDULER_SLOT_SLAVE);
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+  /* start a new operation status sequence at the commanded rate */
+  SlaveNode_StatusRate = command.status_rate;
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  /* the command is the slave's sync point, the sequence runs its expiry
+   * points up to the next one, the first frame included (wait timer state) */
+  (void)ScheduleTable_Sync(&SlaveNode_ScheduleRun, CAN2CAN_SCHEDULE_COMMAND, SlaveNode_SequenceId, pEvent->timestamp_us);
+  SlaveNode_StatusCount = ScheduleTable_Count(&SlaveNode_ScheduleRun);
+#else
+  SlaveNode_StatusCount = OPERATION_STATUS_COUNT_AT(command.status_rate);
+  SlaveNode_SequenceStart = Timebase_GetMicros();
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+  SlaveNode_TransmitCount = 0;
+
+  taskENTER_CRITICAL();
+  Jitter_Restart(&SlaveNode_StatusJitter, OPERATION_STATUS_PERIOD_US_AT(command.status_rate));
+  taskEXIT_CRITICAL();
 
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 0u)
   /* update & send operation status */
   SlaveNode_UpdateOperationStatus();
   SlaveNode_TransmitOperationStatus();
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 0u) */
 
   /* event was processed */
   return EVENT_HANDLED;
 }
 
 /**
- * @brief Slave node receive status state handler
+ * @brief Send the next operation status frame of the sequence
  * 
- * @param pEvent [in] pointer to the current event
+ * @param pEvent [in] pointer to the current event (TIME_EVENT)
  */
-static StateResult_t SlaveNode_WaitTimer_StateHandler(const Event_t * const pEvent) {
-  if(pEvent->type != TIME_EVENT) {
-    /* pass event */
-    return EVENT_IGNORED;
-  }
-
+static StateResult_t SlaveNode_SendStatus(const Event_t * const pEvent) {
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+  /* sent by the TX scheduler, publish its operation status */
+  SignalDb_Write(SIGNAL_SLAVE_STATUS, &SlaveNode_ScheduledStatus);
+  SlaveNode_TransmitCount++;
+#else
   /* update & send operation status */
   SlaveNode_UpdateOperationStatus();
   SlaveNode_TransmitOperationStatus();
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+  (void)pEvent;
 
   /* event processed */
   return EVENT_HANDLED;
 }
 
+/* transition tables, indexed by event type */
+static const Hsm_Transition_t SlaveNode_ActiveTransitions[EVENT_TYPE_NUMBER] = {
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  [CAN_RX_EVENT] = HSM_EXTERNAL(SlaveNode_ReceiveCommand, SLAVE_NODE_WAIT_TIMER),
+#else
+  [CAN_RX_EVENT] = HSM_EXTERNAL(SlaveNode_ReceiveCommand, SLAVE_NODE_STATE_TX),
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+};
+
+static const Hsm_Transition_t SlaveNode_TransmitTransitions[EVENT_TYPE_NUMBER] = {
+  [CAN_TX_EVENT] = HSM_CHOICE(NULL, SlaveNode_SequencePending, SLAVE_NODE_WAIT_TIMER, SLAVE_NODE_STATE_IDLE),
+  [CAN_RX_EVENT] = HSM_DEFER, /* new operation command once the current frame is sent */
+};
+
+static const Hsm_Transition_t SlaveNode_WaitTimerTransitions[EVENT_TYPE_NUMBER] = {
+  [TIME_EVENT] = HSM_EXTERNAL(SlaveNode_SendStatus, SLAVE_NODE_STATE_TX),
+};
+
+/* state table, indexed by state ID */
+static const Hsm_State_t SlaveNode_States[SLAVE_NODE_STATE_NUMBER] = {
+  [SLAVE_NODE_STATE_ACTIVE] = {
+    .parent = HSM_NO_STATE,
+    .initial = SLAVE_NODE_STATE_IDLE,
+    .transitions = SlaveNode_ActiveTransitions,
+  },
+  [SLAVE_NODE_STATE_IDLE] = {
+    .parent = SLAVE_NODE_STATE_ACTIVE,
+    .initial = HSM_NO_STATE,
+  },
+  [SLAVE_NODE_STATE_TX] = {
+    .parent = SLAVE_NODE_STATE_ACTIVE,
+    .initial = HSM_NO_STATE,
+    .transitions = SlaveNode_TransmitTransitions,
+  },
+  [SLAVE_NODE_WAIT_TIMER] = {
+    .parent = SLAVE_NODE_STATE_ACTIVE,
+    .initial = HSM_NO_STATE,
+    .entry = SlaveNode_WaitTimer_Entry,
+    .exit = SlaveNode_WaitTimer_Exit,
+    .transitions = SlaveNode_WaitTimerTransitions,
+  },
+};
+
 /**
- * @brief Slave node transmit state handler
- * 
- * @param pEvent [in] pointer to the current event
+ * @brief Run an event to completion in the slave node state machine
+ *
+ * @param pEvent [in] event
  */
-static StateResult_t SlaveNode_Transmit_StateHandler(const Event_t * const pEvent) {
-  if(pEvent->type != CAN_TX_EVENT) {
-    return EVENT_IGNORED;
-  }
+static void SlaveNode_DispatchEvent(const Event_t *const pEvent) {
+  uint64_t now_us = Timebase_GetMicros();
 
-  /* increment transmit count */
-  SlaveNode_TransmitCount++;
+  taskENTER_CRITICAL();
+  EventLatency_Update(&SlaveNode_EventLatency, pEvent, now_us);
+  taskEXIT_CRITICAL();
 
-  /* event was processed */
-  return EVENT_HANDLED;
+  Hsm_Dispatch(&SlaveNode_Hsm, pEvent);
 }
 
-
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+static const Executive_Node_t SlaveNode_ExecutiveNode = {
+  .start = NULL,
+  .dispatch = SlaveNode_DispatchEvent,
+  .poll = NULL,
+};
+#else
 /**
  * @brief Slave node task, handles events generated by SlaveNode_Timer and HAL_CAN_RxFifo0MsgPendingCallback
  * 
  * @param pvParam 
  */
 static void SlaveNode_TaskFunction(void *const pvParam) {
-  Event_t current_event = {0};
+  Event_t *current_event = NULL;
 
   while (1) {
-    /* reset current event */
-    memset(&current_event, 0x00, sizeof(Event_t));
-
     /* get event */
-    xQueueReceive(SlaveNode_EventQueueHandle, (void * const)&current_event, portMAX_DELAY);
-
-    switch(SlaveNode_CurrentState) {
-      case SLAVE_NODE_STATE_IDLE: {
-        if(SlaveNode_Idle_StateHandler(&current_event) == EVENT_HANDLED) {
-          SlaveNode_CurrentState = SLAVE_NODE_STATE_TX;
-        }
-      } break;
-
-      case SLAVE_NODE_WAIT_TIMER: {
-        if(SlaveNode_WaitTimer_StateHandler(&current_event) == EVENT_HANDLED) {
-          SlaveNode_CurrentState = SLAVE_NODE_STATE_TX;
-        }
-      } break;
-
-      case SLAVE_NODE_STATE_TX: {
-        if(SlaveNode_Transmit_StateHandler(&current_event) == EVENT_HANDLED) {
-          if(SlaveNode_TransmitCount == OPERATION_STATUS_COUNT) {
-            SlaveNode_TransmitCount = 0;
-            SlaveNode_CurrentState = SLAVE_NODE_STATE_IDLE;
-          } else {
-            configASSERT(xTimerStart(SlaveNode_TimerHandle, portMAX_DELAY) == pdTRUE);
-            SlaveNode_CurrentState = SLAVE_NODE_WAIT_TIMER;
-          }
-        }
-      } break;
-      
-      default:
-      break;
+#if (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+    current_event = EventChannel_Receive(&SlaveNode_EventChannel, portMAX_DELAY);
+    if (current_event == NULL) {
+      continue;
+    }
+#else
+    if (xQueueReceive(SlaveNode_EventQueueHandle, (void * const)&current_event, portMAX_DELAY) != pdTRUE) {
+      continue;
     }
+#endif /* (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+
+    SlaveNode_DispatchEvent(current_event);
+    EventPool_Release(current_event);
   }
 
   (void)pvParam;
 }
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
 
 void SlaveNode_Initialize(void) {
-  SlaveNode_CurrentState = SLAVE_NODE_STATE_IDLE;
-  SlaveNode_CurrentOperationStatus.status = 0;
-  SlaveNode_CurrentOperationStatus.value = 0;
+  Hsm_Initialize(&SlaveNode_Hsm, SlaveNode_States, SLAVE_NODE_STATE_ACTIVE);
+  SignalDb_Write(SIGNAL_SLAVE_STATUS, &SlaveNode_InitialStatus);
   SlaveNode_TransmitCount = 0;
+#if (CAN2CAN_USE_STATUS_SEQUENCE == 1u)
+  SlaveNode_StatusSequence = 0;
+#endif /* (CAN2CAN_USE_STATUS_SEQUENCE == 1u) */
+  SlaveNode_StatusRate = OPERATION_STATUS_FREQUENCY;
+  SlaveNode_StatusCount = OPERATION_STATUS_COUNT;
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  ScheduleTable_StartSynchronized(&SlaveNode_ScheduleRun, &Can2Can_Schedule, SCHEDULE_TABLE_SENDER_SLAVE, SLAVE_NODE_ID);
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+  Jitter_Initialize(&SlaveNode_StatusJitter, OPERATION_STATUS_PERIOD_US_AT(OPERATION_STATUS_FREQUENCY));
+  memset(&SlaveNode_EventLatency, 0x00, sizeof(EventLatency_t));
+  SlaveNode_DroppedTimeEvents = 0;
+
+  /* initialize CAN RX filters for operation command STD ID */
+  SlaveNode_Id = SLAVE_NODE_ID;
+  SlaveNode_SequenceId = SLAVE_NODE_ID;
+  SlaveNode_FilterBank = SLAVE_NODE_POLICY_NUMBER;
+  SlaveNode_Active = 1;
+
+  /* mode, scale and FIFO of both operation command banks need the filter
+   * initialization mode, they are set now. Slave ID changes only write the ID */
+  configASSERT(bxCAN_SetFilterPolicy(SLAVE_NODE_ALT_POLICY_NUMBER,
+    SLAVE_NODE_RX_FIFO,
+    SlaveNode_CommandFilter(SlaveNode_Id),
+    SlaveNode_CANRxMask) == HAL_OK
+  );
+  bxCAN_DeactivateFilterPolicy(SLAVE_NODE_ALT_POLICY_NUMBER);
+  configASSERT(bxCAN_SetFilterPolicy(SlaveNode_FilterBank,
+    SLAVE_NODE_RX_FIFO,
+    SlaveNode_CommandFilter(SlaveNode_Id),
+    SlaveNode_CANRxMask) == HAL_OK
+  );
 
-  /* initialize CAN RX filters for operation status STD ID */
-  configASSERT(bxCAN_SetFilterPolicy(SLAVE_NODE_POLICY_NUMBER, 
+  /* initialize CAN RX filters for clock sync STD ID */
+  configASSERT(bxCAN_SetFilterPolicy(CLOCK_SYNC_POLICY_NUMBER, 
     SLAVE_NODE_RX_FIFO,
-    SlaveNode_CANRxFilter, 
+    SlaveNode_ClockSyncRxFilter, 
     SlaveNode_CANRxMask) == HAL_OK
   );
 
+  ClockSync_SlaveInitialize();
+  bxCAN_SetRxHandler(SLAVE_NODE_RX_FIFO, SLAVE_NODE_RX_FIFO_CALLBACK);
+
   /* start CAN */
   if (hcan.State == HAL_CAN_STATE_READY) {
     configASSERT(bxCAN_Initialize() == HAL_OK);
   }
 
-  /* initialize timer */
+#if (BXCAN_USE_TX_SCHEDULER == 0u)
+  /* initialize timer, operation status frames are released by the TX scheduler otherwise */
   SlaveNode_TimerHandle = xTimerCreateStatic(
     "SlaveNodeTimer", 
     pdMS_TO_TICKS(1000 / OPERATION_STATUS_FREQUENCY),
@@ -272,23 +745,13 @@ void SlaveNode_Initialize(void) {
     SlaveNode_TimerCallback, 
     &SlaveNode_Timer
   );
+  vTimerSetTimerNumber(SlaveNode_TimerHandle, TRACE_OBJECT_SLAVE_NODE);
+#endif /* (BXCAN_USE_TX_SCHEDULER == 0u) */
 
-  /* initialize rx queue */
-  SlaveNode_RxQueueHandle = xQueueCreateStatic(
-    SLAVE_NODE_RX_QUEUE_SIZE,
-    OPERATION_COMMAND_MSG_SIZE,
-    SlaveNode_RxQueueStorage,
-    &SlaveNode_RxQueue
-  );
-
-  /* initialize event queue */
-  SlaveNode_EventQueueHandle = xQueueCreateStatic(
-    SLAVE_NODE_MAX_EVENTS, 
-    sizeof(Event_t),
-    (uint8_t *)&SlaveNode_EventQueueStorage, 
-    &SlaveNode_EventQueue
-  );
-
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  /* slave node runs in the executive task */
+  SlaveNode_ExecutiveId = Executive_Register(&SlaveNode_ExecutiveNode, SLAVE_TASK_TASK_PRIORITY);
+#else
   // initialize slave node task
   SlaveNode_TaskHandle = xTaskCreateStatic(
     &SlaveNode_TaskFunction, 
@@ -299,4 +762,148 @@ void SlaveNode_Initialize(void) {
     SlaveNode_TaskStack,  /* stack buffer (StackType_t *)  */
     &SlaveNode_TaskBuffer /* task buffer (StaticTask_t *) */
   );
+
+#if (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  /* initialize event channel, the task is its consumer */
+  EventChannel_Initialize(&SlaveNode_EventChannel,
+    SlaveNode_EventChannelStorage,
+    EVENT_POOL_SIZE,
+    SlaveNode_TaskHandle,
+    CAN2CAN_EVENT_CHANNEL_BIT,
+    TRACE_OBJECT_SLAVE_NODE
+  );
+#else
+  /* initialize event queue */
+  SlaveNode_EventQueueHandle = xQueueCreateStatic(
+    SLAVE_NODE_MAX_EVENTS, 
+    sizeof(Event_t *),
+    (uint8_t *)&SlaveNode_EventQueueStorage, 
+    &SlaveNode_EventQueue
+  );
+  vQueueSetQueueNumber(SlaveNode_EventQueueHandle, TRACE_OBJECT_SLAVE_NODE);
+#endif /* (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
+}
+
+/**
+ * @brief Get the operation status transmission period jitter
+ *
+ * @param statistics [out] jitter statistics
+ */
+void SlaveNode_GetStatusJitter(Jitter_Statistics_t *const statistics) {
+  taskENTER_CRITICAL();
+  Jitter_GetStatistics(&SlaveNode_StatusJitter, statistics);
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get the latency of the events dispatched to the slave node
+ *
+ * @param latency [out] event latency statistics
+ */
+void SlaveNode_GetEventLatency(EventLatency_t *const latency) {
+  taskENTER_CRITICAL();
+  memcpy(latency, &SlaveNode_EventLatency, sizeof(EventLatency_t));
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get the number of TIME_EVENT allocations that failed (event pool
+ * empty), each one delayed an operation status frame
+ *
+ * @return uint32_t failed allocations since the initialization
+ */
+uint32_t SlaveNode_GetDroppedTimeEvents(void) {
+  return SlaveNode_DroppedTimeEvents;
+}
+
+/**
+ * @brief Get the synchronization statistics of the slave's communication
+ * schedule table
+ *
+ * @param statistics [out] schedule table statistics, all 0 without the table
+ */
+void SlaveNode_GetScheduleStatistics(ScheduleTable_Statistics_t *const statistics) {
+#if (CAN2CAN_USE_SCHEDULE_TABLE == 1u)
+  taskENTER_CRITICAL();
+  memcpy(statistics, &SlaveNode_ScheduleRun.statistics, sizeof(ScheduleTable_Statistics_t));
+  taskEXIT_CRITICAL();
+#else
+  memset(statistics, 0x00, sizeof(ScheduleTable_Statistics_t));
+#endif /* (CAN2CAN_USE_SCHEDULE_TABLE == 1u) */
+}
+
+/**
+ * @brief Get the slave node event channel statistics
+ *
+ * @param statistics [out] channel statistics, all 0 if the node doesn't use an event channel
+ */
+void SlaveNode_GetEventChannelStatistics(EventChannel_Statistics_t *const statistics) {
+#if (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  EventChannel_GetStatistics(&SlaveNode_EventChannel, statistics);
+#else
+  memset(statistics, 0x00, sizeof(EventChannel_Statistics_t));
+#endif /* (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+}
+
+/**
+ * @brief Change the slave ID. The operation command filter for the new ID is
+ * activated in the spare filter bank before the current one is deactivated,
+ * so commands sent to either ID during the change are not dropped. Only the
+ * filter IDs and activation bits are written, the filter initialization mode
+ * (which stops the reception) isn't entered. Must be called from a task
+ *
+ * @param slave_id [in] new slave ID, < CAN2CAN_SLAVE_NUMBER
+ * @return uint8_t 1: changed, 0: out of range
+ */
+uint8_t SlaveNode_SetId(uint8_t slave_id) {
+  uint8_t spare_bank = (SlaveNode_FilterBank == SLAVE_NODE_POLICY_NUMBER) ? SLAVE_NODE_ALT_POLICY_NUMBER : SLAVE_NODE_POLICY_NUMBER;
+
+  if (slave_id >= CAN2CAN_SLAVE_NUMBER) {
+    return 0;
+  }
+
+  if (slave_id == SlaveNode_Id) {
+    return 1;
+  }
+
+  if (SlaveNode_Active) {
+    /* make before break, neither step stops the reception */
+    SlaveNode_SetCommandFilter(spare_bank, slave_id);
+    bxCAN_DeactivateFilterPolicy(SlaveNode_FilterBank);
+  }
+
+  SlaveNode_FilterBank = spare_bank;
+  SlaveNode_Id = slave_id;
+  return 1;
 }
+
+uint8_t SlaveNode_GetId(void) {
+  return SlaveNode_Id;
+}
+
+/**
+ * @brief Enable/disable the slave role. A disabled slave doesn't receive
+ * operation commands anymore, the current operation status sequence is
+ * completed. Must be called from a task
+ *
+ * @param active [in] 1: enabled, 0: disabled
+ */
+void SlaveNode_SetActive(uint8_t active) {
+  active = (active != 0) ? 1 : 0;
+  if (active == SlaveNode_Active) {
+    return;
+  }
+
+  if (active) {
+    SlaveNode_SetCommandFilter(SlaveNode_FilterBank, SlaveNode_Id);
+  } else {
+    bxCAN_DeactivateFilterPolicy(SlaveNode_FilterBank);
+  }
+
+  SlaveNode_Active = active;
+}
+
+uint8_t SlaveNode_IsActive(void) {
+  return SlaveNode_Active;
+}
\ No newline at end of file
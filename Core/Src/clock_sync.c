@@ -0,0 +1,313 @@
+#include <string.h>
+#include "main.h"
+#include "can.h"
+#include "cmsis_os.h"
+#include "can2can.h"
+#include "timebase.h"
+#include "clock_sync.h"
+
+#define CLOCK_SYNC_PPB              (1000000000LL)
+
+/* master: SYNC sequence number and transmission time */
+static uint8_t ClockSync_MasterSequence = 0;
+static volatile uint64_t ClockSync_MasterTxTime = 0;
+
+/* master: SYNC/FOLLOW_UP transmission */
+static ClockSync_MasterStatistics_t ClockSync_MasterStatistics = {0};
+
+/* master: SYNC timer */
+static TimerHandle_t ClockSync_TimerHandle = NULL;
+static StaticTimer_t ClockSync_Timer = {0};
+static uint32_t ClockSync_TimerID = 0xF1;
+
+/* slave: last received SYNC */
+static uint64_t ClockSync_SyncRxTime = 0;
+static uint8_t ClockSync_SyncSequence = 0;
+static uint8_t ClockSync_SyncPending = 0;
+static uint8_t ClockSync_ReferenceValid = 0;
+static uint8_t ClockSync_ConsecutiveOutliers = 0;
+
+/* slave: synchronization status */
+static ClockSync_Status_t ClockSync_SlaveStatus = {0};
+
+/**
+ * @brief Convert local time to master time using the current estimation,
+ * must be called with interrupts masked
+ */
+static uint64_t ClockSync_LocalToMasterUnsafe(uint64_t local_us) {
+  int64_t elapsed = 0;
+
+  if (ClockSync_SlaveStatus.synchronized == 0) {
+    return local_us;
+  }
+
+  elapsed = (int64_t)(local_us - ClockSync_SlaveStatus.ref_local_us);
+  elapsed -= (elapsed * ClockSync_SlaveStatus.drift_ppb) / CLOCK_SYNC_PPB;
+
+  return ClockSync_SlaveStatus.ref_master_us + elapsed;
+}
+
+/**
+ * @brief Count a FOLLOW_UP frame not sent, the slave drops the SYNC when
+ * the next one arrives. Safe from tasks and ISRs
+ */
+static void ClockSync_CountFollowUpError(void) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  ClockSync_MasterStatistics.follow_up_errors++;
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Send FOLLOW_UP frame with the SYNC transmission time, runs in the
+ * timer task (pended from the SYNC TX complete callback). The mailbox bits
+ * are set through the timer task, it doesn't wait for a free mailbox
+ *
+ * @param pvParam1 unused
+ * @param sequence [in] sequence number of the SYNC frame
+ */
+static void ClockSync_SendFollowUp(void *pvParam1, uint32_t sequence) {
+  uint8_t frame[CLOCK_SYNC_MSG_SIZE] = {0};
+  ClockSyncFrame_Msg_t follow_up = {
+    .type = CLOCK_SYNC_TYPE_FOLLOW_UP,
+    .sequence = (uint8_t)sequence,
+    .tx_time = ClockSync_MasterTxTime,
+  };
+
+  ClockSyncFrame_Pack(&follow_up, frame);
+
+  if (bxCAN_TryTransmit(frame, CLOCK_SYNC_MSG_SIZE, CLOCK_SYNC_STD_ID, NULL) != HAL_OK) {
+    /* both mailboxes busy, this SYNC is lost */
+    ClockSync_CountFollowUpError();
+  }
+
+  (void)pvParam1;
+}
+
+/**
+ * @brief SYNC TX complete callback, captures the transmission time
+ *
+ * @param mailbox [in] mailbox used to transmit the SYNC frame
+ */
+static void ClockSync_BxCANTxCompleteCallback(uint8_t mailbox) {
+  BaseType_t pended = pdFAIL;
+#if (BXCAN_USE_SERVICE_TASK == 0u)
+  BaseType_t xTaskWoken = pdFALSE;
+#endif /* (BXCAN_USE_SERVICE_TASK == 0u) */
+
+  ClockSync_MasterTxTime = bxCAN_GetTxTime(mailbox);
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  pended = xTimerPendFunctionCall(ClockSync_SendFollowUp, NULL, ClockSync_MasterSequence, 0);
+#else
+  pended = xTimerPendFunctionCallFromISR(ClockSync_SendFollowUp, NULL, ClockSync_MasterSequence, &xTaskWoken);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  if (pended != pdPASS) {
+    /* timer queue full */
+    ClockSync_CountFollowUpError();
+  }
+
+#if (BXCAN_USE_SERVICE_TASK == 0u)
+  portYIELD_FROM_ISR(xTaskWoken);
+#endif /* (BXCAN_USE_SERVICE_TASK == 0u) */
+}
+
+/**
+ * @brief Clock sync timer callback, sends SYNC frame. Runs in the timer
+ * task, which can't wait for a free mailbox: when both are busy the SYNC is
+ * skipped and sent in the next period
+ *
+ * @param timer_handle
+ */
+static void ClockSync_TimerCallback(TimerHandle_t timer_handle) {
+  uint8_t frame[CLOCK_SYNC_MSG_SIZE] = {0};
+  HAL_StatusTypeDef status = HAL_ERROR;
+  ClockSyncFrame_Msg_t sync = {
+    .type = CLOCK_SYNC_TYPE_SYNC,
+    .sequence = (uint8_t)(ClockSync_MasterSequence + 1u),
+    .tx_time = 0,
+  };
+
+  /* SYNC frame carries type and sequence number only */
+  ClockSyncFrame_Pack(&sync, frame);
+
+  /* sequence read by the TX complete callback, set before the frame is loaded */
+  ClockSync_MasterSequence = sync.sequence;
+
+  status = bxCAN_TryTransmit(
+    frame,
+    CLOCK_SYNC_SYNC_MSG_SIZE,
+    CLOCK_SYNC_STD_ID,
+    ClockSync_BxCANTxCompleteCallback
+  );
+  configASSERT((status == HAL_OK) || (status == HAL_BUSY));
+
+  taskENTER_CRITICAL();
+  if (status == HAL_OK) {
+    ClockSync_MasterStatistics.sync_count++;
+  } else {
+    /* the sequence number is reused by the next period */
+    ClockSync_MasterSequence = (uint8_t)(sync.sequence - 1u);
+    ClockSync_MasterStatistics.sync_busy++;
+  }
+  taskEXIT_CRITICAL();
+
+  (void)timer_handle;
+}
+
+/**
+ * @brief Update offset and drift estimations from a SYNC/FOLLOW_UP pair,
+ * must be called with interrupts masked
+ *
+ * @param master_us [in] SYNC transmission time (master time)
+ * @param local_us [in] SYNC reception time (local time)
+ */
+static void ClockSync_UpdateEstimation(uint64_t master_us, uint64_t local_us) {
+  ClockSync_Status_t *const status = &ClockSync_SlaveStatus;
+  int64_t residual = 0;
+  int64_t local_delta = 0;
+  int64_t master_delta = 0;
+  int32_t drift = 0;
+
+  if (status->synchronized != 0) {
+    residual = (int64_t)(ClockSync_LocalToMasterUnsafe(local_us) - master_us);
+
+    if ((residual > CLOCK_SYNC_OUTLIER_US) || (residual < -(int64_t)CLOCK_SYNC_OUTLIER_US)) {
+      status->outlier_count++;
+      ClockSync_ConsecutiveOutliers++;
+      if (ClockSync_ConsecutiveOutliers < CLOCK_SYNC_MAX_OUTLIERS) {
+        return;
+      }
+
+      /* estimation no longer matches the master clock, start over */
+      status->synchronized = 0;
+      ClockSync_ReferenceValid = 0;
+    }
+  }
+
+  ClockSync_ConsecutiveOutliers = 0;
+
+  if (ClockSync_ReferenceValid != 0) {
+    local_delta = (int64_t)(local_us - status->ref_local_us);
+    master_delta = (int64_t)(master_us - status->ref_master_us);
+
+    if (master_delta > 0) {
+      drift = (int32_t)(((local_delta - master_delta) * CLOCK_SYNC_PPB) / master_delta);
+
+      if (status->synchronized == 0) {
+        status->drift_ppb = drift;
+        status->synchronized = 1;
+        status->max_residual_us = 0;
+      } else {
+        status->drift_ppb += (drift - status->drift_ppb) / (1 << CLOCK_SYNC_DRIFT_FILTER_SHIFT);
+        status->residual_us = (int32_t)residual;
+        if ((uint32_t)((residual < 0) ? -residual : residual) > status->max_residual_us) {
+          status->max_residual_us = (uint32_t)((residual < 0) ? -residual : residual);
+        }
+      }
+    }
+  }
+
+  status->ref_local_us = local_us;
+  status->ref_master_us = master_us;
+  status->sync_count++;
+  ClockSync_ReferenceValid = 1;
+}
+
+void ClockSync_MasterInitialize(void) {
+  ClockSync_MasterSequence = 0;
+  ClockSync_MasterTxTime = 0;
+  memset(&ClockSync_MasterStatistics, 0x00, sizeof(ClockSync_MasterStatistics_t));
+
+  ClockSync_TimerHandle = xTimerCreateStatic(
+    "ClockSyncTimer",
+    pdMS_TO_TICKS(CLOCK_SYNC_PERIOD_MS),
+    pdTRUE,
+    (void *)&ClockSync_TimerID,
+    ClockSync_TimerCallback,
+    &ClockSync_Timer
+  );
+  vTimerSetTimerNumber(ClockSync_TimerHandle, TRACE_OBJECT_CLOCK_SYNC);
+
+  configASSERT(xTimerStart(ClockSync_TimerHandle, 0) == pdPASS);
+}
+
+void ClockSync_SlaveInitialize(void) {
+  memset(&ClockSync_SlaveStatus, 0x00, sizeof(ClockSync_Status_t));
+  ClockSync_SyncRxTime = 0;
+  ClockSync_SyncSequence = 0;
+  ClockSync_SyncPending = 0;
+  ClockSync_ReferenceValid = 0;
+  ClockSync_ConsecutiveOutliers = 0;
+}
+
+void ClockSync_SlaveProcessFrame(const uint8_t *const data, uint8_t len, uint64_t rx_time_us) {
+#if (BXCAN_USE_SERVICE_TASK == 0u)
+  UBaseType_t saved_mask = 0;
+#endif /* (BXCAN_USE_SERVICE_TASK == 0u) */
+  ClockSyncFrame_Msg_t frame = {0};
+
+  if (len < CLOCK_SYNC_SYNC_MSG_SIZE) {
+    return;
+  }
+
+  ClockSyncFrame_Unpack(data, &frame);
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  taskENTER_CRITICAL();
+#else
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  switch (frame.type) {
+    case CLOCK_SYNC_TYPE_SYNC: {
+      ClockSync_SyncRxTime = rx_time_us - CLOCK_SYNC_RX_LATENCY_US;
+      ClockSync_SyncSequence = frame.sequence;
+      ClockSync_SyncPending = 1;
+    } break;
+
+    case CLOCK_SYNC_TYPE_FOLLOW_UP: {
+      if ((len == CLOCK_SYNC_MSG_SIZE)
+          && (ClockSync_SyncPending != 0)
+          && (ClockSync_SyncSequence == frame.sequence)) {
+        ClockSync_UpdateEstimation(frame.tx_time, ClockSync_SyncRxTime);
+      } else {
+        ClockSync_SlaveStatus.missed_count++;
+      }
+      ClockSync_SyncPending = 0;
+    } break;
+
+    default:
+    break;
+  }
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  taskEXIT_CRITICAL();
+#else
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+}
+
+uint64_t ClockSync_LocalToMaster(uint64_t local_us) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  uint64_t master_us = ClockSync_LocalToMasterUnsafe(local_us);
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  return master_us;
+}
+
+uint64_t ClockSync_GetMasterTime(void) {
+  return ClockSync_LocalToMaster(Timebase_GetMicros());
+}
+
+void ClockSync_GetStatus(ClockSync_Status_t *const status) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(status, &ClockSync_SlaveStatus, sizeof(ClockSync_Status_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+void ClockSync_GetMasterStatistics(ClockSync_MasterStatistics_t *const statistics) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &ClockSync_MasterStatistics, sizeof(ClockSync_MasterStatistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
@@ -0,0 +1,243 @@
+#include <string.h>
+#include "main.h"
+#include "can.h"
+#include "cmsis_os.h"
+#include "can2can.h"
+#include "timebase.h"
+#include "cpu_load.h"
+#include "config_service.h"
+
+#define CONFIG_SERVICE_LATENCY_MAX_US   (0xFFFFu)   /* response latency signal saturates */
+
+/* request waiting for the timer task */
+static ConfigRequest_Msg_t ConfigService_Request = {0};
+static uint64_t ConfigService_RequestTime = 0;
+static volatile uint8_t ConfigService_Pending = 0;
+
+static ConfigService_Statistics_t ConfigService_Statistics = {0};
+
+static const bxCAN_Filter_t ConfigService_CANRxFilter = {
+  .as_struct = {
+    .RTR = 0, /* data */
+    .IDE = 0, /* standard ID */
+    .StdId = CONFIG_SERVICE_REQUEST_STD_ID
+  }
+};
+
+static const bxCAN_Filter_t ConfigService_CANRxMask = {
+  .as_struct = {
+    .RTR = 0, /* don't care */
+    .IDE = 0, /* don't care */
+    .StdId = ~0 /* exact match */
+  }
+};
+
+/**
+ * @brief Count a frame not sent, both mailboxes of the task were busy. The
+ * timer task can't wait for them, the tool retries its request
+ *
+ * @param status [in] bxCAN_TryTransmit() result
+ */
+static void ConfigService_CountUnsent(HAL_StatusTypeDef status) {
+  configASSERT((status == HAL_OK) || (status == HAL_BUSY));
+
+  if (status == HAL_BUSY) {
+    taskENTER_CRITICAL();
+    ConfigService_Statistics.unsent++;
+    taskEXIT_CRITICAL();
+  }
+}
+
+/**
+ * @brief Send a configuration response with the current configuration
+ *
+ * @param service [in] requested service
+ * @param result [in] CONFIG_RESPONSE_RESULT_x
+ * @param latency_us [in] request reception to configuration in effect
+ */
+static void ConfigService_Respond(uint8_t service, uint8_t result, uint32_t latency_us) {
+  uint8_t frame[CONFIG_SERVICE_RESPONSE_MSG_SIZE] = {0};
+  ConfigResponse_Msg_t response = {
+    .service = service,
+    .result = result,
+    .latency = (uint16_t)((latency_us > CONFIG_SERVICE_LATENCY_MAX_US) ? CONFIG_SERVICE_LATENCY_MAX_US : latency_us),
+    .status_rate = MasterNode_GetStatusRate(),
+    .slave_id = SlaveNode_GetId(),
+    .roles = (uint8_t)((MasterNode_IsActive() ? CAN2CAN_ROLE_MASTER : 0u) | (SlaveNode_IsActive() ? CAN2CAN_ROLE_SLAVE : 0u)),
+  };
+
+  ConfigResponse_Pack(&response, frame);
+
+  ConfigService_CountUnsent(bxCAN_TryTransmit(frame, CONFIG_SERVICE_RESPONSE_MSG_SIZE, CONFIG_SERVICE_RESPONSE_STD_ID, NULL));
+}
+
+/**
+ * @brief Send a load report, CPU load (cpu_load.h) and bus load
+ */
+static void ConfigService_ReportLoad(void) {
+  uint8_t frame[CONFIG_SERVICE_LOAD_MSG_SIZE] = {0};
+  CpuLoad_Statistics_t load = {0};
+  LoadReport_Msg_t report = {0};
+
+  CpuLoad_GetStatistics(&load);
+  report.cpu_load = load.load;
+  report.cpu_load_long = load.long_load;
+  report.cpu_peak = load.peak_load;
+  report.bus_load = load.bus_load;
+
+  LoadReport_Pack(&report, frame);
+
+  ConfigService_CountUnsent(bxCAN_TryTransmit(frame, CONFIG_SERVICE_LOAD_MSG_SIZE, CONFIG_SERVICE_LOAD_STD_ID, NULL));
+}
+
+/**
+ * @brief Apply the pending configuration request, runs in the timer task
+ * (pended from the slave's RX handler)
+ *
+ * @param pvParam1 unused
+ * @param param2 unused
+ */
+static void ConfigService_Execute(void *pvParam1, uint32_t param2) {
+  uint8_t result = CONFIG_RESPONSE_RESULT_OK;
+  uint32_t latency_us = 0;
+
+  switch (ConfigService_Request.service) {
+    case CONFIG_REQUEST_SERVICE_SET_STATUS_RATE: {
+      /* applied by the master from the next command period */
+      if (MasterNode_SetStatusRate(ConfigService_Request.value) == 0) {
+        result = CONFIG_RESPONSE_RESULT_INVALID;
+      }
+    } break;
+
+    case CONFIG_REQUEST_SERVICE_SET_SLAVE_ID: {
+      if ((ConfigService_Request.value > UINT8_MAX) || (SlaveNode_SetId((uint8_t)ConfigService_Request.value) == 0)) {
+        result = CONFIG_RESPONSE_RESULT_INVALID;
+      }
+    } break;
+
+    case CONFIG_REQUEST_SERVICE_SET_ROLES: {
+      if ((ConfigService_Request.value & ~CAN2CAN_ROLE_ALL) != 0) {
+        result = CONFIG_RESPONSE_RESULT_INVALID;
+      } else {
+        MasterNode_SetActive((ConfigService_Request.value & CAN2CAN_ROLE_MASTER) != 0);
+        SlaveNode_SetActive((ConfigService_Request.value & CAN2CAN_ROLE_SLAVE) != 0);
+      }
+    } break;
+
+    case CONFIG_REQUEST_SERVICE_GET_CONFIG:
+    case CONFIG_REQUEST_SERVICE_GET_LOAD:
+    break;
+
+    default: {
+      result = CONFIG_RESPONSE_RESULT_UNKNOWN;
+    } break;
+  }
+
+  latency_us = (uint32_t)(Timebase_GetMicros() - ConfigService_RequestTime);
+
+  taskENTER_CRITICAL();
+  if (result == CONFIG_RESPONSE_RESULT_OK) {
+    ConfigService_Statistics.requests++;
+    ConfigService_Statistics.last_latency_us = latency_us;
+    if (latency_us > ConfigService_Statistics.max_latency_us) {
+      ConfigService_Statistics.max_latency_us = latency_us;
+    }
+  } else {
+    ConfigService_Statistics.rejected++;
+  }
+  taskEXIT_CRITICAL();
+
+  ConfigService_Respond(ConfigService_Request.service, result, latency_us);
+  if (ConfigService_Request.service == CONFIG_REQUEST_SERVICE_GET_LOAD) {
+    ConfigService_ReportLoad();
+  }
+
+  /* next request can be accepted */
+  ConfigService_Pending = 0;
+
+  (void)pvParam1;
+  (void)param2;
+}
+
+/**
+ * @brief Answer a request received while another one was pending, runs in
+ * the timer task
+ *
+ * @param pvParam1 unused
+ * @param service [in] requested service
+ */
+static void ConfigService_RespondBusy(void *pvParam1, uint32_t service) {
+  ConfigService_Respond((uint8_t)service, CONFIG_RESPONSE_RESULT_BUSY, 0);
+
+  (void)pvParam1;
+}
+
+void ConfigService_Initialize(void) {
+  memset(&ConfigService_Statistics, 0x00, sizeof(ConfigService_Statistics_t));
+  ConfigService_Pending = 0;
+
+  /* configuration requests are received with the slave node's frames */
+  configASSERT(bxCAN_SetFilterPolicy(CONFIG_SERVICE_POLICY_NUMBER,
+    SLAVE_NODE_RX_FIFO,
+    ConfigService_CANRxFilter,
+    ConfigService_CANRxMask) == HAL_OK
+  );
+}
+
+void ConfigService_ProcessFrame(const uint8_t *const data, uint8_t len, uint64_t rx_time_us) {
+#if (BXCAN_USE_SERVICE_TASK == 0u)
+  BaseType_t xTaskWoken = pdFALSE;
+  UBaseType_t saved_mask = 0;
+#endif /* (BXCAN_USE_SERVICE_TASK == 0u) */
+  BaseType_t pended = pdFAIL;
+  ConfigRequest_Msg_t request = {0};
+
+  if (len < CONFIG_SERVICE_REQUEST_MSG_SIZE) {
+    return;
+  }
+
+  ConfigRequest_Unpack(data, &request);
+
+  if (ConfigService_Pending != 0) {
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+    taskENTER_CRITICAL();
+    ConfigService_Statistics.busy++;
+    taskEXIT_CRITICAL();
+
+    (void)xTimerPendFunctionCall(ConfigService_RespondBusy, NULL, request.service, 0);
+#else
+    saved_mask = taskENTER_CRITICAL_FROM_ISR();
+    ConfigService_Statistics.busy++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+    (void)xTimerPendFunctionCallFromISR(ConfigService_RespondBusy, NULL, request.service, &xTaskWoken);
+    portYIELD_FROM_ISR(xTaskWoken);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+    return;
+  }
+
+  ConfigService_Request = request;
+  ConfigService_RequestTime = rx_time_us;
+  ConfigService_Pending = 1;
+
+#if (BXCAN_USE_SERVICE_TASK == 1u)
+  pended = xTimerPendFunctionCall(ConfigService_Execute, NULL, 0, 0);
+#else
+  pended = xTimerPendFunctionCallFromISR(ConfigService_Execute, NULL, 0, &xTaskWoken);
+#endif /* (BXCAN_USE_SERVICE_TASK == 1u) */
+
+  if (pended != pdPASS) {
+    /* timer queue full, request dropped without response, the tool retries */
+    ConfigService_Pending = 0;
+  }
+
+#if (BXCAN_USE_SERVICE_TASK == 0u)
+  portYIELD_FROM_ISR(xTaskWoken);
+#endif /* (BXCAN_USE_SERVICE_TASK == 0u) */
+}
+
+void ConfigService_GetStatistics(ConfigService_Statistics_t *const statistics) {
+  taskENTER_CRITICAL();
+  memcpy(statistics, &ConfigService_Statistics, sizeof(ConfigService_Statistics_t));
+  taskEXIT_CRITICAL();
+}
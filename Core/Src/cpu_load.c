@@ -0,0 +1,193 @@
+#include <string.h>
+#include "main.h"
+#include "can.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "runtime_stats.h"
+#include "cpu_load.h"
+
+#if (CPU_LOAD_USE_METER == 1u) && (configUSE_IDLE_HOOK != 1)
+#error the CPU load meter needs configUSE_IDLE_HOOK
+#endif /* (CPU_LOAD_USE_METER == 1u) && (configUSE_IDLE_HOOK != 1) */
+
+static CpuLoad_Statistics_t CpuLoad_Statistics = {0};
+
+#if (CPU_LOAD_USE_METER == 1u)
+/* idle task, since boot: set by the idle hook, cleared at its switch out.
+ * The idle cycles don't include the accounted interrupt handlers that
+ * preempted the idle task */
+static volatile uint8_t CpuLoad_Idle = 0;
+static volatile uint32_t CpuLoad_IdleStart = 0;
+static volatile uint32_t CpuLoad_IdleIsrStart = 0;
+static volatile uint32_t CpuLoad_IdleCycles = 0;
+
+/* current window, counters at its start */
+static uint32_t CpuLoad_WindowStart = 0;
+static uint32_t CpuLoad_WindowIdle = 0;
+static uint32_t CpuLoad_WindowIsr = 0;
+static uint32_t CpuLoad_WindowBusBits = 0;
+static uint8_t CpuLoad_Started = 0;
+
+/* current long window */
+static uint32_t CpuLoad_LongBusy = 0;
+static uint32_t CpuLoad_LongCycles = 0;
+static uint32_t CpuLoad_LongWindows = 0;
+
+/**
+ * @brief Cycles of the accounted interrupt handlers since boot, wraps
+ */
+static uint32_t CpuLoad_IsrCycles(void) {
+  RuntimeStats_IsrStatistics_t isr = {0};
+  uint32_t cycles = 0;
+
+  for (uint32_t index = 0; index < RUNTIME_STATS_ISR_NUMBER; index++) {
+    RuntimeStats_GetIsrStatistics((RuntimeStats_Isr_t)index, &isr);
+    cycles += isr.cycles;
+  }
+
+  return cycles;
+}
+
+/**
+ * @brief Idle cycles of the current run, without the accounted interrupt
+ * handlers that preempted it
+ *
+ * @param now [in] Timebase_GetCycles()
+ */
+static uint32_t CpuLoad_IdleRun(uint32_t now) {
+  const uint32_t run = now - CpuLoad_IdleStart;
+  const uint32_t isr = CpuLoad_IsrCycles() - CpuLoad_IdleIsrStart;
+
+  /* a handler that started before the run is accounted in full */
+  return (isr < run) ? (run - isr) : 0u;
+}
+
+/**
+ * @brief Share of a window, CPU_LOAD_FULL_SCALE at most
+ */
+static uint16_t CpuLoad_Share(uint64_t part, uint64_t whole) {
+  const uint64_t share = (whole != 0) ? ((part * CPU_LOAD_FULL_SCALE) / whole) : 0u;
+
+  return (uint16_t)((share > CPU_LOAD_FULL_SCALE) ? CPU_LOAD_FULL_SCALE : share);
+}
+
+/**
+ * @brief End the current window, from the tick hook
+ *
+ * @param now [in] Timebase_GetCycles()
+ * @param elapsed [in] window length, cycles
+ * @param idle [in] idle task cycles since boot, current run included
+ */
+static void CpuLoad_CloseWindow(uint32_t now, uint32_t elapsed, uint32_t idle) {
+  const uint32_t isr = CpuLoad_IsrCycles();
+  const uint32_t bus_bits = bxCAN_GetBusBits();
+  uint32_t idle_cycles = idle - CpuLoad_WindowIdle;
+  uint32_t busy = 0;
+
+  if (idle_cycles > elapsed) {
+    idle_cycles = elapsed;
+  }
+  busy = elapsed - idle_cycles;
+
+  CpuLoad_Statistics.windows++;
+  CpuLoad_Statistics.window_cycles = elapsed;
+  CpuLoad_Statistics.idle_cycles = idle_cycles;
+  CpuLoad_Statistics.load = CpuLoad_Share(busy, elapsed);
+  CpuLoad_Statistics.isr_load = CpuLoad_Share(isr - CpuLoad_WindowIsr, elapsed);
+
+  /* bits sent at BXCAN_BIT_RATE over the window */
+  CpuLoad_Statistics.bus_load = CpuLoad_Share((uint64_t)(bus_bits - CpuLoad_WindowBusBits) * SystemCoreClock,
+    (uint64_t)elapsed * BXCAN_BIT_RATE);
+
+  if (CpuLoad_Statistics.load >= CpuLoad_Statistics.peak_load) {
+    CpuLoad_Statistics.peak_load = CpuLoad_Statistics.load;
+    CpuLoad_Statistics.peak_bus_load = CpuLoad_Statistics.bus_load;
+  }
+
+  CpuLoad_LongBusy += busy;
+  CpuLoad_LongCycles += elapsed;
+  if (++CpuLoad_LongWindows >= CPU_LOAD_LONG_WINDOWS) {
+    CpuLoad_Statistics.long_load = CpuLoad_Share(CpuLoad_LongBusy, CpuLoad_LongCycles);
+    CpuLoad_LongBusy = 0;
+    CpuLoad_LongCycles = 0;
+    CpuLoad_LongWindows = 0;
+  }
+
+  CpuLoad_WindowStart = now;
+  CpuLoad_WindowIdle = idle;
+  CpuLoad_WindowIsr = isr;
+  CpuLoad_WindowBusBits = bus_bits;
+}
+
+/**
+ * @brief Idle hook, idle task. The idle time starts at the first call after
+ * the idle task is switched in, the following calls and the sleeps between
+ * them are in the same run
+ */
+void vApplicationIdleHook(void) {
+  if (CpuLoad_Idle != 0) {
+    return;
+  }
+
+  /* only the idle task sets the flag, and it isn't cleared while it runs */
+  taskENTER_CRITICAL();
+  CpuLoad_IdleStart = Timebase_GetCycles();
+  CpuLoad_IdleIsrStart = CpuLoad_IsrCycles();
+  CpuLoad_Idle = 1;
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Tick hook, SysTick interrupt: end the window once it's
+ * CPU_LOAD_WINDOW_MS long. The first tick starts the first window
+ */
+void vApplicationTickHook(void) {
+  const uint32_t now = Timebase_GetCycles();
+  const uint32_t window = (SystemCoreClock / 1000u) * CPU_LOAD_WINDOW_MS;
+  const uint32_t elapsed = now - CpuLoad_WindowStart;
+  uint32_t idle = CpuLoad_IdleCycles;
+
+  /* the idle task's current run, the tick interrupted it */
+  if (CpuLoad_Idle != 0) {
+    idle += CpuLoad_IdleRun(now);
+  }
+
+  if (CpuLoad_Started == 0) {
+    CpuLoad_WindowStart = now;
+    CpuLoad_WindowIdle = idle;
+    CpuLoad_WindowIsr = CpuLoad_IsrCycles();
+    CpuLoad_WindowBusBits = bxCAN_GetBusBits();
+    CpuLoad_Started = 1;
+    return;
+  }
+
+  if (elapsed >= window) {
+    CpuLoad_CloseWindow(now, elapsed, idle);
+  }
+}
+#endif /* (CPU_LOAD_USE_METER == 1u) */
+
+/**
+ * @brief Idle task switched out (traceTASK_SWITCHED_OUT), from the context
+ * switch. The flag is only set while the idle task runs, no check of the
+ * task is needed
+ */
+void CpuLoad_TaskSwitchedOut(void) {
+#if (CPU_LOAD_USE_METER == 1u)
+  if (CpuLoad_Idle != 0) {
+    CpuLoad_IdleCycles += CpuLoad_IdleRun(Timebase_GetCycles());
+    CpuLoad_Idle = 0;
+  }
+#endif /* (CPU_LOAD_USE_METER == 1u) */
+}
+
+/**
+ * @brief Get the CPU load
+ *
+ * @param statistics [out] load of the last windows, all 0 without the meter
+ */
+void CpuLoad_GetStatistics(CpuLoad_Statistics_t *const statistics) {
+  taskENTER_CRITICAL();
+  memcpy(statistics, &CpuLoad_Statistics, sizeof(CpuLoad_Statistics_t));
+  taskEXIT_CRITICAL();
+}
@@ -0,0 +1,421 @@
+#include <string.h>
+#include "main.h"
+#include "can.h"
+#include "crc.h"
+#include "cmsis_os.h"
+#include "can2can.h"
+#include "timebase.h"
+#include "trace.h"
+#include "e2e.h"
+
+/* data ID (2) + DLC (1) + frame without CRC (6), padded to 32 bit words */
+#define E2E_CRC_BUFFER_SIZE       (12u)
+#define E2E_CRC_INIT              (0xFFFFFFFFu)
+
+/**
+ * @brief Protection parameters of a standard ID
+ */
+typedef struct {
+  uint16_t std_id;              /* first protected standard ID */
+  uint8_t id_number;            /* number of protected IDs, id_step apart */
+  uint8_t id_step;              /* distance between protected IDs */
+  uint8_t max_delta_counter;    /* largest counter jump accepted as OK */
+  uint8_t timeout_periods;      /* periods without a valid frame before E2E_STATUS_NO_NEW_DATA */
+  uint16_t (*get_rate)(void);   /* current frame rate of each ID, Hz */
+} E2E_Config_t;
+
+/**
+ * @brief Protection state of a standard ID
+ */
+typedef struct {
+  uint8_t tx_counter;           /* next counter value to send */
+  uint8_t rx_counter;           /* last received counter value */
+  uint8_t rx_counter_valid;     /* a valid frame was received, rx_counter can be used */
+  E2E_Status_t status;          /* last check result */
+  uint32_t last_rx_tick;        /* tick of the last OK frame */
+  E2E_Statistics_t statistics;  /* receive statistics */
+} E2E_Channel_t;
+
+static uint16_t E2E_GetCommandRate(void);
+
+/* one channel per slave for each message, the operation status rate is set
+ * at run time by the master */
+static const E2E_Config_t E2E_Configs[] = {
+  {
+    OPERATION_COMMAND_STD_ID, CAN2CAN_SLAVE_NUMBER, SLAVE_ID_RANGE_SIZE,
+    OPERATION_COMMAND_E2E_MAX_DELTA, OPERATION_COMMAND_E2E_TIMEOUT_PERIODS, E2E_GetCommandRate
+  },
+  {
+    OPERATION_STATUS_STD_ID, CAN2CAN_SLAVE_NUMBER, SLAVE_ID_RANGE_SIZE,
+    OPERATION_STATUS_E2E_MAX_DELTA, OPERATION_STATUS_E2E_TIMEOUT_PERIODS, MasterNode_GetStatusRate
+  },
+};
+
+#define E2E_CONFIG_NUMBER         (sizeof(E2E_Configs) / sizeof(E2E_Configs[0]))
+#define E2E_CHANNEL_NUMBER        (2u * CAN2CAN_SLAVE_NUMBER)
+
+static E2E_Channel_t E2E_Channels[E2E_CHANNEL_NUMBER] = {0};
+static E2E_Benchmark_t E2E_BenchmarkResult = {0};
+
+/* CRC-32 (0x04C11DB7), MSB first, same result as the CRC peripheral */
+static const uint32_t E2E_CrcTable[256] = {
+  0x00000000u, 0x04C11DB7u, 0x09823B6Eu, 0x0D4326D9u, 0x130476DCu, 0x17C56B6Bu,
+  0x1A864DB2u, 0x1E475005u, 0x2608EDB8u, 0x22C9F00Fu, 0x2F8AD6D6u, 0x2B4BCB61u,
+  0x350C9B64u, 0x31CD86D3u, 0x3C8EA00Au, 0x384FBDBDu, 0x4C11DB70u, 0x48D0C6C7u,
+  0x4593E01Eu, 0x4152FDA9u, 0x5F15ADACu, 0x5BD4B01Bu, 0x569796C2u, 0x52568B75u,
+  0x6A1936C8u, 0x6ED82B7Fu, 0x639B0DA6u, 0x675A1011u, 0x791D4014u, 0x7DDC5DA3u,
+  0x709F7B7Au, 0x745E66CDu, 0x9823B6E0u, 0x9CE2AB57u, 0x91A18D8Eu, 0x95609039u,
+  0x8B27C03Cu, 0x8FE6DD8Bu, 0x82A5FB52u, 0x8664E6E5u, 0xBE2B5B58u, 0xBAEA46EFu,
+  0xB7A96036u, 0xB3687D81u, 0xAD2F2D84u, 0xA9EE3033u, 0xA4AD16EAu, 0xA06C0B5Du,
+  0xD4326D90u, 0xD0F37027u, 0xDDB056FEu, 0xD9714B49u, 0xC7361B4Cu, 0xC3F706FBu,
+  0xCEB42022u, 0xCA753D95u, 0xF23A8028u, 0xF6FB9D9Fu, 0xFBB8BB46u, 0xFF79A6F1u,
+  0xE13EF6F4u, 0xE5FFEB43u, 0xE8BCCD9Au, 0xEC7DD02Du, 0x34867077u, 0x30476DC0u,
+  0x3D044B19u, 0x39C556AEu, 0x278206ABu, 0x23431B1Cu, 0x2E003DC5u, 0x2AC12072u,
+  0x128E9DCFu, 0x164F8078u, 0x1B0CA6A1u, 0x1FCDBB16u, 0x018AEB13u, 0x054BF6A4u,
+  0x0808D07Du, 0x0CC9CDCAu, 0x7897AB07u, 0x7C56B6B0u, 0x71159069u, 0x75D48DDEu,
+  0x6B93DDDBu, 0x6F52C06Cu, 0x6211E6B5u, 0x66D0FB02u, 0x5E9F46BFu, 0x5A5E5B08u,
+  0x571D7DD1u, 0x53DC6066u, 0x4D9B3063u, 0x495A2DD4u, 0x44190B0Du, 0x40D816BAu,
+  0xACA5C697u, 0xA864DB20u, 0xA527FDF9u, 0xA1E6E04Eu, 0xBFA1B04Bu, 0xBB60ADFCu,
+  0xB6238B25u, 0xB2E29692u, 0x8AAD2B2Fu, 0x8E6C3698u, 0x832F1041u, 0x87EE0DF6u,
+  0x99A95DF3u, 0x9D684044u, 0x902B669Du, 0x94EA7B2Au, 0xE0B41DE7u, 0xE4750050u,
+  0xE9362689u, 0xEDF73B3Eu, 0xF3B06B3Bu, 0xF771768Cu, 0xFA325055u, 0xFEF34DE2u,
+  0xC6BCF05Fu, 0xC27DEDE8u, 0xCF3ECB31u, 0xCBFFD686u, 0xD5B88683u, 0xD1799B34u,
+  0xDC3ABDEDu, 0xD8FBA05Au, 0x690CE0EEu, 0x6DCDFD59u, 0x608EDB80u, 0x644FC637u,
+  0x7A089632u, 0x7EC98B85u, 0x738AAD5Cu, 0x774BB0EBu, 0x4F040D56u, 0x4BC510E1u,
+  0x46863638u, 0x42472B8Fu, 0x5C007B8Au, 0x58C1663Du, 0x558240E4u, 0x51435D53u,
+  0x251D3B9Eu, 0x21DC2629u, 0x2C9F00F0u, 0x285E1D47u, 0x36194D42u, 0x32D850F5u,
+  0x3F9B762Cu, 0x3B5A6B9Bu, 0x0315D626u, 0x07D4CB91u, 0x0A97ED48u, 0x0E56F0FFu,
+  0x1011A0FAu, 0x14D0BD4Du, 0x19939B94u, 0x1D528623u, 0xF12F560Eu, 0xF5EE4BB9u,
+  0xF8AD6D60u, 0xFC6C70D7u, 0xE22B20D2u, 0xE6EA3D65u, 0xEBA91BBCu, 0xEF68060Bu,
+  0xD727BBB6u, 0xD3E6A601u, 0xDEA580D8u, 0xDA649D6Fu, 0xC423CD6Au, 0xC0E2D0DDu,
+  0xCDA1F604u, 0xC960EBB3u, 0xBD3E8D7Eu, 0xB9FF90C9u, 0xB4BCB610u, 0xB07DABA7u,
+  0xAE3AFBA2u, 0xAAFBE615u, 0xA7B8C0CCu, 0xA379DD7Bu, 0x9B3660C6u, 0x9FF77D71u,
+  0x92B45BA8u, 0x9675461Fu, 0x8832161Au, 0x8CF30BADu, 0x81B02D74u, 0x857130C3u,
+  0x5D8A9099u, 0x594B8D2Eu, 0x5408ABF7u, 0x50C9B640u, 0x4E8EE645u, 0x4A4FFBF2u,
+  0x470CDD2Bu, 0x43CDC09Cu, 0x7B827D21u, 0x7F436096u, 0x7200464Fu, 0x76C15BF8u,
+  0x68860BFDu, 0x6C47164Au, 0x61043093u, 0x65C52D24u, 0x119B4BE9u, 0x155A565Eu,
+  0x18197087u, 0x1CD86D30u, 0x029F3D35u, 0x065E2082u, 0x0B1D065Bu, 0x0FDC1BECu,
+  0x3793A651u, 0x3352BBE6u, 0x3E119D3Fu, 0x3AD08088u, 0x2497D08Du, 0x2056CD3Au,
+  0x2D15EBE3u, 0x29D4F654u, 0xC5A92679u, 0xC1683BCEu, 0xCC2B1D17u, 0xC8EA00A0u,
+  0xD6AD50A5u, 0xD26C4D12u, 0xDF2F6BCBu, 0xDBEE767Cu, 0xE3A1CBC1u, 0xE760D676u,
+  0xEA23F0AFu, 0xEEE2ED18u, 0xF0A5BD1Du, 0xF464A0AAu, 0xF9278673u, 0xFDE69BC4u,
+  0x89B8FD09u, 0x8D79E0BEu, 0x803AC667u, 0x84FBDBD0u, 0x9ABC8BD5u, 0x9E7D9662u,
+  0x933EB0BBu, 0x97FFAD0Cu, 0xAFB010B1u, 0xAB710D06u, 0xA6322BDFu, 0xA2F33668u,
+  0xBCB4666Du, 0xB8757BDAu, 0xB5365D03u, 0xB1F740B4u
+};
+
+/**
+ * @brief Get the channel of a protected standard ID
+ *
+ * @param std_id [in] standard ID
+ * @param config [out] protection parameters of the channel, can be NULL
+ * @return int32_t channel index, -1 if std_id is not protected
+ */
+static int32_t E2E_FindChannel(uint16_t std_id, const E2E_Config_t **config) {
+  uint32_t first_channel = 0;
+
+  for (uint32_t i = 0; i < E2E_CONFIG_NUMBER; i++) {
+    const E2E_Config_t *const entry = &E2E_Configs[i];
+    uint16_t offset = (uint16_t)(std_id - entry->std_id);
+
+    if ((std_id >= entry->std_id) && ((offset % entry->id_step) == 0)
+        && ((offset / entry->id_step) < entry->id_number)) {
+      if (config != NULL) {
+        (*config) = entry;
+      }
+      return (int32_t)(first_channel + (offset / entry->id_step));
+    }
+
+    first_channel += entry->id_number;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Serialize the protected data: data ID, DLC, then the frame without
+ * the CRC field, zero padded to a multiple of 4 bytes
+ *
+ * @return uint8_t number of 32 bit words
+ */
+static uint8_t E2E_Serialize(uint16_t std_id, const uint8_t *const data, uint8_t len, uint8_t *const buffer) {
+  uint8_t size = 0;
+
+  memset(buffer, 0x00, E2E_CRC_BUFFER_SIZE);
+  buffer[size++] = (uint8_t)(std_id >> 8);
+  buffer[size++] = (uint8_t)(std_id & 0xFFu);
+  buffer[size++] = len;
+  memcpy(&buffer[size], &data[E2E_COUNTER_POS], len - E2E_COUNTER_POS);
+  size += len - E2E_COUNTER_POS;
+
+  return (uint8_t)((size + 3u) / 4u);
+}
+
+/**
+ * @brief CRC-32 using the CRC peripheral, words are fed MSB first
+ */
+static uint32_t E2E_HardwareCrc(const uint8_t *const buffer, uint8_t words) {
+  uint32_t input[E2E_CRC_BUFFER_SIZE / 4u] = {0};
+  UBaseType_t saved_mask = 0;
+  uint32_t crc = 0;
+
+  for (uint8_t i = 0; i < words; i++) {
+    input[i] = ((uint32_t)buffer[(4u * i)] << 24) | ((uint32_t)buffer[(4u * i) + 1u] << 16)
+      | ((uint32_t)buffer[(4u * i) + 2u] << 8) | (uint32_t)buffer[(4u * i) + 3u];
+  }
+
+  /* CRC peripheral is shared by tasks and the CAN ISRs */
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  crc = HAL_CRC_Calculate(&hcrc, input, words);
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  return crc;
+}
+
+/**
+ * @brief CRC-32 using a 256 entry table, one lookup per byte
+ */
+static uint32_t E2E_SoftwareCrc(const uint8_t *const buffer, uint8_t words) {
+  uint32_t crc = E2E_CRC_INIT;
+
+  for (uint8_t i = 0; i < (4u * words); i++) {
+    crc = (crc << 8) ^ E2E_CrcTable[(crc >> 24) ^ buffer[i]];
+  }
+
+  return crc;
+}
+
+static inline uint16_t E2E_ComputeCrc(uint16_t std_id, const uint8_t *const data, uint8_t len) {
+  uint8_t buffer[E2E_CRC_BUFFER_SIZE] = {0};
+  uint8_t words = E2E_Serialize(std_id, data, len, buffer);
+
+#if (E2E_USE_HW_CRC == 1u)
+  return (uint16_t)E2E_HardwareCrc(buffer, words);
+#else
+  return (uint16_t)E2E_SoftwareCrc(buffer, words);
+#endif /* (E2E_USE_HW_CRC == 1u) */
+}
+
+/**
+ * @brief Measure the cost of both CRC implementations on full size frames,
+ * and check they agree
+ */
+static void E2E_RunBenchmark(void) {
+  uint8_t data[BXCAN_MAX_DATA_SIZE] = {0};
+  uint8_t buffer[E2E_CRC_BUFFER_SIZE] = {0};
+  uint32_t hw_cycles = 0;
+  uint32_t sw_cycles = 0;
+  uint32_t start = 0;
+  uint32_t hw_crc = 0;
+  uint32_t sw_crc = 0;
+  uint8_t words = 0;
+  uint8_t match = 1;
+
+  for (uint32_t frame = 0; frame < E2E_BENCHMARK_FRAMES; frame++) {
+    for (uint8_t i = 0; i < BXCAN_MAX_DATA_SIZE; i++) {
+      data[i] = (uint8_t)((frame * 31u) + (i * 7u));
+    }
+
+    start = Timebase_GetCycles();
+    words = E2E_Serialize(OPERATION_STATUS_STD_ID, data, BXCAN_MAX_DATA_SIZE, buffer);
+    hw_crc = E2E_HardwareCrc(buffer, words);
+    hw_cycles += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    words = E2E_Serialize(OPERATION_STATUS_STD_ID, data, BXCAN_MAX_DATA_SIZE, buffer);
+    sw_crc = E2E_SoftwareCrc(buffer, words);
+    sw_cycles += Timebase_GetCycles() - start;
+
+    match &= (hw_crc == sw_crc);
+  }
+
+  E2E_BenchmarkResult.hw_cycles = hw_cycles / E2E_BENCHMARK_FRAMES;
+  E2E_BenchmarkResult.sw_cycles = sw_cycles / E2E_BENCHMARK_FRAMES;
+  E2E_BenchmarkResult.match = match;
+}
+
+static uint16_t E2E_GetCommandRate(void) {
+  return OPERATION_COMMAND_FREQUENCY;
+}
+
+/**
+ * @brief Report a timeout if no valid frame was received in time, must be
+ * called with interrupts masked. IDs never received aren't supervised
+ *
+ * @return uint32_t ms until the timeout, 0: timed out, UINT32_MAX: not supervised
+ */
+static uint32_t E2E_CheckTimeout(const E2E_Config_t *const config, E2E_Channel_t *const channel) {
+  const uint16_t rate = config->get_rate();
+  const uint32_t timeout_ms = (rate != 0) ? ((1000u * config->timeout_periods) / rate) : UINT32_MAX;
+  const uint32_t elapsed_ms = HAL_GetTick() - channel->last_rx_tick;
+
+  if ((channel->status == E2E_STATUS_NONE) || (channel->status == E2E_STATUS_NO_NEW_DATA) || (rate == 0)) {
+    return UINT32_MAX;
+  }
+
+  if (elapsed_ms > timeout_ms) {
+    channel->status = E2E_STATUS_NO_NEW_DATA;
+    channel->statistics.timeouts++;
+    return 0;
+  }
+
+  return timeout_ms - elapsed_ms + 1u;
+}
+
+void E2E_Initialize(void) {
+  memset(E2E_Channels, 0x00, sizeof(E2E_Channels));
+  for (uint32_t i = 0; i < E2E_CHANNEL_NUMBER; i++) {
+    E2E_Channels[i].status = E2E_STATUS_NONE;
+    E2E_Channels[i].last_rx_tick = HAL_GetTick();
+  }
+
+  E2E_RunBenchmark();
+  configASSERT(E2E_BenchmarkResult.match == 1u);
+}
+
+void E2E_Protect(uint16_t std_id, uint8_t *const data, uint8_t len) {
+  int32_t index = E2E_FindChannel(std_id, NULL);
+  UBaseType_t saved_mask = 0;
+  uint16_t crc = 0;
+  uint8_t counter = 0;
+
+  if ((index < 0) || (len < E2E_HEADER_SIZE)) {
+    return;
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  counter = E2E_Channels[index].tx_counter;
+  E2E_Channels[index].tx_counter = (uint8_t)((counter + 1u) & E2E_COUNTER_MASK);
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  data[E2E_COUNTER_POS] = (uint8_t)((data[E2E_COUNTER_POS] & ~E2E_COUNTER_MASK) | counter);
+
+  crc = E2E_ComputeCrc(std_id, data, len);
+  data[E2E_CRC_POS] = (uint8_t)(crc & 0xFFu);
+  data[E2E_CRC_POS + 1u] = (uint8_t)(crc >> 8);
+}
+
+E2E_Status_t E2E_Check(uint16_t std_id, const uint8_t *const data, uint8_t len) {
+  const E2E_Config_t *config = NULL;
+  int32_t index = E2E_FindChannel(std_id, &config);
+  E2E_Channel_t *channel = NULL;
+  E2E_Status_t status = E2E_STATUS_ERROR;
+  UBaseType_t saved_mask = 0;
+  uint16_t crc = 0;
+  uint8_t counter = 0;
+  uint8_t delta = 0;
+
+  /* unprotected IDs are not checked */
+  if (index < 0) {
+    return E2E_STATUS_OK;
+  }
+
+  channel = &E2E_Channels[index];
+
+  if (len >= E2E_HEADER_SIZE) {
+    crc = (uint16_t)(data[E2E_CRC_POS] | (data[E2E_CRC_POS + 1u] << 8));
+    if (crc == E2E_ComputeCrc(std_id, data, len)) {
+      status = E2E_STATUS_OK;
+    }
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  if (status == E2E_STATUS_ERROR) {
+    channel->statistics.crc_errors++;
+  } else {
+    counter = data[E2E_COUNTER_POS] & E2E_COUNTER_MASK;
+    delta = (uint8_t)((counter - channel->rx_counter) & E2E_COUNTER_MASK);
+
+    if (channel->rx_counter_valid == 0) {
+      /* first frame, accept its counter as reference */
+      status = E2E_STATUS_OK;
+    } else if (delta == 0) {
+      status = E2E_STATUS_REPEATED;
+      channel->statistics.repeated++;
+    } else if (delta > config->max_delta_counter) {
+      /* resynchronize on the received counter */
+      status = E2E_STATUS_WRONG_SEQUENCE;
+      channel->statistics.wrong_sequence++;
+    } else {
+      channel->statistics.lost_frames += delta - 1u;
+    }
+
+    channel->rx_counter = counter;
+    channel->rx_counter_valid = 1;
+  }
+
+  if (status == E2E_STATUS_OK) {
+    channel->statistics.ok_count++;
+    channel->last_rx_tick = HAL_GetTick();
+  }
+
+  channel->status = status;
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  return status;
+}
+
+E2E_Status_t E2E_GetStatus(uint16_t std_id) {
+  const E2E_Config_t *config = NULL;
+  int32_t index = E2E_FindChannel(std_id, &config);
+  UBaseType_t saved_mask = 0;
+  E2E_Status_t status = E2E_STATUS_OK;
+
+  if (index < 0) {
+    return E2E_STATUS_OK;
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  (void)E2E_CheckTimeout(config, &E2E_Channels[index]);
+  status = E2E_Channels[index].status;
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  return status;
+}
+
+uint32_t E2E_Supervise(void) {
+  uint32_t next_ms = UINT32_MAX;
+  uint32_t channel_ms = 0;
+  uint32_t index = 0;
+  UBaseType_t saved_mask = 0;
+
+  for (uint32_t i = 0; i < E2E_CONFIG_NUMBER; i++) {
+    const E2E_Config_t *const config = &E2E_Configs[i];
+
+    for (uint32_t id = 0; id < config->id_number; id++, index++) {
+      saved_mask = taskENTER_CRITICAL_FROM_ISR();
+      channel_ms = E2E_CheckTimeout(config, &E2E_Channels[index]);
+      taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+      if (channel_ms == 0) {
+        Trace_Record(TRACE_EVENT_E2E_TIMEOUT, 0, (uint16_t)(config->std_id + (id * config->id_step)));
+      } else if (channel_ms < next_ms) {
+        next_ms = channel_ms;
+      }
+    }
+  }
+
+  return next_ms;
+}
+
+void E2E_GetStatistics(uint16_t std_id, E2E_Statistics_t *const statistics) {
+  const E2E_Config_t *config = NULL;
+  int32_t index = E2E_FindChannel(std_id, &config);
+  UBaseType_t saved_mask = 0;
+
+  memset(statistics, 0x00, sizeof(E2E_Statistics_t));
+  if (index < 0) {
+    return;
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  (void)E2E_CheckTimeout(config, &E2E_Channels[index]);
+  memcpy(statistics, &E2E_Channels[index].statistics, sizeof(E2E_Statistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+void E2E_GetBenchmark(E2E_Benchmark_t *const benchmark) {
+  memcpy(benchmark, &E2E_BenchmarkResult, sizeof(E2E_Benchmark_t));
+}
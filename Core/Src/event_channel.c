@@ -0,0 +1,227 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "trace.h"
+#include "event_channel.h"
+
+static EventChannel_Benchmark_t EventChannel_BenchmarkResult = {0};
+static uint8_t EventChannel_BenchmarkDone = 0;
+
+/**
+ * @brief Reserve a slot and write the event, lock free, safe from tasks and
+ * ISRs. A producer preempted between the reservation and the write only
+ * delays the events reserved after its own
+ *
+ * @param depth [out] events waiting before this one
+ * @return BaseType_t pdPASS: posted, pdFAIL: no free slot
+ */
+static BaseType_t EventChannel_Push(EventChannel_t *const channel, Event_t *const pEvent, uint32_t *const depth) {
+  uint32_t head = 0;
+
+  /* exceptions clear the exclusive monitor, the reservation is retried if
+   * another producer preempted this one */
+  do {
+    head = __LDREXW(&channel->head);
+    if ((head - channel->tail) >= channel->size) {
+      __CLREX();
+      return pdFAIL;
+    }
+  } while (__STREXW(head + 1u, &channel->head) != 0u);
+
+  (*depth) = head - channel->tail;
+  channel->ring[head & (channel->size - 1u)] = pEvent;
+  __DMB();
+
+  return pdPASS;
+}
+
+/**
+ * @brief Take the oldest event, from the consumer task
+ *
+ * @return Event_t* event, NULL: no event, or the oldest slot isn't written yet
+ */
+static Event_t *EventChannel_Pop(EventChannel_t *const channel) {
+  const uint32_t tail = channel->tail;
+  Event_t **const slot = &channel->ring[tail & (channel->size - 1u)];
+  Event_t *const pEvent = (*slot);
+  uint32_t depth = 0;
+
+  if (pEvent == NULL) {
+    return NULL;
+  }
+
+  depth = channel->head - tail;
+  if (depth > channel->statistics.high_water) {
+    channel->statistics.high_water = depth;
+  }
+
+  /* the slot is free before the producers can see it */
+  (*slot) = NULL;
+  __DMB();
+  channel->tail = tail + 1u;
+
+  Trace_Record(TRACE_EVENT_QUEUE_RECEIVE, channel->number, (uint16_t)depth);
+  return pEvent;
+}
+
+/**
+ * @brief Count a post that found no free slot, safe from tasks and ISRs
+ * (posted events are counted by the head)
+ */
+static void EventChannel_AccountFull(EventChannel_t *const channel) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  channel->statistics.full++;
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  Trace_Record(TRACE_EVENT_QUEUE_FULL, channel->number, (uint16_t)channel->size);
+}
+
+/**
+ * @brief Measure the post and receive cost of the channel and of a FreeRTOS
+ * queue of event pointers, before the scheduler starts
+ */
+static void EventChannel_RunBenchmark(EventChannel_t *const channel) {
+  static StaticQueue_t queue_buffer = {0};
+  static Event_t *queue_storage[1] = {0};
+  QueueHandle_t queue = xQueueCreateStatic(1, sizeof(Event_t *), (uint8_t *)queue_storage, &queue_buffer);
+  Event_t event = {0};
+  Event_t *pEvent = &event;
+  Event_t *received = NULL;
+  uint32_t post_cycles[2] = {0};
+  uint32_t receive_cycles[2] = {0};
+  uint32_t start = 0;
+
+  configASSERT(queue != NULL);
+
+  for (uint32_t pass = 0; pass < EVENT_CHANNEL_BENCHMARK_PASSES; pass++) {
+    start = Timebase_GetCycles();
+    (void)EventChannel_Post(channel, pEvent);
+    post_cycles[0] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    received = EventChannel_Receive(channel, 0);
+    receive_cycles[0] += Timebase_GetCycles() - start;
+    configASSERT(received == pEvent);
+
+    start = Timebase_GetCycles();
+    (void)xQueueSend(queue, (const void *const)&pEvent, 0);
+    post_cycles[1] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    (void)xQueueReceive(queue, (void *const)&received, 0);
+    receive_cycles[1] += Timebase_GetCycles() - start;
+    configASSERT(received == pEvent);
+  }
+
+  EventChannel_BenchmarkResult.channel_post_cycles = post_cycles[0] / EVENT_CHANNEL_BENCHMARK_PASSES;
+  EventChannel_BenchmarkResult.channel_receive_cycles = receive_cycles[0] / EVENT_CHANNEL_BENCHMARK_PASSES;
+  EventChannel_BenchmarkResult.queue_post_cycles = post_cycles[1] / EVENT_CHANNEL_BENCHMARK_PASSES;
+  EventChannel_BenchmarkResult.queue_receive_cycles = receive_cycles[1] / EVENT_CHANNEL_BENCHMARK_PASSES;
+
+  /* the consumer task starts without the benchmark's notification */
+  (void)xTaskNotifyStateClear(channel->task);
+  channel->head = 0;
+  channel->tail = 0;
+  memset(&channel->statistics, 0x00, sizeof(EventChannel_Statistics_t));
+}
+
+/**
+ * @brief Initialize a channel, before the scheduler is started
+ *
+ * @param channel [in] channel
+ * @param storage [in] slots
+ * @param size [in] slots, power of 2
+ * @param task [in] consumer task, the only one calling EventChannel_Receive()
+ * @param bit [in] notification bit of the channel, the task's other bits are left alone
+ * @param number [in] trace object number (Trace_Object_t)
+ */
+void EventChannel_Initialize(EventChannel_t *const channel, Event_t **const storage, uint32_t size, TaskHandle_t task, uint32_t bit, uint8_t number) {
+  configASSERT((size != 0) && ((size & (size - 1u)) == 0));
+  configASSERT((task != NULL) && (bit != 0));
+
+  memset(storage, 0x00, size * sizeof(Event_t *));
+  memset(channel, 0x00, sizeof(EventChannel_t));
+  channel->ring = storage;
+  channel->size = size;
+  channel->task = task;
+  channel->bit = bit;
+  channel->number = number;
+
+  if (EventChannel_BenchmarkDone == 0) {
+    EventChannel_RunBenchmark(channel);
+    EventChannel_BenchmarkDone = 1;
+  }
+}
+
+/**
+ * @brief Post an event from a task
+ *
+ * @param channel [in] channel
+ * @param pEvent [in] pool event, the caller's reference is passed to the channel
+ * @return BaseType_t pdPASS: posted, pdFAIL: no free slot, the caller keeps its reference
+ */
+BaseType_t EventChannel_Post(EventChannel_t *const channel, Event_t *const pEvent) {
+  uint32_t depth = 0;
+
+  if (EventChannel_Push(channel, pEvent, &depth) != pdPASS) {
+    EventChannel_AccountFull(channel);
+    return pdFAIL;
+  }
+
+  Trace_Record(TRACE_EVENT_QUEUE_SEND, channel->number, (uint16_t)depth);
+  (void)xTaskNotify(channel->task, channel->bit, eSetBits);
+  return pdPASS;
+}
+
+/**
+ * @brief Post an event from an ISR
+ *
+ * @param channel [in] channel
+ * @param pEvent [in] pool event, the caller's reference is passed to the channel
+ * @param pxTaskWoken [out] set to pdTRUE if the consumer task must run
+ * @return BaseType_t pdPASS: posted, pdFAIL: no free slot, the caller keeps its reference
+ */
+BaseType_t EventChannel_PostFromISR(EventChannel_t *const channel, Event_t *const pEvent, BaseType_t *const pxTaskWoken) {
+  uint32_t depth = 0;
+
+  if (EventChannel_Push(channel, pEvent, &depth) != pdPASS) {
+    EventChannel_AccountFull(channel);
+    return pdFAIL;
+  }
+
+  Trace_Record(TRACE_EVENT_QUEUE_SEND_ISR, channel->number, (uint16_t)depth);
+  (void)xTaskNotifyFromISR(channel->task, channel->bit, eSetBits, pxTaskWoken);
+  return pdPASS;
+}
+
+/**
+ * @brief Receive the oldest event, from the consumer task
+ *
+ * @param channel [in] channel
+ * @param wait [in] ticks to wait for an event
+ * @return Event_t* event, with the channel's reference, NULL: timeout, or
+ * woken before the event was written (the caller waits again)
+ */
+Event_t *EventChannel_Receive(EventChannel_t *const channel, TickType_t wait) {
+  Event_t *pEvent = EventChannel_Pop(channel);
+
+  /* posts since the pop attempt left the bit set, the wait returns at once */
+  if ((pEvent == NULL) && (wait != 0)) {
+    (void)xTaskNotifyWait(0, channel->bit, NULL, wait);
+    pEvent = EventChannel_Pop(channel);
+  }
+
+  return pEvent;
+}
+
+void EventChannel_GetStatistics(const EventChannel_t *const channel, EventChannel_Statistics_t *const statistics) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &channel->statistics, sizeof(EventChannel_Statistics_t));
+  statistics->posted = channel->head;
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+void EventChannel_GetBenchmark(EventChannel_Benchmark_t *const benchmark) {
+  memcpy(benchmark, &EventChannel_BenchmarkResult, sizeof(EventChannel_Benchmark_t));
+}
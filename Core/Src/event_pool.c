@@ -0,0 +1,135 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "event_pool.h"
+
+#define EVENT_POOL_NO_BLOCK       (0xFFu)
+
+/* blocks, reference counts, and free list links, kept apart from the events
+ * since Event_t is 8 byte aligned */
+static Event_t EventPool_Events[EVENT_POOL_SIZE] = {0};
+static uint8_t EventPool_References[EVENT_POOL_SIZE] = {0};
+static uint8_t EventPool_Next[EVENT_POOL_SIZE] = {0};
+static uint8_t EventPool_FreeHead = EVENT_POOL_NO_BLOCK;
+
+static EventPool_Statistics_t EventPool_Statistics = {0};
+
+/**
+ * @brief Block index of an event allocated from the pool
+ */
+static inline uint8_t EventPool_IndexOf(const Event_t *const pEvent) {
+  uint32_t index = (uint32_t)(pEvent - EventPool_Events);
+
+  configASSERT(index < EVENT_POOL_SIZE);
+  return (uint8_t)index;
+}
+
+void EventPool_Initialize(void) {
+  memset(EventPool_References, 0x00, sizeof(EventPool_References));
+  memset(&EventPool_Statistics, 0x00, sizeof(EventPool_Statistics_t));
+
+  /* all blocks are free */
+  for (uint8_t block = 0; block < EVENT_POOL_SIZE; block++) {
+    EventPool_Next[block] = ((block + 1u) < EVENT_POOL_SIZE) ? (block + 1u) : EVENT_POOL_NO_BLOCK;
+  }
+  EventPool_FreeHead = 0;
+}
+
+/**
+ * @brief Allocate an event, safe from tasks and ISRs
+ *
+ * @param type [in] event type, the rest of the event is cleared
+ * @return Event_t* event with 1 reference, owned by the caller, NULL: pool empty
+ */
+Event_t *EventPool_Alloc(EventType_t type) {
+  uint32_t start = Timebase_GetCycles();
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  uint8_t block = EventPool_FreeHead;
+
+  if (block == EVENT_POOL_NO_BLOCK) {
+    EventPool_Statistics.failed++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+    return NULL;
+  }
+
+  EventPool_FreeHead = EventPool_Next[block];
+  EventPool_References[block] = 1;
+
+  EventPool_Statistics.allocated++;
+  EventPool_Statistics.in_use++;
+  if (EventPool_Statistics.in_use > EventPool_Statistics.high_water) {
+    EventPool_Statistics.high_water = EventPool_Statistics.in_use;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  /* the block belongs to the caller, it's cleared outside the critical section */
+  memset(&EventPool_Events[block], 0x00, sizeof(Event_t));
+  EventPool_Events[block].type = type;
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  EventPool_Statistics.last_cycles = Timebase_GetCycles() - start;
+  if (EventPool_Statistics.last_cycles > EventPool_Statistics.max_cycles) {
+    EventPool_Statistics.max_cycles = EventPool_Statistics.last_cycles;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  return &EventPool_Events[block];
+}
+
+/**
+ * @brief Add a reference to an event, before posting it to one more
+ * consumer, safe from tasks and ISRs
+ *
+ * @param pEvent [in] event allocated from the pool, referenced by the caller
+ * @return Event_t* the event
+ */
+Event_t *EventPool_Ref(Event_t *const pEvent) {
+  uint8_t block = EventPool_IndexOf(pEvent);
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  configASSERT((EventPool_References[block] > 0) && (EventPool_References[block] < EVENT_POOL_MAX_REFERENCES));
+  EventPool_References[block]++;
+
+  EventPool_Statistics.shared++;
+  if (EventPool_References[block] > EventPool_Statistics.max_references) {
+    EventPool_Statistics.max_references = EventPool_References[block];
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+  return pEvent;
+}
+
+/**
+ * @brief Release a reference to an event, the block is returned to the pool
+ * with the last reference, safe from tasks and ISRs
+ *
+ * @param pEvent [in] event allocated from the pool, NULL: ignored
+ */
+void EventPool_Release(Event_t *const pEvent) {
+  uint8_t block = 0;
+  UBaseType_t saved_mask = 0;
+
+  if (pEvent == NULL) {
+    return;
+  }
+
+  block = EventPool_IndexOf(pEvent);
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  configASSERT(EventPool_References[block] > 0);
+  EventPool_References[block]--;
+  if (EventPool_References[block] == 0) {
+    EventPool_Next[block] = EventPool_FreeHead;
+    EventPool_FreeHead = block;
+    EventPool_Statistics.in_use--;
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+void EventPool_GetStatistics(EventPool_Statistics_t *const statistics) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &EventPool_Statistics, sizeof(EventPool_Statistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
@@ -0,0 +1,236 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "event_pool.h"
+#include "executive.h"
+
+#define EXECUTIVE_NO_SLOT             (0xFFu)
+
+/**
+ * @brief Registered node and its pending events
+ */
+typedef struct {
+  const Executive_Node_t *node;
+  UBaseType_t priority;
+  uint8_t head;
+  uint8_t tail;
+} Executive_Entry_t;
+
+/* registered nodes */
+static Executive_Entry_t Executive_Nodes[EXECUTIVE_MAX_NODES] = {0};
+static uint8_t Executive_NodeCount = 0;
+
+/* event slots, pool events (event_pool.h) linked in a per node FIFO or the
+ * free list */
+static Event_t *Executive_Events[EXECUTIVE_MAX_EVENTS] = {0};
+static uint8_t Executive_Next[EXECUTIVE_MAX_EVENTS] = {0};
+static uint8_t Executive_FreeHead = 0;
+static uint32_t Executive_Queued = 0;
+
+static Executive_Statistics_t Executive_Statistics = {0};
+
+/* executive task */
+static TaskHandle_t Executive_TaskHandle = NULL;
+static StaticTask_t Executive_TaskBuffer = {0};
+static StackType_t Executive_TaskStack[EXECUTIVE_TASK_STACK_DEPTH] = {0};
+
+/**
+ * @brief Queue an event for a node, safe from tasks and ISRs
+ *
+ * @return BaseType_t pdPASS: queued, pdFAIL: no free event slot
+ */
+static BaseType_t Executive_Enqueue(uint8_t node_id, Event_t *const pEvent) {
+  Executive_Entry_t *const entry = &Executive_Nodes[node_id];
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  uint8_t slot = Executive_FreeHead;
+
+  if (slot == EXECUTIVE_NO_SLOT) {
+    Executive_Statistics.dropped++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+    return pdFAIL;
+  }
+
+  Executive_FreeHead = Executive_Next[slot];
+  Executive_Events[slot] = pEvent;
+  Executive_Next[slot] = EXECUTIVE_NO_SLOT;
+
+  if (entry->tail == EXECUTIVE_NO_SLOT) {
+    entry->head = slot;
+  } else {
+    Executive_Next[entry->tail] = slot;
+  }
+  entry->tail = slot;
+
+  Executive_Queued++;
+  if (Executive_Queued > Executive_Statistics.max_queued) {
+    Executive_Statistics.max_queued = Executive_Queued;
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+  return pdPASS;
+}
+
+/**
+ * @brief Take the oldest event of the highest priority node with pending events
+ *
+ * @param node_id [out] node of the event
+ * @return Event_t* event, with the queue's reference, NULL: no pending events
+ */
+static Event_t *Executive_Dequeue(uint8_t *const node_id) {
+  Executive_Entry_t *entry = NULL;
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  uint8_t slot = EXECUTIVE_NO_SLOT;
+  Event_t *pEvent = NULL;
+
+  for (uint8_t id = 0; id < Executive_NodeCount; id++) {
+    if ((Executive_Nodes[id].head != EXECUTIVE_NO_SLOT)
+        && ((entry == NULL) || (Executive_Nodes[id].priority > entry->priority))) {
+      entry = &Executive_Nodes[id];
+      (*node_id) = id;
+    }
+  }
+
+  if (entry != NULL) {
+    slot = entry->head;
+    entry->head = Executive_Next[slot];
+    if (entry->head == EXECUTIVE_NO_SLOT) {
+      entry->tail = EXECUTIVE_NO_SLOT;
+    }
+
+    pEvent = Executive_Events[slot];
+    Executive_Next[slot] = Executive_FreeHead;
+    Executive_FreeHead = slot;
+    Executive_Queued--;
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+  return pEvent;
+}
+
+/**
+ * @brief Executive task, dispatches events to the nodes one at a time, and
+ * sleeps until the next event or the earliest node deadline
+ *
+ * @param pvParam
+ */
+static void Executive_TaskFunction(void *const pvParam) {
+  Event_t *current_event = NULL;
+  uint8_t node_id = 0;
+  TickType_t wait = portMAX_DELAY;
+  TickType_t node_wait = portMAX_DELAY;
+
+  for (uint8_t id = 0; id < Executive_NodeCount; id++) {
+    if (Executive_Nodes[id].node->start != NULL) {
+      Executive_Nodes[id].node->start();
+    }
+  }
+
+  while (1) {
+    wait = portMAX_DELAY;
+    for (uint8_t id = 0; id < Executive_NodeCount; id++) {
+      if (Executive_Nodes[id].node->poll != NULL) {
+        node_wait = Executive_Nodes[id].node->poll();
+        if (node_wait < wait) {
+          wait = node_wait;
+        }
+      }
+    }
+
+    current_event = Executive_Dequeue(&node_id);
+    if (current_event == NULL) {
+      /* posted events give the notification, events posted since the
+       * dequeue attempt return immediately */
+      (void)ulTaskNotifyTake(pdTRUE, wait);
+      continue;
+    }
+
+    Executive_Nodes[node_id].node->dispatch(current_event);
+    EventPool_Release(current_event);
+    Executive_Statistics.dispatched++;
+  }
+
+  (void)pvParam;
+}
+
+void Executive_Initialize(void) {
+  memset(Executive_Nodes, 0x00, sizeof(Executive_Nodes));
+  memset(&Executive_Statistics, 0x00, sizeof(Executive_Statistics_t));
+  Executive_NodeCount = 0;
+  Executive_Queued = 0;
+
+  /* all slots are free */
+  for (uint8_t slot = 0; slot < EXECUTIVE_MAX_EVENTS; slot++) {
+    Executive_Next[slot] = ((slot + 1u) < EXECUTIVE_MAX_EVENTS) ? (slot + 1u) : EXECUTIVE_NO_SLOT;
+  }
+  Executive_FreeHead = 0;
+
+  Executive_TaskHandle = xTaskCreateStatic(
+    &Executive_TaskFunction,
+    "ExecutiveTask",
+    EXECUTIVE_TASK_STACK_DEPTH,
+    NULL,
+    EXECUTIVE_TASK_PRIORITY,
+    Executive_TaskStack,  /* stack buffer (StackType_t *)  */
+    &Executive_TaskBuffer /* task buffer (StaticTask_t *) */
+  );
+}
+
+/**
+ * @brief Register a node, must be called before the scheduler is started
+ *
+ * @param node [in] node callbacks
+ * @param priority [in] node priority, events of higher priority nodes are dispatched first
+ * @return uint8_t node ID, used to post events to the node
+ */
+uint8_t Executive_Register(const Executive_Node_t *const node, UBaseType_t priority) {
+  Executive_Entry_t *const entry = &Executive_Nodes[Executive_NodeCount];
+
+  configASSERT(Executive_NodeCount < EXECUTIVE_MAX_NODES);
+  configASSERT(node->dispatch != NULL);
+
+  entry->node = node;
+  entry->priority = priority;
+  entry->head = EXECUTIVE_NO_SLOT;
+  entry->tail = EXECUTIVE_NO_SLOT;
+
+  return Executive_NodeCount++;
+}
+
+/**
+ * @brief Post an event to a node from a task
+ *
+ * @param node_id [in] node ID
+ * @param pEvent [in] pool event, the caller's reference is passed to the queue
+ * @return BaseType_t pdPASS: queued, pdFAIL: no free event slot, the caller keeps its reference
+ */
+BaseType_t Executive_Post(uint8_t node_id, Event_t *const pEvent) {
+  if (Executive_Enqueue(node_id, pEvent) != pdPASS) {
+    return pdFAIL;
+  }
+
+  (void)xTaskNotifyGive(Executive_TaskHandle);
+  return pdPASS;
+}
+
+/**
+ * @brief Post an event to a node from an ISR
+ *
+ * @param node_id [in] node ID
+ * @param pEvent [in] pool event, the caller's reference is passed to the queue
+ * @param pxTaskWoken [out] set to pdTRUE if the executive task must run
+ * @return BaseType_t pdPASS: queued, pdFAIL: no free event slot, the caller keeps its reference
+ */
+BaseType_t Executive_PostFromISR(uint8_t node_id, Event_t *const pEvent, BaseType_t *const pxTaskWoken) {
+  if (Executive_Enqueue(node_id, pEvent) != pdPASS) {
+    return pdFAIL;
+  }
+
+  vTaskNotifyGiveFromISR(Executive_TaskHandle, pxTaskWoken);
+  return pdPASS;
+}
+
+void Executive_GetStatistics(Executive_Statistics_t *const statistics) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &Executive_Statistics, sizeof(Executive_Statistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
@@ -0,0 +1,83 @@
+#include <string.h>
+#include "histogram.h"
+
+/**
+ * @brief Clear the histogram
+ *
+ * @param histogram [in] histogram
+ */
+void Histogram_Initialize(Histogram_t *const histogram) {
+  memset(histogram, 0x00, sizeof(Histogram_t));
+  histogram->min_us = UINT32_MAX;
+}
+
+/**
+ * @brief Add a latency
+ *
+ * @param histogram [in] histogram
+ * @param latency_us [in] latency
+ */
+void Histogram_Add(Histogram_t *const histogram, uint32_t latency_us) {
+  uint32_t bin = 0;
+
+  if (latency_us < histogram->min_us) {
+    histogram->min_us = latency_us;
+  }
+  if (latency_us > histogram->max_us) {
+    histogram->max_us = latency_us;
+  }
+  histogram->total_us += latency_us;
+  histogram->count++;
+
+  /* bin of the highest set bit above the first bin (CLZ on the Cortex-M3) */
+  if (latency_us >= HISTOGRAM_FIRST_BIN_US) {
+    bin = (uint32_t)(31 - __builtin_clz(latency_us)) - (uint32_t)(31 - __builtin_clz(HISTOGRAM_FIRST_BIN_US)) + 1u;
+    if (bin >= HISTOGRAM_BINS) {
+      bin = HISTOGRAM_BINS - 1u;
+    }
+  }
+  histogram->bins[bin]++;
+}
+
+/**
+ * @brief Upper edge of a bin
+ *
+ * @param bin [in] bin
+ * @return uint32_t latencies of the bin are below this value, UINT32_MAX: last bin
+ */
+uint32_t Histogram_GetBinUpperEdge(uint32_t bin) {
+  if (bin >= (HISTOGRAM_BINS - 1u)) {
+    return UINT32_MAX;
+  }
+
+  return HISTOGRAM_FIRST_BIN_US << bin;
+}
+
+/**
+ * @brief Get a percentile of the latencies
+ *
+ * @param histogram [in] histogram
+ * @param percent [in] percentile, 1 to 100
+ * @return uint32_t upper edge of the smallest bin covering percent of the
+ * latencies (the longest latency if it's in that bin), 0: empty histogram
+ */
+uint32_t Histogram_GetPercentile(const Histogram_t *const histogram, uint32_t percent) {
+  uint32_t target = 0;
+  uint32_t cumulative = 0;
+  uint32_t edge = 0;
+
+  if (histogram->count == 0) {
+    return 0;
+  }
+
+  target = (uint32_t)(((uint64_t)histogram->count * percent + 99u) / 100u);
+  for (uint32_t bin = 0; bin < HISTOGRAM_BINS; bin++) {
+    cumulative += histogram->bins[bin];
+    if (cumulative >= target) {
+      edge = Histogram_GetBinUpperEdge(bin);
+      break;
+    }
+  }
+
+  return (histogram->max_us < edge) ? histogram->max_us : edge;
+}
@@ -0,0 +1,222 @@
+#include <stddef.h>
+#include "hsm.h"
+
+/**
+ * @brief Number of states from a state to the top level state, included
+ */
+static uint8_t Hsm_Depth(const Hsm_t *const hsm, Hsm_StateId_t state) {
+  uint8_t depth = 0;
+
+  while (state != HSM_NO_STATE) {
+    depth++;
+    state = hsm->states[state].parent;
+  }
+
+  return depth;
+}
+
+/**
+ * @brief Enter a state and its parents below a common ancestor, top down,
+ * then drill into initial sub-states
+ *
+ * @param hsm [in] state machine
+ * @param ancestor [in] common ancestor, already active (HSM_NO_STATE: none)
+ * @param target [in] target state
+ */
+static void Hsm_EnterPath(Hsm_t *const hsm, Hsm_StateId_t ancestor, Hsm_StateId_t target) {
+  Hsm_StateId_t path[HSM_MAX_DEPTH] = {0};
+  uint8_t length = 0;
+
+  for (Hsm_StateId_t state = target; state != ancestor; state = hsm->states[state].parent) {
+    path[length++] = state;
+  }
+
+  while (length > 0) {
+    length--;
+    if (hsm->states[path[length]].entry != NULL) {
+      hsm->states[path[length]].entry();
+    }
+  }
+
+  hsm->current = target;
+  while (hsm->states[hsm->current].initial != HSM_NO_STATE) {
+    hsm->current = hsm->states[hsm->current].initial;
+    if (hsm->states[hsm->current].entry != NULL) {
+      hsm->states[hsm->current].entry();
+    }
+  }
+}
+
+/**
+ * @brief Take an external transition: exit from the current state up to the
+ * common ancestor of source and target, then enter the target
+ *
+ * @param hsm [in] state machine
+ * @param source [in] state that handled the event (current state or one of its parents)
+ * @param target [in] target state
+ */
+static void Hsm_Transition(Hsm_t *const hsm, Hsm_StateId_t source, Hsm_StateId_t target) {
+  Hsm_StateId_t s = source;
+  Hsm_StateId_t t = target;
+  uint8_t s_depth = Hsm_Depth(hsm, s);
+  uint8_t t_depth = Hsm_Depth(hsm, t);
+
+  /* least common ancestor */
+  while (s_depth > t_depth) {
+    s = hsm->states[s].parent;
+    s_depth--;
+  }
+  while (t_depth > s_depth) {
+    t = hsm->states[t].parent;
+    t_depth--;
+  }
+  while (s != t) {
+    s = hsm->states[s].parent;
+    t = hsm->states[t].parent;
+  }
+
+  /* self transition, or transition to/from an ancestor, exits and re-enters it */
+  if ((s == source) || (s == target)) {
+    s = hsm->states[s].parent;
+  }
+
+  for (Hsm_StateId_t state = hsm->current; state != s; state = hsm->states[state].parent) {
+    if (hsm->states[state].exit != NULL) {
+      hsm->states[state].exit();
+    }
+  }
+
+  Hsm_EnterPath(hsm, s, target);
+}
+
+/**
+ * @brief Add an event to the deferred events FIFO
+ */
+static void Hsm_Defer(Hsm_t *const hsm, const Event_t *const pEvent) {
+  if (hsm->deferred_count == HSM_DEFERRED_EVENTS) {
+    hsm->deferred_dropped++;
+    return;
+  }
+
+  hsm->deferred[(hsm->deferred_head + hsm->deferred_count) % HSM_DEFERRED_EVENTS] = (*pEvent);
+  hsm->deferred_count++;
+}
+
+/**
+ * @brief Dispatch an event to the current state, then its parents until a
+ * state handles it
+ *
+ * @return uint8_t 1: state changed, 0: no transition
+ */
+static uint8_t Hsm_Process(Hsm_t *const hsm, const Event_t *const pEvent) {
+  const Hsm_Transition_t *transition = NULL;
+  StateResult_t result = EVENT_HANDLED;
+
+  if ((uint32_t)pEvent->type >= EVENT_TYPE_NUMBER) {
+    return 0;
+  }
+
+  for (Hsm_StateId_t state = hsm->current; state != HSM_NO_STATE; state = hsm->states[state].parent) {
+    if (hsm->states[state].transitions == NULL) {
+      continue;
+    }
+
+    transition = &hsm->states[state].transitions[pEvent->type];
+    if (transition->type == HSM_TRANSITION_NONE) {
+      continue;
+    }
+
+    result = (transition->action != NULL) ? transition->action(pEvent) : EVENT_HANDLED;
+    if (result == EVENT_IGNORED) {
+      continue;
+    }
+
+    if (result == EVENT_REQUEUE) {
+      Hsm_Defer(hsm, pEvent);
+      return 0;
+    }
+
+    if (transition->type == HSM_TRANSITION_INTERNAL) {
+      return 0;
+    }
+
+    if ((transition->guard == NULL) || transition->guard()) {
+      Hsm_Transition(hsm, state, transition->target);
+    } else {
+      Hsm_Transition(hsm, state, transition->otherwise);
+    }
+    return 1;
+  }
+
+  /* not handled by any state */
+  return 0;
+}
+
+/**
+ * @brief Initialize a state machine and enter its initial state
+ *
+ * @param hsm [in] state machine
+ * @param states [in] state table, indexed by state ID
+ * @param initial [in] initial state
+ */
+void Hsm_Initialize(Hsm_t *const hsm, const Hsm_State_t *const states, Hsm_StateId_t initial) {
+  hsm->states = states;
+  hsm->current = HSM_NO_STATE;
+  hsm->deferred_head = 0;
+  hsm->deferred_count = 0;
+  hsm->deferred_dropped = 0;
+
+  Hsm_EnterPath(hsm, HSM_NO_STATE, initial);
+}
+
+/**
+ * @brief Dispatch an event, run to completion. Deferred events are recalled
+ * after a state change, in the order they were deferred
+ *
+ * @param hsm [in] state machine
+ * @param pEvent [in] event
+ */
+void Hsm_Dispatch(Hsm_t *const hsm, const Event_t *const pEvent) {
+  Event_t recalled = {0};
+  uint8_t pending = 0;
+
+  if (Hsm_Process(hsm, pEvent) == 0) {
+    return;
+  }
+
+  /* events deferred again are kept for the next state change */
+  pending = hsm->deferred_count;
+  while (pending > 0) {
+    pending--;
+    recalled = hsm->deferred[hsm->deferred_head];
+    hsm->deferred_head = (hsm->deferred_head + 1u) % HSM_DEFERRED_EVENTS;
+    hsm->deferred_count--;
+    (void)Hsm_Process(hsm, &recalled);
+  }
+}
+
+Hsm_StateId_t Hsm_GetState(const Hsm_t *const hsm) {
+  return hsm->current;
+}
+
+/**
+ * @brief Check whether a state is active: the current state or one of its
+ * parents
+ */
+uint8_t Hsm_IsIn(const Hsm_t *const hsm, Hsm_StateId_t state) {
+  for (Hsm_StateId_t active = hsm->current; active != HSM_NO_STATE; active = hsm->states[active].parent) {
+    if (active == state) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Transition action deferring the event until the next state change
+ */
+StateResult_t Hsm_DeferEvent(const Event_t *const pEvent) {
+  (void)pEvent;
+  return EVENT_REQUEUE;
+}
@@ -0,0 +1,93 @@
+#include <string.h>
+#include "jitter.h"
+
+/**
+ * @brief Clear statistics and set the nominal period
+ *
+ * @param jitter [in] jitter accumulator
+ * @param nominal_us [in] nominal period
+ */
+void Jitter_Initialize(Jitter_t *const jitter, uint32_t nominal_us) {
+  memset(jitter, 0x00, sizeof(Jitter_t));
+  jitter->nominal_us = nominal_us;
+  jitter->min_us = INT32_MAX;
+  jitter->max_us = INT32_MIN;
+}
+
+/**
+ * @brief Start a new sequence of events, keeping the statistics: the time
+ * between the last event and the next one is not measured
+ *
+ * @param jitter [in] jitter accumulator
+ * @param nominal_us [in] nominal period of the new sequence
+ */
+void Jitter_Restart(Jitter_t *const jitter, uint32_t nominal_us) {
+  jitter->nominal_us = nominal_us;
+  jitter->running = 0;
+}
+
+/**
+ * @brief Add an event
+ *
+ * @param jitter [in] jitter accumulator
+ * @param timestamp_us [in] event time stamp
+ */
+void Jitter_Update(Jitter_t *const jitter, uint64_t timestamp_us) {
+  int32_t deviation = 0;
+  uint32_t bin = 0;
+
+  if (jitter->running == 0) {
+    jitter->running = 1;
+    jitter->last_us = timestamp_us;
+    return;
+  }
+
+  deviation = (int32_t)(timestamp_us - jitter->last_us) - (int32_t)jitter->nominal_us;
+  jitter->last_us = timestamp_us;
+
+  if (deviation < jitter->min_us) {
+    jitter->min_us = deviation;
+  }
+  if (deviation > jitter->max_us) {
+    jitter->max_us = deviation;
+  }
+  jitter->sum_us += deviation;
+  jitter->count++;
+
+  bin = (uint32_t)((deviation < 0) ? -deviation : deviation) / JITTER_BIN_WIDTH_US;
+  if (bin >= JITTER_HISTOGRAM_BINS) {
+    bin = JITTER_HISTOGRAM_BINS - 1u;
+  }
+  jitter->histogram[bin]++;
+}
+
+/**
+ * @brief Get min/avg/max/p99 jitter
+ *
+ * @param jitter [in] jitter accumulator
+ * @param statistics [out] jitter statistics
+ */
+void Jitter_GetStatistics(const Jitter_t *const jitter, Jitter_Statistics_t *const statistics) {
+  uint32_t target = 0;
+  uint32_t cumulative = 0;
+
+  memset(statistics, 0x00, sizeof(Jitter_Statistics_t));
+  if (jitter->count == 0) {
+    return;
+  }
+
+  statistics->min_us = jitter->min_us;
+  statistics->max_us = jitter->max_us;
+  statistics->avg_us = (int32_t)(jitter->sum_us / (int64_t)jitter->count);
+  statistics->count = jitter->count;
+
+  /* smallest bin covering 99% of the periods */
+  target = jitter->count - (jitter->count / 100u);
+  for (uint32_t bin = 0; bin < JITTER_HISTOGRAM_BINS; bin++) {
+    cumulative += jitter->histogram[bin];
+    if (cumulative >= target) {
+      statistics->p99_us = (bin + 1u) * JITTER_BIN_WIDTH_US;
+      break;
+    }
+  }
+}
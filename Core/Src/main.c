@@ -20,11 +20,23 @@
 #include "main.h"
 #include "can.h"
 #include "cmsis_os.h"
+#include "crc.h"
+#include "dma.h"
+#include "usart.h"
 #include "gpio.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "can2can.h"
+#include "timebase.h"
+#include "e2e.h"
+#include "slcan.h"
+#include "executive.h"
+#include "mem_pool.h"
+#include "event_pool.h"
+#include "config_service.h"
+#include "signal_db.h"
+#include "tx_scheduler.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -87,8 +99,16 @@ int main(void) {
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_CAN_Init();
+  MX_USART1_UART_Init();
+  MX_CRC_Init();
   /* USER CODE BEGIN 2 */
+  Timebase_Initialize();
+  E2E_Initialize();
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+  TxScheduler_Initialize();
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
 
   /* USER CODE END 2 */
 
@@ -97,8 +117,16 @@ int main(void) {
 
   /* Start scheduler */
   // osKernelStart();
+  MemPool_Initialize();
+  EventPool_Initialize();
+  SignalDb_Initialize();
+#if (CAN2CAN_USE_EXECUTIVE == 1u)
+  Executive_Initialize();
+#endif /* (CAN2CAN_USE_EXECUTIVE == 1u) */
   MasterNode_Initialize();
   SlaveNode_Initialize();
+  ConfigService_Initialize();
+  Slcan_Initialize();
 
   vTaskStartScheduler();
 
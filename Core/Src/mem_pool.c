@@ -0,0 +1,329 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "mem_pool.h"
+
+#if ((MEM_POOL_SMALL_SIZE % 8u) != 0) || ((MEM_POOL_MEDIUM_SIZE % 8u) != 0) || ((MEM_POOL_LARGE_SIZE % 8u) != 0)
+#error memory pool block sizes must be multiples of 8 bytes
+#endif
+
+#if (MEM_POOL_SMALL_SIZE >= MEM_POOL_MEDIUM_SIZE) || (MEM_POOL_MEDIUM_SIZE >= MEM_POOL_LARGE_SIZE)
+#error memory pool size classes must be in increasing block size order
+#endif
+
+/**
+ * @brief Size class: its blocks and the head of its free blocks, each free
+ * block holds the address of the next one in its first word
+ */
+typedef struct {
+  uint8_t *storage;
+  uint32_t block_size;
+  uint32_t blocks;
+  volatile uint32_t free_head;        /* address of the first free block, 0: class empty */
+  MemPool_Statistics_t statistics;
+} MemPool_Pool_t;
+
+/* blocks, 8 byte aligned */
+static uint64_t MemPool_SmallStorage[(MEM_POOL_SMALL_SIZE * MEM_POOL_SMALL_BLOCKS) / sizeof(uint64_t)] = {0};
+static uint64_t MemPool_MediumStorage[(MEM_POOL_MEDIUM_SIZE * MEM_POOL_MEDIUM_BLOCKS) / sizeof(uint64_t)] = {0};
+static uint64_t MemPool_LargeStorage[(MEM_POOL_LARGE_SIZE * MEM_POOL_LARGE_BLOCKS) / sizeof(uint64_t)] = {0};
+
+static MemPool_Pool_t MemPool_Pools[MEM_POOL_CLASS_NUMBER] = {
+  [MEM_POOL_SMALL] = {
+    .storage = (uint8_t *)MemPool_SmallStorage,
+    .block_size = MEM_POOL_SMALL_SIZE,
+    .blocks = MEM_POOL_SMALL_BLOCKS,
+  },
+  [MEM_POOL_MEDIUM] = {
+    .storage = (uint8_t *)MemPool_MediumStorage,
+    .block_size = MEM_POOL_MEDIUM_SIZE,
+    .blocks = MEM_POOL_MEDIUM_BLOCKS,
+  },
+  [MEM_POOL_LARGE] = {
+    .storage = (uint8_t *)MemPool_LargeStorage,
+    .block_size = MEM_POOL_LARGE_SIZE,
+    .blocks = MEM_POOL_LARGE_BLOCKS,
+  },
+};
+
+static MemPool_Benchmark_t MemPool_BenchmarkResult = {0};
+
+/**
+ * @brief Add to a counter, lock free
+ *
+ * @return uint32_t counter after the addition
+ */
+static inline uint32_t MemPool_AtomicAdd(volatile uint32_t *const counter, uint32_t value) {
+  uint32_t result = 0;
+
+  do {
+    result = __LDREXW(counter) + value;
+  } while (__STREXW(result, counter) != 0u);
+
+  return result;
+}
+
+/**
+ * @brief Raise a high water mark, lock free
+ */
+static inline void MemPool_AtomicMax(volatile uint32_t *const mark, uint32_t value) {
+  do {
+    if (__LDREXW(mark) >= value) {
+      __CLREX();
+      return;
+    }
+  } while (__STREXW(value, mark) != 0u);
+}
+
+/**
+ * @brief Take the first free block of a class, lock free
+ *
+ * @return void* block, NULL: class empty
+ */
+static void *MemPool_Pop(MemPool_Pool_t *const pool) {
+  uint32_t head = 0;
+
+  /* exceptions clear the exclusive monitor: if an allocation or a release
+   * preempted this one between the head and the link reads, the store fails
+   * and both are read again, a block can't be taken with a stale link (ABA) */
+  do {
+    head = __LDREXW(&pool->free_head);
+    if (head == 0u) {
+      __CLREX();
+      return NULL;
+    }
+  } while (__STREXW(*(const uint32_t *)head, &pool->free_head) != 0u);
+
+  __DMB();
+  return (void *)head;
+}
+
+/**
+ * @brief Give a block back to its class, lock free
+ */
+static void MemPool_Push(MemPool_Pool_t *const pool, void *const block) {
+  uint32_t head = 0;
+
+  /* the caller's writes to the block are done before it's free */
+  __DMB();
+  do {
+    head = __LDREXW(&pool->free_head);
+    *(uint32_t *)block = head;
+  } while (__STREXW((uint32_t)block, &pool->free_head) != 0u);
+}
+
+/**
+ * @brief Size class a block was allocated from
+ */
+static MemPool_Pool_t *MemPool_PoolOf(const void *const block) {
+  const uint32_t address = (uint32_t)block;
+
+  for (uint32_t pool_class = 0; pool_class < MEM_POOL_CLASS_NUMBER; pool_class++) {
+    MemPool_Pool_t *const pool = &MemPool_Pools[pool_class];
+    const uint32_t offset = address - (uint32_t)pool->storage;
+
+    if (offset < (pool->block_size * pool->blocks)) {
+      configASSERT((offset % pool->block_size) == 0);
+      return pool;
+    }
+  }
+
+  /* not a pool block */
+  configASSERT(0);
+  return NULL;
+}
+
+/**
+ * @brief Free list of a class in a critical section, the event pool's way
+ * (event_pool.c), for the benchmark only
+ */
+static void *MemPool_LockedAlloc(MemPool_Pool_t *const pool) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  uint32_t head = pool->free_head;
+
+  if (head == 0u) {
+    pool->statistics.failed++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+    return NULL;
+  }
+
+  pool->free_head = *(const uint32_t *)head;
+  pool->statistics.allocated++;
+  pool->statistics.in_use++;
+  if (pool->statistics.in_use > pool->statistics.high_water) {
+    pool->statistics.high_water = pool->statistics.in_use;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  return (void *)head;
+}
+
+static void MemPool_LockedFree(MemPool_Pool_t *const pool, void *const block) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  *(uint32_t *)block = pool->free_head;
+  pool->free_head = (uint32_t)block;
+  pool->statistics.in_use--;
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Measure the cost of a small block allocation and release, lock
+ * free and in a critical section, and of a small block copy into and out of
+ * a FreeRTOS queue (what the pool replaces), before the scheduler starts
+ */
+static void MemPool_RunBenchmark(void) {
+  static StaticQueue_t queue_buffer = {0};
+  static uint64_t queue_storage[MEM_POOL_SMALL_SIZE / sizeof(uint64_t)] = {0};
+  QueueHandle_t queue = xQueueCreateStatic(1, MEM_POOL_SMALL_SIZE, (uint8_t *)queue_storage, &queue_buffer);
+  MemPool_Pool_t *const pool = &MemPool_Pools[MEM_POOL_SMALL];
+  uint64_t item[MEM_POOL_SMALL_SIZE / sizeof(uint64_t)] = {0};
+  void *block = NULL;
+  uint32_t alloc_cycles[2] = {0};
+  uint32_t free_cycles[2] = {0};
+  uint32_t queue_cycles[2] = {0};
+  uint32_t start = 0;
+
+  configASSERT(queue != NULL);
+
+  for (uint32_t pass = 0; pass < MEM_POOL_BENCHMARK_PASSES; pass++) {
+    start = Timebase_GetCycles();
+    block = MemPool_Alloc(MEM_POOL_SMALL_SIZE);
+    alloc_cycles[0] += Timebase_GetCycles() - start;
+    configASSERT(block != NULL);
+
+    start = Timebase_GetCycles();
+    MemPool_Free(block);
+    free_cycles[0] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    block = MemPool_LockedAlloc(pool);
+    alloc_cycles[1] += Timebase_GetCycles() - start;
+    configASSERT(block != NULL);
+
+    start = Timebase_GetCycles();
+    MemPool_LockedFree(pool, block);
+    free_cycles[1] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    (void)xQueueSend(queue, (const void *const)item, 0);
+    queue_cycles[0] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    (void)xQueueReceive(queue, (void *const)item, 0);
+    queue_cycles[1] += Timebase_GetCycles() - start;
+  }
+
+  MemPool_BenchmarkResult.pool_alloc_cycles = alloc_cycles[0] / MEM_POOL_BENCHMARK_PASSES;
+  MemPool_BenchmarkResult.pool_free_cycles = free_cycles[0] / MEM_POOL_BENCHMARK_PASSES;
+  MemPool_BenchmarkResult.list_alloc_cycles = alloc_cycles[1] / MEM_POOL_BENCHMARK_PASSES;
+  MemPool_BenchmarkResult.list_free_cycles = free_cycles[1] / MEM_POOL_BENCHMARK_PASSES;
+  MemPool_BenchmarkResult.queue_send_cycles = queue_cycles[0] / MEM_POOL_BENCHMARK_PASSES;
+  MemPool_BenchmarkResult.queue_receive_cycles = queue_cycles[1] / MEM_POOL_BENCHMARK_PASSES;
+}
+
+/**
+ * @brief Link the blocks of each class into its free list and measure the
+ * pool, before the scheduler starts and before any user allocates
+ */
+void MemPool_Initialize(void) {
+  for (uint32_t pool_class = 0; pool_class < MEM_POOL_CLASS_NUMBER; pool_class++) {
+    MemPool_Pool_t *const pool = &MemPool_Pools[pool_class];
+
+    for (uint32_t block = 0; block < pool->blocks; block++) {
+      uint8_t *const address = &pool->storage[block * pool->block_size];
+      *(uint32_t *)address = ((block + 1u) < pool->blocks) ? (uint32_t)(address + pool->block_size) : 0u;
+    }
+    pool->free_head = (uint32_t)pool->storage;
+  }
+
+  MemPool_RunBenchmark();
+
+  /* users start with the statistics of their own allocations */
+  for (uint32_t pool_class = 0; pool_class < MEM_POOL_CLASS_NUMBER; pool_class++) {
+    MemPool_Pool_t *const pool = &MemPool_Pools[pool_class];
+
+    memset(&pool->statistics, 0x00, sizeof(MemPool_Statistics_t));
+    pool->statistics.block_size = pool->block_size;
+    pool->statistics.blocks = pool->blocks;
+  }
+}
+
+/**
+ * @brief Allocate a block, lock free, safe from tasks and ISRs
+ *
+ * @param size [in] bytes, at most MEM_POOL_LARGE_SIZE
+ * @return void* block of the smallest class that fits and isn't empty,
+ * 8 byte aligned, not cleared, NULL: no free block
+ */
+void *MemPool_Alloc(uint32_t size) {
+  MemPool_Pool_t *requested = NULL;
+  MemPool_Pool_t *pool = NULL;
+  void *block = NULL;
+  uint32_t in_use = 0;
+
+  configASSERT(size <= MEM_POOL_LARGE_SIZE);
+
+  for (uint32_t pool_class = 0; (pool_class < MEM_POOL_CLASS_NUMBER) && (block == NULL); pool_class++) {
+    pool = &MemPool_Pools[pool_class];
+    if (pool->block_size < size) {
+      continue;
+    }
+
+    if (requested == NULL) {
+      requested = pool;
+    }
+    block = MemPool_Pop(pool);
+  }
+
+  if (block == NULL) {
+    if (requested != NULL) {
+      (void)MemPool_AtomicAdd(&requested->statistics.failed, 1u);
+    }
+    return NULL;
+  }
+
+  if (pool != requested) {
+    (void)MemPool_AtomicAdd(&requested->statistics.fallbacks, 1u);
+  }
+  (void)MemPool_AtomicAdd(&pool->statistics.allocated, 1u);
+  in_use = MemPool_AtomicAdd(&pool->statistics.in_use, 1u);
+  MemPool_AtomicMax(&pool->statistics.high_water, in_use);
+
+  return block;
+}
+
+/**
+ * @brief Release a block, lock free, safe from tasks and ISRs
+ *
+ * @param block [in] block allocated from the pool, NULL: ignored
+ */
+void MemPool_Free(void *const block) {
+  MemPool_Pool_t *pool = NULL;
+
+  if (block == NULL) {
+    return;
+  }
+
+  pool = MemPool_PoolOf(block);
+
+  /* counted out before it can be allocated again, in_use never exceeds the blocks */
+  (void)MemPool_AtomicAdd(&pool->statistics.in_use, (uint32_t)-1);
+  MemPool_Push(pool, block);
+}
+
+void MemPool_GetStatistics(MemPool_Class_t pool_class, MemPool_Statistics_t *const statistics) {
+  UBaseType_t saved_mask = 0;
+
+  configASSERT(pool_class < MEM_POOL_CLASS_NUMBER);
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &MemPool_Pools[pool_class].statistics, sizeof(MemPool_Statistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+void MemPool_GetBenchmark(MemPool_Benchmark_t *const benchmark) {
+  memcpy(benchmark, &MemPool_BenchmarkResult, sizeof(MemPool_Benchmark_t));
+}
@@ -0,0 +1,163 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "runtime_stats.h"
+
+/* interrupt handlers, since boot */
+static RuntimeStats_IsrStatistics_t RuntimeStats_Isr[RUNTIME_STATS_ISR_NUMBER] = {0};
+
+/* values at the previous snapshot, tasks indexed by task number */
+static RuntimeStats_IsrStatistics_t RuntimeStats_IsrWindowStart[RUNTIME_STATS_ISR_NUMBER] = {0};
+static uint32_t RuntimeStats_TaskWindowStart[RUNTIME_STATS_MAX_TASKS + 1u] = {0};
+static uint32_t RuntimeStats_WindowStartCycles = 0;
+static uint64_t RuntimeStats_WindowStartUs = 0;
+
+/* uxTaskGetSystemState() output, too large for the callers' stacks */
+static TaskStatus_t RuntimeStats_Tasks[RUNTIME_STATS_MAX_TASKS] = {0};
+
+/**
+ * @brief Store a 32 bit value, little endian
+ */
+static inline uint8_t *RuntimeStats_Put32(uint8_t *const buffer, uint32_t value) {
+  buffer[0] = (uint8_t)value;
+  buffer[1] = (uint8_t)(value >> 8);
+  buffer[2] = (uint8_t)(value >> 16);
+  buffer[3] = (uint8_t)(value >> 24);
+  return &buffer[4];
+}
+
+/* FreeRTOS run time counter (portGET_RUN_TIME_COUNTER_VALUE), the cycle
+ * counter is enabled by Timebase_Initialize(). The kernel adds the
+ * difference between two task switches, correct across a wrap */
+void configureTimerForRunTimeStats(void) {}
+
+unsigned long getRunTimeCounterValue(void) {
+  return Timebase_GetCycles();
+}
+
+/**
+ * @brief End of an interrupt handler, called from the handler
+ *
+ * @param isr [in] interrupt handler
+ * @param start [in] RuntimeStats_IsrEnter() at the start of the handler
+ */
+void RuntimeStats_IsrExit(RuntimeStats_Isr_t isr, uint32_t start) {
+  RuntimeStats_IsrStatistics_t *const statistics = &RuntimeStats_Isr[isr];
+  const uint32_t cycles = Timebase_GetCycles() - start;
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  statistics->count++;
+  statistics->cycles += cycles;
+  if (cycles > statistics->max_cycles) {
+    statistics->max_cycles = cycles;
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+
+  if ((TRACE_ISR_MASK & (1u << isr)) != 0) {
+    Trace_Record(TRACE_EVENT_ISR_EXIT, (uint8_t)isr, 0);
+  }
+}
+
+/**
+ * @brief Account the entry latency of an interrupt handler, for handlers
+ * whose request time is known (TIM1: the counter restarts from 0 at the
+ * update event, TIM2: the counter passed the compare value). TIM1 has the
+ * lowest priority, its latency includes the higher priority handlers and
+ * the kernel critical sections
+ *
+ * @param isr [in] interrupt handler
+ * @param cycles [in] request to handler entry, CPU cycles
+ */
+void RuntimeStats_IsrLatency(RuntimeStats_Isr_t isr, uint32_t cycles) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  if (cycles > RuntimeStats_Isr[isr].max_latency) {
+    RuntimeStats_Isr[isr].max_latency = cycles;
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+void RuntimeStats_GetIsrStatistics(RuntimeStats_Isr_t isr, RuntimeStats_IsrStatistics_t *const statistics) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  memcpy(statistics, &RuntimeStats_Isr[isr], sizeof(RuntimeStats_IsrStatistics_t));
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Take a binary snapshot of the tasks and interrupt handlers (layout
+ * in runtime_stats.h), and start a new window. Call from a single task, the
+ * scheduler is suspended while the task states are collected
+ *
+ * @param buffer [out] snapshot
+ * @param size [in] buffer size, at least RUNTIME_STATS_SNAPSHOT_SIZE
+ * @return uint16_t snapshot length, 0: buffer too small
+ */
+uint16_t RuntimeStats_Snapshot(uint8_t *const buffer, uint16_t size) {
+  RuntimeStats_IsrStatistics_t isr[RUNTIME_STATS_ISR_NUMBER] = {0};
+  uint8_t *position = buffer;
+  UBaseType_t tasks = 0;
+  uint32_t cycles = 0;
+  uint64_t now_us = 0;
+  uint8_t flags = 0;
+
+  if (size < RUNTIME_STATS_SNAPSHOT_SIZE) {
+    return 0;
+  }
+
+  if (uxTaskGetNumberOfTasks() > RUNTIME_STATS_MAX_TASKS) {
+    flags |= RUNTIME_STATS_FLAG_TRUNCATED;
+  }
+  tasks = uxTaskGetSystemState(RuntimeStats_Tasks, RUNTIME_STATS_MAX_TASKS, NULL);
+
+  taskENTER_CRITICAL();
+  cycles = Timebase_GetCycles();
+  now_us = Timebase_GetMicros();
+  memcpy(isr, RuntimeStats_Isr, sizeof(isr));
+  taskEXIT_CRITICAL();
+
+  /* window longer than a counter wrap, cycle differences are not valid */
+  if ((now_us - RuntimeStats_WindowStartUs) >= (((uint64_t)UINT32_MAX * 1000000u) / SystemCoreClock)) {
+    flags |= RUNTIME_STATS_FLAG_WRAPPED;
+  }
+
+  (*position++) = RUNTIME_STATS_VERSION;
+  (*position++) = (uint8_t)tasks;
+  (*position++) = RUNTIME_STATS_ISR_NUMBER;
+  (*position++) = flags;
+  position = RuntimeStats_Put32(position, cycles - RuntimeStats_WindowStartCycles);
+
+  for (uint32_t id = 0; id < RUNTIME_STATS_ISR_NUMBER; id++) {
+    position = RuntimeStats_Put32(position, isr[id].count - RuntimeStats_IsrWindowStart[id].count);
+    position = RuntimeStats_Put32(position, isr[id].cycles - RuntimeStats_IsrWindowStart[id].cycles);
+    position = RuntimeStats_Put32(position, isr[id].max_cycles);
+  }
+  memcpy(RuntimeStats_IsrWindowStart, isr, sizeof(isr));
+
+  for (UBaseType_t task = 0; task < tasks; task++) {
+    const TaskStatus_t *const status = &RuntimeStats_Tasks[task];
+    uint32_t task_cycles = status->ulRunTimeCounter;
+
+    /* tasks are created at initialization, numbers are small */
+    if (status->xTaskNumber <= RUNTIME_STATS_MAX_TASKS) {
+      task_cycles -= RuntimeStats_TaskWindowStart[status->xTaskNumber];
+      RuntimeStats_TaskWindowStart[status->xTaskNumber] = status->ulRunTimeCounter;
+    }
+
+    (*position++) = (uint8_t)status->xTaskNumber;
+    (*position++) = (uint8_t)status->eCurrentState;
+    (*position++) = (uint8_t)status->uxCurrentPriority;
+    (*position++) = (uint8_t)status->usStackHighWaterMark;
+    (*position++) = (uint8_t)(status->usStackHighWaterMark >> 8);
+    position = RuntimeStats_Put32(position, task_cycles);
+    strncpy((char *)position, status->pcTaskName, RUNTIME_STATS_NAME_SIZE);
+    position += RUNTIME_STATS_NAME_SIZE;
+  }
+
+  RuntimeStats_WindowStartCycles = cycles;
+  RuntimeStats_WindowStartUs = now_us;
+
+  return (uint16_t)(position - buffer);
+}
@@ -0,0 +1,309 @@
+#include <string.h>
+#include "schedule_table.h"
+
+/**
+ * @brief Sort key of an expiry point: offset in the cycle, then message and
+ * slave. 0 is left for the start of the cycle
+ */
+static inline uint64_t ScheduleTable_Key(uint32_t offset_us, uint8_t message, uint8_t slave) {
+  return ((((uint64_t)offset_us) << 16) | (((uint64_t)message) << 8) | slave) + 1u;
+}
+
+/**
+ * @brief Offset of the first expiry point of a message, for a slave
+ */
+static inline uint32_t ScheduleTable_Offset(const ScheduleTable_Message_t *const message, uint8_t slave) {
+  return message->offset_us + ((uint32_t)slave * message->slave_stride_us);
+}
+
+/**
+ * @brief Slaves a message is sent for by the node
+ *
+ * @param run [in] table run by the node
+ * @param message [in] message
+ * @param first [out] first slave
+ * @param last [out] last slave
+ * @return uint8_t 1: the node sends the message, 0: not its message
+ */
+static uint8_t ScheduleTable_Slaves(const ScheduleTable_Run_t *const run, const ScheduleTable_Message_t *const message,
+  uint8_t *const first, uint8_t *const last) {
+  if (message->sender != run->sender) {
+    return 0;
+  }
+
+  if ((message->flags & SCHEDULE_TABLE_FLAG_PER_SLAVE) == 0) {
+    *first = 0;
+    *last = 0;
+    return ((run->sender == SCHEDULE_TABLE_SENDER_MASTER) || (run->slave == 0)) ? 1 : 0;
+  }
+
+  if (run->sender == SCHEDULE_TABLE_SENDER_SLAVE) {
+    *first = run->slave;
+    *last = run->slave;
+  } else {
+    *first = 0;
+    *last = (uint8_t)(run->table->slave_number - 1u);
+  }
+
+  return 1;
+}
+
+/**
+ * @brief First expiry point of a message for a slave after a position
+ *
+ * @param table [in] table
+ * @param index [in] message
+ * @param slave [in] slave
+ * @param position [in] key of the last expiry point, 0: start of the cycle
+ * @param offset_us [out] offset of the expiry point
+ * @return uint8_t 1: found, 0: none left in the cycle
+ */
+static uint8_t ScheduleTable_FirstAfter(const ScheduleTable_t *const table, uint8_t index, uint8_t slave, uint64_t position,
+  uint32_t *const offset_us) {
+  const ScheduleTable_Message_t *const message = &table->messages[index];
+  uint32_t offset = ScheduleTable_Offset(message, slave);
+
+  if (ScheduleTable_Key(offset, index, slave) <= position) {
+    if (message->period_us == 0) {
+      return 0;
+    }
+
+    /* last repetition at or before the position, then the next one */
+    offset += (((uint32_t)((position - 1u) >> 16) - offset) / message->period_us) * message->period_us;
+    if (ScheduleTable_Key(offset, index, slave) <= position) {
+      offset += message->period_us;
+    }
+  }
+
+  if (offset >= table->duration_us) {
+    return 0;
+  }
+
+  *offset_us = offset;
+  return 1;
+}
+
+/**
+ * @brief Earliest expiry point of the node after a position in the cycle
+ *
+ * @param run [in] table run by the node
+ * @param position [in] key of the last expiry point, 0: start of the cycle
+ * @param point [out] expiry point, without its release time
+ * @return uint8_t 1: found, 0: none left in the cycle
+ */
+static uint8_t ScheduleTable_Find(const ScheduleTable_Run_t *const run, uint64_t position,
+  ScheduleTable_ExpiryPoint_t *const point) {
+  const ScheduleTable_t *const table = run->table;
+  uint64_t earliest = UINT64_MAX;
+  uint32_t offset_us = 0;
+  uint8_t first = 0;
+  uint8_t last = 0;
+
+  for (uint8_t index = 0; index < table->message_number; index++) {
+    const ScheduleTable_Message_t *const message = &table->messages[index];
+
+    if (ScheduleTable_Slaves(run, message, &first, &last) == 0) {
+      continue;
+    }
+
+    for (uint32_t slave = first; slave <= last; slave++) {
+      if ((ScheduleTable_FirstAfter(table, index, (uint8_t)slave, position, &offset_us) == 0)
+          || (ScheduleTable_Key(offset_us, index, (uint8_t)slave) >= earliest)) {
+        continue;
+      }
+
+      earliest = ScheduleTable_Key(offset_us, index, (uint8_t)slave);
+      point->offset_us = offset_us;
+      point->message = index;
+      point->slave = (uint8_t)slave;
+      point->len = message->len;
+      point->std_id = message->std_id;
+      if ((message->flags & SCHEDULE_TABLE_FLAG_PER_SLAVE) != 0) {
+        point->std_id += (uint16_t)(slave * table->id_stride);
+      }
+    }
+  }
+
+  return (earliest != UINT64_MAX) ? 1 : 0;
+}
+
+/**
+ * @brief Start a table at a given time
+ *
+ * @param run [out] table run by the node
+ * @param table [in] table
+ * @param sender [in] node, ScheduleTable_Sender_t
+ * @param slave [in] slave ID of a slave node
+ * @param start_us [in] start of the first cycle
+ */
+void ScheduleTable_Start(ScheduleTable_Run_t *const run, const ScheduleTable_t *const table, uint8_t sender, uint8_t slave,
+  uint64_t start_us) {
+  memset(run, 0x00, sizeof(ScheduleTable_Run_t));
+  run->table = table;
+  run->sender = sender;
+  run->slave = slave;
+  run->start_us = start_us;
+  run->state = SCHEDULE_TABLE_RUNNING;
+  run->statistics.cycles = 1;
+}
+
+/**
+ * @brief Start a table at its first sync point (ScheduleTable_Sync())
+ *
+ * @param run [out] table run by the node
+ * @param table [in] table
+ * @param sender [in] node, ScheduleTable_Sender_t
+ * @param slave [in] slave ID of a slave node
+ */
+void ScheduleTable_StartSynchronized(ScheduleTable_Run_t *const run, const ScheduleTable_t *const table, uint8_t sender,
+  uint8_t slave) {
+  ScheduleTable_Start(run, table, sender, slave, 0);
+  run->state = SCHEDULE_TABLE_WAITING;
+  run->statistics.cycles = 0;
+}
+
+void ScheduleTable_Stop(ScheduleTable_Run_t *const run) {
+  run->state = SCHEDULE_TABLE_STOPPED;
+}
+
+/**
+ * @brief Next expiry point of the node, the cycle restarts after its last one
+ *
+ * @param run [in] table run by the node
+ * @param point [out] expiry point
+ * @return uint8_t 1: expiry point, 0: none (not running, or no message of the node)
+ */
+uint8_t ScheduleTable_Next(ScheduleTable_Run_t *const run, ScheduleTable_ExpiryPoint_t *const point) {
+  if (run->state < SCHEDULE_TABLE_RUNNING) {
+    return 0;
+  }
+
+  if (ScheduleTable_Find(run, run->position, point) == 0) {
+    /* end of the cycle, first expiry point of the next one */
+    if (ScheduleTable_Find(run, 0, point) == 0) {
+      return 0;
+    }
+    run->start_us += run->table->duration_us;
+    run->statistics.cycles++;
+  }
+
+  run->position = ScheduleTable_Key(point->offset_us, point->message, point->slave);
+  point->release_us = run->start_us + point->offset_us;
+
+  return 1;
+}
+
+/**
+ * @brief Expiry points of the node per cycle
+ *
+ * @param run [in] table run by the node
+ * @return uint32_t expiry points
+ */
+uint32_t ScheduleTable_Count(const ScheduleTable_Run_t *const run) {
+  const ScheduleTable_t *const table = run->table;
+  uint32_t count = 0;
+  uint8_t first = 0;
+  uint8_t last = 0;
+
+  for (uint8_t index = 0; index < table->message_number; index++) {
+    const ScheduleTable_Message_t *const message = &table->messages[index];
+
+    if (ScheduleTable_Slaves(run, message, &first, &last) == 0) {
+      continue;
+    }
+
+    for (uint32_t slave = first; slave <= last; slave++) {
+      const uint32_t offset_us = ScheduleTable_Offset(message, (uint8_t)slave);
+
+      if (offset_us >= table->duration_us) {
+        continue;
+      }
+      count += (message->period_us == 0) ? 1u : (((table->duration_us - 1u - offset_us) / message->period_us) + 1u);
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief Sync point received, align the cycle to the sender's. The next
+ * expiry points of the node are the ones after the sync point. A slave node
+ * takes the slave ID of a per slave sync point
+ *
+ * @param run [in] table run by the node
+ * @param message [in] message received
+ * @param slave [in] slave the message was sent for
+ * @param sync_us [in] reception time stamp (end of frame), local time
+ * @return uint8_t 1: table restarted at the sync point, 0: corrected, or not a sync point
+ */
+uint8_t ScheduleTable_Sync(ScheduleTable_Run_t *const run, uint8_t message, uint8_t slave, uint64_t sync_us) {
+  const ScheduleTable_t *const table = run->table;
+  const ScheduleTable_Message_t *sync = NULL;
+  const int64_t duration_us = (int64_t)table->duration_us;
+  uint32_t offset_us = 0;
+  uint64_t expected_us = 0;
+  int64_t elapsed_us = 0;
+  int64_t cycles = 0;
+  int64_t deviation_us = 0;
+  int64_t correction_us = 0;
+
+  if ((run->state == SCHEDULE_TABLE_STOPPED) || (message >= table->message_number)
+      || ((table->messages[message].flags & SCHEDULE_TABLE_FLAG_SYNC) == 0)) {
+    return 0;
+  }
+
+  sync = &table->messages[message];
+  if ((sync->flags & SCHEDULE_TABLE_FLAG_PER_SLAVE) == 0) {
+    slave = 0;
+  } else if (run->sender == SCHEDULE_TABLE_SENDER_SLAVE) {
+    run->slave = slave;
+  }
+
+  /* start of the sender's cycle: the frame was released at its offset, and
+   * is time stamped at its end */
+  offset_us = ScheduleTable_Offset(sync, slave);
+  expected_us = sync_us - SCHEDULE_TABLE_FRAME_US(sync->len, table->bit_rate) - offset_us;
+  run->position = ScheduleTable_Key(offset_us, message, slave);
+  run->statistics.syncs++;
+
+  /* deviation from the nearest cycle start of the table */
+  if (run->state != SCHEDULE_TABLE_WAITING) {
+    elapsed_us = (int64_t)(expected_us - run->start_us);
+    if (elapsed_us >= 0) {
+      cycles = (elapsed_us + (duration_us / 2)) / duration_us;
+    } else {
+      cycles = -(((-elapsed_us) + (duration_us / 2)) / duration_us);
+    }
+    deviation_us = elapsed_us - (cycles * duration_us);
+    run->statistics.last_deviation_us = (int32_t)deviation_us;
+  }
+
+  if ((run->state == SCHEDULE_TABLE_WAITING)
+      || (deviation_us > (int64_t)table->precision_us) || (deviation_us < -(int64_t)table->precision_us)) {
+    run->start_us = expected_us;
+    run->state = SCHEDULE_TABLE_RUNNING;
+    run->statistics.cycles += (cycles > 0) ? (uint32_t)cycles : 1u;
+    run->statistics.restarts++;
+    return 1;
+  }
+
+  /* within the precision, corrected a bounded step at a time */
+  correction_us = deviation_us;
+  if (correction_us > (int64_t)table->max_adjust_us) {
+    correction_us = (int64_t)table->max_adjust_us;
+  } else if (correction_us < -(int64_t)table->max_adjust_us) {
+    correction_us = -(int64_t)table->max_adjust_us;
+  }
+
+  run->start_us += (uint64_t)((cycles * duration_us) + correction_us);
+  run->state = SCHEDULE_TABLE_RUNNING_AND_SYNCHRONOUS;
+  if (cycles > 0) {
+    run->statistics.cycles += (uint32_t)cycles;
+  }
+  run->statistics.adjusted++;
+  if ((uint32_t)((deviation_us < 0) ? -deviation_us : deviation_us) > run->statistics.max_deviation_us) {
+    run->statistics.max_deviation_us = (uint32_t)((deviation_us < 0) ? -deviation_us : deviation_us);
+  }
+
+  return 0;
+}
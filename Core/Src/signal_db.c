@@ -0,0 +1,285 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "signal_db.h"
+
+#define SIGNAL_DB_MASK_WORDS        ((SIGNAL_NUMBER + 31u) / 32u)
+
+/**
+ * @brief Signal value, sequence counter odd while the writer updates it
+ */
+typedef struct {
+  uint64_t timestamp_us;                /* time of the last write, 0: never written */
+  volatile uint32_t sequence;
+  uint8_t value[SIGNAL_DB_MAX_SIZE];
+} SignalDb_Entry_t;
+
+/**
+ * @brief Subscriber and its range of signals
+ */
+typedef struct {
+  SignalDb_Subscriber_t callback;
+  uint32_t first;
+  uint32_t count;
+} SignalDb_Subscription_t;
+
+/* signal descriptions, master node statuses share the last one */
+static const SignalDb_Info_t SignalDb_Info[SIGNAL_MASTER_STATUS + 1u] = {
+  [SIGNAL_SLAVE_COMMAND] = { .name = "SlaveCommand", .type = SIGNAL_TYPE_U8, .size = sizeof(OperationCommand_t) },
+  [SIGNAL_SLAVE_STATUS] = { .name = "SlaveStatus", .type = SIGNAL_TYPE_OPERATION_STATUS, .size = sizeof(OperationStatus_t) },
+  [SIGNAL_MASTER_STATUS] = { .name = "MasterStatus", .type = SIGNAL_TYPE_OPERATION_STATUS, .size = sizeof(OperationStatus_t) },
+};
+
+static SignalDb_Entry_t SignalDb_Entries[SIGNAL_NUMBER] = {0};
+
+/* subscribers */
+static SignalDb_Subscription_t SignalDb_Subscriptions[SIGNAL_DB_SUBSCRIBERS] = {0};
+static uint8_t SignalDb_SubscriberCount = 0;
+
+/* signals changed since the last notification batch, and batch timer state */
+static uint32_t SignalDb_Pending[SIGNAL_DB_MASK_WORDS] = {0};
+static uint8_t SignalDb_FlushStarted = 0;
+
+static SignalDb_Statistics_t SignalDb_Statistics = {0};
+static SignalDb_Benchmark_t SignalDb_BenchmarkResult = {0};
+
+/* notification batch timer, one shot, 1 tick */
+static TimerHandle_t SignalDb_TimerHandle = NULL;
+static StaticTimer_t SignalDb_Timer = {0};
+
+/**
+ * @brief Update a value, single writer
+ */
+static inline void SignalDb_Store(SignalDb_Entry_t *const entry, const void *const value, uint8_t size, uint64_t timestamp_us) {
+  entry->sequence++;
+  __DMB();
+  memcpy(entry->value, value, size);
+  entry->timestamp_us = timestamp_us;
+  __DMB();
+  entry->sequence++;
+}
+
+/**
+ * @brief Copy a consistent value, without locking
+ *
+ * @return uint8_t 1: value copied, 0: writer busy on every attempt
+ */
+static inline uint8_t SignalDb_Load(const SignalDb_Entry_t *const entry, void *const value, uint8_t size, uint64_t *const timestamp_us) {
+  uint32_t sequence = 0;
+
+  for (uint32_t attempt = 0; attempt < SIGNAL_DB_READ_RETRIES; attempt++) {
+    sequence = entry->sequence;
+    if ((sequence & 1u) != 0) {
+      continue;
+    }
+
+    __DMB();
+    memcpy(value, entry->value, size);
+    if (timestamp_us != NULL) {
+      (*timestamp_us) = entry->timestamp_us;
+    }
+    __DMB();
+
+    if (entry->sequence == sequence) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Notify subscribers of the signals changed since the last batch,
+ * runs in the timer task
+ *
+ * @param timer_handle
+ */
+static void SignalDb_TimerCallback(TimerHandle_t timer_handle) {
+  uint32_t changed[SIGNAL_DB_MASK_WORDS] = {0};
+  uint32_t notifications = 0;
+
+  taskENTER_CRITICAL();
+  memcpy(changed, SignalDb_Pending, sizeof(changed));
+  memset(SignalDb_Pending, 0x00, sizeof(SignalDb_Pending));
+  SignalDb_FlushStarted = 0;
+  taskEXIT_CRITICAL();
+
+  for (uint8_t subscriber = 0; subscriber < SignalDb_SubscriberCount; subscriber++) {
+    const SignalDb_Subscription_t *const subscription = &SignalDb_Subscriptions[subscriber];
+
+    for (uint32_t id = subscription->first; id < (subscription->first + subscription->count); id++) {
+      if ((changed[id / 32u] & (1uL << (id % 32u))) != 0) {
+        subscription->callback((SignalDb_Id_t)id);
+        notifications++;
+      }
+    }
+  }
+
+  taskENTER_CRITICAL();
+  SignalDb_Statistics.batches++;
+  SignalDb_Statistics.notifications += notifications;
+  taskEXIT_CRITICAL();
+
+  (void)timer_handle;
+}
+
+/**
+ * @brief Measure the cost of seqlock and mutex protected accesses to a
+ * signal value
+ */
+static void SignalDb_RunBenchmark(void) {
+  static StaticSemaphore_t mutex_buffer = {0};
+  SemaphoreHandle_t mutex = xSemaphoreCreateMutexStatic(&mutex_buffer);
+  SignalDb_Entry_t entry = {0};
+  OperationStatus_t status = {0};
+  uint32_t read_cycles[2] = {0};
+  uint32_t write_cycles[2] = {0};
+  uint32_t start = 0;
+
+  configASSERT(mutex != NULL);
+
+  for (uint32_t pass = 0; pass < SIGNAL_DB_BENCHMARK_PASSES; pass++) {
+    status.value = (uint8_t)pass;
+
+    start = Timebase_GetCycles();
+    SignalDb_Store(&entry, &status, sizeof(OperationStatus_t), pass);
+    write_cycles[0] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    configASSERT(SignalDb_Load(&entry, &status, sizeof(OperationStatus_t), NULL) == 1u);
+    read_cycles[0] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    (void)xSemaphoreTake(mutex, 0);
+    memcpy(entry.value, &status, sizeof(OperationStatus_t));
+    entry.timestamp_us = pass;
+    (void)xSemaphoreGive(mutex);
+    write_cycles[1] += Timebase_GetCycles() - start;
+
+    start = Timebase_GetCycles();
+    (void)xSemaphoreTake(mutex, 0);
+    memcpy(&status, entry.value, sizeof(OperationStatus_t));
+    (void)xSemaphoreGive(mutex);
+    read_cycles[1] += Timebase_GetCycles() - start;
+  }
+
+  SignalDb_BenchmarkResult.seqlock_write_cycles = write_cycles[0] / SIGNAL_DB_BENCHMARK_PASSES;
+  SignalDb_BenchmarkResult.seqlock_read_cycles = read_cycles[0] / SIGNAL_DB_BENCHMARK_PASSES;
+  SignalDb_BenchmarkResult.mutex_write_cycles = write_cycles[1] / SIGNAL_DB_BENCHMARK_PASSES;
+  SignalDb_BenchmarkResult.mutex_read_cycles = read_cycles[1] / SIGNAL_DB_BENCHMARK_PASSES;
+}
+
+void SignalDb_Initialize(void) {
+  memset(SignalDb_Entries, 0x00, sizeof(SignalDb_Entries));
+  memset(SignalDb_Subscriptions, 0x00, sizeof(SignalDb_Subscriptions));
+  memset(SignalDb_Pending, 0x00, sizeof(SignalDb_Pending));
+  memset(&SignalDb_Statistics, 0x00, sizeof(SignalDb_Statistics_t));
+  SignalDb_SubscriberCount = 0;
+  SignalDb_FlushStarted = 0;
+
+  SignalDb_RunBenchmark();
+
+  SignalDb_TimerHandle = xTimerCreateStatic(
+    "SignalDbTimer",
+    1,
+    pdFALSE,
+    NULL,
+    SignalDb_TimerCallback,
+    &SignalDb_Timer
+  );
+  configASSERT(SignalDb_TimerHandle != NULL);
+  vTimerSetTimerNumber(SignalDb_TimerHandle, TRACE_OBJECT_SIGNAL_DB);
+}
+
+/**
+ * @brief Write a signal value, from the signal's writer task. Subscribers
+ * are notified at the next tick if the value changed
+ *
+ * @param id [in] signal
+ * @param value [in] value, of the signal's type
+ */
+void SignalDb_Write(SignalDb_Id_t id, const void *const value) {
+  SignalDb_Entry_t *const entry = &SignalDb_Entries[id];
+  const uint8_t size = SignalDb_GetInfo(id)->size;
+  /* only the writer modifies the value, it reads it without the seqlock */
+  const uint8_t changed = (memcmp(entry->value, value, size) != 0);
+  uint8_t start_flush = 0;
+
+  SignalDb_Store(entry, value, size, Timebase_GetMicros());
+
+  taskENTER_CRITICAL();
+  SignalDb_Statistics.writes++;
+  if (changed) {
+    SignalDb_Statistics.changes++;
+    SignalDb_Pending[id / 32u] |= (1uL << (id % 32u));
+    start_flush = (SignalDb_FlushStarted == 0) && (SignalDb_SubscriberCount > 0);
+    SignalDb_FlushStarted |= start_flush;
+  }
+  taskEXIT_CRITICAL();
+
+  /* first change of the batch, the timer queue may be full: the next change retries */
+  if (start_flush && (xTimerStart(SignalDb_TimerHandle, 0) != pdPASS)) {
+    SignalDb_FlushStarted = 0;
+  }
+}
+
+/**
+ * @brief Read a consistent signal value without locking, from tasks or ISRs
+ *
+ * @param id [in] signal
+ * @param value [out] value, of the signal's type
+ * @param timestamp_us [out] time of the last write, 0: never written, NULL: not needed
+ * @return uint8_t 1: value read, 0: the writer was preempted while updating
+ * the value (reader in an ISR or a higher priority task), value is not valid
+ */
+uint8_t SignalDb_Read(SignalDb_Id_t id, void *const value, uint64_t *const timestamp_us) {
+  configASSERT(id < SIGNAL_NUMBER);
+
+  if (SignalDb_Load(&SignalDb_Entries[id], value, SignalDb_GetInfo(id)->size, timestamp_us) == 0) {
+    UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+    SignalDb_Statistics.failed_reads++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+    return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * @brief Subscribe to changes of a range of signals, must be called before
+ * the scheduler is started
+ *
+ * @param subscriber [in] change notification
+ * @param first [in] first signal of the range
+ * @param count [in] number of signals
+ * @return uint8_t 1: subscribed, 0: too many subscribers or invalid range
+ */
+uint8_t SignalDb_Subscribe(SignalDb_Subscriber_t subscriber, SignalDb_Id_t first, uint32_t count) {
+  if ((SignalDb_SubscriberCount >= SIGNAL_DB_SUBSCRIBERS) || (subscriber == NULL)
+      || (count == 0) || (((uint32_t)first + count) > SIGNAL_NUMBER)) {
+    return 0;
+  }
+
+  SignalDb_Subscriptions[SignalDb_SubscriberCount].callback = subscriber;
+  SignalDb_Subscriptions[SignalDb_SubscriberCount].first = first;
+  SignalDb_Subscriptions[SignalDb_SubscriberCount].count = count;
+  SignalDb_SubscriberCount++;
+  return 1;
+}
+
+const SignalDb_Info_t *SignalDb_GetInfo(SignalDb_Id_t id) {
+  configASSERT(id < SIGNAL_NUMBER);
+
+  return &SignalDb_Info[(id < SIGNAL_MASTER_STATUS) ? id : SIGNAL_MASTER_STATUS];
+}
+
+void SignalDb_GetBenchmark(SignalDb_Benchmark_t *const benchmark) {
+  memcpy(benchmark, &SignalDb_BenchmarkResult, sizeof(SignalDb_Benchmark_t));
+}
+
+void SignalDb_GetStatistics(SignalDb_Statistics_t *const statistics) {
+  taskENTER_CRITICAL();
+  memcpy(statistics, &SignalDb_Statistics, sizeof(SignalDb_Statistics_t));
+  taskEXIT_CRITICAL();
+}
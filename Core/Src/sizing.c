@@ -0,0 +1,385 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "event_channel.h"
+#include "can2can.h"
+#include "event_pool.h"
+#include "mem_pool.h"
+#include "trace.h"
+#include "sizing.h"
+
+#if (configRECORD_STACK_HIGH_ADDRESS != 1)
+#error configRECORD_STACK_HIGH_ADDRESS must be 1, the stack depths are taken from pxEndOfStack
+#endif /* (configRECORD_STACK_HIGH_ADDRESS != 1) */
+
+#define SIZING_TIMER_QUEUE_NAME     "TmrQ"    /* timers.c registry name */
+
+/**
+ * @brief Tracked task
+ */
+typedef struct {
+  TaskHandle_t task;
+  uint16_t depth;
+} Sizing_Task_t;
+
+/**
+ * @brief Tracked kernel queue
+ */
+typedef struct {
+  QueueHandle_t queue;
+  uint16_t length;
+  uint8_t item_size;
+  uint16_t peak;
+  uint16_t failed;
+} Sizing_Queue_t;
+
+/* tasks, in creation order */
+static Sizing_Task_t Sizing_Tasks[SIZING_MAX_TASKS] = {0};
+static uint8_t Sizing_TaskCount = 0;
+
+/* queues, in order of their first send */
+static Sizing_Queue_t Sizing_Queues[SIZING_MAX_QUEUES] = {0};
+static uint8_t Sizing_QueueCount = 0;
+
+static uint8_t Sizing_Flags = 0;
+static uint16_t Sizing_SavedStatusRate = 0;
+
+/**
+ * @brief Store a 16 bit value, little endian
+ */
+static inline uint8_t *Sizing_Put16(uint8_t *const buffer, uint16_t value) {
+  buffer[0] = (uint8_t)value;
+  buffer[1] = (uint8_t)(value >> 8);
+  return &buffer[2];
+}
+
+/**
+ * @brief Find a queue, or start tracking it, interrupts masked
+ *
+ * @return Sizing_Queue_t* entry, NULL: table full
+ */
+static Sizing_Queue_t *Sizing_FindQueue(void *const queue, uint32_t length, uint32_t item_size) {
+  for (uint8_t id = 0; id < Sizing_QueueCount; id++) {
+    if (Sizing_Queues[id].queue == (QueueHandle_t)queue) {
+      return &Sizing_Queues[id];
+    }
+  }
+
+  if (Sizing_QueueCount >= SIZING_MAX_QUEUES) {
+    Sizing_Flags |= SIZING_FLAG_TRUNCATED;
+    return NULL;
+  }
+
+  Sizing_Queues[Sizing_QueueCount].queue = (QueueHandle_t)queue;
+  Sizing_Queues[Sizing_QueueCount].length = (uint16_t)length;
+  Sizing_Queues[Sizing_QueueCount].item_size = (uint8_t)item_size;
+  return &Sizing_Queues[Sizing_QueueCount++];
+}
+
+/**
+ * @brief Smallest safe queue length: the peak and a margin, twice the
+ * length if the queue was full
+ */
+static uint16_t Sizing_SuggestLength(uint16_t length, uint16_t peak, uint16_t failed) {
+  if ((failed != 0) || (peak >= length)) {
+    return (uint16_t)(2u * length);
+  }
+
+  return (uint16_t)(peak + SIZING_QUEUE_MARGIN);
+}
+
+/**
+ * @brief Keep the stack depth of a created task, called by traceTASK_CREATE
+ *
+ * @param task [in] task control block
+ * @param depth [in] stack depth in words
+ */
+void Sizing_TaskCreated(void *const task, uint32_t depth) {
+  if (Sizing_TaskCount >= SIZING_MAX_TASKS) {
+    Sizing_Flags |= SIZING_FLAG_TRUNCATED;
+    return;
+  }
+
+  Sizing_Tasks[Sizing_TaskCount].task = (TaskHandle_t)task;
+  Sizing_Tasks[Sizing_TaskCount].depth = (uint16_t)depth;
+  Sizing_TaskCount++;
+}
+
+/**
+ * @brief Track the occupancy of a queue, called by traceQUEUE_SEND and
+ * traceQUEUE_SEND_FROM_ISR before the item is copied
+ *
+ * @param queue [in] queue
+ * @param waiting [in] items in the queue before the send
+ * @param length [in] queue length
+ * @param item_size [in] item size, 0: semaphore or mutex, not tracked
+ */
+void Sizing_QueueSend(void *const queue, uint32_t waiting, uint32_t length, uint32_t item_size) {
+  Sizing_Queue_t *entry = NULL;
+  UBaseType_t saved_mask = 0;
+
+  if (item_size == 0) {
+    return;
+  }
+
+  /* overwriting a full mailbox doesn't add an item */
+  if (waiting < length) {
+    waiting++;
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  entry = Sizing_FindQueue(queue, length, item_size);
+  if ((entry != NULL) && (waiting > entry->peak)) {
+    entry->peak = (uint16_t)waiting;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Count a send to a full queue, called by traceQUEUE_SEND_FAILED
+ * and traceQUEUE_SEND_FROM_ISR_FAILED
+ *
+ * @param queue [in] queue
+ * @param length [in] queue length
+ * @param item_size [in] item size, 0: semaphore or mutex, not tracked
+ */
+void Sizing_QueueFailed(void *const queue, uint32_t length, uint32_t item_size) {
+  Sizing_Queue_t *entry = NULL;
+  UBaseType_t saved_mask = 0;
+
+  if (item_size == 0) {
+    return;
+  }
+
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+  entry = Sizing_FindQueue(queue, length, item_size);
+  if (entry != NULL) {
+    entry->peak = (uint16_t)length;
+    if (entry->failed < UINT16_MAX) {
+      entry->failed++;
+    }
+  }
+  Sizing_Flags |= SIZING_FLAG_SATURATED;
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Start the stress workload: queue peaks are cleared, and the master
+ * requests the operation status at the highest rate, so the CAN RX
+ * interrupts, the node tasks, the timer task and the SLCAN gateway run at
+ * their highest load. Stack high water marks are kept since the start
+ */
+void Sizing_StartStress(void) {
+  taskENTER_CRITICAL();
+  for (uint8_t id = 0; id < Sizing_QueueCount; id++) {
+    Sizing_Queues[id].peak = 0;
+    Sizing_Queues[id].failed = 0;
+  }
+  Sizing_Flags &= (uint8_t)~SIZING_FLAG_SATURATED;
+  if ((Sizing_Flags & SIZING_FLAG_STRESS) == 0) {
+    Sizing_SavedStatusRate = MasterNode_GetStatusRate();
+    Sizing_Flags |= SIZING_FLAG_STRESS;
+  }
+  taskEXIT_CRITICAL();
+
+  (void)MasterNode_SetStatusRate(OPERATION_STATUS_MAX_FREQUENCY);
+}
+
+/**
+ * @brief Stop the stress workload, the status rate is restored
+ */
+void Sizing_StopStress(void) {
+  if ((Sizing_Flags & SIZING_FLAG_STRESS) == 0) {
+    return;
+  }
+
+  (void)MasterNode_SetStatusRate(Sizing_SavedStatusRate);
+
+  taskENTER_CRITICAL();
+  Sizing_Flags &= (uint8_t)~SIZING_FLAG_STRESS;
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Stack use of a task, from its high water mark: the peak use and
+ * a margin (a quarter of the peak, at least SIZING_STACK_MIN_MARGIN words),
+ * rounded up to SIZING_STACK_GRANULE words
+ *
+ * @param index [in] task, in creation order
+ * @param report [out] stack use
+ * @return uint8_t 1: reported, 0: no such task
+ */
+uint8_t Sizing_GetTaskReport(uint8_t index, Sizing_TaskReport_t *const report) {
+  uint32_t margin = 0;
+
+  if (index >= Sizing_TaskCount) {
+    return 0;
+  }
+
+  report->number = (uint8_t)uxTaskGetTaskNumber(Sizing_Tasks[index].task);
+  report->depth = Sizing_Tasks[index].depth;
+  report->used = (uint16_t)(Sizing_Tasks[index].depth - uxTaskGetStackHighWaterMark(Sizing_Tasks[index].task));
+  report->name = pcTaskGetName(Sizing_Tasks[index].task);
+
+  margin = (uint32_t)report->used >> SIZING_STACK_MARGIN_SHIFT;
+  if (margin < SIZING_STACK_MIN_MARGIN) {
+    margin = SIZING_STACK_MIN_MARGIN;
+  }
+  report->suggested = (uint16_t)((report->used + margin + SIZING_STACK_GRANULE - 1u) & ~(SIZING_STACK_GRANULE - 1u));
+
+  return 1;
+}
+
+/**
+ * @brief Occupancy of a queue: the kernel queues first, then the node event
+ * channels, the event pool and the memory pool classes, which keep their own
+ * high water marks since the start
+ *
+ * @param index [in] queue
+ * @param report [out] occupancy
+ * @return uint8_t 1: reported, 0: no such queue
+ */
+uint8_t Sizing_GetQueueReport(uint8_t index, Sizing_QueueReport_t *const report) {
+  EventPool_Statistics_t pool = {0};
+  MemPool_Statistics_t blocks = {0};
+  uint8_t channels = 0;
+
+#if (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  EventChannel_Statistics_t channel = {0};
+
+  channels = 2u;
+#endif /* (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+
+  memset(report, 0x00, sizeof(Sizing_QueueReport_t));
+
+  if (index < Sizing_QueueCount) {
+    const char *const name = pcQueueGetName(Sizing_Queues[index].queue);
+
+    report->kind = ((name != NULL) && (strcmp(name, SIZING_TIMER_QUEUE_NAME) == 0)) ? SIZING_QUEUE_TIMER : SIZING_QUEUE_KERNEL;
+    report->number = (uint8_t)uxQueueGetQueueNumber(Sizing_Queues[index].queue);
+    report->item_size = Sizing_Queues[index].item_size;
+    report->length = Sizing_Queues[index].length;
+
+    taskENTER_CRITICAL();
+    report->peak = Sizing_Queues[index].peak;
+    report->failed = Sizing_Queues[index].failed;
+    taskEXIT_CRITICAL();
+
+    report->suggested = Sizing_SuggestLength(report->length, report->peak, report->failed);
+    return 1;
+  }
+  index -= Sizing_QueueCount;
+
+#if (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u)
+  if (index < channels) {
+    if (index == 0) {
+      MasterNode_GetEventChannelStatistics(&channel);
+      report->number = TRACE_OBJECT_MASTER_NODE;
+    } else {
+      SlaveNode_GetEventChannelStatistics(&channel);
+      report->number = TRACE_OBJECT_SLAVE_NODE;
+    }
+
+    report->kind = SIZING_QUEUE_CHANNEL;
+    report->item_size = (uint8_t)sizeof(Event_t *);
+    report->length = EVENT_POOL_SIZE;
+    report->peak = (uint16_t)channel.high_water;
+    report->failed = (uint16_t)((channel.full > UINT16_MAX) ? UINT16_MAX : channel.full);
+
+    /* channel sizes are powers of 2 */
+    report->suggested = 1u;
+    while (report->suggested < Sizing_SuggestLength(report->length, report->peak, report->failed)) {
+      report->suggested <<= 1;
+    }
+    return 1;
+  }
+#endif /* (CAN2CAN_USE_EXECUTIVE == 0u) && (CAN2CAN_USE_EVENT_CHANNEL == 1u) */
+  index -= channels;
+
+  if (index == 0) {
+    EventPool_GetStatistics(&pool);
+
+    report->kind = SIZING_QUEUE_POOL;
+    report->item_size = (uint8_t)sizeof(Event_t);
+    report->length = EVENT_POOL_SIZE;
+    report->peak = (uint16_t)pool.high_water;
+    report->failed = (uint16_t)((pool.failed > UINT16_MAX) ? UINT16_MAX : pool.failed);
+    report->suggested = Sizing_SuggestLength(report->length, report->peak, report->failed);
+    return 1;
+  }
+  index -= 1u;
+
+  /* a class that was empty is saturated, whether a larger class served the request or not */
+  if (index < MEM_POOL_CLASS_NUMBER) {
+    MemPool_GetStatistics((MemPool_Class_t)index, &blocks);
+
+    report->kind = SIZING_QUEUE_MEM_POOL;
+    report->number = index;
+    report->item_size = (uint8_t)blocks.block_size;
+    report->length = (uint16_t)blocks.blocks;
+    report->peak = (uint16_t)blocks.high_water;
+    report->failed = (uint16_t)(((blocks.failed + blocks.fallbacks) > UINT16_MAX) ? UINT16_MAX : (blocks.failed + blocks.fallbacks));
+    report->suggested = Sizing_SuggestLength(report->length, report->peak, report->failed);
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Pack the sizing report (layout in sizing.h), from a task: the
+ * stack high water marks are found by scanning the stacks
+ *
+ * @param buffer [out] report
+ * @param size [in] buffer size, at least SIZING_REPORT_SIZE
+ * @return uint16_t report length, 0: buffer too small
+ */
+uint16_t Sizing_Report(uint8_t *const buffer, uint16_t size) {
+  Sizing_TaskReport_t task = {0};
+  Sizing_QueueReport_t queue = {0};
+  uint8_t *position = &buffer[SIZING_HEADER_SIZE];
+  uint32_t stack_bytes = 0;
+  uint32_t queue_bytes = 0;
+  uint8_t tasks = 0;
+  uint8_t queues = 0;
+
+  if (size < SIZING_REPORT_SIZE) {
+    return 0;
+  }
+
+  for (tasks = 0; Sizing_GetTaskReport(tasks, &task) != 0; tasks++) {
+    if (task.depth > task.suggested) {
+      stack_bytes += (uint32_t)(task.depth - task.suggested) * sizeof(StackType_t);
+    }
+
+    (*position++) = task.number;
+    position = Sizing_Put16(position, task.depth);
+    position = Sizing_Put16(position, task.used);
+    position = Sizing_Put16(position, task.suggested);
+    strncpy((char *)position, task.name, SIZING_NAME_SIZE);
+    position += SIZING_NAME_SIZE;
+  }
+
+  for (queues = 0; Sizing_GetQueueReport(queues, &queue) != 0; queues++) {
+    if (queue.length > queue.suggested) {
+      queue_bytes += (uint32_t)(queue.length - queue.suggested) * queue.item_size;
+    }
+
+    (*position++) = queue.kind;
+    (*position++) = queue.number;
+    (*position++) = queue.item_size;
+    position = Sizing_Put16(position, queue.length);
+    position = Sizing_Put16(position, queue.peak);
+    position = Sizing_Put16(position, queue.failed);
+    position = Sizing_Put16(position, queue.suggested);
+  }
+
+  buffer[0] = SIZING_VERSION;
+  buffer[1] = tasks;
+  buffer[2] = queues;
+  buffer[3] = Sizing_Flags;
+  (void)Sizing_Put16(&buffer[4], (uint16_t)stack_bytes);
+  (void)Sizing_Put16(&buffer[6], (uint16_t)queue_bytes);
+
+  return (uint16_t)(position - buffer);
+}
@@ -0,0 +1,964 @@
+#include <string.h>
+#include "main.h"
+#include "can.h"
+#include "usart.h"
+#include "cmsis_os.h"
+#include "can2can.h"
+#include "cpu_load.h"
+#include "e2e.h"
+#include "mem_pool.h"
+#include "runtime_stats.h"
+#include "sizing.h"
+#include "trace.h"
+#include "slcan.h"
+
+#define SLCAN_OK                    ('\r')
+#define SLCAN_ERROR                 ('\a')
+#define SLCAN_TIMESTAMP_MODULO      (60000u)
+
+/* t + ID (3) + DLC (1) + data (16) + time stamp (4) + CR */
+#define SLCAN_MAX_FRAME_LINE        (1u + 3u + 1u + (2u * BXCAN_MAX_DATA_SIZE) + 4u + 1u)
+
+/* run time statistics snapshot and sizing report, encoded in chunks of this many bytes */
+#define SLCAN_SNAPSHOT_CHUNK        (16u)
+#define SLCAN_SNAPSHOT_SIZE         ((RUNTIME_STATS_SNAPSHOT_SIZE > SIZING_REPORT_SIZE) ? RUNTIME_STATS_SNAPSHOT_SIZE : SIZING_REPORT_SIZE)
+
+/* H + slave (2) + histogram (1) + count, min, max (3 x 8) + bins (8 each) */
+#define SLCAN_HISTOGRAM_LINE        (1u + 2u + 1u + (8u * (3u + HISTOGRAM_BINS)))
+
+/* I + load, long load, peak load, bus load at the peak, interrupt load, bus load, windows (8 each) */
+#define SLCAN_LOAD_LINE             (1u + (8u * 7u))
+
+/* E + standard ID (3) + status, ok, CRC errors, repeated, wrong sequence, lost, timeouts (8 each) */
+#define SLCAN_E2E_LINE              (1u + 3u + (8u * 7u))
+
+/* CAN bit rate is fixed by MX_CAN_Init() (1 Mbit/s), only S8 is accepted */
+#define SLCAN_BITRATE_CODE          ('8')
+
+/**
+ * @brief Frame queued for the host, binary form
+ */
+typedef struct {
+  uint16_t timestamp;                   /* reception time (ms, modulo 60000) */
+  uint16_t std_id;                      /* standard ID */
+  uint8_t dlc;                          /* data length code */
+  uint8_t data[BXCAN_MAX_DATA_SIZE];    /* frame data */
+} Slcan_Frame_t;
+
+/**
+ * @brief SLCAN channel state
+ */
+typedef enum {
+  SLCAN_CHANNEL_CLOSED,   /* frames are not forwarded to the host */
+  SLCAN_CHANNEL_OPEN,     /* frames are forwarded, host can send frames */
+  SLCAN_CHANNEL_LISTEN,   /* frames are forwarded, host can't send frames */
+} Slcan_ChannelState_t;
+
+static const char Slcan_HexDigits[] = "0123456789ABCDEF";
+
+static volatile Slcan_ChannelState_t Slcan_ChannelState = SLCAN_CHANNEL_CLOSED;
+static uint8_t Slcan_TimestampEnabled = 0;
+static volatile uint8_t Slcan_Injecting = 0;
+
+/* statistics */
+static Slcan_Statistics_t Slcan_Statistics = {0};
+static uint32_t Slcan_WindowStart = 0;
+static uint32_t Slcan_WindowFrames = 0;
+
+/* gateway task */
+static TaskHandle_t Slcan_TaskHandle = NULL;
+static StaticTask_t Slcan_TaskBuffer = {0};
+static StackType_t Slcan_TaskStack[SLCAN_TASK_STACK_DEPTH] = {0};
+
+/* frames waiting to be encoded, pool blocks or copies */
+static QueueHandle_t Slcan_FrameQueueHandle = NULL;
+static StaticQueue_t Slcan_FrameQueue = {0};
+#if (SLCAN_USE_MEM_POOL == 1u)
+static Slcan_Frame_t *Slcan_FrameQueueStorage[SLCAN_FRAME_QUEUE_SIZE] = {0};
+#else
+static Slcan_Frame_t Slcan_FrameQueueStorage[SLCAN_FRAME_QUEUE_SIZE] = {0};
+#endif /* (SLCAN_USE_MEM_POOL == 1u) */
+
+/* operation status frames received by the master node, events referenced
+ * by the gateway until encoded */
+static QueueHandle_t Slcan_EventQueueHandle = NULL;
+static StaticQueue_t Slcan_EventQueue = {0};
+static Event_t *Slcan_EventQueueStorage[SLCAN_EVENT_QUEUE_SIZE] = {0};
+
+/* host -> gateway, circular DMA */
+static uint8_t Slcan_RxBuffer[SLCAN_RX_BUFFER_SIZE] = {0};
+static volatile uint16_t Slcan_RxHead = 0;
+static uint16_t Slcan_RxTail = 0;
+static volatile uint8_t Slcan_RxRestarted = 0;
+static char Slcan_Command[SLCAN_COMMAND_MAX_SIZE] = {0};
+static uint8_t Slcan_CommandLength = 0;
+static uint8_t Slcan_CommandOverflow = 0;
+
+/* gateway -> host, ring buffer drained by DMA */
+static uint8_t Slcan_TxBuffer[SLCAN_TX_BUFFER_SIZE] = {0};
+
+/* run time statistics snapshot or sizing report, and trace block, binary */
+static uint8_t Slcan_Snapshot[SLCAN_SNAPSHOT_SIZE] = {0};
+static uint8_t Slcan_TraceBlock[TRACE_BLOCK_SIZE] = {0};
+static volatile uint16_t Slcan_TxHead = 0;
+static volatile uint16_t Slcan_TxTail = 0;
+static volatile uint16_t Slcan_TxInFlight = 0;
+
+/**
+ * @brief Frames forwarded from the master node's events instead of the
+ * monitor callback: operation status frames received
+ */
+static inline uint8_t Slcan_IsSubscribedFrame(uint16_t std_id, bxCAN_Direction_t direction) {
+  return (direction == BXCAN_DIRECTION_RX) && ((std_id & ~SLAVE_ID_STD_ID_MASK) == OPERATION_STATUS_STD_ID);
+}
+
+/**
+ * @brief Master node frame subscriber, queues the event for the gateway
+ * task, which holds the reference until the frame is encoded. Called from
+ * the master's RX handler, the CAN service task or the CAN RX interrupt
+ *
+ * @param pEvent [in] CAN_RX_EVENT, one reference owned by the gateway
+ */
+static void Slcan_FrameSubscriber(Event_t *const pEvent) {
+  BaseType_t xTaskWoken = pdFALSE;
+  UBaseType_t saved_mask = 0;
+  BaseType_t queued = pdFALSE;
+
+  if ((Slcan_ChannelState == SLCAN_CHANNEL_CLOSED)
+      || (Slcan_IsSubscribedFrame(pEvent->payload.frame.std_id, BXCAN_DIRECTION_RX) == 0)) {
+    EventPool_Release(pEvent);
+    return;
+  }
+
+  if (__get_IPSR() != 0) {
+    queued = xQueueSendFromISR(Slcan_EventQueueHandle, &pEvent, &xTaskWoken);
+    vTaskNotifyGiveFromISR(Slcan_TaskHandle, &xTaskWoken);
+  } else {
+    queued = xQueueSend(Slcan_EventQueueHandle, &pEvent, 0);
+    xTaskNotifyGive(Slcan_TaskHandle);
+  }
+
+  /* the queue bounds the events kept from the master node */
+  if (queued != pdTRUE) {
+    EventPool_Release(pEvent);
+    saved_mask = taskENTER_CRITICAL_FROM_ISR();
+    Slcan_Statistics.dropped_frames++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+  }
+
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+/**
+ * @brief CAN driver monitor callback, queues frame for the gateway task.
+ * No encoding is done here, this may run in the CAN ISR. With the memory
+ * pool, the frame is written once into a block and the queue carries its
+ * pointer
+ */
+static void Slcan_MonitorCallback(uint16_t std_id, const uint8_t *const data, uint8_t len, bxCAN_Direction_t direction) {
+  BaseType_t xTaskWoken = pdFALSE;
+  UBaseType_t saved_mask = 0;
+  BaseType_t queued = pdFALSE;
+#if (SLCAN_USE_MEM_POOL == 1u)
+  Slcan_Frame_t *pFrame = NULL;
+  const void *const item = &pFrame;   /* the queue carries the block pointer */
+#else
+  Slcan_Frame_t frame = {0};
+  Slcan_Frame_t *const pFrame = &frame;
+  const void *const item = &frame;
+#endif /* (SLCAN_USE_MEM_POOL == 1u) */
+
+  if (Slcan_ChannelState == SLCAN_CHANNEL_CLOSED) {
+    return;
+  }
+
+  /* in loopback mode transmitted frames are received back, and frames
+   * injected by the host are not echoed */
+  if ((direction == BXCAN_DIRECTION_TX) && ((hcan.Init.Mode == CAN_MODE_LOOPBACK) || (Slcan_Injecting != 0))) {
+    return;
+  }
+
+  /* forwarded from the master node's event (Slcan_FrameSubscriber()) */
+  if (Slcan_IsSubscribedFrame(std_id, direction) != 0) {
+    return;
+  }
+
+#if (SLCAN_USE_MEM_POOL == 1u)
+  pFrame = MemPool_Alloc(sizeof(Slcan_Frame_t));
+  if (pFrame == NULL) {
+    saved_mask = taskENTER_CRITICAL_FROM_ISR();
+    Slcan_Statistics.dropped_frames++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+    return;
+  }
+#endif /* (SLCAN_USE_MEM_POOL == 1u) */
+
+  pFrame->timestamp = (uint16_t)(HAL_GetTick() % SLCAN_TIMESTAMP_MODULO);
+  pFrame->std_id = std_id;
+  pFrame->dlc = (len > BXCAN_MAX_DATA_SIZE) ? BXCAN_MAX_DATA_SIZE : len;
+  memcpy(pFrame->data, data, pFrame->dlc);
+
+  if (__get_IPSR() != 0) {
+    queued = xQueueSendFromISR(Slcan_FrameQueueHandle, item, &xTaskWoken);
+    vTaskNotifyGiveFromISR(Slcan_TaskHandle, &xTaskWoken);
+  } else {
+    queued = xQueueSend(Slcan_FrameQueueHandle, item, 0);
+    xTaskNotifyGive(Slcan_TaskHandle);
+  }
+
+  if (queued != pdTRUE) {
+#if (SLCAN_USE_MEM_POOL == 1u)
+    MemPool_Free(pFrame);
+#endif /* (SLCAN_USE_MEM_POOL == 1u) */
+    saved_mask = taskENTER_CRITICAL_FROM_ISR();
+    Slcan_Statistics.dropped_frames++;
+    taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+  }
+
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+/**
+ * @brief Start DMA transmission of the pending TX buffer bytes, if idle.
+ * Must be called from a critical section or from the DMA/UART ISR
+ */
+static void Slcan_StartTransmit(void) {
+  uint16_t head = Slcan_TxHead;
+  uint16_t tail = Slcan_TxTail;
+  uint16_t len = 0;
+
+  if ((Slcan_TxInFlight != 0) || (head == tail)) {
+    return;
+  }
+
+  /* contiguous part only, the rest is sent on the next TX complete */
+  len = (head > tail) ? (uint16_t)(head - tail) : (uint16_t)(SLCAN_TX_BUFFER_SIZE - tail);
+
+  Slcan_TxInFlight = len;
+  if (HAL_UART_Transmit_DMA(&huart1, &Slcan_TxBuffer[tail], len) != HAL_OK) {
+    Slcan_TxInFlight = 0;
+  }
+}
+
+/**
+ * @brief Free space in the TX buffer, only grows while the gateway task
+ * isn't writing (DMA consumes bytes)
+ */
+static inline uint16_t Slcan_TxFree(void) {
+  return (uint16_t)(SLCAN_TX_BUFFER_SIZE - 1u - ((Slcan_TxHead + SLCAN_TX_BUFFER_SIZE - Slcan_TxTail) % SLCAN_TX_BUFFER_SIZE));
+}
+
+/**
+ * @brief Copy bytes to TX buffer, all or nothing
+ *
+ * @param data [in] bytes to send
+ * @param len [in] number of bytes
+ * @return uint8_t 1: bytes were copied, 0: not enough space
+ */
+static uint8_t Slcan_Write(const char *const data, uint16_t len) {
+  uint16_t head = Slcan_TxHead;
+
+  if (len > Slcan_TxFree()) {
+    return 0;
+  }
+
+  for (uint16_t i = 0; i < len; i++) {
+    Slcan_TxBuffer[head] = (uint8_t)data[i];
+    head = (uint16_t)((head + 1u) % SLCAN_TX_BUFFER_SIZE);
+  }
+
+  Slcan_TxHead = head;
+  return 1;
+}
+
+static inline void Slcan_WriteByte(char byte) {
+  (void)Slcan_Write(&byte, 1);
+}
+
+/**
+ * @brief Encode frame as an SLCAN line: tiiildd..[tttt]\r
+ *
+ * @param frame [in] frame to encode
+ * @param line [out] line buffer, at least SLCAN_MAX_FRAME_LINE bytes
+ * @return uint16_t line length
+ */
+static uint16_t Slcan_EncodeFrame(const Slcan_Frame_t *const frame, char *const line) {
+  uint16_t len = 0;
+
+  line[len++] = 't';
+  line[len++] = Slcan_HexDigits[(frame->std_id >> 8) & 0x07u];
+  line[len++] = Slcan_HexDigits[(frame->std_id >> 4) & 0x0Fu];
+  line[len++] = Slcan_HexDigits[frame->std_id & 0x0Fu];
+  line[len++] = (char)('0' + frame->dlc);
+
+  for (uint8_t i = 0; i < frame->dlc; i++) {
+    line[len++] = Slcan_HexDigits[frame->data[i] >> 4];
+    line[len++] = Slcan_HexDigits[frame->data[i] & 0x0Fu];
+  }
+
+  if (Slcan_TimestampEnabled != 0) {
+    line[len++] = Slcan_HexDigits[(frame->timestamp >> 12) & 0x0Fu];
+    line[len++] = Slcan_HexDigits[(frame->timestamp >> 8) & 0x0Fu];
+    line[len++] = Slcan_HexDigits[(frame->timestamp >> 4) & 0x0Fu];
+    line[len++] = Slcan_HexDigits[frame->timestamp & 0x0Fu];
+  }
+
+  line[len++] = SLCAN_OK;
+  return len;
+}
+
+/**
+ * @brief Parse hex digits
+ *
+ * @param text [in] hex digits
+ * @param digits [in] number of digits
+ * @param value [out] parsed value
+ * @return uint8_t 1: success, 0: invalid digit
+ */
+static uint8_t Slcan_ParseHex(const char *const text, uint8_t digits, uint32_t *const value) {
+  uint32_t result = 0;
+
+  for (uint8_t i = 0; i < digits; i++) {
+    char c = text[i];
+    result <<= 4;
+    if ((c >= '0') && (c <= '9')) {
+      result |= (uint32_t)(c - '0');
+    } else if ((c >= 'A') && (c <= 'F')) {
+      result |= (uint32_t)(c - 'A' + 10);
+    } else if ((c >= 'a') && (c <= 'f')) {
+      result |= (uint32_t)(c - 'a' + 10);
+    } else {
+      return 0;
+    }
+  }
+
+  (*value) = result;
+  return 1;
+}
+
+/**
+ * @brief Encode a 32 bit value as 8 hex digits
+ *
+ * @param value [in] value
+ * @param text [out] 8 characters
+ */
+static void Slcan_EncodeHex32(uint32_t value, char *const text) {
+  for (uint8_t i = 0; i < 8u; i++) {
+    text[i] = Slcan_HexDigits[(value >> (28u - (4u * i))) & 0x0Fu];
+  }
+}
+
+/**
+ * @brief Send a master node latency histogram to the host: Hssk, ss: slave
+ * ID, k: MasterNode_Latency_t. Answer: Hssk followed by count, min, max and
+ * the HISTOGRAM_BINS bins (us, 8 hex digits each)
+ *
+ * @return uint8_t 1: histogram sent, 0: invalid command or TX buffer full
+ */
+static uint8_t Slcan_SendHistogram(void) {
+  char line[SLCAN_HISTOGRAM_LINE] = {0};
+  Histogram_t histogram = {0};
+  uint32_t slave = 0;
+  uint32_t latency = 0;
+  uint16_t len = 0;
+
+  if ((Slcan_CommandLength != 4u)
+      || (Slcan_ParseHex(&Slcan_Command[1], 2, &slave) == 0) || (slave >= CAN2CAN_SLAVE_NUMBER)
+      || (Slcan_ParseHex(&Slcan_Command[3], 1, &latency) == 0) || (latency >= MASTER_NODE_LATENCY_NUMBER)) {
+    return 0;
+  }
+
+  /* copy, the master node isn't paused */
+  MasterNode_GetLatencyHistogram((uint8_t)slave, (MasterNode_Latency_t)latency, &histogram);
+
+  memcpy(line, Slcan_Command, 4u);
+  len = 4u;
+  Slcan_EncodeHex32(histogram.count, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32((histogram.count != 0) ? histogram.min_us : 0u, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(histogram.max_us, &line[len]);
+  len += 8u;
+  for (uint32_t bin = 0; bin < HISTOGRAM_BINS; bin++) {
+    Slcan_EncodeHex32(histogram.bins[bin], &line[len]);
+    len += 8u;
+  }
+
+  return Slcan_Write(line, len);
+}
+
+/**
+ * @brief Write the binary snapshot buffer to the host, 2 hex digits per byte
+ *
+ * @param command [in] first character of the line
+ * @param len [in] snapshot length, the caller checked that the line fits
+ */
+static void Slcan_WriteSnapshot(char command, uint16_t len) {
+  char chunk[2u * SLCAN_SNAPSHOT_CHUNK] = {0};
+  uint16_t count = 0;
+
+  Slcan_WriteByte(command);
+
+  for (uint16_t offset = 0; offset < len; offset += count) {
+    count = (uint16_t)(len - offset);
+    if (count > SLCAN_SNAPSHOT_CHUNK) {
+      count = SLCAN_SNAPSHOT_CHUNK;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+      chunk[2u * i] = Slcan_HexDigits[Slcan_Snapshot[offset + i] >> 4];
+      chunk[(2u * i) + 1u] = Slcan_HexDigits[Slcan_Snapshot[offset + i] & 0x0Fu];
+    }
+    (void)Slcan_Write(chunk, (uint16_t)(2u * count));
+  }
+}
+
+/**
+ * @brief Send a run time statistics snapshot to the host: J. Answer: J
+ * followed by the binary snapshot (runtime_stats.h), 2 hex digits per byte.
+ * R is the Lawicel extended remote frame command
+ *
+ * @return uint8_t 1: snapshot sent, 0: invalid command or TX buffer full
+ */
+static uint8_t Slcan_SendRuntimeStats(void) {
+  if (Slcan_CommandLength != 1u) {
+    return 0;
+  }
+
+  /* the whole line must fit, the gateway task is the only writer and DMA
+   * only frees space. The window restarts only if the snapshot is sent */
+  if ((1u + (2u * RUNTIME_STATS_SNAPSHOT_SIZE)) > Slcan_TxFree()) {
+    return 0;
+  }
+
+  Slcan_WriteSnapshot('J', RuntimeStats_Snapshot(Slcan_Snapshot, sizeof(Slcan_Snapshot)));
+  return 1;
+}
+
+/**
+ * @brief Sizing monitor commands: K1 starts the stress workload, K0 stops
+ * it, K sends the sizing report. Answer to K: K followed by the binary
+ * report (sizing.h), 2 hex digits per byte
+ *
+ * @return uint8_t 1: done, 0: invalid command or TX buffer full
+ */
+static uint8_t Slcan_Sizing(void) {
+  if (Slcan_CommandLength == 2u) {
+    if (Slcan_Command[1] == '1') {
+      Sizing_StartStress();
+    } else if (Slcan_Command[1] == '0') {
+      Sizing_StopStress();
+    } else {
+      return 0;
+    }
+    return 1;
+  }
+
+  if ((Slcan_CommandLength != 1u) || ((1u + (2u * SIZING_REPORT_SIZE)) > Slcan_TxFree())) {
+    return 0;
+  }
+
+  Slcan_WriteSnapshot('K', Sizing_Report(Slcan_Snapshot, sizeof(Slcan_Snapshot)));
+  return 1;
+}
+
+/**
+ * @brief Send the CPU load to the host: I. Answer: I followed by the load,
+ * the long window load, the peak load, the bus load of the peak window, the
+ * interrupt load, the bus load (0.01 %) and the windows (8 hex digits each)
+ *
+ * @return uint8_t 1: load sent, 0: invalid command or TX buffer full
+ */
+static uint8_t Slcan_SendLoad(void) {
+  char line[SLCAN_LOAD_LINE] = {0};
+  CpuLoad_Statistics_t load = {0};
+  uint16_t len = 1u;
+
+  if (Slcan_CommandLength != 1u) {
+    return 0;
+  }
+
+  CpuLoad_GetStatistics(&load);
+
+  line[0] = 'I';
+  Slcan_EncodeHex32(load.load, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(load.long_load, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(load.peak_load, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(load.peak_bus_load, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(load.isr_load, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(load.bus_load, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(load.windows, &line[len]);
+  len += 8u;
+
+  return Slcan_Write(line, len);
+}
+
+/**
+ * @brief Send E2E protection results to the host. Eiii, iii: protected
+ * standard ID. Answer: Eiii followed by the E2E_Status_t, then the
+ * E2E_Statistics_t counters in order (8 hex digits each). E: answer E
+ * followed by the CRC benchmark, peripheral and software cycles per frame
+ * and the match flag (8 hex digits each)
+ *
+ * @return uint8_t 1: results sent, 0: invalid command or TX buffer full
+ */
+static uint8_t Slcan_SendE2E(void) {
+  char line[SLCAN_E2E_LINE] = {0};
+  E2E_Statistics_t statistics = {0};
+  E2E_Benchmark_t benchmark = {0};
+  uint32_t std_id = 0;
+  uint16_t len = 1u;
+
+  line[0] = 'E';
+
+  if (Slcan_CommandLength == 1u) {
+    E2E_GetBenchmark(&benchmark);
+    Slcan_EncodeHex32(benchmark.hw_cycles, &line[len]);
+    len += 8u;
+    Slcan_EncodeHex32(benchmark.sw_cycles, &line[len]);
+    len += 8u;
+    Slcan_EncodeHex32(benchmark.match, &line[len]);
+    len += 8u;
+
+    return Slcan_Write(line, len);
+  }
+
+  if ((Slcan_CommandLength != 4u) || (Slcan_ParseHex(&Slcan_Command[1], 3, &std_id) == 0) || (std_id > 0x7FFu)) {
+    return 0;
+  }
+
+  E2E_GetStatistics((uint16_t)std_id, &statistics);
+
+  memcpy(&line[len], &Slcan_Command[1], 3u);
+  len += 3u;
+  Slcan_EncodeHex32((uint32_t)E2E_GetStatus((uint16_t)std_id), &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(statistics.ok_count, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(statistics.crc_errors, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(statistics.repeated, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(statistics.wrong_sequence, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(statistics.lost_frames, &line[len]);
+  len += 8u;
+  Slcan_EncodeHex32(statistics.timeouts, &line[len]);
+  len += 8u;
+
+  return Slcan_Write(line, len);
+}
+
+/**
+ * @brief Send a standard data frame received from the host: tiiildd..
+ *
+ * @return uint8_t 1: frame sent, 0: invalid command
+ */
+static uint8_t Slcan_InjectFrame(void) {
+  uint8_t data[BXCAN_MAX_DATA_SIZE] = {0};
+  uint32_t std_id = 0;
+  uint32_t dlc = 0;
+  uint32_t byte = 0;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  if ((Slcan_ChannelState != SLCAN_CHANNEL_OPEN) || (Slcan_CommandLength < 5u)) {
+    return 0;
+  }
+
+  if ((Slcan_ParseHex(&Slcan_Command[1], 3, &std_id) == 0) || (std_id > 0x7FFu)) {
+    return 0;
+  }
+
+  if ((Slcan_ParseHex(&Slcan_Command[4], 1, &dlc) == 0) || (dlc > BXCAN_MAX_DATA_SIZE)
+      || (Slcan_CommandLength != (5u + (2u * dlc)))) {
+    return 0;
+  }
+
+  for (uint8_t i = 0; i < dlc; i++) {
+    if (Slcan_ParseHex(&Slcan_Command[5u + (2u * i)], 2, &byte) == 0) {
+      return 0;
+    }
+    data[i] = (uint8_t)byte;
+  }
+
+  Slcan_Injecting = 1;
+  status = bxCAN_Transmit(data, (uint8_t)dlc, (uint16_t)std_id, NULL);
+  Slcan_Injecting = 0;
+
+  if (status != HAL_OK) {
+    return 0;
+  }
+
+  Slcan_Statistics.injected_frames++;
+  return 1;
+}
+
+/**
+ * @brief Execute a complete host command (without the trailing CR)
+ */
+static void Slcan_ExecuteCommand(void) {
+  uint8_t ok = 0;
+
+  switch (Slcan_Command[0]) {
+    case 'O': {
+      ok = (Slcan_ChannelState == SLCAN_CHANNEL_CLOSED);
+      if (ok) {
+        Slcan_ChannelState = SLCAN_CHANNEL_OPEN;
+      }
+    } break;
+
+    case 'L': {
+      ok = (Slcan_ChannelState == SLCAN_CHANNEL_CLOSED);
+      if (ok) {
+        Slcan_ChannelState = SLCAN_CHANNEL_LISTEN;
+      }
+    } break;
+
+    case 'C': {
+      ok = (Slcan_ChannelState != SLCAN_CHANNEL_CLOSED);
+      Slcan_ChannelState = SLCAN_CHANNEL_CLOSED;
+    } break;
+
+    case 'S': {
+      ok = (Slcan_CommandLength == 2u) && (Slcan_Command[1] == SLCAN_BITRATE_CODE);
+    } break;
+
+    case 'Z': {
+      ok = (Slcan_CommandLength == 2u) && ((Slcan_Command[1] == '0') || (Slcan_Command[1] == '1'));
+      if (ok) {
+        Slcan_TimestampEnabled = (Slcan_Command[1] == '1');
+      }
+    } break;
+
+    case 'V': {
+      (void)Slcan_Write(SLCAN_VERSION, sizeof(SLCAN_VERSION) - 1u);
+      ok = 1;
+    } break;
+
+    case 'N': {
+      (void)Slcan_Write(SLCAN_SERIAL_NUMBER, sizeof(SLCAN_SERIAL_NUMBER) - 1u);
+      ok = 1;
+    } break;
+
+    case 'F': {
+      (void)Slcan_Write("F00", 3);
+      ok = 1;
+    } break;
+
+    case 'H': {
+      ok = Slcan_SendHistogram();
+    } break;
+
+    case 'J': {
+      ok = Slcan_SendRuntimeStats();
+    } break;
+
+    case 'K': {
+      ok = Slcan_Sizing();
+    } break;
+
+    case 'I': {
+      ok = Slcan_SendLoad();
+    } break;
+
+    case 'E': {
+      ok = Slcan_SendE2E();
+    } break;
+
+    case 'Y': {
+      /* trace recording replaces frame forwarding, the channel must be closed */
+      ok = (Slcan_CommandLength == 2u) && ((Slcan_Command[1] == '0')
+        || ((Slcan_Command[1] == '1') && (Slcan_ChannelState == SLCAN_CHANNEL_CLOSED)));
+      if (ok && (Slcan_Command[1] == '1')) {
+        Trace_Start();
+      } else if (ok) {
+        Trace_Stop();
+      }
+    } break;
+
+    case 't': {
+      ok = Slcan_InjectFrame();
+      if (ok) {
+        Slcan_WriteByte('z');
+      }
+    } break;
+
+    default: {
+      /* extended (T), remote (r, R) frames and unknown commands */
+      ok = 0;
+    } break;
+  }
+
+  if (ok) {
+    Slcan_WriteByte(SLCAN_OK);
+  } else {
+    Slcan_Statistics.rejected_commands++;
+    Slcan_WriteByte(SLCAN_ERROR);
+  }
+}
+
+/**
+ * @brief Consume bytes received by DMA, execute complete commands
+ */
+static void Slcan_ProcessRx(void) {
+  uint16_t head = Slcan_RxHead;
+
+  if (Slcan_RxRestarted != 0) {
+    Slcan_RxRestarted = 0;
+    Slcan_RxTail = 0;
+    Slcan_CommandLength = 0;
+    head = Slcan_RxHead;
+  }
+
+  while (Slcan_RxTail != head) {
+    char c = (char)Slcan_RxBuffer[Slcan_RxTail];
+    Slcan_RxTail = (uint16_t)((Slcan_RxTail + 1u) % SLCAN_RX_BUFFER_SIZE);
+
+    if (c == '\r') {
+      if (Slcan_CommandOverflow != 0) {
+        Slcan_Statistics.rejected_commands++;
+        Slcan_WriteByte(SLCAN_ERROR);
+      } else if (Slcan_CommandLength > 0) {
+        Slcan_ExecuteCommand();
+      }
+      Slcan_CommandLength = 0;
+      Slcan_CommandOverflow = 0;
+    } else if (c == '\n') {
+      /* ignored */
+    } else if (Slcan_CommandLength < SLCAN_COMMAND_MAX_SIZE) {
+      Slcan_Command[Slcan_CommandLength++] = c;
+    } else {
+      Slcan_CommandOverflow = 1;
+    }
+  }
+}
+
+/**
+ * @brief Encode all queued frames to the TX buffer
+ */
+static void Slcan_ForwardFrames(void) {
+  char line[SLCAN_MAX_FRAME_LINE] = {0};
+#if (SLCAN_USE_MEM_POOL == 1u)
+  Slcan_Frame_t *pFrame = NULL;
+  void *const item = &pFrame;
+#else
+  Slcan_Frame_t frame = {0};
+  Slcan_Frame_t *const pFrame = &frame;
+  void *const item = &frame;
+#endif /* (SLCAN_USE_MEM_POOL == 1u) */
+  Slcan_Frame_t event_frame = {0};
+  Event_t *pEvent = NULL;
+  uint16_t len = 0;
+  uint32_t batch = 0;
+
+  while (xQueuePeek(Slcan_FrameQueueHandle, item, 0) == pdTRUE) {
+    if (Slcan_ChannelState != SLCAN_CHANNEL_CLOSED) {
+      len = Slcan_EncodeFrame(pFrame, line);
+      if (Slcan_Write(line, len) == 0) {
+        /* TX buffer full, frame stays queued until DMA catches up */
+        break;
+      }
+      batch++;
+    }
+
+    (void)xQueueReceive(Slcan_FrameQueueHandle, item, 0);
+#if (SLCAN_USE_MEM_POOL == 1u)
+    MemPool_Free(pFrame);
+#endif /* (SLCAN_USE_MEM_POOL == 1u) */
+  }
+
+  /* then the master node's events, released once encoded */
+  while (xQueuePeek(Slcan_EventQueueHandle, &pEvent, 0) == pdTRUE) {
+    if (Slcan_ChannelState != SLCAN_CHANNEL_CLOSED) {
+      event_frame.timestamp = (uint16_t)((pEvent->timestamp_us / 1000u) % SLCAN_TIMESTAMP_MODULO);
+      event_frame.std_id = pEvent->payload.frame.std_id;
+      event_frame.dlc = (pEvent->payload.frame.len > BXCAN_MAX_DATA_SIZE) ? BXCAN_MAX_DATA_SIZE : pEvent->payload.frame.len;
+      memcpy(event_frame.data, pEvent->payload.frame.data, event_frame.dlc);
+      len = Slcan_EncodeFrame(&event_frame, line);
+      if (Slcan_Write(line, len) == 0) {
+        break;
+      }
+      batch++;
+    }
+
+    (void)xQueueReceive(Slcan_EventQueueHandle, &pEvent, 0);
+    EventPool_Release(pEvent);
+  }
+
+  Slcan_Statistics.forwarded_frames += batch;
+  Slcan_WindowFrames += batch;
+  if (batch > Slcan_Statistics.max_batch) {
+    Slcan_Statistics.max_batch = batch;
+  }
+}
+
+/**
+ * @brief Copy pending trace records to the TX buffer, in blocks
+ */
+static void Slcan_ForwardTrace(void) {
+  uint16_t len = 0;
+
+  while (Slcan_TxFree() >= TRACE_BLOCK_SIZE) {
+    len = Trace_ReadBlock(Slcan_TraceBlock);
+    if (len == 0) {
+      break;
+    }
+
+    (void)Slcan_Write((const char *)Slcan_TraceBlock, len);
+  }
+}
+
+/**
+ * @brief Update forwarded frame rate at the end of each window
+ */
+static void Slcan_UpdateFrameRate(void) {
+  uint32_t now = HAL_GetTick();
+  uint32_t elapsed = now - Slcan_WindowStart;
+
+  if (elapsed < SLCAN_RATE_WINDOW_MS) {
+    return;
+  }
+
+  Slcan_Statistics.frame_rate = (Slcan_WindowFrames * 1000u) / elapsed;
+  if (Slcan_Statistics.frame_rate > Slcan_Statistics.max_frame_rate) {
+    Slcan_Statistics.max_frame_rate = Slcan_Statistics.frame_rate;
+  }
+
+  Slcan_WindowFrames = 0;
+  Slcan_WindowStart = now;
+}
+
+/**
+ * @brief SLCAN gateway task, woken by queued frames, received bytes and TX complete
+ *
+ * @param pvParam
+ */
+static void Slcan_TaskFunction(void *const pvParam) {
+  Slcan_WindowStart = HAL_GetTick();
+
+  while (1) {
+    (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(Trace_IsRunning() ? SLCAN_TRACE_FLUSH_MS : SLCAN_RATE_WINDOW_MS));
+
+    Slcan_ProcessRx();
+    Slcan_ForwardFrames();
+    Slcan_ForwardTrace();
+
+    taskENTER_CRITICAL();
+    Slcan_StartTransmit();
+    taskEXIT_CRITICAL();
+
+    Slcan_UpdateFrameRate();
+  }
+
+  (void)pvParam;
+}
+
+/* UART Callbacks --------------------------------------------------------- */
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+  BaseType_t xTaskWoken = pdFALSE;
+
+  if (huart->Instance != USART1) {
+    return;
+  }
+
+  Slcan_TxTail = (uint16_t)((Slcan_TxTail + Slcan_TxInFlight) % SLCAN_TX_BUFFER_SIZE);
+  Slcan_TxInFlight = 0;
+  Slcan_StartTransmit();
+
+  /* TX buffer space was released, frames may be waiting for it */
+  vTaskNotifyGiveFromISR(Slcan_TaskHandle, &xTaskWoken);
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+  BaseType_t xTaskWoken = pdFALSE;
+
+  if (huart->Instance != USART1) {
+    return;
+  }
+
+  /* Size is the DMA write position in the circular buffer */
+  Slcan_RxHead = (uint16_t)(Size % SLCAN_RX_BUFFER_SIZE);
+
+  vTaskNotifyGiveFromISR(Slcan_TaskHandle, &xTaskWoken);
+  portYIELD_FROM_ISR(xTaskWoken);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+  if (huart->Instance != USART1) {
+    return;
+  }
+
+  /* reception is aborted on errors, restart from the start of the buffer */
+  if (huart->RxState == HAL_UART_STATE_READY) {
+    Slcan_RxHead = 0;
+    Slcan_RxRestarted = 1;
+    (void)HAL_UARTEx_ReceiveToIdle_DMA(&huart1, Slcan_RxBuffer, SLCAN_RX_BUFFER_SIZE);
+  }
+
+  /* transmission is aborted as well, drop the chunk in flight */
+  if ((Slcan_TxInFlight != 0) && (huart->gState == HAL_UART_STATE_READY)) {
+    Slcan_TxTail = (uint16_t)((Slcan_TxTail + Slcan_TxInFlight) % SLCAN_TX_BUFFER_SIZE);
+    Slcan_TxInFlight = 0;
+    Slcan_StartTransmit();
+  }
+}
+
+/* Initialize -------------------------------------------------------------- */
+
+void Slcan_Initialize(void) {
+  memset(&Slcan_Statistics, 0x00, sizeof(Slcan_Statistics_t));
+  Slcan_ChannelState = SLCAN_CHANNEL_CLOSED;
+  Slcan_TimestampEnabled = 0;
+  Slcan_RxHead = 0;
+  Slcan_RxTail = 0;
+  Slcan_TxHead = 0;
+  Slcan_TxTail = 0;
+  Slcan_TxInFlight = 0;
+
+  /* initialize frame queue */
+  Slcan_FrameQueueHandle = xQueueCreateStatic(
+    SLCAN_FRAME_QUEUE_SIZE,
+    sizeof(Slcan_FrameQueueStorage[0]),
+    (uint8_t *)Slcan_FrameQueueStorage,
+    &Slcan_FrameQueue
+  );
+  vQueueSetQueueNumber(Slcan_FrameQueueHandle, TRACE_OBJECT_SLCAN);
+
+  Slcan_EventQueueHandle = xQueueCreateStatic(
+    SLCAN_EVENT_QUEUE_SIZE,
+    sizeof(Slcan_EventQueueStorage[0]),
+    (uint8_t *)Slcan_EventQueueStorage,
+    &Slcan_EventQueue
+  );
+  vQueueSetQueueNumber(Slcan_EventQueueHandle, TRACE_OBJECT_SLCAN);
+
+  /* initialize gateway task */
+  Slcan_TaskHandle = xTaskCreateStatic(
+    &Slcan_TaskFunction,
+    "SlcanTask",
+    SLCAN_TASK_STACK_DEPTH,
+    NULL,
+    SLCAN_TASK_PRIORITY,
+    Slcan_TaskStack,   /* stack buffer (StackType_t *)  */
+    &Slcan_TaskBuffer  /* task buffer (StaticTask_t *) */
+  );
+
+  /* start receiving host commands */
+  configASSERT(HAL_UARTEx_ReceiveToIdle_DMA(&huart1, Slcan_RxBuffer, SLCAN_RX_BUFFER_SIZE) == HAL_OK);
+
+  bxCAN_SetMonitorCallback(Slcan_MonitorCallback);
+  configASSERT(MasterNode_SubscribeFrames(Slcan_FrameSubscriber) == 1u);
+}
+
+void Slcan_GetStatistics(Slcan_Statistics_t *const statistics) {
+  taskENTER_CRITICAL();
+  memcpy(statistics, &Slcan_Statistics, sizeof(Slcan_Statistics_t));
+  taskEXIT_CRITICAL();
+}
@@ -22,6 +22,9 @@
 #include "stm32f1xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "runtime_stats.h"
+#include "timebase.h"
+#include "tx_scheduler.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -56,6 +59,9 @@
 
 /* External variables --------------------------------------------------------*/
 extern CAN_HandleTypeDef hcan;
+extern DMA_HandleTypeDef hdma_usart1_rx;
+extern DMA_HandleTypeDef hdma_usart1_tx;
+extern UART_HandleTypeDef huart1;
 extern TIM_HandleTypeDef htim1;
 
 /* USER CODE BEGIN EV */
@@ -160,17 +166,45 @@ void DebugMon_Handler(void)
 /* please refer to the startup file (startup_stm32f1xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles DMA1 channel4 global interrupt.
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 channel5 global interrupt.
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel5_IRQn 0 */
+
+  /* USER CODE END DMA1_Channel5_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  /* USER CODE BEGIN DMA1_Channel5_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel5_IRQn 1 */
+}
+
 /**
   * @brief This function handles USB high priority or CAN TX interrupts.
   */
 void USB_HP_CAN1_TX_IRQHandler(void)
 {
   /* USER CODE BEGIN USB_HP_CAN1_TX_IRQn 0 */
-
+  const uint32_t start = RuntimeStats_IsrEnter(RUNTIME_STATS_ISR_CAN_TX);
   /* USER CODE END USB_HP_CAN1_TX_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN USB_HP_CAN1_TX_IRQn 1 */
-
+  RuntimeStats_IsrExit(RUNTIME_STATS_ISR_CAN_TX, start);
   /* USER CODE END USB_HP_CAN1_TX_IRQn 1 */
 }
 
@@ -180,25 +214,39 @@ void USB_HP_CAN1_TX_IRQHandler(void)
 void USB_LP_CAN1_RX0_IRQHandler(void)
 {
   /* USER CODE BEGIN USB_LP_CAN1_RX0_IRQn 0 */
-
+  const uint32_t start = RuntimeStats_IsrEnter(RUNTIME_STATS_ISR_CAN_RX0);
   /* USER CODE END USB_LP_CAN1_RX0_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN USB_LP_CAN1_RX0_IRQn 1 */
-
+  RuntimeStats_IsrExit(RUNTIME_STATS_ISR_CAN_RX0, start);
   /* USER CODE END USB_LP_CAN1_RX0_IRQn 1 */
 }
 
+/**
+  * @brief This function handles CAN RX1 interrupt.
+  */
+void CAN1_RX1_IRQHandler(void)
+{
+  /* USER CODE BEGIN CAN1_RX1_IRQn 0 */
+  const uint32_t start = RuntimeStats_IsrEnter(RUNTIME_STATS_ISR_CAN_RX1);
+  /* USER CODE END CAN1_RX1_IRQn 0 */
+  HAL_CAN_IRQHandler(&hcan);
+  /* USER CODE BEGIN CAN1_RX1_IRQn 1 */
+  RuntimeStats_IsrExit(RUNTIME_STATS_ISR_CAN_RX1, start);
+  /* USER CODE END CAN1_RX1_IRQn 1 */
+}
+
 /**
   * @brief This function handles CAN SCE interrupt.
   */
 void CAN1_SCE_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN1_SCE_IRQn 0 */
-
+  const uint32_t start = RuntimeStats_IsrEnter(RUNTIME_STATS_ISR_CAN_SCE);
   /* USER CODE END CAN1_SCE_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN CAN1_SCE_IRQn 1 */
-
+  RuntimeStats_IsrExit(RUNTIME_STATS_ISR_CAN_SCE, start);
   /* USER CODE END CAN1_SCE_IRQn 1 */
 }
 
@@ -208,14 +256,44 @@ void CAN1_SCE_IRQHandler(void)
 void TIM1_UP_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_UP_IRQn 0 */
-
+  const uint32_t start = RuntimeStats_IsrEnter(RUNTIME_STATS_ISR_TIM1);
+  /* TIM1 counts microseconds from the update event */
+  RuntimeStats_IsrLatency(RUNTIME_STATS_ISR_TIM1, __HAL_TIM_GET_COUNTER(&htim1) * (SystemCoreClock / 1000000u));
+  /* update flag and HAL tick in one step, HAL_TIM_IRQHandler() finds the flag cleared */
+  Timebase_TickHandler();
   /* USER CODE END TIM1_UP_IRQn 0 */
   HAL_TIM_IRQHandler(&htim1);
   /* USER CODE BEGIN TIM1_UP_IRQn 1 */
-
+  RuntimeStats_IsrExit(RUNTIME_STATS_ISR_TIM1, start);
   /* USER CODE END TIM1_UP_IRQn 1 */
 }
 
+/**
+  * @brief This function handles USART1 global interrupt.
+  */
+void USART1_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART1_IRQn 0 */
+
+  /* USER CODE END USART1_IRQn 0 */
+  HAL_UART_IRQHandler(&huart1);
+  /* USER CODE BEGIN USART1_IRQn 1 */
+
+  /* USER CODE END USART1_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+  * @brief This function handles TIM2 global interrupt, the compare events
+  * of the TX scheduler (not configured in CubeMX, not handled by the HAL).
+  */
+void TIM2_IRQHandler(void)
+{
+  const uint32_t start = RuntimeStats_IsrEnter(RUNTIME_STATS_ISR_TIM2);
+  TxScheduler_IRQHandler();
+  RuntimeStats_IsrExit(RUNTIME_STATS_ISR_TIM2, start);
+}
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
 
 /* USER CODE END 1 */
@@ -0,0 +1,207 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "tickless.h"
+
+/* TIM1 is the HAL timebase, counting at 1 MHz with a 1 ms period */
+extern TIM_HandleTypeDef htim1;
+
+#define TICKLESS_US_PER_HAL_TICK  (1000u)
+
+static Tickless_Statistics_t Tickless_Statistics = {0};
+
+#if (configUSE_TICKLESS_IDLE == 2)
+
+/**
+ * @brief Stop the HAL tick for a sleep, interrupts disabled: the TIM1 update
+ * interrupt is disabled, the counter keeps running and wraps silently
+ *
+ * @return uint32_t TIM1 counter, the wraps after it are added back by Tickless_ResumeHalTick()
+ */
+static uint32_t Tickless_SuspendHalTick(void) {
+  uint32_t counter = 0;
+
+  HAL_SuspendTick();
+  counter = htim1.Instance->CNT;
+
+  /* a wrap not serviced yet can't wake the core, it's counted now if it
+   * happened before the counter was read (same check as Timebase_GetMicros()),
+   * later ones are counted at wake-up */
+  if (__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE) != RESET) {
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+    NVIC_ClearPendingIRQ(TIM1_UP_IRQn);
+    if (counter < (TICKLESS_US_PER_HAL_TICK / 2u)) {
+      uwTick += uwTickFreq;
+    }
+  }
+
+  return counter;
+}
+
+/**
+ * @brief Add the HAL ticks of a sleep and restart the HAL tick, interrupts
+ * disabled
+ *
+ * @param counter [in] TIM1 counter at Tickless_SuspendHalTick()
+ * @param elapsed_us [in] time since Tickless_SuspendHalTick(), measured with
+ * the SysTick (a few microseconds off, the counter gives the exact wraps)
+ */
+static void Tickless_ResumeHalTick(uint32_t counter, uint32_t elapsed_us) {
+  uint32_t now = 0;
+  uint32_t wraps = 0;
+
+  __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+  now = htim1.Instance->CNT;
+
+  wraps = (counter + elapsed_us + (TICKLESS_US_PER_HAL_TICK / 2u) - now) / TICKLESS_US_PER_HAL_TICK;
+  uwTick += wraps * uwTickFreq;
+
+  /* a wrap between the flag clear and the counter read is already counted */
+  if ((__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE) != RESET) && (now < (TICKLESS_US_PER_HAL_TICK / 2u))) {
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+  }
+
+  HAL_ResumeTick();
+}
+
+/**
+ * @brief Sleep with the kernel and HAL ticks stopped, called by the idle task
+ * with the scheduler suspended
+ *
+ * @param xExpectedIdleTime [in] ticks to the next kernel timeout
+ */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime) {
+  const uint32_t cycles_per_tick = configCPU_CLOCK_HZ / configTICK_RATE_HZ;
+  const uint32_t cycles_per_us = configCPU_CLOCK_HZ / 1000000u;
+  uint32_t remaining = 0;   /* cycles to the next tick at entry */
+  uint32_t reload = 0;
+  uint32_t stopped = 0;     /* cycles the SysTick was stopped before the sleep */
+  uint32_t start = 0;
+  uint32_t wake = 0;
+  uint32_t slept = 0;       /* SysTick cycles in the sleep */
+  uint32_t late = 0;        /* cycles since the expected wake-up, woken by the tick */
+  uint32_t elapsed = 0;     /* cycles since the SysTick was stopped at entry */
+  uint32_t passed = 0;      /* cycles since the start of the tick period at entry */
+  uint32_t ticks = 0;
+  uint32_t load = 0;
+  uint32_t exit_cycles = 0;
+  uint32_t hal_counter = 0;
+  uint32_t pending = 0;
+  uint64_t entry_us = 0;
+  int32_t error_us = 0;
+
+  if (xExpectedIdleTime > (SysTick_LOAD_RELOAD_Msk / cycles_per_tick)) {
+    xExpectedIdleTime = SysTick_LOAD_RELOAD_Msk / cycles_per_tick;
+  }
+
+  /* interrupts still wake the core, but they run once both ticks are corrected */
+  __disable_irq();
+  __DSB();
+  __ISB();
+
+  stopped = Timebase_GetCycles();
+  SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+  remaining = SysTick->VAL;
+
+  /* a tick that expired since the idle time was computed isn't in the kernel
+   * count yet, the sleep would be one tick too long */
+  if ((eTaskConfirmSleepModeStatus() == eAbortSleep) || ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0)) {
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    Tickless_Statistics.aborted++;
+    __enable_irq();
+    return;
+  }
+
+  entry_us = Timebase_GetMicros();
+  hal_counter = Tickless_SuspendHalTick();
+
+  /* wake-up on the tick boundary of the expected idle time, the SysTick
+   * stopped cycles are taken off */
+  reload = remaining + (cycles_per_tick * (xExpectedIdleTime - 1u));
+  stopped = Timebase_GetCycles() - stopped;
+  if (reload > (stopped + TICKLESS_MIN_LOAD_CYCLES)) {
+    reload -= stopped;
+  }
+
+  SysTick->LOAD = reload;
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+  start = Timebase_GetCycles();
+  __DSB();
+  __WFI();
+  __ISB();
+  wake = Timebase_GetCycles();
+
+  /* stopped without reading CTRL, which would clear COUNTFLAG */
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+  if ((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0) {
+    /* the SysTick reached 0 and reloaded, the tick interrupt is pending */
+    late = (reload + 1u) - SysTick->VAL;
+    slept = (reload + 1u) + late;
+    pending = 1;
+  } else {
+    slept = (reload + 1u) - SysTick->VAL;
+  }
+
+  Tickless_ResumeHalTick(hal_counter, (stopped + slept + (Timebase_GetCycles() - wake)) / cycles_per_us);
+
+  /* the kernel time restarts where the SysTick was stopped at entry, plus the
+   * measured time, the time stamp is taken right before the restart */
+  elapsed = stopped + slept + (Timebase_GetCycles() - wake);
+  error_us = (int32_t)(elapsed / cycles_per_us) - (int32_t)(Timebase_GetMicros() - entry_us);
+  passed = (cycles_per_tick - remaining) + elapsed;
+  ticks = passed / cycles_per_tick;
+  load = cycles_per_tick - (passed % cycles_per_tick);
+  if (load < TICKLESS_MIN_LOAD_CYCLES) {
+    ticks++;
+    load += cycles_per_tick;
+  }
+
+  SysTick->LOAD = load - 1u;
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+  /* the pending tick interrupt adds the last tick */
+  vTaskStepTick(((ticks - pending) > xExpectedIdleTime) ? xExpectedIdleTime : (ticks - pending));
+  SysTick->LOAD = cycles_per_tick - 1u;
+
+  exit_cycles = Timebase_GetCycles() - wake;
+
+  Tickless_Statistics.sleeps++;
+  Tickless_Statistics.interrupted += (pending == 0) ? 1u : 0u;
+  Tickless_Statistics.slept_ticks += ticks;
+  Tickless_Statistics.last_error_us = error_us;
+  if (ticks >= Tickless_Statistics.max_sleep_ticks) {
+    Tickless_Statistics.max_sleep_ticks = ticks;
+    Tickless_Statistics.long_sleep_error_us = error_us;
+  }
+  if ((uint32_t)((error_us < 0) ? -error_us : error_us) > Tickless_Statistics.max_error_us) {
+    Tickless_Statistics.max_error_us = (uint32_t)((error_us < 0) ? -error_us : error_us);
+  }
+  if (pending != 0) {
+    Tickless_Statistics.last_wakeup_cycles = late + exit_cycles;
+    if (Tickless_Statistics.last_wakeup_cycles > Tickless_Statistics.max_wakeup_cycles) {
+      Tickless_Statistics.max_wakeup_cycles = Tickless_Statistics.last_wakeup_cycles;
+    }
+  }
+  if (exit_cycles > Tickless_Statistics.max_exit_cycles) {
+    Tickless_Statistics.max_exit_cycles = exit_cycles;
+  }
+
+  /* the cycle counter stops with the core clock, the sleep is added back */
+  if (slept > (wake - start)) {
+    Timebase_AddSleepCycles(slept - (wake - start));
+  }
+
+  __enable_irq();
+}
+
+#endif /* (configUSE_TICKLESS_IDLE == 2) */
+
+void Tickless_GetStatistics(Tickless_Statistics_t *const statistics) {
+  taskENTER_CRITICAL();
+  memcpy(statistics, &Tickless_Statistics, sizeof(Tickless_Statistics_t));
+  taskEXIT_CRITICAL();
+}
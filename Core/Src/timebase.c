@@ -0,0 +1,61 @@
+#include "main.h"
+#include "timebase.h"
+
+/* TIM1 is the HAL timebase, counting at 1 MHz with a 1 ms period */
+extern TIM_HandleTypeDef htim1;
+
+#define TIMEBASE_US_PER_TICK  (1000u)
+
+/* cycles the DWT counter missed while the core was sleeping (tickless idle) */
+static volatile uint32_t Timebase_SleepCycles = 0;
+
+void Timebase_Initialize(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void Timebase_TickHandler(void) {
+  uint32_t primask = __get_PRIMASK();
+
+  /* HAL_TIM_IRQHandler() clears the update flag before HAL_IncTick(), an ISR
+   * preempting it in between would read the old tick with the flag cleared */
+  __disable_irq();
+
+  if (__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE) != RESET) {
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+    HAL_IncTick();
+  }
+
+  __set_PRIMASK(primask);
+}
+
+uint64_t Timebase_GetMicros(void) {
+  uint32_t primask = __get_PRIMASK();
+  uint32_t ticks = 0;
+  uint32_t counter = 0;
+
+  __disable_irq();
+
+  ticks = HAL_GetTick();
+  counter = htim1.Instance->CNT;
+
+  /* TIM1 wrapped, but the update interrupt was not serviced yet (masked, or
+   * called from an ISR with a higher priority than the tick). The counter
+   * check rejects the case where the wrap happened right after it was read */
+  if ((__HAL_TIM_GET_FLAG(&htim1, TIM_FLAG_UPDATE) != RESET) && (counter < (TIMEBASE_US_PER_TICK / 2u))) {
+    ticks++;
+  }
+
+  __set_PRIMASK(primask);
+
+  return ((uint64_t)ticks * TIMEBASE_US_PER_TICK) + counter;
+}
+
+uint32_t Timebase_GetCycles(void) {
+  return DWT->CYCCNT + Timebase_SleepCycles;
+}
+
+void Timebase_AddSleepCycles(uint32_t cycles) {
+  Timebase_SleepCycles += cycles;
+}
@@ -0,0 +1,205 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "trace.h"
+
+#define TRACE_NAME_PART_SIZE      (4u)    /* name characters per TRACE_EVENT_TASK_NAME record */
+
+/**
+ * @brief Task name, recorded at task creation, sent at start
+ */
+typedef struct {
+  const char *name;               /* name in the task control block */
+  uint8_t number;
+} Trace_TaskName_t;
+
+/* ring buffer, indexes run freely, records head - tail are pending. Records
+ * are never overwritten: the writer drops them when the ring is full, so the
+ * reader copies without locking */
+static Trace_Record_t Trace_Buffer[TRACE_BUFFER_RECORDS] = {0};
+static volatile uint32_t Trace_Head = 0;
+static volatile uint32_t Trace_Tail = 0;
+static uint32_t Trace_Lost = 0;
+static volatile uint8_t Trace_Running = 0;
+
+static Trace_TaskName_t Trace_TaskNames[TRACE_TASK_NAMES] = {0};
+static uint8_t Trace_TaskCount = 0;
+
+/* record cost */
+static Trace_Statistics_t Trace_Statistics = {0};
+static uint64_t Trace_TotalCycles = 0;
+
+/**
+ * @brief Append a record, interrupts masked
+ */
+static inline void Trace_Append(uint32_t timestamp, uint8_t type, uint8_t arg8, uint16_t arg16) {
+  Trace_Record_t *const record = &Trace_Buffer[Trace_Head % TRACE_BUFFER_RECORDS];
+
+  record->timestamp = timestamp;
+  record->type = type;
+  record->arg8 = arg8;
+  record->arg16 = arg16;
+  Trace_Head++;
+}
+
+/**
+ * @brief Write a record, from tasks, kernel hooks and interrupts up to
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY. Ignored while not recording
+ *
+ * @param type [in] Trace_Event_t
+ * @param arg8 [in] 8 bit argument
+ * @param arg16 [in] 16 bit argument
+ */
+void Trace_Record(uint8_t type, uint8_t arg8, uint16_t arg16) {
+  uint32_t start = 0;
+  uint32_t cycles = 0;
+  uint32_t free = 0;
+  UBaseType_t saved_mask = 0;
+
+  if (Trace_Running == 0) {
+    return;
+  }
+
+  start = Timebase_GetCycles();
+  saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  free = TRACE_BUFFER_RECORDS - (Trace_Head - Trace_Tail);
+
+  /* report the records dropped since the ring was full, before the next one */
+  if ((Trace_Lost > 0) && (free >= 2u)) {
+    Trace_Append(start, TRACE_EVENT_OVERFLOW, 0, (uint16_t)((Trace_Lost > UINT16_MAX) ? UINT16_MAX : Trace_Lost));
+    Trace_Lost = 0;
+    free--;
+  }
+
+  if ((Trace_Lost > 0) || (free == 0)) {
+    Trace_Lost++;
+    Trace_Statistics.dropped++;
+  } else {
+    Trace_Append(start, type, arg8, arg16);
+  }
+
+  cycles = Timebase_GetCycles() - start;
+  Trace_Statistics.records++;
+  Trace_TotalCycles += cycles;
+  if (cycles > Trace_Statistics.max_cycles) {
+    Trace_Statistics.max_cycles = cycles;
+  }
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
+
+/**
+ * @brief Keep the name of a created task, called by traceTASK_CREATE
+ *
+ * @param number [in] task number
+ * @param name [in] name in the task control block (static allocation, stays valid)
+ */
+void Trace_TaskCreated(uint8_t number, const char *const name) {
+  if (Trace_TaskCount >= TRACE_TASK_NAMES) {
+    return;
+  }
+
+  Trace_TaskNames[Trace_TaskCount].name = name;
+  Trace_TaskNames[Trace_TaskCount].number = number;
+  Trace_TaskCount++;
+}
+
+/**
+ * @brief Start recording, from the task that reads the records: pending
+ * records are discarded, the clock and the task names are recorded first
+ */
+void Trace_Start(void) {
+  uint32_t part = 0;
+
+  taskENTER_CRITICAL();
+  Trace_Running = 0;
+  Trace_Head = 0;
+  Trace_Tail = 0;
+  Trace_Lost = 0;
+  memset(&Trace_Statistics, 0x00, sizeof(Trace_Statistics_t));
+  Trace_TotalCycles = 0;
+  Trace_Running = 1;
+  taskEXIT_CRITICAL();
+
+  Trace_Record(TRACE_EVENT_START, 0, (uint16_t)(SystemCoreClock / 1000u));
+
+  /* the time stamp field carries the name characters */
+  for (uint8_t task = 0; task < Trace_TaskCount; task++) {
+    const char *const name = Trace_TaskNames[task].name;
+
+    for (uint16_t offset = 0; (offset < configMAX_TASK_NAME_LEN) && (name[offset] != '\0'); offset += TRACE_NAME_PART_SIZE) {
+      part = 0;
+      for (uint16_t i = 0; (i < TRACE_NAME_PART_SIZE) && ((offset + i) < configMAX_TASK_NAME_LEN) && (name[offset + i] != '\0'); i++) {
+        part |= (uint32_t)(uint8_t)name[offset + i] << (8u * i);
+      }
+
+      taskENTER_CRITICAL();
+      if ((TRACE_BUFFER_RECORDS - (Trace_Head - Trace_Tail)) > 0) {
+        Trace_Append(part, TRACE_EVENT_TASK_NAME, Trace_TaskNames[task].number, (uint16_t)(offset / TRACE_NAME_PART_SIZE));
+      }
+      taskEXIT_CRITICAL();
+    }
+  }
+}
+
+void Trace_Stop(void) {
+  Trace_Running = 0;
+}
+
+uint8_t Trace_IsRunning(void) {
+  return Trace_Running;
+}
+
+/**
+ * @brief Take the oldest pending records as a block for the host (layout in
+ * trace.h), from a single reader task
+ *
+ * @param block [out] block, at least TRACE_BLOCK_SIZE bytes
+ * @return uint16_t block length, 0: no pending records
+ */
+uint16_t Trace_ReadBlock(uint8_t *const block) {
+  Trace_Statistics_t statistics = {0};
+  uint32_t count = Trace_Head - Trace_Tail;
+  uint32_t average = 0;
+
+  if (count == 0) {
+    return 0;
+  }
+  if (count > TRACE_BLOCK_RECORDS) {
+    count = TRACE_BLOCK_RECORDS;
+  }
+
+  Trace_GetStatistics(&statistics);
+  average = statistics.avg_cycles;
+
+  block[0] = (uint8_t)TRACE_BLOCK_MAGIC;
+  block[1] = (uint8_t)(TRACE_BLOCK_MAGIC >> 8);
+  block[2] = (uint8_t)count;
+  block[3] = (statistics.dropped != 0) ? TRACE_BLOCK_FLAG_DROPPED : 0u;
+  block[4] = (uint8_t)((average > UINT16_MAX) ? UINT16_MAX : average);
+  block[5] = (uint8_t)(((average > UINT16_MAX) ? UINT16_MAX : average) >> 8);
+  block[6] = (uint8_t)((statistics.max_cycles > UINT16_MAX) ? UINT16_MAX : statistics.max_cycles);
+  block[7] = (uint8_t)(((statistics.max_cycles > UINT16_MAX) ? UINT16_MAX : statistics.max_cycles) >> 8);
+
+  /* records are little endian in memory (Cortex-M3), they're sent as is */
+  for (uint32_t i = 0; i < count; i++) {
+    memcpy(&block[TRACE_BLOCK_HEADER_SIZE + (i * sizeof(Trace_Record_t))],
+      &Trace_Buffer[(Trace_Tail + i) % TRACE_BUFFER_RECORDS], sizeof(Trace_Record_t));
+  }
+
+  /* slots are given back to the writers once copied */
+  Trace_Tail += count;
+
+  return (uint16_t)(TRACE_BLOCK_HEADER_SIZE + (count * sizeof(Trace_Record_t)));
+}
+
+void Trace_GetStatistics(Trace_Statistics_t *const statistics) {
+  UBaseType_t saved_mask = taskENTER_CRITICAL_FROM_ISR();
+
+  memcpy(statistics, &Trace_Statistics, sizeof(Trace_Statistics_t));
+  statistics->avg_cycles = (statistics->records != 0) ? (uint32_t)(Trace_TotalCycles / statistics->records) : 0;
+
+  taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+}
@@ -0,0 +1,258 @@
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "timebase.h"
+#include "runtime_stats.h"
+#include "tx_scheduler.h"
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+/**
+ * @brief Slot of the schedule table
+ */
+typedef struct {
+  TxScheduler_Frame_t frame;
+  uint8_t has_frame;                      /* 0: the release only calls the callback */
+  volatile uint8_t armed;
+  uint64_t release_us;                    /* release time, Timebase_GetMicros() */
+  uint32_t remaining_us;                  /* left to the release after the current compare value */
+  uint16_t release_counter;               /* TIM2 counter at the release */
+  bxCAN_TxCompleteCallback_t tx_callback;
+  TxScheduler_Callback_t callback;
+  TxScheduler_Statistics_t statistics;
+} TxScheduler_Entry_t;
+
+TIM_HandleTypeDef htim2;
+
+static TxScheduler_Entry_t TxScheduler_Entries[TX_SCHEDULER_SLOT_NUMBER] = {0};
+
+/**
+ * @brief Compare register of a slot
+ */
+static inline volatile uint32_t *TxScheduler_Compare(TxScheduler_Slot_t slot) {
+  return &TIM2->CCR1 + slot;
+}
+
+/**
+ * @brief Set the next compare value of a slot, one hop from a counter value.
+ * A value the counter already passed would match only after a wrap, its
+ * event is generated at once
+ *
+ * @param slot [in] slot
+ * @param from [in] counter value the hop starts from
+ */
+static void TxScheduler_SetCompare(TxScheduler_Slot_t slot, uint32_t from) {
+  TxScheduler_Entry_t *const entry = &TxScheduler_Entries[slot];
+  volatile uint32_t *const compare = TxScheduler_Compare(slot);
+  uint32_t step = (entry->remaining_us < TX_SCHEDULER_MAX_HOP_US) ? entry->remaining_us : TX_SCHEDULER_MAX_HOP_US;
+
+  entry->remaining_us -= step;
+  *compare = (from + step) & 0xFFFFu;
+
+  if ((uint16_t)(__HAL_TIM_GET_COUNTER(&htim2) - *compare) < TX_SCHEDULER_MAX_HOP_US) {
+    TIM2->EGR = (TIM_EGR_CC1G << slot);
+  }
+}
+
+/**
+ * @brief Compare event of a slot, from the TIM2 interrupt: next hop, or
+ * release the frame
+ *
+ * @param slot [in] slot
+ */
+static void TxScheduler_Service(TxScheduler_Slot_t slot) {
+  TxScheduler_Entry_t *const entry = &TxScheduler_Entries[slot];
+  TxScheduler_Statistics_t *const statistics = &entry->statistics;
+  uint32_t delay_us = 0;
+
+  if (entry->remaining_us > 0) {
+    TxScheduler_SetCompare(slot, *TxScheduler_Compare(slot));
+    return;
+  }
+
+  /* the previous scheduled frame (any slot) is still waiting for the bus */
+  if ((entry->has_frame != 0)
+      && (bxCAN_TransmitScheduled(entry->frame.data, entry->frame.len, entry->frame.std_id, entry->tx_callback) != HAL_OK)) {
+    statistics->busy++;
+    entry->remaining_us = TX_SCHEDULER_RETRY_US;
+    TxScheduler_SetCompare(slot, __HAL_TIM_GET_COUNTER(&htim2));
+    return;
+  }
+
+  __HAL_TIM_DISABLE_IT(&htim2, (TIM_IT_CC1 << slot));
+  entry->armed = 0;
+
+  delay_us = (uint16_t)(__HAL_TIM_GET_COUNTER(&htim2) - entry->release_counter);
+  statistics->released++;
+  statistics->last_delay_us = delay_us;
+  if (delay_us > statistics->max_delay_us) {
+    statistics->max_delay_us = delay_us;
+  }
+
+  entry->callback(entry->release_us);
+}
+
+/**
+ * @brief Start TIM2, free running at 1 MHz. APB1 isn't divided, TIM2 runs
+ * from PCLK1
+ */
+void TxScheduler_Initialize(void) {
+  memset(TxScheduler_Entries, 0x00, sizeof(TxScheduler_Entries));
+
+  __HAL_RCC_TIM2_CLK_ENABLE();
+
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = (HAL_RCC_GetPCLK1Freq() / 1000000u) - 1u;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 0xFFFFu;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim2) != HAL_OK) {
+    Error_Handler();
+  }
+
+  /* compare channels are frozen outputs, only their flags are used */
+  HAL_NVIC_SetPriority(TIM2_IRQn, TX_SCHEDULER_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+  if (HAL_TIM_Base_Start(&htim2) != HAL_OK) {
+    Error_Handler();
+  }
+}
+
+/**
+ * @brief Arm a slot, from a task. The frame is copied, the slot must not be
+ * armed (released or cancelled since the last arm)
+ *
+ * @param slot [in] slot
+ * @param release_us [in] release time (Timebase_GetMicros()), in the past: released at once
+ * @param frame [in] frame to load into the scheduled mailbox, NULL: none, only the callback is called
+ * @param tx_callback [in] TX complete callback of the frame, NULL: none
+ * @param callback [in] called from the TIM2 interrupt after the release
+ */
+void TxScheduler_Arm(TxScheduler_Slot_t slot, uint64_t release_us, const TxScheduler_Frame_t *const frame,
+  bxCAN_TxCompleteCallback_t tx_callback, TxScheduler_Callback_t callback) {
+  TxScheduler_Entry_t *const entry = &TxScheduler_Entries[slot];
+  uint64_t now_us = 0;
+  uint32_t counter = 0;
+
+  configASSERT((slot < TX_SCHEDULER_SLOT_NUMBER) && (callback != NULL));
+
+  taskENTER_CRITICAL();
+  configASSERT(entry->armed == 0);
+
+  entry->has_frame = (frame != NULL) ? 1 : 0;
+  if (frame != NULL) {
+    configASSERT(frame->len <= BXCAN_MAX_DATA_SIZE);
+    memcpy(&entry->frame, frame, sizeof(TxScheduler_Frame_t));
+  }
+  entry->tx_callback = tx_callback;
+  entry->callback = callback;
+  entry->release_us = release_us;
+
+  /* TIM2 and the timebase count the same microseconds, the release is
+   * placed relative to both read together */
+  now_us = Timebase_GetMicros();
+  counter = __HAL_TIM_GET_COUNTER(&htim2);
+  if (release_us > now_us) {
+    entry->remaining_us = (uint32_t)(release_us - now_us);
+  } else {
+    entry->remaining_us = 0;
+    entry->statistics.late++;
+  }
+  entry->release_counter = (uint16_t)(counter + entry->remaining_us);
+
+  __HAL_TIM_CLEAR_FLAG(&htim2, (TIM_FLAG_CC1 << slot));
+  TxScheduler_SetCompare(slot, counter);
+  entry->armed = 1;
+  __HAL_TIM_ENABLE_IT(&htim2, (TIM_IT_CC1 << slot));
+
+  taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Call the callback of a slot again TX_SCHEDULER_RETRY_US later, from
+ * that callback (TIM2 interrupt), when it couldn't complete the release. The
+ * frame was loaded already, the retry only calls the callback, with the same
+ * release time
+ *
+ * @param slot [in] slot, released
+ */
+void TxScheduler_RetryFromISR(TxScheduler_Slot_t slot) {
+  TxScheduler_Entry_t *const entry = &TxScheduler_Entries[slot];
+
+  configASSERT((slot < TX_SCHEDULER_SLOT_NUMBER) && (entry->armed == 0));
+
+  /* the release counter is kept, the retry adds to the release delay */
+  entry->has_frame = 0;
+  entry->remaining_us = TX_SCHEDULER_RETRY_US;
+  entry->statistics.retried++;
+
+  __HAL_TIM_CLEAR_FLAG(&htim2, (TIM_FLAG_CC1 << slot));
+  TxScheduler_SetCompare(slot, __HAL_TIM_GET_COUNTER(&htim2));
+  entry->armed = 1;
+  __HAL_TIM_ENABLE_IT(&htim2, (TIM_IT_CC1 << slot));
+}
+
+/**
+ * @brief Cancel an armed slot, from a task
+ *
+ * @param slot [in] slot
+ * @return uint8_t 1: cancelled before its release, 0: not armed (released already)
+ */
+uint8_t TxScheduler_Cancel(TxScheduler_Slot_t slot) {
+  TxScheduler_Entry_t *const entry = &TxScheduler_Entries[slot];
+  uint8_t cancelled = 0;
+
+  configASSERT(slot < TX_SCHEDULER_SLOT_NUMBER);
+
+  taskENTER_CRITICAL();
+  if (entry->armed != 0) {
+    __HAL_TIM_DISABLE_IT(&htim2, (TIM_IT_CC1 << slot));
+    __HAL_TIM_CLEAR_FLAG(&htim2, (TIM_FLAG_CC1 << slot));
+    entry->armed = 0;
+    entry->statistics.cancelled++;
+    cancelled = 1;
+  }
+  taskEXIT_CRITICAL();
+
+  return cancelled;
+}
+
+/**
+ * @brief TIM2 interrupt: compare events of the armed slots. The latency of
+ * each event (compare match to handler) is accounted in the run time
+ * statistics, the counter gives the match time
+ */
+void TxScheduler_IRQHandler(void) {
+  const uint32_t pending = TIM2->SR & TIM2->DIER;
+
+  for (uint32_t slot = 0; slot < TX_SCHEDULER_SLOT_NUMBER; slot++) {
+    if ((pending & (TIM_FLAG_CC1 << slot)) == 0) {
+      continue;
+    }
+
+    __HAL_TIM_CLEAR_FLAG(&htim2, (TIM_FLAG_CC1 << slot));
+    RuntimeStats_IsrLatency(RUNTIME_STATS_ISR_TIM2,
+      (uint16_t)(__HAL_TIM_GET_COUNTER(&htim2) - *TxScheduler_Compare((TxScheduler_Slot_t)slot)) * (SystemCoreClock / 1000000u));
+    TxScheduler_Service((TxScheduler_Slot_t)slot);
+  }
+}
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+
+/**
+ * @brief Get the statistics of a slot
+ *
+ * @param slot [in] slot
+ * @param statistics [out] slot statistics, all 0 without the TX scheduler
+ */
+void TxScheduler_GetStatistics(TxScheduler_Slot_t slot, TxScheduler_Statistics_t *const statistics) {
+  configASSERT(slot < TX_SCHEDULER_SLOT_NUMBER);
+
+#if (BXCAN_USE_TX_SCHEDULER == 1u)
+  taskENTER_CRITICAL();
+  memcpy(statistics, &TxScheduler_Entries[slot].statistics, sizeof(TxScheduler_Statistics_t));
+  taskEXIT_CRITICAL();
+#else
+  memset(statistics, 0x00, sizeof(TxScheduler_Statistics_t));
+#endif /* (BXCAN_USE_TX_SCHEDULER == 1u) */
+}
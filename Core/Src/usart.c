@@ -25,6 +25,8 @@
 /* USER CODE END 0 */
 
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
 
 /* USART1 init function */
 
@@ -38,7 +40,7 @@ void MX_USART1_UART_Init(void) {
 
   /* USER CODE END USART1_Init 1 */
   huart1.Instance = USART1;
-  huart1.Init.BaudRate = 115200;
+  huart1.Init.BaudRate = USART1_BAUDRATE;
   huart1.Init.WordLength = UART_WORDLENGTH_8B;
   huart1.Init.StopBits = UART_STOPBITS_1;
   huart1.Init.Parity = UART_PARITY_NONE;
@@ -77,6 +79,40 @@ void HAL_UART_MspInit(UART_HandleTypeDef *uartHandle) {
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+  /* USART1 DMA Init */
+  /* USART1_RX Init */
+  hdma_usart1_rx.Instance = DMA1_Channel5;
+  hdma_usart1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_usart1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_usart1_rx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_usart1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;
+  hdma_usart1_rx.Init.Priority = DMA_PRIORITY_LOW;
+  if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK) {
+    Error_Handler();
+  }
+
+  __HAL_LINKDMA(uartHandle, hdmarx, hdma_usart1_rx);
+
+  /* USART1_TX Init */
+  hdma_usart1_tx.Instance = DMA1_Channel4;
+  hdma_usart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_usart1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_usart1_tx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_usart1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_usart1_tx.Init.Mode = DMA_NORMAL;
+  hdma_usart1_tx.Init.Priority = DMA_PRIORITY_LOW;
+  if (HAL_DMA_Init(&hdma_usart1_tx) != HAL_OK) {
+    Error_Handler();
+  }
+
+  __HAL_LINKDMA(uartHandle, hdmatx, hdma_usart1_tx);
+
+  /* USART1 interrupt Init */
+  HAL_NVIC_SetPriority(USART1_IRQn, 6, 0);
+  HAL_NVIC_EnableIRQ(USART1_IRQn);
   /* USER CODE BEGIN USART1_MspInit 1 */
 
   /* USER CODE END USART1_MspInit 1 */
@@ -96,6 +132,12 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef *uartHandle) {
   */
   HAL_GPIO_DeInit(GPIOA, GPIO_PIN_9 | GPIO_PIN_10);
 
+  /* USART1 DMA DeInit */
+  HAL_DMA_DeInit(uartHandle->hdmarx);
+  HAL_DMA_DeInit(uartHandle->hdmatx);
+
+  /* USART1 interrupt Deinit */
+  HAL_NVIC_DisableIRQ(USART1_IRQn);
   /* USER CODE BEGIN USART1_MspDeInit 1 */
 
   /* USER CODE END USART1_MspDeInit 1 */
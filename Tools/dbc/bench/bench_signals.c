@@ -0,0 +1,175 @@
+/*
+ * Generated pack/unpack functions vs a generic runtime bit-field decoder.
+ *
+ * build & run (host):
+ *    python3 Tools/dbc/dbc2c.py Tools/dbc/bench/bench.dbc -o Tools/dbc/bench/bench_signals.h
+ *    gcc -O2 -std=c99 -o bench_signals Tools/dbc/bench/bench_signals.c && ./bench_signals
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench_signals.h"
+
+#define BENCH_FRAMES      (4096u)
+#define BENCH_PASSES      (2000u)
+#define BENCH_SIGNALS     (7u)
+
+/**
+ * @brief Signal layout, as interpreted at run time by the generic decoder
+ */
+typedef struct {
+  uint8_t start;          /* DBC start bit */
+  uint8_t length;         /* signal length in bits */
+  uint8_t little_endian;  /* 1: Intel, 0: Motorola */
+  uint8_t is_signed;      /* 1: two's complement */
+} SignalLayout_t;
+
+static const SignalLayout_t IntelMixed_Layout[BENCH_SIGNALS] = {
+  {0, 1, 1, 0}, {1, 3, 1, 0}, {4, 12, 1, 1}, {16, 16, 1, 0}, {32, 4, 1, 0}, {36, 20, 1, 1}, {56, 8, 1, 0},
+};
+
+static const SignalLayout_t MotorolaMixed_Layout[BENCH_SIGNALS] = {
+  {7, 1, 0, 0}, {6, 3, 0, 0}, {3, 12, 0, 1}, {23, 16, 0, 0}, {39, 4, 0, 0}, {35, 20, 0, 1}, {63, 8, 0, 0},
+};
+
+static uint8_t Bench_Frames[BENCH_FRAMES][8];
+
+/**
+ * @brief Generic decoder, walks the signal bit by bit
+ */
+static int64_t Generic_Decode(const uint8_t *const data, const SignalLayout_t *const layout) {
+  uint64_t raw = 0;
+  uint32_t position = layout->start;
+
+  for (uint32_t i = 0; i < layout->length; i++) {
+    uint32_t bit = (data[position / 8u] >> (position % 8u)) & 1u;
+
+    if (layout->little_endian) {
+      raw |= (uint64_t)bit << i;
+      position++;
+    } else {
+      raw = (raw << 1) | bit;
+      position = ((position % 8u) == 0u) ? (position + 15u) : (position - 1u);
+    }
+  }
+
+  if (layout->is_signed && (layout->length < 64u) && (raw & (1ull << (layout->length - 1u)))) {
+    raw |= ~((1ull << layout->length) - 1u);
+  }
+
+  return (int64_t)raw;
+}
+
+static double Bench_Now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+static int Bench_Verify(void) {
+  for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+    const uint8_t *const data = Bench_Frames[f];
+    IntelMixed_Msg_t intel;
+    MotorolaMixed_Msg_t motorola;
+    uint8_t packed[8];
+    int64_t intel_values[BENCH_SIGNALS];
+    int64_t motorola_values[BENCH_SIGNALS];
+
+    IntelMixed_Unpack(data, &intel);
+    MotorolaMixed_Unpack(data, &motorola);
+
+    intel_values[0] = intel.flag; intel_values[1] = intel.mode; intel_values[2] = intel.temperature;
+    intel_values[3] = intel.speed; intel_values[4] = intel.counter; intel_values[5] = intel.torque;
+    intel_values[6] = intel.checksum;
+
+    motorola_values[0] = motorola.flag; motorola_values[1] = motorola.mode; motorola_values[2] = motorola.temperature;
+    motorola_values[3] = motorola.speed; motorola_values[4] = motorola.counter; motorola_values[5] = motorola.torque;
+    motorola_values[6] = motorola.checksum;
+
+    for (uint32_t s = 0; s < BENCH_SIGNALS; s++) {
+      if (intel_values[s] != Generic_Decode(data, &IntelMixed_Layout[s])) {
+        printf("IntelMixed signal %u mismatch in frame %u\n", s, f);
+        return 1;
+      }
+      if (motorola_values[s] != Generic_Decode(data, &MotorolaMixed_Layout[s])) {
+        printf("MotorolaMixed signal %u mismatch in frame %u\n", s, f);
+        return 1;
+      }
+    }
+
+    IntelMixed_Pack(&intel, packed);
+    if (memcmp(packed, data, sizeof(packed)) != 0) {
+      printf("IntelMixed pack mismatch in frame %u\n", f);
+      return 1;
+    }
+
+    MotorolaMixed_Pack(&motorola, packed);
+    if (memcmp(packed, data, sizeof(packed)) != 0) {
+      printf("MotorolaMixed pack mismatch in frame %u\n", f);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int main(void) {
+  volatile int64_t sink = 0;
+  double start = 0;
+  double generated_ns = 0;
+  double generic_ns = 0;
+
+  srand(1);
+  for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+    for (uint32_t b = 0; b < 8u; b++) {
+      Bench_Frames[f][b] = (uint8_t)rand();
+    }
+  }
+
+  if (Bench_Verify() != 0) {
+    return 1;
+  }
+
+  start = Bench_Now();
+  for (uint32_t p = 0; p < BENCH_PASSES; p++) {
+    int64_t acc = 0;
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+      IntelMixed_Msg_t intel;
+      MotorolaMixed_Msg_t motorola;
+      IntelMixed_Unpack(Bench_Frames[f], &intel);
+      MotorolaMixed_Unpack(Bench_Frames[f], &motorola);
+      acc += intel.temperature + intel.torque + intel.speed + intel.mode;
+      acc += motorola.temperature + motorola.torque + motorola.speed + motorola.mode;
+    }
+    sink += acc;
+  }
+  generated_ns = (Bench_Now() - start) * 1e9 / ((double)BENCH_PASSES * BENCH_FRAMES);
+
+  start = Bench_Now();
+  for (uint32_t p = 0; p < BENCH_PASSES; p++) {
+    int64_t acc = 0;
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+      for (uint32_t s = 0; s < BENCH_SIGNALS; s++) {
+        int64_t intel = Generic_Decode(Bench_Frames[f], &IntelMixed_Layout[s]);
+        int64_t motorola = Generic_Decode(Bench_Frames[f], &MotorolaMixed_Layout[s]);
+        if ((s == 1u) || (s == 2u) || (s == 3u) || (s == 5u)) {
+          acc += intel + motorola;
+        }
+      }
+    }
+    sink += acc;
+  }
+  generic_ns = (Bench_Now() - start) * 1e9 / ((double)BENCH_PASSES * BENCH_FRAMES);
+
+  printf("frames: %u x %u passes, 2 messages x %u signals per frame\n", BENCH_FRAMES, BENCH_PASSES, BENCH_SIGNALS);
+  printf("generated unpack : %8.2f ns/frame\n", generated_ns);
+  printf("generic decoder  : %8.2f ns/frame\n", generic_ns);
+  printf("speedup          : %8.2fx\n", generic_ns / generated_ns);
+
+  (void)sink;
+  return 0;
+}
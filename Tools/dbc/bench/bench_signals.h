@@ -0,0 +1,131 @@
+/* generated by Tools/dbc/dbc2c.py from bench.dbc, do not edit */
+#ifndef _BENCH_SIGNALS_H_
+#define _BENCH_SIGNALS_H_
+
+#include <stdint.h>
+
+/* IntelMixed: ID 0x100, DLC 8, sender Bench */
+#define INTEL_MIXED_FRAME_ID              (0x100u)
+#define INTEL_MIXED_FRAME_DLC             (8u)
+
+typedef struct {
+  uint8_t flag; /* 0|1@1+ [0|1] */
+  uint8_t mode; /* 1|3@1+ [0|7] */
+  int16_t temperature; /* 4|12@1- [-244.8|164.7] degC */
+  uint16_t speed; /* 16|16@1+ [0|655.35] km/h */
+  uint8_t counter; /* 32|4@1+ [0|15] */
+  int32_t torque; /* 36|20@1- [-262144|262143.5] Nm */
+  uint8_t checksum; /* 56|8@1+ [0|255] */
+} IntelMixed_Msg_t;
+
+static inline void IntelMixed_Pack(const IntelMixed_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)((msg->flag & 0x01u) | ((msg->mode & 0x07u) << 1u) | (((uint16_t)msg->temperature & 0x0Fu) << 4u));
+  data[1] = (uint8_t)(((uint16_t)msg->temperature >> 4u) & 0xFFu);
+  data[2] = (uint8_t)(msg->speed & 0xFFu);
+  data[3] = (uint8_t)((msg->speed >> 8u) & 0xFFu);
+  data[4] = (uint8_t)((msg->counter & 0x0Fu) | (((uint32_t)msg->torque & 0x0Fu) << 4u));
+  data[5] = (uint8_t)(((uint32_t)msg->torque >> 4u) & 0xFFu);
+  data[6] = (uint8_t)(((uint32_t)msg->torque >> 12u) & 0xFFu);
+  data[7] = (uint8_t)(msg->checksum & 0xFFu);
+}
+
+static inline void IntelMixed_Unpack(const uint8_t *const data, IntelMixed_Msg_t *const msg) {
+  msg->flag = (uint8_t)(data[0] & 0x01u);
+  msg->mode = (uint8_t)((data[0] >> 1u) & 0x07u);
+  msg->temperature = (int16_t)((((uint16_t)(data[0] >> 4u) | ((uint16_t)data[1] << 4u)) ^ 0x800u) - 0x800u);
+  msg->speed = (uint16_t)((uint16_t)data[2] | ((uint16_t)data[3] << 8u));
+  msg->counter = (uint8_t)(data[4] & 0x0Fu);
+  msg->torque = (int32_t)((((uint32_t)(data[4] >> 4u) | ((uint32_t)data[5] << 4u) | ((uint32_t)data[6] << 12u)) ^ 0x80000u) - 0x80000u);
+  msg->checksum = (uint8_t)data[7];
+}
+
+static inline float IntelMixed_temperature_ToPhys(int16_t raw) {
+  return ((float)raw * 0.1f) - 40.0f;
+}
+
+static inline int16_t IntelMixed_temperature_FromPhys(float phys) {
+  float raw = (phys + 40.0f) / 0.1f;
+  return (int16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float IntelMixed_speed_ToPhys(uint16_t raw) {
+  return (float)raw * 0.01f;
+}
+
+static inline uint16_t IntelMixed_speed_FromPhys(float phys) {
+  float raw = phys / 0.01f;
+  return (uint16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float IntelMixed_torque_ToPhys(int32_t raw) {
+  return (float)raw * 0.5f;
+}
+
+static inline int32_t IntelMixed_torque_FromPhys(float phys) {
+  float raw = phys / 0.5f;
+  return (int32_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+/* MotorolaMixed: ID 0x101, DLC 8, sender Bench */
+#define MOTOROLA_MIXED_FRAME_ID           (0x101u)
+#define MOTOROLA_MIXED_FRAME_DLC          (8u)
+
+typedef struct {
+  uint8_t flag; /* 7|1@0+ [0|1] */
+  uint8_t mode; /* 6|3@0+ [0|7] */
+  int16_t temperature; /* 3|12@0- [-244.8|164.7] degC */
+  uint16_t speed; /* 23|16@0+ [0|655.35] km/h */
+  uint8_t counter; /* 39|4@0+ [0|15] */
+  int32_t torque; /* 35|20@0- [-262144|262143.5] Nm */
+  uint8_t checksum; /* 63|8@0+ [0|255] */
+} MotorolaMixed_Msg_t;
+
+static inline void MotorolaMixed_Pack(const MotorolaMixed_Msg_t *const msg, uint8_t *const data) {
+  data[0] = (uint8_t)(((msg->flag & 0x01u) << 7u) | ((msg->mode & 0x07u) << 4u) | (((uint16_t)msg->temperature >> 8u) & 0x0Fu));
+  data[1] = (uint8_t)((uint16_t)msg->temperature & 0xFFu);
+  data[2] = (uint8_t)((msg->speed >> 8u) & 0xFFu);
+  data[3] = (uint8_t)(msg->speed & 0xFFu);
+  data[4] = (uint8_t)(((msg->counter & 0x0Fu) << 4u) | (((uint32_t)msg->torque >> 16u) & 0x0Fu));
+  data[5] = (uint8_t)(((uint32_t)msg->torque >> 8u) & 0xFFu);
+  data[6] = (uint8_t)((uint32_t)msg->torque & 0xFFu);
+  data[7] = (uint8_t)(msg->checksum & 0xFFu);
+}
+
+static inline void MotorolaMixed_Unpack(const uint8_t *const data, MotorolaMixed_Msg_t *const msg) {
+  msg->flag = (uint8_t)(data[0] >> 7u);
+  msg->mode = (uint8_t)((data[0] >> 4u) & 0x07u);
+  msg->temperature = (int16_t)((((uint16_t)data[1] | ((uint16_t)(data[0] & 0x0Fu) << 8u)) ^ 0x800u) - 0x800u);
+  msg->speed = (uint16_t)((uint16_t)data[3] | ((uint16_t)data[2] << 8u));
+  msg->counter = (uint8_t)(data[4] >> 4u);
+  msg->torque = (int32_t)((((uint32_t)data[6] | ((uint32_t)data[5] << 8u) | ((uint32_t)(data[4] & 0x0Fu) << 16u)) ^ 0x80000u) - 0x80000u);
+  msg->checksum = (uint8_t)data[7];
+}
+
+static inline float MotorolaMixed_temperature_ToPhys(int16_t raw) {
+  return ((float)raw * 0.1f) - 40.0f;
+}
+
+static inline int16_t MotorolaMixed_temperature_FromPhys(float phys) {
+  float raw = (phys + 40.0f) / 0.1f;
+  return (int16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float MotorolaMixed_speed_ToPhys(uint16_t raw) {
+  return (float)raw * 0.01f;
+}
+
+static inline uint16_t MotorolaMixed_speed_FromPhys(float phys) {
+  float raw = phys / 0.01f;
+  return (uint16_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+static inline float MotorolaMixed_torque_ToPhys(int32_t raw) {
+  return (float)raw * 0.5f;
+}
+
+static inline int32_t MotorolaMixed_torque_FromPhys(float phys) {
+  float raw = phys / 0.5f;
+  return (int32_t)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));
+}
+
+#endif /* _BENCH_SIGNALS_H_ */
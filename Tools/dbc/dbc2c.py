@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""
+Generate C pack/unpack functions from a DBC file.
+
+Every signal is split into per-byte segments at generation time, so the
+emitted code is a fixed sequence of shifts and masks by constants, with no
+bit loops or lookups at run time. Handles Intel (little endian) and Motorola
+(big endian) byte order, signed signals (sign extension) and factor/offset
+scaling. Multiplexed signals are not supported.
+
+usage:
+    python3 Tools/dbc/dbc2c.py Tools/dbc/can2can.dbc -o Core/Inc/can2can_signals.h
+"""
+
+import argparse
+import os
+import re
+import sys
+
+BO_RE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+SG_RE = re.compile(
+    r'^\s*SG_\s+(\w+)\s*(\S*)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+    r'\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*"([^"]*)"'
+)
+VAL_RE = re.compile(r'^VAL_\s+(\d+)\s+(\w+)\s+(.*);')
+VAL_ITEM_RE = re.compile(r'(-?\d+)\s+"([^"]*)"')
+CM_BO_RE = re.compile(r'^CM_\s+BO_\s+(\d+)\s+"([^"]*)"\s*;')
+
+
+class Signal:
+    def __init__(self, name, start, length, little_endian, signed, factor, offset, minimum, maximum, unit):
+        self.name = name
+        self.start = start
+        self.length = length
+        self.little_endian = little_endian
+        self.signed = signed
+        self.factor = factor
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.unit = unit
+        self.values = []
+
+    def bit_positions(self):
+        """frame bit position of each raw bit, raw bit 0 (LSB) first"""
+        if self.little_endian:
+            return [self.start + i for i in range(self.length)]
+
+        # Motorola: start bit is the MSB, walk the "sawtooth" bit numbering
+        positions = []
+        position = self.start
+        for _ in range(self.length):
+            positions.append(position)
+            position = position + 15 if (position % 8) == 0 else position - 1
+        positions.reverse()
+        return positions
+
+    def segments(self):
+        """split into (byte, low bit in byte, width, raw bit offset) segments"""
+        segments = []
+        for raw_bit, position in enumerate(self.bit_positions()):
+            byte, bit = divmod(position, 8)
+            if segments:
+                s_byte, s_low, s_width, s_raw = segments[-1]
+                if s_byte == byte and bit == s_low + s_width and raw_bit == s_raw + s_width:
+                    segments[-1] = (s_byte, s_low, s_width + 1, s_raw)
+                    continue
+            segments.append((byte, bit, 1, raw_bit))
+        return segments
+
+    def width(self):
+        for width in (8, 16, 32, 64):
+            if self.length <= width:
+                return width
+        raise ValueError('signal %s is longer than 64 bits' % self.name)
+
+    def c_type(self):
+        return '%sint%d_t' % ('' if self.signed else 'u', self.width())
+
+    def raw_type(self):
+        return 'uint%d_t' % self.width()
+
+    def scaled(self):
+        return self.factor != 1.0 or self.offset != 0.0
+
+
+class Message:
+    def __init__(self, frame_id, name, dlc, sender):
+        self.frame_id = frame_id
+        self.name = name
+        self.dlc = dlc
+        self.sender = sender
+        self.comment = ''
+        self.signals = []
+
+
+def parse_dbc(path):
+    messages = []
+    by_id = {}
+    message = None
+
+    with open(path, 'r') as dbc:
+        for line_number, line in enumerate(dbc, 1):
+            line = line.rstrip()
+            match = BO_RE.match(line)
+            if match:
+                frame_id = int(match.group(1))
+                if frame_id & 0x80000000:
+                    raise ValueError('%s:%d: extended frames are not supported' % (path, line_number))
+                message = Message(frame_id, match.group(2), int(match.group(3)), match.group(4))
+                messages.append(message)
+                by_id[frame_id] = message
+                continue
+
+            match = SG_RE.match(line)
+            if match:
+                if message is None:
+                    raise ValueError('%s:%d: signal outside of a message' % (path, line_number))
+                if match.group(2):
+                    raise ValueError('%s:%d: multiplexed signals are not supported' % (path, line_number))
+                signal = Signal(
+                    match.group(1), int(match.group(3)), int(match.group(4)),
+                    match.group(5) == '1', match.group(6) == '-',
+                    float(match.group(7)), float(match.group(8)),
+                    match.group(9).strip(), match.group(10).strip(), match.group(11))
+                for position in signal.bit_positions():
+                    if position < 0 or position >= message.dlc * 8:
+                        raise ValueError('%s:%d: signal %s does not fit in %d bytes' %
+                                         (path, line_number, signal.name, message.dlc))
+                message.signals.append(signal)
+                continue
+
+            if not line.startswith(' '):
+                message = None
+
+            match = CM_BO_RE.match(line)
+            if match and int(match.group(1)) in by_id:
+                by_id[int(match.group(1))].comment = match.group(2)
+                continue
+
+            match = VAL_RE.match(line)
+            if match and int(match.group(1)) in by_id:
+                for signal in by_id[int(match.group(1))].signals:
+                    if signal.name == match.group(2):
+                        signal.values = [(int(v), n) for v, n in VAL_ITEM_RE.findall(match.group(3))]
+
+    return messages
+
+
+def upper_snake(name):
+    name = re.sub(r'([a-z0-9])([A-Z])', r'\1_\2', name)
+    return re.sub(r'[^A-Za-z0-9]', '_', name).upper()
+
+
+def hex_mask(width, bits):
+    return '0x%0*Xu' % ((bits + 3) // 4, (1 << width) - 1)
+
+
+def emit_pack(message):
+    lines = []
+    lines.append('static inline void %s_Pack(const %s_Msg_t *const msg, uint8_t *const data) {' %
+                 (message.name, message.name))
+
+    per_byte = [[] for _ in range(message.dlc)]
+    for signal in message.signals:
+        value = 'msg->%s' % signal.name
+        if signal.signed:
+            value = '(%s)%s' % (signal.raw_type(), value)
+        for byte, low, width, raw_offset in signal.segments():
+            term = value
+            if raw_offset:
+                term = '(%s >> %du)' % (term, raw_offset)
+            term = '(%s & %s)' % (term, hex_mask(width, 8))
+            if low:
+                term = '(%s << %du)' % (term, low)
+            per_byte[byte].append(term)
+
+    for byte, terms in enumerate(per_byte):
+        if terms:
+            expression = terms[0] if len(terms) == 1 else '(%s)' % ' | '.join(terms)
+            lines.append('  data[%d] = (uint8_t)%s;' % (byte, expression))
+        else:
+            lines.append('  data[%d] = 0u;' % byte)
+
+    lines.append('}')
+    return lines
+
+
+def emit_unpack(message):
+    lines = []
+    lines.append('static inline void %s_Unpack(const uint8_t *const data, %s_Msg_t *const msg) {' %
+                 (message.name, message.name))
+
+    for signal in message.signals:
+        terms = []
+        for byte, low, width, raw_offset in signal.segments():
+            term = 'data[%d]' % byte
+            if low:
+                term = '(%s >> %du)' % (term, low)
+            if low + width < 8:
+                term = '(%s & %s)' % (term, hex_mask(width, 8))
+            term = '(%s)%s' % (signal.raw_type(), term)
+            if raw_offset:
+                term = '(%s << %du)' % (term, raw_offset)
+            terms.append(term)
+        raw = terms[0] if len(terms) == 1 else '(%s)' % ' | '.join(terms)
+
+        if signal.signed and signal.length < signal.width():
+            sign_bit = '0x%Xu' % (1 << (signal.length - 1))
+            if signal.width() == 64:
+                sign_bit = sign_bit + 'LL'
+            raw = '((%s ^ %s) - %s)' % (raw, sign_bit, sign_bit)
+
+        if raw.startswith('(%s)' % signal.c_type()) and len(terms) == 1:
+            lines.append('  msg->%s = %s;' % (signal.name, raw))
+        else:
+            lines.append('  msg->%s = (%s)%s;' % (signal.name, signal.c_type(), raw))
+
+    lines.append('}')
+    return lines
+
+
+def emit_scaling(message, signal):
+    prefix = '%s_%s' % (message.name, signal.name)
+    to_phys = '(float)raw * %rf' % signal.factor
+    from_phys = 'phys'
+    if signal.offset > 0:
+        to_phys = '(%s) + %rf' % (to_phys, signal.offset)
+        from_phys = '(phys - %rf)' % signal.offset
+    elif signal.offset < 0:
+        to_phys = '(%s) - %rf' % (to_phys, -signal.offset)
+        from_phys = '(phys + %rf)' % -signal.offset
+    return [
+        'static inline float %s_ToPhys(%s raw) {' % (prefix, signal.c_type()),
+        '  return %s;' % to_phys,
+        '}',
+        '',
+        'static inline %s %s_FromPhys(float phys) {' % (signal.c_type(), prefix),
+        '  float raw = %s / %rf;' % (from_phys, signal.factor),
+        '  return (%s)((raw < 0.0f) ? (raw - 0.5f) : (raw + 0.5f));' % signal.c_type(),
+        '}',
+        '',
+    ]
+
+
+def generate(messages, source, guard):
+    out = []
+    out.append('/* generated by Tools/dbc/dbc2c.py from %s, do not edit */' % source)
+    out.append('#ifndef %s' % guard)
+    out.append('#define %s' % guard)
+    out.append('')
+    out.append('#include <stdint.h>')
+    out.append('')
+
+    for message in messages:
+        macro = upper_snake(message.name)
+        out.append('/* %s: ID 0x%03X, DLC %d, sender %s%s */' % (
+            message.name, message.frame_id, message.dlc, message.sender,
+            (', ' + message.comment) if message.comment else ''))
+        out.append('#define %s_FRAME_ID %s(0x%03Xu)' % (macro, ' ' * max(1, 24 - len(macro)), message.frame_id))
+        out.append('#define %s_FRAME_DLC %s(%du)' % (macro, ' ' * max(1, 23 - len(macro)), message.dlc))
+        for signal in message.signals:
+            for value, name in signal.values:
+                define = '%s_%s_%s' % (macro, upper_snake(signal.name), upper_snake(name))
+                out.append('#define %s %s(%du)' % (define, ' ' * max(1, 33 - len(define)), value))
+        out.append('')
+
+        out.append('typedef struct {')
+        for signal in message.signals:
+            out.append('  %s %s; /* %s|%s@%d%s [%s|%s]%s */' % (
+                signal.c_type(), signal.name, signal.start, signal.length, 1 if signal.little_endian else 0,
+                '-' if signal.signed else '+', signal.minimum, signal.maximum,
+                (' ' + signal.unit) if signal.unit else ''))
+        out.append('} %s_Msg_t;' % message.name)
+        out.append('')
+
+        out.extend(emit_pack(message))
+        out.append('')
+        out.extend(emit_unpack(message))
+        out.append('')
+
+        for signal in message.signals:
+            if signal.scaled():
+                out.extend(emit_scaling(message, signal))
+
+    out.append('#endif /* %s */' % guard)
+    out.append('')
+    return '\n'.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='generate C pack/unpack functions from a DBC file')
+    parser.add_argument('dbc', help='input DBC file')
+    parser.add_argument('-o', '--output', required=True, help='output C header')
+    args = parser.parse_args()
+
+    try:
+        messages = parse_dbc(args.dbc)
+    except ValueError as error:
+        sys.stderr.write('error: %s\n' % error)
+        return 1
+
+    guard = '_%s_' % re.sub(r'[^A-Za-z0-9]', '_', os.path.basename(args.output)).upper()
+    header = generate(messages, os.path.basename(args.dbc), guard)
+
+    with open(args.output, 'w') as output:
+        output.write(header)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,252 @@
+/*
+ * Table driven state machine (Core/Src/hsm.c) vs the switch based dispatch
+ * the node tasks used before, on the master node's states and a typical
+ * event trace (one command slot: TIME, CAN TX, 10 CAN RX). Actions are stubs,
+ * so the times are dispatch overhead only.
+ *
+ * build & run (host):
+ *    gcc -O2 -std=c99 -I Core/Inc -o hsm_bench Tools/hsm_bench/hsm_bench.c Core/Src/hsm.c && ./hsm_bench
+ *
+ * dispatch code size (host, -Os):
+ *    gcc -Os -std=c99 -I Core/Inc -c Tools/hsm_bench/hsm_bench.c Core/Src/hsm.c && nm -S --size-sort hsm_bench.o hsm.o
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "hsm.h"
+
+#define BENCH_PASSES      (2000000u)
+
+typedef enum {
+  BENCH_STATE_OPERATING,
+  BENCH_STATE_IDLE,
+  BENCH_STATE_TX,
+  BENCH_STATE_NUMBER,
+} Bench_State_t;
+
+static const Event_t Bench_Trace[] = {
+  { .type = TIME_EVENT }, { .type = CAN_TX_EVENT },
+  { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT },
+  { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT }, { .type = CAN_RX_EVENT },
+};
+
+#define BENCH_TRACE_LENGTH  (sizeof(Bench_Trace) / sizeof(Bench_Trace[0]))
+
+static volatile uint32_t Bench_Commands = 0;
+static volatile uint32_t Bench_Statuses = 0;
+
+/* switch based dispatch --------------------------------------------------- */
+
+static Bench_State_t Switch_CurrentState = BENCH_STATE_IDLE;
+
+static StateResult_t Switch_Idle_StateHandler(const Event_t *const pEvent) {
+  if (pEvent->type != TIME_EVENT) {
+    return EVENT_IGNORED;
+  }
+  Bench_Commands++;
+  return EVENT_HANDLED;
+}
+
+static StateResult_t Switch_Transmit_StateHandler(const Event_t *const pEvent) {
+  if (pEvent->type != CAN_TX_EVENT) {
+    return EVENT_IGNORED;
+  }
+  return EVENT_HANDLED;
+}
+
+static StateResult_t Switch_ReceiveStatus_EventHandler(const Event_t *const pEvent) {
+  if (pEvent->type != CAN_RX_EVENT) {
+    return EVENT_IGNORED;
+  }
+  Bench_Statuses++;
+  return EVENT_HANDLED;
+}
+
+__attribute__((noinline)) static void Switch_Dispatch(const Event_t *const pEvent) {
+  if (Switch_ReceiveStatus_EventHandler(pEvent) == EVENT_HANDLED) {
+    return;
+  }
+
+  switch (Switch_CurrentState) {
+    case BENCH_STATE_IDLE: {
+      if (Switch_Idle_StateHandler(pEvent) == EVENT_HANDLED) {
+        Switch_CurrentState = BENCH_STATE_TX;
+      }
+    } break;
+
+    case BENCH_STATE_TX: {
+      if (Switch_Transmit_StateHandler(pEvent) == EVENT_HANDLED) {
+        Switch_CurrentState = BENCH_STATE_IDLE;
+      } else {
+        (void)Switch_Idle_StateHandler(pEvent);
+      }
+    } break;
+
+    default:
+    break;
+  }
+}
+
+/* table driven dispatch --------------------------------------------------- */
+
+static StateResult_t Table_SendCommand(const Event_t *const pEvent) {
+  Bench_Commands++;
+  (void)pEvent;
+  return EVENT_HANDLED;
+}
+
+static StateResult_t Table_ReceiveStatus(const Event_t *const pEvent) {
+  Bench_Statuses++;
+  (void)pEvent;
+  return EVENT_HANDLED;
+}
+
+static const Hsm_Transition_t Table_OperatingTransitions[EVENT_TYPE_NUMBER] = {
+  [CAN_RX_EVENT] = HSM_INTERNAL(Table_ReceiveStatus),
+};
+
+static const Hsm_Transition_t Table_IdleTransitions[EVENT_TYPE_NUMBER] = {
+  [TIME_EVENT] = HSM_EXTERNAL(Table_SendCommand, BENCH_STATE_TX),
+};
+
+static const Hsm_Transition_t Table_TransmitTransitions[EVENT_TYPE_NUMBER] = {
+  [TIME_EVENT] = HSM_INTERNAL(Table_SendCommand),
+  [CAN_TX_EVENT] = HSM_EXTERNAL(NULL, BENCH_STATE_IDLE),
+};
+
+static const Hsm_State_t Table_States[BENCH_STATE_NUMBER] = {
+  [BENCH_STATE_OPERATING] = { .parent = HSM_NO_STATE, .initial = BENCH_STATE_IDLE, .transitions = Table_OperatingTransitions },
+  [BENCH_STATE_IDLE] = { .parent = BENCH_STATE_OPERATING, .initial = HSM_NO_STATE, .transitions = Table_IdleTransitions },
+  [BENCH_STATE_TX] = { .parent = BENCH_STATE_OPERATING, .initial = HSM_NO_STATE, .transitions = Table_TransmitTransitions },
+};
+
+static Hsm_t Table_Hsm;
+
+/* deferral check: TX defers RX until TX complete, WAIT has entry/exit ----- */
+
+typedef enum {
+  DEFER_STATE_ACTIVE,
+  DEFER_STATE_IDLE,
+  DEFER_STATE_TX,
+  DEFER_STATE_WAIT,
+  DEFER_STATE_NUMBER,
+} Defer_State_t;
+
+static char Defer_Log[64];
+static uint8_t Defer_Pending = 0;
+
+static void Defer_LogChar(char c) {
+  size_t length = strlen(Defer_Log);
+  if (length < (sizeof(Defer_Log) - 1u)) {
+    Defer_Log[length] = c;
+  }
+}
+
+static StateResult_t Defer_Send(const Event_t *const pEvent) { Defer_LogChar('s'); (void)pEvent; return EVENT_HANDLED; }
+static void Defer_WaitEntry(void) { Defer_LogChar('('); }
+static void Defer_WaitExit(void) { Defer_LogChar(')'); }
+static uint8_t Defer_SequencePending(void) { return Defer_Pending; }
+
+static const Hsm_Transition_t Defer_ActiveTransitions[EVENT_TYPE_NUMBER] = {
+  [CAN_RX_EVENT] = HSM_EXTERNAL(Defer_Send, DEFER_STATE_TX),
+};
+
+static const Hsm_Transition_t Defer_TransmitTransitions[EVENT_TYPE_NUMBER] = {
+  [CAN_TX_EVENT] = HSM_CHOICE(NULL, Defer_SequencePending, DEFER_STATE_WAIT, DEFER_STATE_IDLE),
+  [CAN_RX_EVENT] = HSM_DEFER,
+};
+
+static const Hsm_Transition_t Defer_WaitTransitions[EVENT_TYPE_NUMBER] = {
+  [TIME_EVENT] = HSM_EXTERNAL(Defer_Send, DEFER_STATE_TX),
+};
+
+static const Hsm_State_t Defer_States[DEFER_STATE_NUMBER] = {
+  [DEFER_STATE_ACTIVE] = { .parent = HSM_NO_STATE, .initial = DEFER_STATE_IDLE, .transitions = Defer_ActiveTransitions },
+  [DEFER_STATE_IDLE] = { .parent = DEFER_STATE_ACTIVE, .initial = HSM_NO_STATE },
+  [DEFER_STATE_TX] = { .parent = DEFER_STATE_ACTIVE, .initial = HSM_NO_STATE, .transitions = Defer_TransmitTransitions },
+  [DEFER_STATE_WAIT] = { .parent = DEFER_STATE_ACTIVE, .initial = HSM_NO_STATE,
+    .entry = Defer_WaitEntry, .exit = Defer_WaitExit, .transitions = Defer_WaitTransitions },
+};
+
+static int Bench_CheckDeferral(void) {
+  static const EventType_t events[] = {CAN_RX_EVENT, CAN_RX_EVENT, CAN_TX_EVENT, CAN_TX_EVENT, TIME_EVENT, CAN_RX_EVENT, CAN_TX_EVENT};
+  Hsm_t hsm;
+
+  memset(Defer_Log, 0x00, sizeof(Defer_Log));
+  Defer_Pending = 1;
+  Hsm_Initialize(&hsm, Defer_States, DEFER_STATE_ACTIVE);
+
+  for (uint32_t i = 0; i < (sizeof(events) / sizeof(events[0])); i++) {
+    Event_t event = { .type = events[i] };
+    Hsm_Dispatch(&hsm, &event);
+  }
+
+  /* actions run before exit actions: RX: send; RX deferred; TX: wait,
+   * recalled RX: send, leave wait; TX: wait; TIME: send, leave wait;
+   * RX deferred; TX: wait, recalled RX: send, leave wait */
+  if ((strcmp(Defer_Log, "s(s)(s)(s)") != 0) || (Hsm_GetState(&hsm) != DEFER_STATE_TX)) {
+    printf("deferral check failed: \"%s\", state %u\n", Defer_Log, Hsm_GetState(&hsm));
+    return 1;
+  }
+
+  return 0;
+}
+
+static double Bench_Now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+int main(void) {
+  double start = 0;
+  double switch_ns = 0;
+  double table_ns = 0;
+  uint32_t switch_commands = 0;
+  uint32_t switch_statuses = 0;
+
+  if (Bench_CheckDeferral() != 0) {
+    return 1;
+  }
+
+  Hsm_Initialize(&Table_Hsm, Table_States, BENCH_STATE_OPERATING);
+
+  start = Bench_Now();
+  for (uint32_t p = 0; p < BENCH_PASSES; p++) {
+    for (uint32_t e = 0; e < BENCH_TRACE_LENGTH; e++) {
+      Switch_Dispatch(&Bench_Trace[e]);
+    }
+  }
+  switch_ns = (Bench_Now() - start) * 1e9 / ((double)BENCH_PASSES * BENCH_TRACE_LENGTH);
+  switch_commands = Bench_Commands;
+  switch_statuses = Bench_Statuses;
+  Bench_Commands = 0;
+  Bench_Statuses = 0;
+
+  start = Bench_Now();
+  for (uint32_t p = 0; p < BENCH_PASSES; p++) {
+    for (uint32_t e = 0; e < BENCH_TRACE_LENGTH; e++) {
+      Hsm_Dispatch(&Table_Hsm, &Bench_Trace[e]);
+    }
+  }
+  table_ns = (Bench_Now() - start) * 1e9 / ((double)BENCH_PASSES * BENCH_TRACE_LENGTH);
+
+  if ((switch_commands != Bench_Commands) || (switch_statuses != Bench_Statuses)
+      || (Switch_CurrentState != Hsm_GetState(&Table_Hsm))) {
+    printf("dispatch mismatch: switch %u/%u, table %u/%u\n",
+      switch_commands, switch_statuses, Bench_Commands, Bench_Statuses);
+    return 1;
+  }
+
+  printf("events: %u x %u passes (TIME, CAN TX, 10 x CAN RX)\n", (unsigned)BENCH_TRACE_LENGTH, BENCH_PASSES);
+  printf("switch dispatch  : %8.2f ns/event\n", switch_ns);
+  printf("table dispatch   : %8.2f ns/event\n", table_ns);
+  printf("tables (flash)   : %8u bytes (%u states)\n",
+    (unsigned)(sizeof(Table_States) + sizeof(Table_OperatingTransitions)
+      + sizeof(Table_IdleTransitions) + sizeof(Table_TransmitTransitions)), BENCH_STATE_NUMBER);
+
+  return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * N-slave polling simulation: bus load, operation status latency, master RX
+ * FIFO depth and master CPU load as the number of slaves grows, with the
+ * master schedule table (staggered commands) and with all slaves commanded
+ * at the same time.
+ *
+ * build & run (host):
+ *    gcc -O2 -std=c99 -I Core/Inc -o polling_sim Tools/polling_sim/polling_sim.c && ./polling_sim
+ *
+ * master CPU cost per frame can be given in CPU cycles:
+ *    ./polling_sim [rx_cycles] [tx_cycles]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can2can.h"
+
+#define SIM_BIT_RATE            (1000000u)    /* bits/s, MX_CAN_Init() */
+#define SIM_CPU_HZ              (8000000u)    /* SystemCoreClock */
+#define SIM_PERIODS             (10u)         /* simulated command periods */
+#define SIM_SLAVE_RESPONSE_US   (200u)        /* operation command reception to first operation status */
+#define SIM_RX_FIFO_DEPTH       (3u)          /* bxCAN RX FIFO depth */
+
+/* default master cost, CAN ISR + event queue + task handler (estimation) */
+#define SIM_MASTER_RX_CYCLES    (2400u)
+#define SIM_MASTER_TX_CYCLES    (3200u)
+
+#define SIM_MAX_FRAMES          (CAN2CAN_SLAVE_MAX_NUMBER * SIM_PERIODS * (1u + OPERATION_STATUS_COUNT))
+
+/**
+ * @brief Simulated frame
+ */
+typedef struct {
+  uint64_t ready_us;    /* queued for transmission */
+  uint64_t end_us;      /* end of transmission */
+  uint16_t std_id;      /* arbitration priority */
+  uint8_t dlc;          /* data length code */
+  uint8_t slave;        /* slave ID */
+  uint8_t is_status;    /* 1: operation status, 0: operation command */
+  uint8_t sent;         /* 1: transmitted */
+} Sim_Frame_t;
+
+/**
+ * @brief Results of a simulation run
+ */
+typedef struct {
+  double frame_rate;        /* frames/s */
+  double bus_load;          /* % */
+  double cpu_load;          /* % master CPU */
+  uint64_t max_latency_us;  /* operation status, queued to end of transmission */
+  uint32_t max_fifo_depth;  /* master RX FIFO */
+  uint32_t overruns;        /* operation status frames lost, master RX FIFO full */
+} Sim_Result_t;
+
+static Sim_Frame_t Sim_Frames[SIM_MAX_FRAMES];
+static uint32_t Sim_FrameCount = 0;
+static uint32_t Sim_MasterRxCycles = SIM_MASTER_RX_CYCLES;
+static uint32_t Sim_MasterTxCycles = SIM_MASTER_TX_CYCLES;
+
+/**
+ * @brief Worst case standard data frame length, with stuff bits and IFS
+ */
+static uint32_t Sim_FrameBits(uint8_t dlc) {
+  uint32_t bits = 44u + (8u * dlc);
+  uint32_t stuff = (34u + (8u * dlc) - 1u) / 4u;
+  return bits + stuff + 3u;
+}
+
+static void Sim_AddFrame(uint64_t ready_us, uint16_t std_id, uint8_t dlc, uint8_t slave, uint8_t is_status) {
+  Sim_Frame_t *const frame = &Sim_Frames[Sim_FrameCount++];
+
+  memset(frame, 0x00, sizeof(Sim_Frame_t));
+  frame->ready_us = ready_us;
+  frame->std_id = std_id;
+  frame->dlc = dlc;
+  frame->slave = slave;
+  frame->is_status = is_status;
+}
+
+static int Sim_CompareEnd(const void *a, const void *b) {
+  const Sim_Frame_t *const fa = (const Sim_Frame_t *)a;
+  const Sim_Frame_t *const fb = (const Sim_Frame_t *)b;
+  return (fa->end_us > fb->end_us) - (fa->end_us < fb->end_us);
+}
+
+/**
+ * @brief Run the bus: lowest pending ID wins arbitration when the bus is idle,
+ * slaves queue their operation status frames when a command is received
+ */
+static uint64_t Sim_RunBus(uint64_t *const busy_us) {
+  uint64_t now = 0;
+  uint32_t sent = 0;
+
+  (*busy_us) = 0;
+
+  while (sent < Sim_FrameCount) {
+    Sim_Frame_t *next = NULL;
+    uint64_t earliest = UINT64_MAX;
+
+    for (uint32_t i = 0; i < Sim_FrameCount; i++) {
+      Sim_Frame_t *const frame = &Sim_Frames[i];
+      if (frame->sent) {
+        continue;
+      }
+      if (frame->ready_us <= now) {
+        if ((next == NULL) || (frame->std_id < next->std_id)) {
+          next = frame;
+        }
+      } else if (frame->ready_us < earliest) {
+        earliest = frame->ready_us;
+      }
+    }
+
+    if (next == NULL) {
+      now = earliest;
+      continue;
+    }
+
+    uint64_t duration = (Sim_FrameBits(next->dlc) * 1000000ull) / SIM_BIT_RATE;
+    now += duration;
+    (*busy_us) += duration;
+    next->end_us = now;
+    next->sent = 1;
+    sent++;
+
+    if (!next->is_status) {
+      for (uint32_t k = 0; k < OPERATION_STATUS_COUNT; k++) {
+        Sim_AddFrame(now + SIM_SLAVE_RESPONSE_US + (k * OPERATION_STATUS_PERIOD_MS * 1000ull),
+          (uint16_t)OPERATION_STATUS_STD_ID_OF(next->slave), OPERATION_STATUS_MSG_SIZE, next->slave, 1);
+      }
+    }
+  }
+
+  return now;
+}
+
+/**
+ * @brief Run the master: a single CPU serving received operation status
+ * frames in order, each frame waits in the RX FIFO until it is read
+ */
+static void Sim_RunMaster(Sim_Result_t *const result) {
+  uint64_t cpu_free_us = 0;
+  uint64_t rx_cost_us = ((uint64_t)Sim_MasterRxCycles * 1000000ull) / SIM_CPU_HZ;
+  uint64_t tx_cost_us = ((uint64_t)Sim_MasterTxCycles * 1000000ull) / SIM_CPU_HZ;
+  uint64_t read_us[SIM_RX_FIFO_DEPTH] = {0};
+  uint32_t fifo_head = 0;
+
+  qsort(Sim_Frames, Sim_FrameCount, sizeof(Sim_Frame_t), Sim_CompareEnd);
+
+  for (uint32_t i = 0; i < Sim_FrameCount; i++) {
+    const Sim_Frame_t *const frame = &Sim_Frames[i];
+    uint32_t depth = 0;
+
+    if (!frame->is_status) {
+      /* command is prepared by the master when it's queued */
+      cpu_free_us = ((cpu_free_us > frame->ready_us) ? cpu_free_us : frame->ready_us) + tx_cost_us;
+      continue;
+    }
+
+    /* frames still in the FIFO: received earlier, not read yet */
+    for (uint32_t f = 0; f < SIM_RX_FIFO_DEPTH; f++) {
+      if (read_us[f] > frame->end_us) {
+        depth++;
+      }
+    }
+
+    if (depth >= SIM_RX_FIFO_DEPTH) {
+      result->overruns++;
+      continue;
+    }
+
+    if ((depth + 1u) > result->max_fifo_depth) {
+      result->max_fifo_depth = depth + 1u;
+    }
+
+    uint64_t start = (cpu_free_us > frame->end_us) ? cpu_free_us : frame->end_us;
+    cpu_free_us = start + rx_cost_us;
+    read_us[fifo_head] = start;
+    fifo_head = (fifo_head + 1u) % SIM_RX_FIFO_DEPTH;
+
+    if ((frame->end_us - frame->ready_us) > result->max_latency_us) {
+      result->max_latency_us = frame->end_us - frame->ready_us;
+    }
+  }
+}
+
+static void Sim_Run(uint32_t slave_number, int staggered, Sim_Result_t *const result) {
+  uint64_t busy_us = 0;
+  uint64_t total_us = (uint64_t)SIM_PERIODS * OPERATION_COMMAND_PERIOD_MS * 1000ull;
+  uint32_t commands = 0;
+  uint32_t statuses = 0;
+
+  memset(result, 0x00, sizeof(Sim_Result_t));
+  Sim_FrameCount = 0;
+
+  for (uint32_t period = 0; period < SIM_PERIODS; period++) {
+    for (uint32_t slave = 0; slave < slave_number; slave++) {
+      uint64_t offset_us = staggered
+        ? MASTER_NODE_SCHEDULE_OFFSET_US(slave, slave_number, OPERATION_STATUS_PERIOD_US_AT(OPERATION_STATUS_FREQUENCY)) : 0;
+      Sim_AddFrame((period * OPERATION_COMMAND_PERIOD_MS * 1000ull) + offset_us,
+        (uint16_t)OPERATION_COMMAND_STD_ID_OF(slave), OPERATION_COMMAND_MSG_SIZE, (uint8_t)slave, 0);
+    }
+  }
+
+  uint64_t end_us = Sim_RunBus(&busy_us);
+  if (end_us > total_us) {
+    total_us = end_us;
+  }
+
+  for (uint32_t i = 0; i < Sim_FrameCount; i++) {
+    if (Sim_Frames[i].is_status) {
+      statuses++;
+    } else {
+      commands++;
+    }
+  }
+
+  Sim_RunMaster(result);
+
+  result->frame_rate = (double)Sim_FrameCount * 1e6 / (double)total_us;
+  result->bus_load = 100.0 * (double)busy_us / (double)total_us;
+  result->cpu_load = 100.0 * (((double)(statuses - result->overruns) * Sim_MasterRxCycles)
+    + ((double)commands * Sim_MasterTxCycles)) / ((double)total_us * SIM_CPU_HZ / 1e6);
+}
+
+int main(int argc, char **argv) {
+  static const uint32_t slave_numbers[] = {1, 2, 4, 8, 16, 24, 32};
+
+  if (argc > 1) {
+    Sim_MasterRxCycles = (uint32_t)strtoul(argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    Sim_MasterTxCycles = (uint32_t)strtoul(argv[2], NULL, 0);
+  }
+
+  printf("bus: %u bit/s, master: %u Hz, %u cycles/status, %u cycles/command\n",
+    SIM_BIT_RATE, SIM_CPU_HZ, Sim_MasterRxCycles, Sim_MasterTxCycles);
+  printf("command period %u ms, %u status frames every %u ms per command\n\n",
+    OPERATION_COMMAND_PERIOD_MS, OPERATION_STATUS_COUNT, OPERATION_STATUS_PERIOD_MS);
+  printf("                                       |   staggered (schedule)   |     simultaneous\n");
+  printf("slaves  frames/s  bus load  master CPU | latency  FIFO  overruns  | latency  FIFO  overruns\n");
+
+  for (uint32_t i = 0; i < (sizeof(slave_numbers) / sizeof(slave_numbers[0])); i++) {
+    Sim_Result_t staggered;
+    Sim_Result_t simultaneous;
+
+    Sim_Run(slave_numbers[i], 1, &staggered);
+    Sim_Run(slave_numbers[i], 0, &simultaneous);
+
+    printf("%6u  %8.1f  %7.2f%%  %9.2f%% | %5llu us  %4u  %8u  | %5llu us  %4u  %8u\n",
+      slave_numbers[i], staggered.frame_rate, staggered.bus_load, staggered.cpu_load,
+      (unsigned long long)staggered.max_latency_us, staggered.max_fifo_depth, staggered.overruns,
+      (unsigned long long)simultaneous.max_latency_us, simultaneous.max_fifo_depth, simultaneous.overruns);
+  }
+
+  return 0;
+}
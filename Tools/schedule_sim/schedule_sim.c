@@ -0,0 +1,257 @@
+/*
+ * Communication schedule table check: expands the firmware's schedule table
+ * (Core/Src/can2can_schedule.c) with the firmware's engine
+ * (Core/Src/schedule_table.c) into the frames of one cycle, sent by the
+ * master and by each slave, and verifies that their transmission windows
+ * don't overlap at a given bit rate, so that no two frames ever compete in
+ * arbitration. A window starts at the expiry point and lasts the worst case
+ * frame length plus the release jitter (TIM2 interrupt latency, busy
+ * retries), slave frames are widened on both sides by the table precision
+ * (deviation of the synchronized slave cycle). Exits with 1 on a collision.
+ *
+ * build & run (host):
+ *    gcc -O2 -std=c99 -DSTM32F103xB -DUSE_HAL_DRIVER -I Core/Inc -I Drivers/STM32F1xx_HAL_Driver/Inc \
+ *      -I Drivers/CMSIS/Device/ST/STM32F1xx/Include -I Drivers/CMSIS/Include \
+ *      -I Middlewares/Third_Party/FreeRTOS/Source/include -I Middlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS \
+ *      -I Middlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM3 -o schedule_sim \
+ *      Tools/schedule_sim/schedule_sim.c Core/Src/can2can_schedule.c Core/Src/schedule_table.c && ./schedule_sim
+ *
+ * bit rate (bits/s) and release jitter (us) can be given, -t prints the windows:
+ *    ./schedule_sim [bit_rate] [release_jitter_us] [-t]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can2can.h"
+
+#define SIM_RELEASE_JITTER_US   (50u)   /* TX scheduler release to mailbox loaded (estimation) */
+#define SIM_MAX_COLLISIONS      (10u)   /* collisions printed */
+
+/**
+ * @brief Transmission window of a frame in the cycle
+ */
+typedef struct {
+  int64_t start_us;       /* earliest start of transmission */
+  int64_t end_us;         /* latest end of transmission */
+  uint32_t offset_us;     /* expiry point */
+  uint32_t frame_us;      /* worst case frame length */
+  uint16_t std_id;
+  uint8_t message;
+  uint8_t slave;
+  uint8_t sender;         /* ScheduleTable_Sender_t */
+} Sim_Window_t;
+
+static Sim_Window_t *Sim_Windows = NULL;
+static uint32_t Sim_WindowCount = 0;
+static uint32_t Sim_BitRate = CAN2CAN_SCHEDULE_BIT_RATE;
+static uint32_t Sim_ReleaseJitterUs = SIM_RELEASE_JITTER_US;
+
+static const char *const Sim_SenderNames[] = {"master", "slave"};
+
+/**
+ * @brief Expiry points of one node over a cycle, into windows
+ */
+static void Sim_AddNode(const ScheduleTable_t *const table, uint8_t sender, uint8_t slave) {
+  ScheduleTable_Run_t run;
+  ScheduleTable_ExpiryPoint_t point;
+  uint32_t count = 0;
+
+  ScheduleTable_Start(&run, table, sender, slave, 0);
+  count = ScheduleTable_Count(&run);
+
+  for (uint32_t i = 0; i < count; i++) {
+    Sim_Window_t *const window = &Sim_Windows[Sim_WindowCount++];
+    const uint32_t margin_us = (sender == SCHEDULE_TABLE_SENDER_SLAVE) ? table->precision_us : 0u;
+
+    if (ScheduleTable_Next(&run, &point) == 0) {
+      fprintf(stderr, "expiry point %u of %s %u missing\n", i, Sim_SenderNames[sender], slave);
+      exit(2);
+    }
+
+    memset(window, 0x00, sizeof(Sim_Window_t));
+    window->offset_us = point.offset_us;
+    window->frame_us = SCHEDULE_TABLE_FRAME_US(point.len, Sim_BitRate);
+    window->start_us = (int64_t)point.offset_us - margin_us;
+    window->end_us = (int64_t)point.offset_us + margin_us + Sim_ReleaseJitterUs + window->frame_us;
+    window->std_id = point.std_id;
+    window->message = point.message;
+    window->slave = point.slave;
+    window->sender = sender;
+  }
+}
+
+/**
+ * @brief Overlap of two windows, in the cycle or across its end
+ */
+static int64_t Sim_Overlap(const Sim_Window_t *const a, const Sim_Window_t *const b, int64_t duration_us) {
+  int64_t overlap = 0;
+
+  for (int64_t shift = -duration_us; shift <= duration_us; shift += duration_us) {
+    int64_t start = (a->start_us > (b->start_us + shift)) ? a->start_us : (b->start_us + shift);
+    int64_t end = (a->end_us < (b->end_us + shift)) ? a->end_us : (b->end_us + shift);
+
+    if ((end - start) > overlap) {
+      overlap = end - start;
+    }
+  }
+
+  return overlap;
+}
+
+static int Sim_CompareStart(const void *a, const void *b) {
+  const Sim_Window_t *const wa = (const Sim_Window_t *)a;
+  const Sim_Window_t *const wb = (const Sim_Window_t *)b;
+  return (wa->start_us > wb->start_us) - (wa->start_us < wb->start_us);
+}
+
+/**
+ * @brief Expiry points out of the cycle are dropped by the engine, and sync
+ * points must be once per cycle
+ *
+ * @return uint32_t table errors
+ */
+static uint32_t Sim_CheckTable(const ScheduleTable_t *const table) {
+  uint32_t errors = 0;
+
+  for (uint8_t index = 0; index < table->message_number; index++) {
+    const ScheduleTable_Message_t *const message = &table->messages[index];
+    const uint32_t slaves = ((message->flags & SCHEDULE_TABLE_FLAG_PER_SLAVE) != 0) ? table->slave_number : 1u;
+
+    for (uint32_t slave = 0; slave < slaves; slave++) {
+      if ((message->offset_us + (slave * message->slave_stride_us)) >= table->duration_us) {
+        printf("error: message %u of slave %u is out of the cycle\n", index, slave);
+        errors++;
+      }
+    }
+
+    if (((message->flags & SCHEDULE_TABLE_FLAG_SYNC) != 0) && (message->period_us != 0)) {
+      printf("error: sync point message %u repeats in the cycle\n", index);
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+int main(int argc, char **argv) {
+  const ScheduleTable_t *const table = &Can2Can_Schedule;
+  const int64_t duration_us = (int64_t)table->duration_us;
+  uint32_t positional = 0;
+  int timeline = 0;
+  uint32_t errors = 0;
+  uint32_t collisions = 0;
+  uint64_t busy_us = 0;
+  int64_t smallest_gap = INT64_MAX;
+  uint32_t gap_index = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-t") == 0) {
+      timeline = 1;
+    } else if (positional++ == 0) {
+      Sim_BitRate = (uint32_t)strtoul(argv[i], NULL, 0);
+    } else {
+      Sim_ReleaseJitterUs = (uint32_t)strtoul(argv[i], NULL, 0);
+    }
+  }
+  if (Sim_BitRate == 0) {
+    fprintf(stderr, "usage: %s [bit_rate] [release_jitter_us] [-t]\n", argv[0]);
+    return 2;
+  }
+
+  printf("cycle %u us, %u messages, %u slaves, %u bit/s (table: %u bit/s)\n",
+    table->duration_us, table->message_number, table->slave_number, Sim_BitRate, table->bit_rate);
+  printf("release jitter %u us, slave precision %u us\n\n", Sim_ReleaseJitterUs, table->precision_us);
+
+  errors = Sim_CheckTable(table);
+
+  /* master, then each slave */
+  {
+    ScheduleTable_Run_t run;
+    uint32_t total = 0;
+
+    ScheduleTable_Start(&run, table, SCHEDULE_TABLE_SENDER_MASTER, 0, 0);
+    total = ScheduleTable_Count(&run);
+    for (uint32_t slave = 0; slave < table->slave_number; slave++) {
+      ScheduleTable_Start(&run, table, SCHEDULE_TABLE_SENDER_SLAVE, (uint8_t)slave, 0);
+      total += ScheduleTable_Count(&run);
+    }
+
+    Sim_Windows = calloc((total > 0) ? total : 1u, sizeof(Sim_Window_t));
+    if (Sim_Windows == NULL) {
+      return 2;
+    }
+  }
+
+  Sim_AddNode(table, SCHEDULE_TABLE_SENDER_MASTER, 0);
+  for (uint32_t slave = 0; slave < table->slave_number; slave++) {
+    Sim_AddNode(table, SCHEDULE_TABLE_SENDER_SLAVE, (uint8_t)slave);
+  }
+  qsort(Sim_Windows, Sim_WindowCount, sizeof(Sim_Window_t), Sim_CompareStart);
+
+  printf("message  sender  std_id  len  frames/cycle  frame  window\n");
+  for (uint8_t index = 0; index < table->message_number; index++) {
+    const ScheduleTable_Message_t *const message = &table->messages[index];
+    uint32_t frames = 0;
+    uint32_t window_us = 0;
+
+    for (uint32_t i = 0; i < Sim_WindowCount; i++) {
+      if (Sim_Windows[i].message == index) {
+        frames++;
+        window_us = (uint32_t)(Sim_Windows[i].end_us - Sim_Windows[i].start_us);
+      }
+    }
+
+    printf("%7u  %-6s  0x%03X   %3u  %12u  %3u us  %4u us\n", index, Sim_SenderNames[message->sender],
+      message->std_id, message->len, frames, SCHEDULE_TABLE_FRAME_US(message->len, Sim_BitRate), window_us);
+  }
+
+  if (timeline != 0) {
+    printf("\n     start      end   offset  std_id  sender\n");
+    for (uint32_t i = 0; i < Sim_WindowCount; i++) {
+      printf("%10lld %8lld %8u  0x%03X   %s %u\n", (long long)Sim_Windows[i].start_us, (long long)Sim_Windows[i].end_us,
+        Sim_Windows[i].offset_us, Sim_Windows[i].std_id, Sim_SenderNames[Sim_Windows[i].sender], Sim_Windows[i].slave);
+    }
+  }
+
+  printf("\n");
+  for (uint32_t i = 0; i < Sim_WindowCount; i++) {
+    const Sim_Window_t *const a = &Sim_Windows[i];
+    const Sim_Window_t *const next = &Sim_Windows[(i + 1u) % Sim_WindowCount];
+    int64_t gap = next->start_us - a->end_us;
+
+    busy_us += a->frame_us;
+    if ((i + 1u) == Sim_WindowCount) {
+      gap += duration_us;
+    }
+    if (gap < smallest_gap) {
+      smallest_gap = gap;
+      gap_index = i;
+    }
+
+    for (uint32_t j = i + 1u; j < Sim_WindowCount; j++) {
+      const Sim_Window_t *const b = &Sim_Windows[j];
+      const int64_t overlap = Sim_Overlap(a, b, duration_us);
+
+      if (overlap <= 0) {
+        continue;
+      }
+      if (collisions < SIM_MAX_COLLISIONS) {
+        printf("collision: 0x%03X at %u us (%s %u) and 0x%03X at %u us (%s %u), %lld us\n",
+          a->std_id, a->offset_us, Sim_SenderNames[a->sender], a->slave,
+          b->std_id, b->offset_us, Sim_SenderNames[b->sender], b->slave, (long long)overlap);
+      }
+      collisions++;
+    }
+  }
+
+  printf("frames %u/cycle, bus load %.2f%%", Sim_WindowCount, 100.0 * (double)busy_us / (double)duration_us);
+  if (Sim_WindowCount > 1u) {
+    printf(", smallest gap %lld us after 0x%03X at %u us", (long long)smallest_gap,
+      Sim_Windows[gap_index].std_id, Sim_Windows[gap_index].offset_us);
+  }
+  printf("\ncollisions: %u, table errors: %u\n", collisions, errors);
+
+  free(Sim_Windows);
+  return ((collisions != 0) || (errors != 0)) ? 1 : 0;
+}
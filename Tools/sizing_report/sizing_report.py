@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Decode the sizing report of the SLCAN gateway (K command, Core/Inc/sizing.h).
+
+Prints the stack use of each task and the occupancy of each queue, the
+suggested sizes and the configuration macros they replace. The report line
+is read from the arguments, a file or the serial port, the last K line wins.
+
+usage:
+    stty -F /dev/ttyUSB0 500000 raw
+    printf 'K1\\r' > /dev/ttyUSB0      # stress workload, run the host load meanwhile
+    printf 'K\\r' > /dev/ttyUSB0 && timeout 1 cat /dev/ttyUSB0 > report.txt
+    printf 'K0\\r' > /dev/ttyUSB0
+    python3 Tools/sizing_report/sizing_report.py report.txt
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+VERSION = 1
+HEADER_SIZE = 8
+NAME_SIZE = 7
+TASK_SIZE = 7 + NAME_SIZE
+QUEUE_SIZE = 11
+
+FLAG_STRESS = 0x01
+FLAG_TRUNCATED = 0x02
+FLAG_SATURATED = 0x04
+
+# Sizing_QueueKind_t, Trace_Object_t
+QUEUE_KINDS = ['queue', 'timer queue', 'event channel', 'event pool', 'memory pool']
+KIND_MEM_POOL = 4
+OBJECTS = ['other', 'master node', 'slave node', 'slcan', 'signal db', 'clock sync']
+# MemPool_Class_t
+MEM_POOL_CLASSES = ['small blocks', 'medium blocks', 'large blocks']
+
+# task name (first NAME_SIZE characters) -> stack depth macro
+TASK_MACROS = {
+    'MasterN': 'MASTER_TASK_STACK_DEPTH',
+    'SlaveNo': 'SLAVE_TASK_STACK_DEPTH',
+    'SlcanTa': 'SLCAN_TASK_STACK_DEPTH',
+    'Executi': 'EXECUTIVE_TASK_STACK_DEPTH',
+    'CanServ': 'BXCAN_SERVICE_STACK_DEPTH',
+    'Tmr Svc': 'configTIMER_TASK_STACK_DEPTH',
+    'IDLE': 'configMINIMAL_STACK_SIZE',
+}
+
+# (kind, number) -> length macro
+QUEUE_MACROS = {
+    (0, 1): 'MASTER_NODE_MAX_EVENTS',
+    (0, 2): 'SLAVE_NODE_MAX_EVENTS',
+    (0, 3): 'SLCAN_FRAME_QUEUE_SIZE',
+    (1, 0): 'configTIMER_QUEUE_LENGTH',
+    (2, 1): 'master event channel size',
+    (2, 2): 'slave event channel size',
+    (3, 0): 'EVENT_POOL_SIZE',
+    (4, 0): 'MEM_POOL_SMALL_BLOCKS',
+    (4, 1): 'MEM_POOL_MEDIUM_BLOCKS',
+    (4, 2): 'MEM_POOL_LARGE_BLOCKS',
+}
+
+REPORT_RE = re.compile(r'K([0-9A-Fa-f]{%d,})' % (2 * HEADER_SIZE))
+
+
+def decode(data):
+    version, tasks, queues, flags, stack_bytes, queue_bytes = struct.unpack_from('<BBBBHH', data, 0)
+    if version != VERSION:
+        sys.exit('unsupported report version %d' % version)
+    if len(data) < HEADER_SIZE + (tasks * TASK_SIZE) + (queues * QUEUE_SIZE):
+        sys.exit('truncated report')
+
+    notes = [name for flag, name in ((FLAG_STRESS, 'stress workload running'),
+                                     (FLAG_TRUNCATED, 'more tasks or queues than tracked'),
+                                     (FLAG_SATURATED, 'a queue was full')) if flags & flag]
+    print('flags: %s' % (', '.join(notes) if notes else 'none'))
+    if not flags & FLAG_STRESS:
+        print('warning: no stress workload, queue peaks may be low')
+
+    position = HEADER_SIZE
+    print('\n%-4s %-8s %6s %6s %9s  %s' % ('task', 'name', 'depth', 'used', 'suggested', 'macro'))
+    for _ in range(tasks):
+        number, depth, used, suggested = struct.unpack_from('<BHHH', data, position)
+        name = data[position + 7:position + TASK_SIZE].split(b'\0')[0].decode('ascii', 'replace')
+        position += TASK_SIZE
+        warning = '  OVERFLOW RISK' if suggested > depth else ''
+        print('%-4d %-8s %6d %6d %9d  %s%s' % (number, name, depth, used, suggested,
+                                              TASK_MACROS.get(name, '-'), warning))
+
+    print('\n%-14s %-12s %4s %6s %5s %6s %9s  %s' % ('queue', 'owner', 'item', 'length', 'peak',
+                                                   'failed', 'suggested', 'macro'))
+    for _ in range(queues):
+        kind, number, item_size, length, peak, failed, suggested = struct.unpack_from('<BBBHHHH', data, position)
+        position += QUEUE_SIZE
+        warning = '  SATURATED' if failed or peak >= length else ''
+        owners = MEM_POOL_CLASSES if kind == KIND_MEM_POOL else OBJECTS
+        print('%-14s %-12s %4d %6d %5d %6d %9d  %s%s' % (
+            QUEUE_KINDS[kind] if kind < len(QUEUE_KINDS) else kind,
+            owners[number] if number < len(owners) else number,
+            item_size, length, peak, failed, suggested, QUEUE_MACROS.get((kind, number), '-'), warning))
+
+    print('\nreclaimable: %d bytes of stack, %d bytes of queues' % (stack_bytes, queue_bytes))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode the SLCAN sizing report (K command)')
+    parser.add_argument('input', nargs='?', help='file with the K line, or the K line itself (default: stdin)')
+    args = parser.parse_args()
+
+    if args.input is None:
+        text = sys.stdin.read()
+    elif REPORT_RE.fullmatch(args.input.strip()):
+        text = args.input
+    else:
+        with open(args.input, 'r', errors='replace') as capture:
+            text = capture.read()
+
+    reports = REPORT_RE.findall(text)
+    if not reports:
+        sys.exit('no sizing report found')
+
+    decode(bytes.fromhex(reports[-1][:len(reports[-1]) & ~1]))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,425 @@
+/*
+ * Trace decoder: rebuilds the timeline of a trace recorder capture (trace.h)
+ * and reports per task run time, interrupt handler durations, queue send to
+ * receive latencies, operation command TX complete to operation status RX
+ * latencies, and the recorder overhead.
+ *
+ * capture (gateway channel closed, Y1 starts and Y0 stops the recording):
+ *    stty -F /dev/ttyUSB0 500000 raw && printf 'Y1\r' > /dev/ttyUSB0 && cat /dev/ttyUSB0 > capture.bin
+ *
+ * build & run (host):
+ *    g++ -O2 -std=c++17 -I Core/Inc -o trace_decoder Tools/trace_decoder/trace_decoder.cpp && ./trace_decoder capture.bin
+ *
+ * the timeline is printed with -t:
+ *    ./trace_decoder -t capture.bin
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+#include "can2can.h"
+#include "trace.h"
+
+namespace {
+
+const uint32_t DEFAULT_CPU_KHZ = 8000u;     /* SystemCoreClock, until the start record */
+const uint8_t ISR_NUMBER = 6u;              /* RuntimeStats_Isr_t */
+const char *const ISR_NAMES[ISR_NUMBER] = { "CAN_TX", "CAN_RX0", "CAN_RX1", "CAN_SCE", "TIM1", "TIM2" };
+const char *const OBJECT_NAMES[] = { "other", "master", "slave", "slcan", "signal_db", "clock_sync" };
+
+/**
+ * @brief Duration statistics, in CPU cycles
+ */
+struct Duration {
+  uint64_t count = 0;
+  uint64_t total = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+
+  void Add(uint64_t cycles) {
+    count++;
+    total += cycles;
+    min = (cycles < min) ? cycles : min;
+    max = (cycles > max) ? cycles : max;
+  }
+};
+
+/**
+ * @brief Decoded record, with the time stamp unwrapped to 64 bits
+ */
+struct Record {
+  uint64_t time;
+  uint32_t raw;
+  uint8_t type;
+  uint8_t arg8;
+  uint16_t arg16;
+};
+
+class Decoder {
+ public:
+  explicit Decoder(bool timeline) : timeline_(timeline) {}
+
+  void Parse(const std::vector<uint8_t> &capture);
+  void Report() const;
+
+ private:
+  void Process(const Record &record);
+  void PrintRecord(const Record &record) const;
+  std::string TaskName(uint8_t number) const;
+  std::string ObjectName(uint8_t number) const;
+  double Micros(uint64_t cycles) const { return (double)cycles * 1000.0 / (double)cpu_khz_; }
+  void PrintDuration(const char *name, const Duration &duration) const;
+
+  bool timeline_;
+  uint32_t cpu_khz_ = DEFAULT_CPU_KHZ;
+
+  /* time stamp unwrapping */
+  bool started_ = false;
+  uint32_t last_raw_ = 0;
+  uint64_t time_ = 0;
+  uint64_t first_time_ = 0;
+
+  /* link */
+  uint64_t blocks_ = 0;
+  uint64_t block_bytes_ = 0;
+  uint64_t skipped_bytes_ = 0;
+  uint64_t records_ = 0;
+  uint64_t dropped_ = 0;
+  uint16_t avg_record_cycles_ = 0;
+  uint16_t max_record_cycles_ = 0;
+
+  /* tasks */
+  std::map<uint8_t, std::string> names_;
+  std::map<uint8_t, uint64_t> run_;
+  std::map<uint8_t, uint64_t> switches_;
+  bool running_ = false;
+  uint8_t current_task_ = 0;
+  uint64_t switched_in_ = 0;
+
+  /* interrupts */
+  Duration isr_[ISR_NUMBER];
+  uint64_t isr_enter_[ISR_NUMBER] = {0};
+  bool isr_active_[ISR_NUMBER] = {false};
+
+  /* queues: send time stamps, oldest first */
+  std::map<uint8_t, std::deque<uint64_t>> sent_;
+  std::map<uint8_t, Duration> queue_;
+  std::map<uint8_t, uint64_t> queue_full_;
+  std::map<uint8_t, uint64_t> timers_;
+
+  /* operation command TX complete, per slave, to the next operation status RX */
+  std::map<uint8_t, uint64_t> command_tx_;
+  std::map<uint8_t, Duration> status_;
+  uint64_t can_errors_ = 0;
+  uint64_t e2e_timeouts_ = 0;
+};
+
+/**
+ * @brief Find the blocks in the capture, the gateway responses and the bytes
+ * of a block cut by the start of the capture are skipped
+ */
+void Decoder::Parse(const std::vector<uint8_t> &capture) {
+  size_t pos = 0;
+
+  while ((pos + TRACE_BLOCK_HEADER_SIZE) <= capture.size()) {
+    const uint8_t *const block = &capture[pos];
+    uint8_t count = block[2];
+    size_t size = TRACE_BLOCK_HEADER_SIZE + ((size_t)count * sizeof(Trace_Record_t));
+    bool valid = (((uint16_t)block[0] | ((uint16_t)block[1] << 8)) == TRACE_BLOCK_MAGIC)
+      && (count > 0) && (count <= TRACE_BLOCK_RECORDS) && ((pos + size) <= capture.size());
+
+    for (uint8_t i = 0; valid && (i < count); i++) {
+      uint8_t type = block[TRACE_BLOCK_HEADER_SIZE + (i * sizeof(Trace_Record_t)) + 4u];
+      valid = (type >= TRACE_EVENT_START) && (type <= TRACE_EVENT_E2E_TIMEOUT);
+    }
+
+    if (!valid) {
+      skipped_bytes_++;
+      pos++;
+      continue;
+    }
+
+    blocks_++;
+    block_bytes_ += size;
+    avg_record_cycles_ = (uint16_t)(block[4] | (block[5] << 8));
+    max_record_cycles_ = (uint16_t)(block[6] | (block[7] << 8));
+
+    for (uint8_t i = 0; i < count; i++) {
+      const uint8_t *const data = &block[TRACE_BLOCK_HEADER_SIZE + (i * sizeof(Trace_Record_t))];
+      Record record = {};
+
+      record.raw = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+      record.type = data[4];
+      record.arg8 = data[5];
+      record.arg16 = (uint16_t)(data[6] | (data[7] << 8));
+      Process(record);
+    }
+
+    pos += size;
+  }
+
+  skipped_bytes_ += capture.size() - pos;
+}
+
+void Decoder::Process(const Record &source) {
+  Record record = source;
+
+  records_++;
+
+  /* task names carry characters in the time stamp field */
+  if (record.type == TRACE_EVENT_TASK_NAME) {
+    std::string &name = names_[record.arg8];
+
+    name.resize((size_t)record.arg16 * 4u, ' ');
+    for (uint8_t i = 0; (i < 4u) && (((record.raw >> (8u * i)) & 0xFFu) != 0); i++) {
+      name.push_back((char)((record.raw >> (8u * i)) & 0xFFu));
+    }
+    return;
+  }
+
+  if (record.type == TRACE_EVENT_START) {
+    cpu_khz_ = (record.arg16 != 0) ? record.arg16 : DEFAULT_CPU_KHZ;
+    started_ = false;
+    running_ = false;
+  }
+
+  /* the cycle counter wraps every 2^32 cycles (536 s at 8 MHz), records are
+   * in time order, so a smaller value is a wrap */
+  if (!started_) {
+    started_ = true;
+    time_ = record.raw;
+    first_time_ = time_;
+  } else {
+    time_ += (uint32_t)(record.raw - last_raw_);
+  }
+  last_raw_ = record.raw;
+  record.time = time_;
+
+  if (timeline_) {
+    PrintRecord(record);
+  }
+
+  switch (record.type) {
+    case TRACE_EVENT_TASK_SWITCH: {
+      if (running_) {
+        run_[current_task_] += record.time - switched_in_;
+      }
+      running_ = true;
+      current_task_ = record.arg8;
+      switched_in_ = record.time;
+      switches_[record.arg8]++;
+    } break;
+
+    case TRACE_EVENT_QUEUE_SEND:
+    case TRACE_EVENT_QUEUE_SEND_ISR: {
+      sent_[record.arg8].push_back(record.time);
+    } break;
+
+    case TRACE_EVENT_QUEUE_RECEIVE: {
+      std::deque<uint64_t> &sent = sent_[record.arg8];
+
+      /* arg16 counts the messages in the queue, the received one included:
+       * extra send time stamps were never received (queue reset), missing
+       * ones were sent before the start */
+      if (sent.size() > record.arg16) {
+        sent.erase(sent.begin(), sent.end() - record.arg16);
+      }
+      if (!sent.empty() && (sent.size() == record.arg16)) {
+        queue_[record.arg8].Add(record.time - sent.front());
+        sent.pop_front();
+      }
+    } break;
+
+    case TRACE_EVENT_QUEUE_FULL: {
+      queue_full_[record.arg8]++;
+    } break;
+
+    case TRACE_EVENT_TIMER: {
+      timers_[record.arg8]++;
+    } break;
+
+    case TRACE_EVENT_ISR_ENTER: {
+      if (record.arg8 < ISR_NUMBER) {
+        isr_enter_[record.arg8] = record.time;
+        isr_active_[record.arg8] = true;
+      }
+    } break;
+
+    case TRACE_EVENT_ISR_EXIT: {
+      if ((record.arg8 < ISR_NUMBER) && isr_active_[record.arg8]) {
+        isr_[record.arg8].Add(record.time - isr_enter_[record.arg8]);
+        isr_active_[record.arg8] = false;
+      }
+    } break;
+
+    case TRACE_EVENT_CAN_TX_COMPLETE: {
+      if ((record.arg16 & ~SLAVE_ID_STD_ID_MASK) == OPERATION_COMMAND_STD_ID) {
+        command_tx_[(uint8_t)SLAVE_ID_OF_STD_ID(record.arg16)] = record.time;
+      }
+    } break;
+
+    case TRACE_EVENT_CAN_RX: {
+      if ((record.arg16 & ~SLAVE_ID_STD_ID_MASK) == OPERATION_STATUS_STD_ID) {
+        uint8_t slave = (uint8_t)SLAVE_ID_OF_STD_ID(record.arg16 - (OPERATION_STATUS_STD_ID - OPERATION_COMMAND_STD_ID));
+        std::map<uint8_t, uint64_t>::iterator command = command_tx_.find(slave);
+
+        /* first status of each command period */
+        if (command != command_tx_.end()) {
+          status_[slave].Add(record.time - command->second);
+          command_tx_.erase(command);
+        }
+      }
+    } break;
+
+    case TRACE_EVENT_CAN_ERROR: {
+      can_errors_++;
+    } break;
+
+    case TRACE_EVENT_E2E_TIMEOUT: {
+      e2e_timeouts_++;
+    } break;
+
+    case TRACE_EVENT_OVERFLOW: {
+      dropped_ += record.arg16;
+      /* pairs cut by the dropped records are discarded */
+      running_ = false;
+      std::fill(std::begin(isr_active_), std::end(isr_active_), false);
+      sent_.clear();
+      command_tx_.clear();
+    } break;
+
+    default:
+    break;
+  }
+}
+
+std::string Decoder::TaskName(uint8_t number) const {
+  std::map<uint8_t, std::string>::const_iterator name = names_.find(number);
+
+  return (name != names_.end()) ? name->second : ("task " + std::to_string(number));
+}
+
+std::string Decoder::ObjectName(uint8_t number) const {
+  return (number < (sizeof(OBJECT_NAMES) / sizeof(OBJECT_NAMES[0]))) ? OBJECT_NAMES[number] : ("object " + std::to_string(number));
+}
+
+void Decoder::PrintRecord(const Record &record) const {
+  std::printf("%12.1f us  ", Micros(record.time - first_time_));
+
+  switch (record.type) {
+    case TRACE_EVENT_START: std::printf("start, %u kHz\n", record.arg16); break;
+    case TRACE_EVENT_TASK_SWITCH: std::printf("switch to %s\n", TaskName(record.arg8).c_str()); break;
+    case TRACE_EVENT_QUEUE_SEND: std::printf("queue send %s (%u waiting)\n", ObjectName(record.arg8).c_str(), record.arg16); break;
+    case TRACE_EVENT_QUEUE_SEND_ISR: std::printf("queue send from ISR %s (%u waiting)\n", ObjectName(record.arg8).c_str(), record.arg16); break;
+    case TRACE_EVENT_QUEUE_RECEIVE: std::printf("queue receive %s (%u waiting)\n", ObjectName(record.arg8).c_str(), record.arg16); break;
+    case TRACE_EVENT_QUEUE_BLOCK: std::printf("queue block %s\n", ObjectName(record.arg8).c_str()); break;
+    case TRACE_EVENT_QUEUE_FULL: std::printf("queue full %s\n", ObjectName(record.arg8).c_str()); break;
+    case TRACE_EVENT_TIMER: std::printf("timer %s\n", ObjectName(record.arg8).c_str()); break;
+    case TRACE_EVENT_ISR_ENTER: std::printf("ISR enter %s\n", (record.arg8 < ISR_NUMBER) ? ISR_NAMES[record.arg8] : "?"); break;
+    case TRACE_EVENT_ISR_EXIT: std::printf("ISR exit %s\n", (record.arg8 < ISR_NUMBER) ? ISR_NAMES[record.arg8] : "?"); break;
+    case TRACE_EVENT_CAN_TX: std::printf("CAN TX 0x%03X\n", record.arg16); break;
+    case TRACE_EVENT_CAN_TX_COMPLETE: std::printf("CAN TX complete 0x%03X, mailbox %u\n", record.arg16, record.arg8); break;
+    case TRACE_EVENT_CAN_RX: std::printf("CAN RX 0x%03X, FIFO %u\n", record.arg16, record.arg8); break;
+    case TRACE_EVENT_CAN_ERROR: std::printf("CAN error 0x%04X\n", record.arg16); break;
+    case TRACE_EVENT_OVERFLOW: std::printf("overflow, %u records dropped\n", record.arg16); break;
+    case TRACE_EVENT_E2E_TIMEOUT: std::printf("E2E timeout 0x%03X\n", record.arg16); break;
+    default: std::printf("type %u\n", record.type); break;
+  }
+}
+
+void Decoder::PrintDuration(const char *name, const Duration &duration) const {
+  std::printf("  %-16s %8llu %10.1f %10.1f %10.1f\n", name, (unsigned long long)duration.count,
+    Micros(duration.min), Micros(duration.total / duration.count), Micros(duration.max));
+}
+
+void Decoder::Report() const {
+  uint64_t elapsed = time_ - first_time_;
+  uint64_t payload = records_ * sizeof(Trace_Record_t);
+
+  std::printf("capture: %llu blocks, %llu records, %.1f ms, %llu records dropped, %llu bytes skipped\n",
+    (unsigned long long)blocks_, (unsigned long long)records_, Micros(elapsed) / 1000.0,
+    (unsigned long long)dropped_, (unsigned long long)skipped_bytes_);
+
+  if (elapsed == 0) {
+    return;
+  }
+
+  std::printf("\ntask run time:\n  %-16s %8s %10s %8s\n", "task", "switches", "us", "%");
+  for (const std::pair<const uint8_t, uint64_t> &run : run_) {
+    std::printf("  %-16s %8llu %10.1f %8.2f\n", TaskName(run.first).c_str(),
+      (unsigned long long)switches_.at(run.first), Micros(run.second), (100.0 * (double)run.second) / (double)elapsed);
+  }
+
+  std::printf("\nduration (us):\n  %-16s %8s %10s %10s %10s\n", "", "count", "min", "avg", "max");
+  for (uint8_t isr = 0; isr < ISR_NUMBER; isr++) {
+    if (isr_[isr].count != 0) {
+      PrintDuration((std::string("ISR ") + ISR_NAMES[isr]).c_str(), isr_[isr]);
+    }
+  }
+  for (const std::pair<const uint8_t, Duration> &queue : queue_) {
+    PrintDuration(("queue " + ObjectName(queue.first)).c_str(), queue.second);
+  }
+  for (const std::pair<const uint8_t, Duration> &status : status_) {
+    PrintDuration(("status slave " + std::to_string(status.first)).c_str(), status.second);
+  }
+
+  for (const std::pair<const uint8_t, uint64_t> &full : queue_full_) {
+    std::printf("queue %s full: %llu\n", ObjectName(full.first).c_str(), (unsigned long long)full.second);
+  }
+  for (const std::pair<const uint8_t, uint64_t> &timer : timers_) {
+    std::printf("timer %s callbacks: %llu\n", ObjectName(timer.first).c_str(), (unsigned long long)timer.second);
+  }
+  if (can_errors_ != 0) {
+    std::printf("CAN errors: %llu\n", (unsigned long long)can_errors_);
+  }
+  if (e2e_timeouts_ != 0) {
+    std::printf("E2E timeouts: %llu\n", (unsigned long long)e2e_timeouts_);
+  }
+
+  /* record cost as measured by the recorder, at the end of the capture */
+  std::printf("\noverhead: %u cycles/record avg, %u max (%.2f us), %.2f %% CPU, %.1f %% of the link is block headers, %.0f B/s\n",
+    avg_record_cycles_, max_record_cycles_, Micros(max_record_cycles_),
+    (100.0 * (double)(records_ + dropped_) * (double)avg_record_cycles_) / (double)elapsed,
+    (block_bytes_ != 0) ? ((100.0 * (double)(block_bytes_ - payload)) / (double)block_bytes_) : 0.0,
+    ((double)block_bytes_ * 1000000.0) / Micros(elapsed));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bool timeline = false;
+  const char *path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-t") == 0) {
+      timeline = true;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  if (path == nullptr) {
+    std::fprintf(stderr, "usage: %s [-t] capture.bin\n", argv[0]);
+    return 1;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::fprintf(stderr, "can't open %s\n", path);
+    return 1;
+  }
+
+  std::vector<uint8_t> capture((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  Decoder decoder(timeline);
+
+  decoder.Parse(capture);
+  decoder.Report();
+
+  return 0;
+}